@@ -0,0 +1,3 @@
+from highway_pursuit_gym.datasets.trajectory_reader import TrajectoryReader
+from highway_pursuit_gym.datasets.shared_replay_buffer import SharedReplayBuffer
+from highway_pursuit_gym.datasets.spectator_tap import SpectatorTap
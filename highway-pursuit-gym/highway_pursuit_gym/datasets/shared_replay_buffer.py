@@ -0,0 +1,126 @@
+import numpy as np
+from multiprocessing import shared_memory
+from highway_pursuit_gym.datasets.trajectory_reader import TransitionKind
+
+class SharedReplayBuffer:
+    """
+    Circular transition store in shared memory, filled directly by the env servers given its name (replay_buffer option).
+    Mirrors highway-pursuit-server/ReplayBuffer/SharedReplayBuffer.hpp. Servers reserve slots with an atomic ticket and
+    publish them with a per-slot sequence number, sampling takes no lock: transitions overwritten while being copied are
+    detected with the sequence numbers and sampled again (x86 memory ordering).
+    """
+    MAGIC = 0x42525048 # "HPRB"
+    VERSION = 1
+    CACHE_LINE_SIZE = 64
+    NO_TICKET = np.uint64(0xFFFFFFFFFFFFFFFF)
+
+    # Layout: header line, cursor line, then the slots (header line followed by the observation)
+    _CURSOR_OFFSET = 64
+    _SLOTS_OFFSET = 128
+    _SLOT_SEQUENCE = 0
+    _SLOT_PREVIOUS = 8
+    _SLOT_ACTION = 16
+    _SLOT_REWARD = 20
+    _SLOT_KIND = 24
+    _SLOT_TERMINATED = 25
+    _SLOT_TRUNCATED = 26
+    _SLOT_OBSERVATION = 64
+
+    def __init__(self, capacity, observation_shape, name=None):
+        """
+        Creates the buffer.
+
+        Args:
+            capacity (int): number of transitions kept, the oldest ones are overwritten.
+            observation_shape (tuple): shape of the env observations, e.g. env.observation_space.shape.
+            name (str): name of the shared memory, generated if None. Passed to the envs as the replay_buffer option.
+        """
+        self.capacity = capacity
+        self.observation_shape = tuple(observation_shape)
+        observation_size = int(np.prod(self.observation_shape))
+        lines = (observation_size + self.CACHE_LINE_SIZE - 1) // self.CACHE_LINE_SIZE
+        self._stride = self._SLOT_OBSERVATION + lines * self.CACHE_LINE_SIZE
+
+        self._memory = shared_memory.SharedMemory(name=name, create=True, size=self._SLOTS_OFFSET + capacity * self._stride)
+        self.name = self._memory.name
+        buffer = self._memory.buf
+
+        header = np.ndarray((4,), dtype='<u4', buffer=buffer, offset=0)
+        header[:] = (self.MAGIC, self.VERSION, capacity, observation_size)
+        np.ndarray((1,), dtype='<u8', buffer=buffer, offset=16)[0] = self._stride
+        self._cursor = np.ndarray((1,), dtype='<u8', buffer=buffer, offset=self._CURSOR_OFFSET)
+
+        # Strided views of the slot fields
+        def field(dtype, offset):
+            return np.ndarray((capacity,), dtype=dtype, buffer=buffer, offset=self._SLOTS_OFFSET + offset, strides=(self._stride,))
+        self._sequences = field('<u8', self._SLOT_SEQUENCE)
+        self._previous = field('<u8', self._SLOT_PREVIOUS)
+        self._actions = field('<u4', self._SLOT_ACTION)
+        self._rewards = field('<f4', self._SLOT_REWARD)
+        self._kinds = field('u1', self._SLOT_KIND)
+        self._terminated = field('u1', self._SLOT_TERMINATED)
+        self._truncated = field('u1', self._SLOT_TRUNCATED)
+
+        observation_strides = tuple(int(np.prod(self.observation_shape[i + 1:])) for i in range(len(self.observation_shape)))
+        self._observations = np.ndarray((capacity, *self.observation_shape), dtype=np.uint8, buffer=buffer,
+                                        offset=self._SLOTS_OFFSET + self._SLOT_OBSERVATION, strides=(self._stride, *observation_strides))
+
+    def __len__(self):
+        return int(min(self._cursor[0], self.capacity))
+
+    def sample(self, batch_size, rng=None, max_attempts=100):
+        """
+        Samples steps uniformly among the available ones.
+
+        Returns:
+            dict: observation, action_mask, reward, terminated, truncated and next_observation arrays of batch_size rows.
+        """
+        rng = rng if rng is not None else np.random.default_rng()
+        parts = []
+        needed = batch_size
+        for _ in range(max_attempts):
+            end = int(self._cursor[0])
+            begin = max(0, end - self.capacity)
+            if end == begin:
+                break
+
+            tickets = rng.integers(begin, end, size=2 * needed, dtype=np.uint64)
+            slots = (tickets % np.uint64(self.capacity)).astype(np.intp)
+            expected = np.uint64(2) * tickets + np.uint64(2)
+
+            # Complete steps whose predecessor is still available
+            sequences = self._sequences[slots]
+            previous = self._previous[slots]
+            valid = (sequences == expected) & (self._kinds[slots] == TransitionKind.STEP) & (previous != self.NO_TICKET)
+            previous = np.where(valid, previous, np.uint64(0))
+            previous_slots = (previous % np.uint64(self.capacity)).astype(np.intp)
+            previous_expected = np.uint64(2) * previous + np.uint64(2)
+            valid &= self._sequences[previous_slots] == previous_expected
+
+            batch = {
+                "observation": self._observations[previous_slots],
+                "action_mask": self._actions[slots],
+                "reward": self._rewards[slots],
+                "terminated": self._terminated[slots].astype(bool),
+                "truncated": self._truncated[slots].astype(bool),
+                "next_observation": self._observations[slots],
+            }
+
+            # Transitions overwritten during the copy are dropped
+            valid &= (self._sequences[slots] == expected) & (self._sequences[previous_slots] == previous_expected)
+            indices = np.flatnonzero(valid)[:needed]
+            parts.append({key: value[indices] for key, value in batch.items()})
+            needed -= len(indices)
+            if needed == 0:
+                return {key: np.concatenate([part[key] for part in parts]) for key in parts[0]}
+
+        raise RuntimeError(f"Couldn't sample {batch_size} steps from the replay buffer")
+
+    def close(self):
+        """
+        Releases the shared memory. The envs writing to it have to be closed first.
+        """
+        for name in ("_cursor", "_sequences", "_previous", "_actions", "_rewards", "_kinds", "_terminated", "_truncated", "_observations"):
+            setattr(self, name, None)
+        self._memory.close()
+        self._memory.unlink()
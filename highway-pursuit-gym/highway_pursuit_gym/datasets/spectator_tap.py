@@ -0,0 +1,77 @@
+import os
+import numpy as np
+from multiprocessing import shared_memory
+
+class SpectatorTap:
+    """
+    Latest observation and stats of a running env, published by its server in the section named by the spectator option.
+    Mirrors highway-pursuit-server/Spectator/SpectatorTap.hpp. The server never waits for the viewers: a frame published
+    while it is being copied is detected with the sequence number and copied again (x86 memory ordering).
+    """
+    MAGIC = 0x50535048 # "HPSP"
+    VERSION = 1
+
+    # Layout: header line, frame line (sequence then stats), then the observation
+    _FRAME_OFFSET = 64
+    _OBSERVATION_OFFSET = 128
+    _STATS = np.dtype([("frames", "<u8"), ("steps", "<u8"), ("episodes", "<u8"), ("checksum", "<u8"), ("reward", "<f4"),
+                       ("tps", "<f4"), ("server_time", "<f4"), ("game_time", "<f4"), ("terminated", "u1"), ("truncated", "u1")])
+
+    def __init__(self, name):
+        """
+        Opens the section of a running server, read-only use.
+
+        Args:
+            name (str): the spectator option of the env.
+        """
+        self._memory = self._attach(name)
+        buffer = self._memory.buf
+        magic, version, width, height, channels, observation_size = np.ndarray((6,), dtype='<u4', buffer=buffer, offset=0)
+        if magic != self.MAGIC or version != self.VERSION:
+            raise RuntimeError(f"{name} isn't a spectator tap of this version")
+        self.observation_shape = (int(height), int(width), int(channels))
+
+        self._sequence = np.ndarray((1,), dtype='<u8', buffer=buffer, offset=self._FRAME_OFFSET)
+        self._stats = np.ndarray((1,), dtype=self._STATS, buffer=buffer, offset=self._FRAME_OFFSET + 8)
+        self._observation = np.ndarray(self.observation_shape, dtype=np.uint8, buffer=buffer, offset=self._OBSERVATION_OFFSET)
+
+    @staticmethod
+    def _attach(name):
+        # Viewers don't own the section, it must not be unlinked when they exit
+        try:
+            return shared_memory.SharedMemory(name=name, track=False)
+        except TypeError:
+            memory = shared_memory.SharedMemory(name=name)
+            # Python < 3.13 only registers the section with the resource tracker on posix
+            if os.name == "posix":
+                from multiprocessing import resource_tracker
+                resource_tracker.unregister(memory._name, "shared_memory")
+            return memory
+
+    @property
+    def published_count(self):
+        return int(self._sequence[0]) // 2
+
+    def read(self, max_attempts=64):
+        """
+        Copies the latest frame.
+
+        Returns:
+            tuple: (observation, stats) with stats a dict (frames, steps, episodes, checksum, reward, tps, server_time, game_time,
+            terminated, truncated), or None if nothing was published yet or if every attempt overlapped a publish.
+        """
+        for _ in range(max_attempts):
+            sequence = int(self._sequence[0])
+            if sequence == 0:
+                return None
+            if sequence % 2 == 1:
+                continue
+            stats = self._stats[0].copy()
+            observation = self._observation.copy()
+            if int(self._sequence[0]) == sequence:
+                return observation, {key: stats[key].item() for key in self._STATS.names}
+        return None
+
+    def close(self):
+        self._sequence = self._stats = self._observation = None
+        self._memory.close()
@@ -0,0 +1,120 @@
+import ctypes
+import mmap
+import os
+import numpy as np
+
+class TrajectoryHeader(ctypes.LittleEndianStructure):
+    MAGIC = 0x52545048 # "HPTR"
+    VERSION = 1
+
+    _pack_ = 1
+    _fields_ = (
+        ('magic', ctypes.c_uint32),
+        ('version', ctypes.c_uint32),
+        ('obs_width', ctypes.c_uint32),
+        ('obs_height', ctypes.c_uint32),
+        ('obs_channels', ctypes.c_uint32),
+        ('chunk_transitions', ctypes.c_uint32)
+    )
+
+class TransitionKind:
+    RESET = 0
+    STEP = 1
+    RESTORE = 2
+
+class FrameCompression:
+    NONE = 0
+    PIXEL_RLE = 1
+
+# Fixed-size index entry, one per transition
+INDEX_ENTRY_DTYPE = np.dtype([
+    ('sequence', '<u8'),
+    ('offset', '<u8'),
+    ('chunk', '<u4'),
+    ('stored_size', '<u4'),
+    ('action_mask', '<u4'),
+    ('reward', '<f4'),
+    ('kind', 'u1'),
+    ('compression', 'u1'),
+    ('terminated', 'u1'),
+    ('truncated', 'u1')
+])
+
+class TrajectoryReader:
+    """
+    Random access to the transitions recorded by the server (trajectory_dir option), through memory mappings.
+    """
+    def __init__(self, directory):
+        """
+        Opens a trajectory directory. Transitions recorded after opening are picked up by refresh().
+        """
+        self._directory = directory
+        self._chunks = {}
+        self.refresh()
+
+    def refresh(self):
+        with open(os.path.join(self._directory, "index.hpti"), "rb") as index_file:
+            self._index_map = mmap.mmap(index_file.fileno(), 0, access=mmap.ACCESS_READ)
+
+        header = TrajectoryHeader.from_buffer_copy(self._index_map)
+        if header.magic != TrajectoryHeader.MAGIC or header.version != TrajectoryHeader.VERSION:
+            raise ValueError(f"{self._directory} doesn't contain a trajectory of this version")
+
+        self.observation_shape = (header.obs_height, header.obs_width, header.obs_channels)
+        count = (len(self._index_map) - ctypes.sizeof(TrajectoryHeader)) // INDEX_ENTRY_DTYPE.itemsize
+        self.index = np.frombuffer(self._index_map, dtype=INDEX_ENTRY_DTYPE, count=count, offset=ctypes.sizeof(TrajectoryHeader))
+
+    def __len__(self):
+        return len(self.index)
+
+    def observation(self, i):
+        """
+        Returns the observation of transition i, shape (height, width, channels) in the BGRX order of the env.
+        """
+        entry = self.index[i]
+        start = int(entry['offset'])
+        stored = self._chunk(int(entry['chunk']), start + int(entry['stored_size']))[start:start + int(entry['stored_size'])]
+
+        if entry['compression'] == FrameCompression.NONE:
+            frame = np.frombuffer(stored, dtype=np.uint8).copy()
+        elif entry['compression'] == FrameCompression.PIXEL_RLE:
+            frame = TrajectoryReader._decompress(stored, int(np.prod(self.observation_shape)))
+        else:
+            raise ValueError(f"Transition {i} uses an unknown compression")
+        return frame.reshape(self.observation_shape)
+
+    def transition(self, i):
+        """
+        Returns (observation, action_mask, reward, terminated, truncated) of transition i.
+        """
+        entry = self.index[i]
+        return self.observation(i), int(entry['action_mask']), float(entry['reward']), bool(entry['terminated']), bool(entry['truncated'])
+
+    def _chunk(self, chunk, min_size):
+        # The last chunk grows while recording, it's mapped again when too short
+        mapping = self._chunks.get(chunk)
+        if mapping is None or len(mapping) < min_size:
+            with open(os.path.join(self._directory, f"chunk_{chunk:06d}.hptc"), "rb") as chunk_file:
+                mapping = mmap.mmap(chunk_file.fileno(), 0, access=mmap.ACCESS_READ)
+            self._chunks[chunk] = mapping
+        return memoryview(mapping)
+
+    @staticmethod
+    def _decompress(stored, size):
+        # Packets of a 16 bits header (high bit: run of one pixel, low bits: pixel count - 1) followed by the pixels
+        pixels = np.empty(size // 4, dtype=np.uint32)
+        data = bytes(stored)
+        position = 0
+        out = 0
+        while position < len(data):
+            header = int.from_bytes(data[position:position + 2], "little")
+            position += 2
+            count = (header & 0x7FFF) + 1
+            if header & 0x8000:
+                pixels[out:out + count] = int.from_bytes(data[position:position + 4], "little")
+                position += 4
+            else:
+                pixels[out:out + count] = np.frombuffer(data, dtype='<u4', count=count, offset=position)
+                position += 4 * count
+            out += count
+        return pixels.view(np.uint8)
@@ -1 +1,3 @@
-from highway_pursuit_gym.envs.highway_pursuit import HighwayPursuitEnv
\ No newline at end of file
+from highway_pursuit_gym.envs.highway_pursuit import HighwayPursuitEnv
+from highway_pursuit_gym.envs._remote.warm_pool import WarmPool
+from highway_pursuit_gym.envs._remote.supervisor import Supervisor
\ No newline at end of file
@@ -1,6 +1,7 @@
 import ctypes
 import numpy as np
 import os
+import struct
 import uuid
 import subprocess
 from multiprocessing import shared_memory
@@ -43,6 +44,10 @@ class ErrorCode(Enum):
         UNSUPPORTED_BACKBUFFER_FORMAT (int): Unsupported pixel format (4).
         UNKNOWN_ACTION: An unknown action was sent to the server (5).
         ENVIRONMENT_NOT_RESET: STEP was called while the environment was either terminated or uninitialized.
+        INVALID_SNAPSHOT: RESTORE was called with an empty or invalid snapshot slot (7).
+        UNSUPPORTED_INSTRUCTION: The server doesn't support the instruction (8).
+        DISCARDED: Written by a warm pool instead of a client, the parked server exits (9).
+        STALLED: Written by a supervisor that killed the server, the episode is truncated (10).
     """
     NOT_ACK = -1
     ACK = 0
@@ -52,6 +57,16 @@ class ErrorCode(Enum):
     UNSUPPORTED_BACKBUFFER_FORMAT = 4
     UNKNOWN_ACTION = 5,
     ENVIRONMENT_NOT_RESET = 6
+    INVALID_SNAPSHOT = 7
+    UNSUPPORTED_INSTRUCTION = 8
+    DISCARDED = 9
+    STALLED = 10
+
+class ServerStalledError(Exception):
+    """
+    Raised when a supervisor killed the server while it handled an instruction, the client can only be closed.
+    """
+    pass
 
 class HighwayPursuitClient:
     """
@@ -74,6 +89,28 @@ class HighwayPursuitClient:
                 - is_real_time (bool): If highway pursuit runs in real time. Defaults to False.
                 - frameskip (int): the number of frames to repeat an action for. Defaults to 4.
                 - log_dir (str): Directory for storing server logs. If not provided, defaults to a 'logs' folder in the same directory as the DLL path.
+                - trace (bool): If the server records trace events (requires a server built with HP_ENABLE_TRACING). Defaults to False.
+                - trace_memory_budget (int): Memory in bytes used to store the trace events.
+                - record_actions (str): Path of a binary log of the instructions handled by the server, which the launcher can replay with --replay.
+                - trajectory_dir (str): Directory where the server records the transitions, in a subdirectory per server instance (see highway_pursuit_gym.datasets).
+                - trajectory_compression (bool): If the recorded observations are compressed. Defaults to True.
+                - replay_buffer (str): Name of a highway_pursuit_gym.datasets.SharedReplayBuffer the server appends its transitions to.
+                - warm_pool (WarmPool): Pool the server is acquired from instead of being launched, started with the same options.
+                - supervisor (Supervisor): Watches the heartbeat of the server, kills it and raises ServerStalledError when it stalls.
+                - game_cores (list): Logical processors the game thread is pinned to.
+                - server_cores (list): Logical processors the server thread is pinned to.
+                - placement (tuple): (index, count) automatic placement of the game and server threads of instance index out of count, for the threads without cores.
+                - client_cores (list): Logical processors the thread connecting the client is pinned to.
+                - auto_reset (bool): If a step ending the episode also resets it, the next reset (new life) then doesn't wait for the server.
+                - sticky_actions (float): Probability of each frame to keep the action of the previous frame instead of the action of the step.
+                - seed (int): Seed of the sticky actions, runs with the same seed and actions are reproducible.
+                - startup_image (str): Path of the game state once the intro is skipped, written by the first server and loaded by the next ones.
+                - spectator (str): Name of the section where the server publishes its latest observation and stats for viewers (highway_pursuit_gym.datasets.SpectatorTap).
+                - spectator_fps (float): Publishes per second at most, 0 publishes every observation. Defaults to 0.
+                - video (str): Path of a y4m video of the observations, written by a background thread of the server that drops frames instead of waiting.
+                - video_downsample (int): Each video pixel averages a block of video_downsample x video_downsample observation pixels. Defaults to 1.
+                - video_interval (int): One observation out of video_interval is recorded. Defaults to 1.
+                - native_wrappers (dict): Transforms applied by the server in place of the python wrappers, see HighwayPursuitClient.pipeline_config.
         """       
         
         # App and serv dll paths
@@ -87,6 +124,13 @@ class HighwayPursuitClient:
         # Handles for shared memory sections
         self._shared_memory_handles = []
 
+        # First observation and info of the episode the server started on its own (auto-reset)
+        self._pending_reset = None
+
+        # Set once a supervisor killed the server
+        self._stalled = False
+        self._supervisor = None
+
     def _create_shared_memory(self, name, size):
         """
         Creates a shared memory segment and appends it to the shared memory handles list.
@@ -106,29 +150,88 @@ class HighwayPursuitClient:
                 - action_count (int): The number of possible actions.
         """
         
-        # Generate name for mutex and share memory sections
-        self._app_resources_id = f"{str(uuid.uuid1())}-"
-        # Setup the server and the data formats
-        self._setup_server()
+        # The client and its server take turns, on the same core the handoffs stay in its caches
+        if self._options.get("client_cores"):
+            mask = sum(1 << core for core in self._options["client_cores"])
+            kernel32.SetThreadAffinityMask(kernel32.GetCurrentThread(), ctypes.c_size_t(mask))
+
+        warm_pool = self._options.get("warm_pool")
+        if warm_pool is not None:
+            # The server is already past the game's intro, waiting on the first handshake
+            parked_instance = warm_pool.acquire()
+            if parked_instance is None:
+                raise Exception("No server was parked in the warm pool before the timeout")
+            self._app_resources_id = parked_instance.resources_id
+            self._setup_server(parked_instance)
+        else:
+            # Generate name for mutex and share memory sections
+            self._app_resources_id = f"{str(uuid.uuid1())}-"
+            # Setup the server and the data formats
+            self._setup_server()
         return self.observation_shape, self.action_count
-    
-    def _start_process(self):
+
+    @staticmethod
+    def launcher_command(launcher_path, highway_pursuit_path, dll_path, options, app_resources_id):
         """
-        Starts the launcher process.
+        Gets the command running the launcher for a server with the given shared resources prefix.
         """
         # Define the command and its arguments
         command = [
-            self._launcher_path,
-            self._highway_pursuit_path,
-            self._dll_path,
-            str(self._options["real_time"]),
-            str(self._options["frameskip"]),
-            self._options["resolution"],
-            str(self._options["enable_rendering"]),
-            self._options["log_dir"],
-            self._app_resources_id
+            os.path.abspath(launcher_path),
+            os.path.abspath(highway_pursuit_path),
+            os.path.abspath(dll_path),
+            str(options["real_time"]),
+            str(options["frameskip"]),
+            options["resolution"],
+            str(options["enable_rendering"]),
+            options["log_dir"],
+            app_resources_id
         ]
 
+        # Optional args
+        if "trace" in options:
+            command.append(f"--trace={options['trace']}")
+        if "trace_memory_budget" in options:
+            command.append(f"--trace-memory-budget={options['trace_memory_budget']}")
+        if options.get("record_actions"):
+            command.append(f"--record-actions={os.path.abspath(options['record_actions'])}")
+        if options.get("trajectory_dir"):
+            # Restarted servers don't overwrite the transitions of the previous ones
+            trajectory_dir = os.path.join(os.path.abspath(options["trajectory_dir"]), app_resources_id.rstrip("-"))
+            command.append(f"--trajectory-dir={trajectory_dir}")
+            command.append(f"--trajectory-compression={options.get('trajectory_compression', True)}")
+        if options.get("replay_buffer"):
+            command.append(f"--replay-buffer={options['replay_buffer']}")
+        if options.get("game_cores"):
+            command.append(f"--game-cores={','.join(str(core) for core in options['game_cores'])}")
+        if options.get("server_cores"):
+            command.append(f"--server-cores={','.join(str(core) for core in options['server_cores'])}")
+        if options.get("placement"):
+            index, count = options["placement"]
+            command.append(f"--placement={index}/{count}")
+        if options.get("auto_reset"):
+            command.append(f"--auto-reset={options['auto_reset']}")
+        if options.get("sticky_actions"):
+            command.append(f"--sticky-actions={options['sticky_actions']}")
+        if options.get("seed") is not None:
+            command.append(f"--seed={options['seed']}")
+        if options.get("startup_image"):
+            command.append(f"--startup-image={os.path.abspath(options['startup_image'])}")
+        if options.get("spectator"):
+            command.append(f"--spectator={options['spectator']}")
+            command.append(f"--spectator-fps={options.get('spectator_fps', 0)}")
+        if options.get("video"):
+            command.append(f"--video={os.path.abspath(options['video'])}")
+            command.append(f"--video-downsample={options.get('video_downsample', 1)}")
+            command.append(f"--video-interval={options.get('video_interval', 1)}")
+        return command
+    
+    def _start_process(self):
+        """
+        Starts the launcher process.
+        """
+        command = HighwayPursuitClient.launcher_command(self._launcher_path, self._highway_pursuit_path, self._dll_path, self._options, self._app_resources_id)
+
         # Run the command
         result = subprocess.run(command, capture_output=False, text=False)
         if(result.returncode != 0):
@@ -140,9 +243,9 @@ class HighwayPursuitClient:
         """
         return f"{self._app_resources_id}{id}"
 
-    def _setup_server(self):
+    def _setup_server(self, parked_instance=None):
         """
-        Creates the semaphores and shared memory sections for communicating with the server.
+        Creates the semaphores and shared memory sections for communicating with the server, or takes over the ones of a parked server.
         Handles the connection protocol and returns the server info.
         """
         # Define shared resources names
@@ -157,23 +260,48 @@ class HighwayPursuitClient:
         reward_memory_name = self._name_from_id(reward_memory_id)
         action_memory_name = self._name_from_id(action_memory_id) 
         termination_memory_name = self._name_from_id(termination_memory_id)
-
-        # Create semaphores for synchronization
-        # Initially no availability
-        self._lock_server_pool = Semaphore(lock_server_name, initial_count=0, max_count=1) 
-        self._lock_client_pool = Semaphore(lock_client_name, initial_count=0, max_count=1)
-
-        # Create the shared memory for the return code
-        # Write some value that has to be overwritten by the server to ensure it is initialized
-        self._return_code_sm = self._create_shared_memory(name=return_code_memory_name, size=ctypes.sizeof(ReturnCode))
-        init_return_code = bytearray(ReturnCode(ErrorCode.NOT_ACK.value))
-        self._return_code_sm.buf[:len(init_return_code)] = init_return_code
-
-        # Create the initial shared memory for retrieving server info
-        self._server_info_sm = self._create_shared_memory(name=server_info_memory_name, size=ctypes.sizeof(ServerInfo))
-        
-        # Start the server process
-        self._start_process()
+        server_info_ex_memory_name = self._name_from_id(server_info_ex_memory_id)
+        instruction_argument_memory_name = self._name_from_id(instruction_argument_memory_id)
+        heartbeat_memory_name = self._name_from_id(heartbeat_memory_id)
+        final_observation_memory_name = self._name_from_id(final_observation_memory_id)
+        action_repeat_memory_name = self._name_from_id(action_repeat_memory_id)
+        pipeline_config_memory_name = self._name_from_id(pipeline_config_memory_id)
+        episode_stats_memory_name = self._name_from_id(episode_stats_memory_id)
+        metrics_memory_name = self._name_from_id(metrics_memory_id)
+
+        if parked_instance is not None:
+            # The pool created them in the same state, and started the server
+            self._lock_server_pool, self._lock_client_pool, self._return_code_sm, self._server_info_sm, self._server_info_ex_sm, self._heartbeat_sm = parked_instance.take_resources()
+            self._shared_memory_handles += [self._return_code_sm, self._server_info_sm, self._server_info_ex_sm, self._heartbeat_sm]
+        else:
+            # Create semaphores for synchronization
+            # Initially no availability
+            self._lock_server_pool = Semaphore(lock_server_name, initial_count=0, max_count=1) 
+            self._lock_client_pool = Semaphore(lock_client_name, initial_count=0, max_count=1)
+
+            # Create the shared memory for the return code
+            # Write some value that has to be overwritten by the server to ensure it is initialized
+            self._return_code_sm = self._create_shared_memory(name=return_code_memory_name, size=ctypes.sizeof(ReturnCode))
+            init_return_code = bytearray(ReturnCode(ErrorCode.NOT_ACK.value))
+            self._return_code_sm.buf[:len(init_return_code)] = init_return_code
+
+            # Create the initial shared memory for retrieving server info
+            self._server_info_sm = self._create_shared_memory(name=server_info_memory_name, size=ctypes.sizeof(ServerInfo))
+
+            # The extension section is left zeroed by servers that don't know it
+            self._server_info_ex_sm = self._create_shared_memory(name=server_info_ex_memory_name, size=ServerInfoEx.SECTION_SIZE)
+
+            # Opened by the server when it starts, before the game's intro
+            self._heartbeat_sm = self._create_shared_memory(name=heartbeat_memory_name, size=Heartbeat.SECTION_SIZE)
+            
+            # Start the server process
+            self._start_process()
+
+        # Read by the server in the first handshake, parked servers included
+        pipeline_config = HighwayPursuitClient.pipeline_config(self._options.get("native_wrappers"))
+        if pipeline_config is not None:
+            pipeline_config_sm = self._create_shared_memory(name=pipeline_config_memory_name, size=ctypes.sizeof(PipelineConfig))
+            pipeline_config_sm.buf[:ctypes.sizeof(PipelineConfig)] = bytearray(pipeline_config)
 
         # Notify server that server info is ready to be retrieved, and wait for the operation to complete
         self._sync_wait_for_serv()
@@ -184,22 +312,90 @@ class HighwayPursuitClient:
         # This is the observation shape in the shared memory
         self._server_observation_shape = (server_info.obs_height, server_info.obs_width, server_info.obs_channels)
         # This is the observation shape as returned by the client when reset/step is called
-        self.observation_shape = (server_info.obs_height, server_info.obs_width, HighwayPursuitClient.RGB_CHANNEL_COUNT)
+        self.observation_shape = (server_info.obs_height, server_info.obs_width, min(server_info.obs_channels, HighwayPursuitClient.RGB_CHANNEL_COUNT))
         self.action_count = server_info.action_count
+
+        server_info_ex: ServerInfoEx = ServerInfoEx.from_buffer_copy(self._server_info_ex_sm.buf[:ctypes.sizeof(ServerInfoEx)])
+        if pipeline_config is not None and server_info_ex.version < 6:
+            raise Exception("The server doesn't support native wrappers")
+        self.discrete_actions = pipeline_config is not None and pipeline_config.action_transform == ActionTransform.DISCRETE
+        self._action_encoding = server_info_ex.action_encoding if server_info_ex.version >= 1 else ActionEncoding.BYTE_PER_ACTION
+        self.snapshot_slots = server_info_ex.snapshot_slots if server_info_ex.version >= 2 else 0
+        self.auto_reset = server_info_ex.version >= 4 and bool(server_info_ex.auto_reset)
+        self.supports_action_repeat = server_info_ex.version >= 5
+        self.supports_episode_stats = server_info_ex.version >= 7
+        # Offset and format of each metric, by name
+        self._metrics_layout = {}
+        if server_info_ex.version >= 8:
+            schema = server_info_ex.metrics_schema
+            for descriptor in schema.metrics[:schema.metric_count]:
+                self._metrics_layout[descriptor.name.decode()] = (descriptor.offset, "<Q" if descriptor.type == MetricType.U64 else "<d")
         
         # Create the remaining shared memory
         self._instruction_sm = self._create_shared_memory(name=instruction_memory_name, size=ctypes.sizeof(Instruction))
         self._info_sm = self._create_shared_memory(name=info_memory_name, size=ctypes.sizeof(Info))
         self._reward_sm = self._create_shared_memory(name=reward_memory_name, size=ctypes.sizeof(Reward))
         self._termination_sm = self._create_shared_memory(name=termination_memory_name, size=ctypes.sizeof(Termination))
+        self._instruction_argument_sm = self._create_shared_memory(name=instruction_argument_memory_name, size=ctypes.sizeof(InstructionArgument))
+        if self.supports_action_repeat:
+            self._action_repeat_sm = self._create_shared_memory(name=action_repeat_memory_name, size=ctypes.sizeof(ActionRepeat))
+        if self.supports_episode_stats:
+            self._episode_stats_sm = self._create_shared_memory(name=episode_stats_memory_name, size=ctypes.sizeof(EpisodeStats))
+            self._read_episode_count = 0
+        if self._metrics_layout:
+            self._metrics_sm = self._create_shared_memory(name=metrics_memory_name, size=server_info_ex.metrics_schema.block_size)
 
         observation_buffer_size = np.prod(self._server_observation_shape).item()
-        action_buffer_size = self.action_count # one byte per action
+        if self._action_encoding == ActionEncoding.BITMASK:
+            action_buffer_size = ctypes.sizeof(ctypes.c_uint32) # bit i set if action i is taken
+        else:
+            action_buffer_size = self.action_count # one byte per action
         self._observation_sm = self._create_shared_memory(name=observation_memory_name, size=observation_buffer_size)
         self._action_sm = self._create_shared_memory(name=action_memory_name, size=action_buffer_size)
+        if self.auto_reset:
+            # The last observation of an episode, the observation section already holds the first one of the next episode
+            self._final_observation_sm = self._create_shared_memory(name=final_observation_memory_name, size=observation_buffer_size)
 
         # Server will now connect to the shared memory
         self._sync_wait_for_serv()
+        # Size of the pages backing the server's view of the observations, 0 if unknown
+        self.observation_page_size = 0
+        if server_info_ex.version >= 9:
+            self.observation_page_size = ServerInfoEx.from_buffer_copy(self._server_info_ex_sm.buf[:ctypes.sizeof(ServerInfoEx)]).observation_page_size
+
+        # Startup stalls are covered by the timeouts, only instructions are supervised
+        supervisor = self._options.get("supervisor")
+        if supervisor is not None:
+            supervisor.watch(self._heartbeat_sm, self._return_code_sm, self._lock_client_pool)
+            self._supervisor = supervisor
+
+    @staticmethod
+    def pipeline_config(native_wrappers):
+        """
+        Config of the server transforms, None without transforms. native_wrappers is a dict with the optional keys:
+            - discrete_actions (bool): MultiBinaryToDiscreteWrapper, the step takes an index and action_count includes the noop.
+            - remove_powerups (bool): RemovePowerupsWrapper, the last 3 actions are removed.
+            - reward_scale (float): TransformRewardWrapper with a scaling transform, e.g. 1 / 500.
+            - no_reward_timeout (int): NoRewardTimeoutWrapper, steps without reward before the episode is truncated.
+            - lives_per_game (int): LivesPerGameWrapper, respawns per game before a reset starts a new game.
+            - observation (str): "rgb_downsample" for RGBDownsampleWrapper, "grayscale" for a single channel.
+        """
+        if not native_wrappers:
+            return None
+        observation_transforms = {
+            None: ObservationTransform.NONE,
+            "rgb_downsample": ObservationTransform.RGB_DOWNSAMPLE,
+            "grayscale": ObservationTransform.GRAYSCALE
+        }
+        return PipelineConfig(
+            version=PipelineConfig.VERSION,
+            action_transform=ActionTransform.DISCRETE if native_wrappers.get("discrete_actions", False) else ActionTransform.NONE,
+            removed_actions=3 if native_wrappers.get("remove_powerups", False) else 0,
+            reward_scale=native_wrappers.get("reward_scale", 1.0),
+            no_reward_timeout=native_wrappers.get("no_reward_timeout", 0),
+            lives_per_game=native_wrappers.get("lives_per_game", 0),
+            observation_transform=observation_transforms[native_wrappers.get("observation")]
+        )
 
     def reset(self, new_game: bool):
         """
@@ -213,7 +409,11 @@ class HighwayPursuitClient:
                 - observation (array-like): The initial observation after the reset.
                 - info (dict): Additional environment information.
         """
-        
+        # The server already respawned the player at the end of the last step
+        pending_reset, self._pending_reset = self._pending_reset, None
+        if pending_reset is not None and not new_game:
+            return pending_reset
+
         # Query
         if(new_game):
             self._write_instruction(Instruction(Instruction.RESET_NEW_GAME))
@@ -228,12 +428,13 @@ class HighwayPursuitClient:
 
         return observation, info.to_dict()
 
-    def step(self, action):
+    def step(self, action, repeat: int = 0):
         """
         Performs one step in the environment by sending the given action to the server, retrieves the reward and next observation.
 
         Args:
             action (any): The action to take in the environment.
+            repeat (int): Frames the action is repeated for, 0 for the frameskip (at most ActionRepeat.MAX_FRAMES).
 
         Returns:
             tuple: A tuple containing:
@@ -243,7 +444,9 @@ class HighwayPursuitClient:
                 - truncated (bool): Whether the episode has been truncated.
                 - info (dict): Additional environment information.
         """
+        self._pending_reset = None
         self._write_action(action)
+        self._write_action_repeat(repeat)
         self._write_instruction(Instruction(Instruction.STEP))
         self._sync_wait_for_serv()
 
@@ -252,13 +455,76 @@ class HighwayPursuitClient:
         reward: Reward = Reward.from_buffer_copy(self._reward_sm.buf)
         info: Info = Info.from_buffer_copy(self._info_sm.buf)
         termination: Termination = Termination.from_buffer_copy(self._termination_sm.buf)
+        if self.auto_reset and (termination.terminated or termination.truncated):
+            # The step still returns the last observation of the episode, the first one of the next episode is returned by the next reset
+            self._pending_reset = (observation, info.to_dict())
+            observation = self._read_observation(self._final_observation_sm)
         return observation, reward.reward, bool(termination.terminated), bool(termination.truncated), info.to_dict()
 
-    def _read_observation(self):
+    def snapshot(self, slot: int):
+        """
+        Saves the game state in the given slot (0 to snapshot_slots - 1).
+        """
+        self._write_instruction_argument(slot)
+        self._write_instruction(Instruction(Instruction.SNAPSHOT))
+        self._sync_wait_for_serv()
+
+    def restore(self, slot: int):
+        """
+        Restores the game state saved in the given slot.
+
+        Returns:
+            tuple: A tuple containing:
+                - observation (array-like): The observation when the snapshot was taken.
+                - terminated (bool): Whether the episode was terminated when the snapshot was taken.
+                - info (dict): Additional environment information.
+        """
+        self._pending_reset = None
+        self._write_instruction_argument(slot)
+        self._write_instruction(Instruction(Instruction.RESTORE))
+        self._sync_wait_for_serv()
+
+        observation = self._read_observation()
+        info: Info = Info.from_buffer_copy(self._info_sm.buf)
+        termination: Termination = Termination.from_buffer_copy(self._termination_sm.buf)
+        return observation, bool(termination.terminated), info.to_dict()
+
+    def episode_stats(self):
+        """
+        Returns the records (dicts) of the episodes that ended since the last call, an empty list for servers without episode stats.
+        Only the last EpisodeStats.RING_SIZE episodes are kept by the server.
+        """
+        if not self.supports_episode_stats:
+            return []
+        stats: EpisodeStats = EpisodeStats.from_buffer_copy(self._episode_stats_sm.buf)
+        first = max(self._read_episode_count, stats.finished_count - EpisodeStats.RING_SIZE)
+        self._read_episode_count = stats.finished_count
+        return [stats.records[index % EpisodeStats.RING_SIZE].to_dict() for index in range(first, stats.finished_count)]
+
+    def metrics(self, names=None):
+        """
+        Returns a dict of the metrics published by the server (all of them if names is None), read from the metrics section
+        without copying it. Names the server doesn't publish are left out.
+        """
+        names = self._metrics_layout.keys() if names is None else names
+        return {
+            name: struct.unpack_from(self._metrics_layout[name][1], self._metrics_sm.buf, self._metrics_layout[name][0])[0]
+            for name in names if name in self._metrics_layout
+        }
+
+    def dump_trace(self):
+        """
+        Requests the server to write the trace events recorded so far to its log directory.
+        """
+        self._write_instruction(Instruction(Instruction.DUMP_TRACE))
+        self._sync_wait_for_serv()
+
+    def _read_observation(self, observation_sm=None):
         """
         Retrieves an observation from the shared memory buffer
         """
-        array = np.ndarray(self._server_observation_shape, dtype=np.uint8, buffer=self._observation_sm.buf)
+        observation_sm = observation_sm if observation_sm is not None else self._observation_sm
+        array = np.ndarray(self._server_observation_shape, dtype=np.uint8, buffer=observation_sm.buf)
         array.flags.writeable = False
         return np.copy(array)[:, :, :HighwayPursuitClient.RGB_CHANNEL_COUNT]
 
@@ -267,10 +533,15 @@ class HighwayPursuitClient:
         Closes the environment, and cleans up shared memory resources and locks.
         This method ensures that all shared resources are properly released and unlinked.
         """
-         
-        # Write the close instruction to the instruction buffer
-        self._write_instruction(Instruction(Instruction.CLOSE))
-        self._sync_wait_for_serv()
+        if self._supervisor is not None:
+            self._supervisor.unwatch(self._heartbeat_sm)
+            self._supervisor = None
+
+        # A stalled server was killed, there is nothing to close
+        if not self._stalled:
+            # Write the close instruction to the instruction buffer
+            self._write_instruction(Instruction(Instruction.CLOSE))
+            self._sync_wait_for_serv()
 
         # At this point, the server shouldn't use any shared resource
         # Clean up everything
@@ -288,9 +559,33 @@ class HighwayPursuitClient:
         Writes the given action to the shared memory buffer.
         """
         # Write an action in the appropriate buffer
-        bytes = bytearray(np.array(action, dtype=np.uint8))
+        if self.discrete_actions:
+            bytes = bytearray(ctypes.c_uint32(int(action)))
+        elif self._action_encoding == ActionEncoding.BITMASK:
+            mask = sum(1 << index for index, taken in enumerate(np.asarray(action).ravel()) if taken)
+            bytes = bytearray(ctypes.c_uint32(mask))
+        else:
+            bytes = bytearray(np.array(action, dtype=np.uint8))
         self._action_sm.buf[:len(bytes)] = bytes
 
+    def _write_action_repeat(self, repeat: int):
+        """
+        Writes the repeat count of the next step, servers without repeat counts only support the frameskip.
+        """
+        if not self.supports_action_repeat:
+            if repeat != 0:
+                raise Exception("The server doesn't support repeat counts")
+            return
+        bytes = bytearray(ActionRepeat(repeat))
+        self._action_repeat_sm.buf[:len(bytes)] = bytes
+
+    def _write_instruction_argument(self, value: int):
+        """
+        Writes the argument of the next instruction.
+        """
+        bytes = bytearray(InstructionArgument(value))
+        self._instruction_argument_sm.buf[:len(bytes)] = bytes
+
     def _write_instruction(self, instruction: Instruction):
         """
         Writes the given instruction  to the shared memory buffer.
@@ -308,6 +603,9 @@ class HighwayPursuitClient:
         
         has_server_timed_out = (wait_result != 0)
         error_code = self._get_error()
+        if(not has_server_timed_out and error_code == ErrorCode.STALLED.value):
+            self._stalled = True
+            raise ServerStalledError("server error - STALLED")
         if(has_server_timed_out or error_code != ErrorCode.ACK.value):
             message = f"server error - {'TIMEOUT | ' if has_server_timed_out else ''}{ErrorCode(error_code).name}"
             raise Exception(message)
@@ -7,17 +7,155 @@ class ServerInfo(ctypes.Structure):
         ('obs_channels', ctypes.c_uint),
         ('action_count', ctypes.c_uint)
     )
-    
+
+class ActionEncoding:
+    BYTE_PER_ACTION = 0
+    BITMASK = 1
+
+class MetricType:
+    U64 = 0
+    F64 = 1
+
+class MetricDescriptor(ctypes.Structure):
+    NAME_SIZE = 24
+
+    _pack_ = 1
+    _fields_ = (
+        ('name', ctypes.c_char * NAME_SIZE), # null terminated
+        ('type', ctypes.c_uint),
+        ('offset', ctypes.c_uint) # in bytes, from the start of the block of the slot
+    )
+
+class MetricsSchema(ctypes.Structure):
+    """
+    Layout of the metrics section (version 8): one block of block_size bytes per slot, each metric at a fixed offset.
+    Later versions only append metrics.
+    """
+    MAX_METRICS = 64
+
+    _pack_ = 1
+    _fields_ = (
+        ('metric_count', ctypes.c_uint),
+        ('block_size', ctypes.c_uint),
+        ('metrics', MetricDescriptor * MAX_METRICS)
+    )
+
+class ServerInfoEx(ctypes.Structure):
+    """
+    Protocol extensions, written by the server in a section created by the client.
+    The section has a fixed size so that later versions can add fields.
+    """
+    SECTION_SIZE = 4096
+
+    _fields_ = (
+        ('version', ctypes.c_uint),
+        ('action_encoding', ctypes.c_uint), # version 1
+        ('snapshot_slots', ctypes.c_uint), # version 2
+        ('vector_slots', ctypes.c_uint), # version 3, 1 for the game server
+        ('auto_reset', ctypes.c_uint), # version 4
+        ('metrics_schema', MetricsSchema), # version 8
+        ('observation_page_size', ctypes.c_uint) # version 9, written by the server in the second handshake
+    )
+
 class Instruction(ctypes.Structure):
     RESET_NEW_LIFE = 1
     RESET_NEW_GAME = 2
     STEP = 3
+    DUMP_TRACE = 4
+    PING = 5
+    SNAPSHOT = 6
+    RESTORE = 7
     CLOSE = 0xFF
 
     _fields_ = (
         ('instruction', ctypes.c_byte),
     )
 
+class InstructionArgument(ctypes.Structure):
+    _fields_ = (
+        ('value', ctypes.c_uint),
+    )
+
+class ActionRepeat(ctypes.Structure):
+    """
+    Frames the action of the next step is repeated for, 0 for the frameskip (version 5).
+    """
+    MAX_FRAMES = 64 # larger counts are clamped
+
+    _fields_ = (
+        ('frames', ctypes.c_uint),
+    )
+
+class ActionTransform:
+    NONE = 0
+    DISCRETE = 1 # one index per step: 0 takes no action, i takes action i - 1
+
+class ObservationTransform:
+    NONE = 0
+    RGB_DOWNSAMPLE = 1 # same as RGBDownsampleWrapper
+    GRAYSCALE = 2
+
+class PipelineConfig(ctypes.Structure):
+    """
+    Transforms applied by the server to every step, written by the client before the first handshake (version 6).
+    The server info then describes the transformed actions and observations.
+    """
+    VERSION = 1
+
+    _pack_ = 1
+    _fields_ = (
+        ('version', ctypes.c_uint),
+        ('action_transform', ctypes.c_uint),
+        ('removed_actions', ctypes.c_uint), # last actions the client can't take
+        ('reward_scale', ctypes.c_float), # 0 is read as 1
+        ('no_reward_timeout', ctypes.c_uint), # steps without reward before the episode is truncated, 0 disables it
+        ('lives_per_game', ctypes.c_uint), # resets start a new game once the lives are spent, 0 disables it
+        ('observation_transform', ctypes.c_uint)
+    )
+
+class EpisodeRecord(ctypes.Structure):
+    """
+    Statistics of a finished episode, from its reset to the step that ended it.
+    """
+    _pack_ = 1
+    _fields_ = (
+        ('index', ctypes.c_uint64), # of the episode in the server, from 1
+        ('frames', ctypes.c_uint64),
+        ('steps', ctypes.c_uint32),
+        ('life', ctypes.c_uint32), # lives of the game used so far, this episode included
+        ('episode_return', ctypes.c_float), # sum of the rewards returned by the steps
+        ('wall_time', ctypes.c_float),
+        ('game_time', ctypes.c_float),
+        ('terminated', ctypes.c_uint8),
+        ('truncated', ctypes.c_uint8)
+    )
+
+    def to_dict(self):
+        return {
+                "index": self.index,
+                "return": self.episode_return,
+                "steps": self.steps,
+                "frames": self.frames,
+                "life": self.life,
+                "wall_time": self.wall_time,
+                "game_time": self.game_time,
+                "terminated": bool(self.terminated),
+                "truncated": bool(self.truncated)
+            }
+
+class EpisodeStats(ctypes.Structure):
+    """
+    Ring of the last finished episodes, written by the server (version 7).
+    Episode i (from 1) is in records[(i - 1) % RING_SIZE] while i > finished_count - RING_SIZE.
+    """
+    RING_SIZE = 64
+
+    _pack_ = 1
+    _fields_ = (
+        ('finished_count', ctypes.c_uint64),
+        ('records', EpisodeRecord * RING_SIZE)
+    )
+
 class Info(ctypes.Structure):
     _fields_ = (
         ('tps', ctypes.c_float),
@@ -45,6 +183,24 @@ class Termination(ctypes.Structure):
         ('truncated', ctypes.c_byte)
     )
 
+class HeartbeatState:
+    STARTING = 0 # the game isn't past its intro yet
+    IDLE = 1 # waiting for the client
+    BUSY = 2 # handling an instruction, the beat has to advance
+    EXITED = 3
+
+class Heartbeat(ctypes.Structure):
+    """
+    Published by the server loop, read by supervisors to detect stalls.
+    """
+    SECTION_SIZE = 64
+
+    _fields_ = (
+        ('beat', ctypes.c_uint64),
+        ('state', ctypes.c_uint32),
+        ('process_id', ctypes.c_uint32)
+    )
+
 class ReturnCode(ctypes.Structure):
     _fields_ = (
         ('code', ctypes.c_byte),
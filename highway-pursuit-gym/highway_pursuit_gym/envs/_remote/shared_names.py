@@ -11,4 +11,13 @@ observation_memory_id = "3"
 info_memory_id = "4"
 reward_memory_id = "5"
 action_memory_id = "6"
-termination_memory_id = "7"
\ No newline at end of file
+termination_memory_id = "7"
+server_info_ex_memory_id = "8"
+instruction_argument_memory_id = "9"
+ready_mutex_id = "r"
+heartbeat_memory_id = "h"
+final_observation_memory_id = "f"
+action_repeat_memory_id = "p"
+pipeline_config_memory_id = "w"
+episode_stats_memory_id = "e"
+metrics_memory_id = "m"
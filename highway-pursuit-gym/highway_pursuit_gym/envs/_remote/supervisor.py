@@ -0,0 +1,90 @@
+import ctypes
+import os
+import threading
+import time
+from highway_pursuit_gym.envs._remote.highway_pursuit_client import ErrorCode, kernel32
+from highway_pursuit_gym.envs._remote.highway_pursuit_data import *
+
+class Supervisor:
+    """
+    Watches the heartbeats of the servers of several envs from a background thread.
+    A server that stays busy on an instruction without a heartbeat for the stall timeout (hung or crashed game) is killed,
+    and its client raises ServerStalledError right away instead of after the server timeout, without stalling the other envs.
+    Envs created with the supervisor option truncate the episode and restart their server on the next reset.
+    """
+
+    PROCESS_TERMINATE = 0x0001
+    SYNCHRONIZE = 0x00100000
+    STALLED_EXIT_CODE = 1
+    KILL_TIMEOUT = 5000 # in ms, waiting for a killed server to exit
+
+    def __init__(self, stall_timeout=0.5):
+        """
+        Starts watching.
+
+        Args:
+            stall_timeout (float): time in seconds, longer than the slowest instruction (e.g. a new game).
+        """
+        self._stall_timeout = stall_timeout
+        self._poll_interval = max(stall_timeout / 10, 0.001)
+
+        self._lock = threading.Lock()
+        self._watched = {} # heartbeat section -> [return code section, client semaphore, last beat, last progress]
+        self._stall_count = 0
+        self._stop_event = threading.Event()
+        self._poll_thread = threading.Thread(target=self._poll_loop, daemon=True)
+        self._poll_thread.start()
+
+    def watch(self, heartbeat_sm, return_code_sm, lock_client_pool):
+        """
+        Watches a server through the handshake resources of its client, which must unwatch it before releasing them.
+        """
+        with self._lock:
+            self._watched[heartbeat_sm] = [return_code_sm, lock_client_pool, self._read(heartbeat_sm).beat, time.monotonic()]
+
+    def unwatch(self, heartbeat_sm):
+        with self._lock:
+            self._watched.pop(heartbeat_sm, None)
+
+    def stall_count(self):
+        with self._lock:
+            return self._stall_count
+
+    def close(self):
+        self._stop_event.set()
+        self._poll_thread.join()
+
+    def _read(self, heartbeat_sm):
+        return Heartbeat.from_buffer_copy(heartbeat_sm.buf[:ctypes.sizeof(Heartbeat)])
+
+    def _poll_loop(self):
+        while not self._stop_event.wait(self._poll_interval):
+            with self._lock:
+                now = time.monotonic()
+                stalled = [heartbeat_sm for heartbeat_sm, watched in self._watched.items() if self._check(heartbeat_sm, watched, now)]
+                for heartbeat_sm in stalled:
+                    del self._watched[heartbeat_sm]
+                self._stall_count += len(stalled)
+
+    def _check(self, heartbeat_sm, watched, now):
+        # Waiting for the client isn't a stall
+        heartbeat = self._read(heartbeat_sm)
+        if heartbeat.state != HeartbeatState.BUSY or heartbeat.beat != watched[2]:
+            watched[2] = heartbeat.beat
+            watched[3] = now
+            return False
+        if now - watched[3] < self._stall_timeout:
+            return False
+
+        # Killed (and exited, termination is asynchronous) before the client is answered, it can't write to the sections anymore
+        if heartbeat.process_id != os.getpid():
+            process = kernel32.OpenProcess(Supervisor.PROCESS_TERMINATE | Supervisor.SYNCHRONIZE, False, heartbeat.process_id)
+            if process:
+                if kernel32.TerminateProcess(process, Supervisor.STALLED_EXIT_CODE):
+                    kernel32.WaitForSingleObject(process, Supervisor.KILL_TIMEOUT)
+                kernel32.CloseHandle(process)
+        return_code_sm, lock_client_pool = watched[0], watched[1]
+        return_code = bytearray(ReturnCode(ErrorCode.STALLED.value))
+        return_code_sm.buf[:len(return_code)] = return_code
+        lock_client_pool.release()
+        return True
@@ -0,0 +1,279 @@
+import ctypes
+import subprocess
+import threading
+import time
+import uuid
+from collections import deque
+from multiprocessing import shared_memory
+from highway_pursuit_gym.envs._remote.highway_pursuit_client import HighwayPursuitClient, Semaphore, ErrorCode, kernel32
+from highway_pursuit_gym.envs._remote.highway_pursuit_data import *
+from highway_pursuit_gym.envs._remote.shared_names import *
+
+class ParkedInstance:
+    """
+    A server started ahead of its client, waiting on the first handshake once the game is past its intro.
+    The pool creates the resources a client creates before launching a server, the client that acquires the instance takes them over.
+    """
+
+    EXIT_TIMEOUT = 2000 # in ms
+    PROCESS_TERMINATE = 0x0001
+    SYNCHRONIZE = 0x00100000
+    WAIT_OBJECT_0 = 0
+    KILLED_EXIT_CODE = 1
+
+    def __init__(self, resources_id, command):
+        self.resources_id = resources_id
+        self._parked = False
+        self._game_process = None # handle, opened once the server published its process id
+        self._game_exited = False
+
+        # Same initial state as a client launching its own server
+        self._lock_server_pool = Semaphore(self._name_from_id(server_mutex_id), initial_count=0, max_count=1)
+        self._lock_client_pool = Semaphore(self._name_from_id(client_mutex_id), initial_count=0, max_count=1)
+        self._lock_ready = Semaphore(self._name_from_id(ready_mutex_id), initial_count=0, max_count=1)
+        self._return_code_sm = shared_memory.SharedMemory(name=self._name_from_id(return_code_memory_id), size=ctypes.sizeof(ReturnCode), create=True)
+        self._write_return_code(ErrorCode.NOT_ACK)
+        self._server_info_sm = shared_memory.SharedMemory(name=self._name_from_id(server_info_memory_id), size=ctypes.sizeof(ServerInfo), create=True)
+        self._server_info_ex_sm = shared_memory.SharedMemory(name=self._name_from_id(server_info_ex_memory_id), size=ServerInfoEx.SECTION_SIZE, create=True)
+        self._heartbeat_sm = shared_memory.SharedMemory(name=self._name_from_id(heartbeat_memory_id), size=Heartbeat.SECTION_SIZE, create=True)
+
+        # The launcher exits once the server is injected, the game process is the one to watch after that
+        self._process = subprocess.Popen(command)
+
+    def _name_from_id(self, id):
+        return f"{self.resources_id}{id}"
+
+    def _write_return_code(self, code: ErrorCode):
+        return_code = bytearray(ReturnCode(code.value))
+        self._return_code_sm.buf[:len(return_code)] = return_code
+
+    def is_parked(self):
+        """
+        Polls the readiness of the server.
+        """
+        if not self._parked and self._lock_ready.acquire(0) == 0:
+            self._parked = True
+        return self._parked
+
+    def has_failed(self):
+        """
+        If the launcher failed to start the server, or if the game exited since.
+        """
+        return_code = self._process.poll()
+        if return_code is not None and return_code != 0:
+            return True
+        if not self._open_game_process():
+            return self._game_exited
+        self._game_exited = kernel32.WaitForSingleObject(self._game_process, 0) == ParkedInstance.WAIT_OBJECT_0
+        return self._game_exited
+
+    def _open_game_process(self):
+        """
+        Opens the game process once the server published its id in the heartbeat section, at the start of the server.
+        The handle keeps the id from being reused. Returns False if the game isn't known (yet) or already exited.
+        """
+        if self._game_process is not None:
+            return True
+        if self._game_exited:
+            return False
+        process_id = Heartbeat.from_buffer_copy(self._heartbeat_sm.buf[:ctypes.sizeof(Heartbeat)]).process_id
+        if process_id == 0:
+            return False
+        process = kernel32.OpenProcess(ParkedInstance.PROCESS_TERMINATE | ParkedInstance.SYNCHRONIZE, False, process_id)
+        if not process:
+            self._game_exited = True
+            return False
+        self._game_process = process
+        return True
+
+    def _kill(self):
+        """
+        Kills the launcher if the server isn't injected yet, else the game, and waits for it to exit.
+        """
+        if self._process.poll() is None:
+            self._process.kill()
+            self._process.wait()
+            return
+
+        # Injected but the server can still be starting, before it published the id of the game
+        deadline = time.monotonic() + ParkedInstance.EXIT_TIMEOUT / 1000
+        while not self._open_game_process() and not self._game_exited and self._process.returncode == 0 and time.monotonic() < deadline:
+            time.sleep(0.001)
+        if self._game_process is not None:
+            kernel32.TerminateProcess(self._game_process, ParkedInstance.KILLED_EXIT_CODE)
+            kernel32.WaitForSingleObject(self._game_process, ParkedInstance.EXIT_TIMEOUT)
+
+    def take_resources(self):
+        """
+        Gives the semaphores and shared memory sections of the handshake to the client, which releases them on close.
+        """
+        self._lock_ready.close()
+        if self._game_process is not None:
+            kernel32.CloseHandle(self._game_process)
+            self._game_process = None
+        return self._lock_server_pool, self._lock_client_pool, self._return_code_sm, self._server_info_sm, self._server_info_ex_sm, self._heartbeat_sm
+
+    def discard(self):
+        """
+        Makes a parked server exit without serving a client, and releases the resources.
+        """
+        if self.is_parked() and not self.has_failed():
+            # Woken up like by a client, the server checks the return code first
+            self._write_return_code(ErrorCode.DISCARDED)
+            self._lock_server_pool.release()
+            if self._lock_client_pool.acquire(ParkedInstance.EXIT_TIMEOUT) != 0:
+                self._kill()
+        elif not self._game_exited:
+            self._kill()
+        if self._game_process is not None:
+            kernel32.CloseHandle(self._game_process)
+            self._game_process = None
+
+        for sm in (self._return_code_sm, self._server_info_sm, self._server_info_ex_sm, self._heartbeat_sm):
+            sm.close()
+            sm.unlink()
+        self._lock_ready.close()
+        self._lock_server_pool.close()
+        self._lock_client_pool.close()
+
+class WarmPool:
+    """
+    Keeps a number of servers parked past the game's intro, and launches new ones in the background as they are acquired.
+    Envs created with the warm_pool option acquire a parked server instead of launching one, which takes seconds.
+    """
+
+    POLL_INTERVAL = 0.002 # in s, between readiness checks of the starting instances
+    RETRY_DELAY = 1.0 # in s, after an instance failed to start
+
+    def __init__(self, launcher_path, highway_pursuit_path, dll_path, options, size, start_timeout=60.0):
+        """
+        Initializes the pool and starts filling it.
+
+        Args:
+            launcher_path (str): Path to the launcher executable.
+            highway_pursuit_path (str): Path to the highway pursuit executable.
+            dll_path (str): Path to the server DLL file.
+            options (dict): launch options of the servers, the same as the envs using the pool (see HighwayPursuitEnv).
+            size (int): the number of parked servers kept ready.
+            start_timeout (float): time in seconds after which a server that isn't parked is killed and replaced.
+        """
+        self._launcher_path = launcher_path
+        self._highway_pursuit_path = highway_pursuit_path
+        self._dll_path = dll_path
+        self._options = options
+        self._size = size
+        self._start_timeout = start_timeout
+
+        self._condition = threading.Condition()
+        self._parked = deque()
+        self._stats = { "started": 0, "parked": 0, "acquired": 0, "failed": 0 }
+        self._closed = False
+        self._refill_thread = threading.Thread(target=self._refill_loop, daemon=True)
+        self._refill_thread.start()
+
+    def acquire(self, timeout=None):
+        """
+        Takes a parked server out of the pool, waiting at most timeout seconds (defaults to the start timeout).
+
+        Returns:
+            ParkedInstance: the instance to connect to, None if none was parked before the timeout.
+        """
+        deadline = time.monotonic() + (self._start_timeout if timeout is None else timeout)
+        with self._condition:
+            while True:
+                remaining = deadline - time.monotonic()
+                if not self._condition.wait_for(lambda: len(self._parked) > 0 or self._closed, timeout=max(remaining, 0)) or self._closed:
+                    return None
+
+                instance = self._parked.popleft()
+                self._condition.notify_all()
+                # Parked servers can die while they wait
+                if instance.has_failed():
+                    self._stats["failed"] += 1
+                    instance.discard()
+                    continue
+                self._stats["acquired"] += 1
+                return instance
+
+    def parked_count(self):
+        with self._condition:
+            return len(self._parked)
+
+    def stats(self):
+        """
+        Gets the number of started, parked, acquired and failed instances.
+        """
+        with self._condition:
+            return dict(self._stats)
+
+    def close(self):
+        """
+        Stops the pool, parked servers exit and starting ones are killed.
+        """
+        with self._condition:
+            self._closed = True
+            self._condition.notify_all()
+        self._refill_thread.join()
+
+        for instance in self._parked:
+            instance.discard()
+        self._parked.clear()
+
+    def _start_instance(self):
+        resources_id = f"{str(uuid.uuid1())}-"
+        command = HighwayPursuitClient.launcher_command(self._launcher_path, self._highway_pursuit_path, self._dll_path, self._options, resources_id)
+        command.append("--parked=True")
+        return ParkedInstance(resources_id, command)
+
+    def _refill_loop(self):
+        # Only this thread touches the starting instances
+        starting = []
+        retry_time = 0.0
+
+        with self._condition:
+            while not self._closed:
+                missing = self._size - len(self._parked) - len(starting)
+                self._condition.release()
+
+                # Launchers are started and polled without the lock, acquiring never waits for them
+                now = time.monotonic()
+                started = failed = 0
+                while missing > 0 and now >= retry_time:
+                    try:
+                        starting.append((self._start_instance(), now + self._start_timeout))
+                        started += 1
+                    except Exception:
+                        failed += 1
+                        retry_time = now + WarmPool.RETRY_DELAY
+                    missing -= 1
+
+                parked = []
+                still_starting = []
+                for instance, deadline in starting:
+                    if instance.is_parked():
+                        parked.append(instance)
+                    elif instance.has_failed() or now > deadline:
+                        instance.discard()
+                        failed += 1
+                        retry_time = now + WarmPool.RETRY_DELAY
+                    else:
+                        still_starting.append((instance, deadline))
+                starting = still_starting
+
+                self._condition.acquire()
+                self._stats["started"] += started
+                self._stats["failed"] += failed
+                self._stats["parked"] += len(parked)
+                if len(parked) > 0:
+                    self._parked.extend(parked)
+                    self._condition.notify_all()
+
+                if len(starting) > 0:
+                    self._condition.wait(WarmPool.POLL_INTERVAL)
+                elif time.monotonic() < retry_time:
+                    self._condition.wait_for(lambda: self._closed, timeout=retry_time - time.monotonic())
+                else:
+                    self._condition.wait_for(lambda: self._closed or len(self._parked) < self._size)
+
+        for instance, _ in starting:
+            instance.discard()
@@ -3,7 +3,7 @@ import numpy as np
 import os
 from dataclasses import dataclass
 from warnings import warn
-from highway_pursuit_gym.envs._remote.highway_pursuit_client import HighwayPursuitClient
+from highway_pursuit_gym.envs._remote.highway_pursuit_client import HighwayPursuitClient, ServerStalledError
 
 class HighwayPursuitEnv(gym.Env):
     """
@@ -22,6 +22,8 @@ class HighwayPursuitEnv(gym.Env):
             "enable_rendering": False,
             "server_restart_frequency": int(5e6),
             "max_memory_usage": 300.0,
+            "trace": False,
+            "trace_memory_budget": 16 * 1024 * 1024,
         }
 
     def _add_options_no_override(defaults, new_params):
@@ -41,6 +43,28 @@ class HighwayPursuitEnv(gym.Env):
                 - server_restart_frequency (int): the number of steps before the game is restarted.
                 - max_memory_usage (float): the maximum memory the server process can use before being restarted.
                 - log_dir (str): Directory for storing server logs. If not provided, defaults to a 'logs' folder in the same directory as the DLL path.
+                - trace (bool): if the server records trace events, dumped on close or when calling dump_trace.
+                - trace_memory_budget (int): the memory in bytes used by the server to store trace events.
+                - record_actions (str): path of a log of every instruction handled by the server, for exact replays. Overwritten when the server restarts.
+                - trajectory_dir (str): directory where the server records (observation, action, reward, termination) transitions, read with highway_pursuit_gym.datasets.TrajectoryReader.
+                - trajectory_compression (bool): if the recorded observations are compressed. Defaults to True.
+                - replay_buffer (str): name of a highway_pursuit_gym.datasets.SharedReplayBuffer the server writes its transitions to, without going through python.
+                - warm_pool (WarmPool): pool of servers started ahead of time with the same options, the env (and its restarts) takes a parked server instead of launching one.
+                - game_cores (list), server_cores (list): logical processors the game and server threads are pinned to, client_cores (list) for the thread creating the env.
+                - placement (tuple): (index, count) automatic placement of instance index out of count: each instance gets a physical core, the game on one SMT sibling and the server on the other.
+                - supervisor (Supervisor): watches the server's heartbeat, a stalled server is killed, the step returns truncated with info["server_stalled"] and the next reset restarts the server (from the warm pool if any).
+                - sticky_actions (float): probability of each frame to keep the action of the previous frame instead of the action of the step, drawn by the server.
+                - seed (int): seed of the sticky actions, give each env its own seed for independent draws.
+                - startup_image (str): path of the game state once the intro is skipped, the first server writes it and the next ones (restarts, other envs) start from it.
+                - spectator (str), spectator_fps (float): name of a section where the server publishes its latest observation and stats at most spectator_fps times per second,
+                  read by any number of highway_pursuit_gym.datasets.SpectatorTap without slowing the env. Give each env its own name.
+                - video (str), video_downsample (int), video_interval (int): path of a y4m video of one observation out of video_interval, averaged over video_downsample x video_downsample pixels.
+                  Written in the background, frames are dropped rather than slowing the steps (metrics()["video_dropped"]). Give each env its own path, a restarted server starts the video again.
+                - auto_reset (bool): the server respawns the player in the step ending the episode, the step still returns the last observation and the next reset (without new_game) returns without a round trip.
+                - native_wrappers (dict): transforms applied by the server instead of the python wrappers (discrete_actions, remove_powerups, reward_scale, no_reward_timeout, lives_per_game, observation),
+                  see HighwayPursuitClient.pipeline_config. The spaces are the ones of the transformed env, steps truncated by the timeout have info["truncate_reason"].
+
+            The step ending an episode has the statistics recorded by the server in info["episode"] (return, steps, frames, life, wall_time, game_time).
         """        
         # Store calling parameters
         self._launcher_path = launcher_path
@@ -59,6 +83,7 @@ class HighwayPursuitEnv(gym.Env):
         # Process monitoring
         self._server_total_elapsed_steps = 0
         self._last_info = None # last info returned by the server
+        self._server_stalled = False # killed by the supervisor
 
         # Keep track of cumulated time across instances for profiling
         self._cumulated_info = { "server_time" : 0, "game_time" : 0 }
@@ -68,7 +93,7 @@ class HighwayPursuitEnv(gym.Env):
 
         # gym env members
         self.observation_space = gym.spaces.Box(low=0, high=255, dtype=np.uint8, shape=image_shape)
-        self.action_space = gym.spaces.MultiBinary(action_count)
+        self.action_space = gym.spaces.Discrete(action_count) if self._client.discrete_actions else gym.spaces.MultiBinary(action_count)
         assert render_mode is None or render_mode in self.metadata["render_modes"]
         self.render_mode = render_mode
 
@@ -88,11 +113,15 @@ class HighwayPursuitEnv(gym.Env):
         self._client.create_process_and_connect()
 
         self._server_total_elapsed_steps = 0
+        self._server_stalled = False
 
     def _should_restart_server(self):
         """
         Checks if the server should be restarted e.g. high memory usage or enough steps elapsed.
         """
+        if self._server_stalled:
+            return True
+
         time_elapsed = self._server_total_elapsed_steps > self._options["server_restart_frequency"]
         
         if(self._last_info != None):
@@ -118,7 +147,7 @@ class HighwayPursuitEnv(gym.Env):
         super().reset(seed=seed)
 
         if seed != None:
-            warn("A seed was provided, but this env does not support seeding.")
+            warn("A seed was provided, but this env is only seeded when the server starts (seed option).")
 
         # restart the server if necessary
         has_restarted = False
@@ -155,12 +184,13 @@ class HighwayPursuitEnv(gym.Env):
 
         return observation, info
 
-    def step(self, action):
+    def step(self, action, repeat: int = 0):
         """
         Performs one step in the environment by sending the given action to the server, retrieves the reward and next observation.
 
         Args:
             action (any): The action to take in the environment.
+            repeat (int): frames the action is repeated for, 0 for the frameskip option.
 
         Returns:
             tuple: A tuple containing:
@@ -170,8 +200,23 @@ class HighwayPursuitEnv(gym.Env):
                 - truncated (bool): Whether the episode has been truncated.
                 - info (dict): Additional environment information.
         """
-        
-        observation, reward, terminated, truncated, info = self._client.step(action)
+        try:
+            observation, reward, terminated, truncated, info = self._client.step(action, repeat)
+        except ServerStalledError:
+            # The killed server can't answer anymore, the episode ends there and the server restarts on reset
+            self._server_stalled = True
+            info = {**self._last_info, "server_stalled": True}
+            return self._last_observation, 0.0, False, True, info
+
+        # the server recorded the episode, no need to accumulate the rewards
+        if terminated or truncated:
+            episodes = self._client.episode_stats()
+            if episodes:
+                info["episode"] = episodes[-1]
+
+        # only the no-reward timeout truncates episodes server side
+        if truncated and (self._options or {}).get("native_wrappers", {}).get("no_reward_timeout", 0) > 0:
+            info["truncate_reason"] = "no_reward_timeout"
 
         # update state
         self._last_observation = observation
@@ -192,6 +237,48 @@ class HighwayPursuitEnv(gym.Env):
         if self.render_mode == "rgb_array":
             return self._last_observation[..., ::-1] # BGR to RGB
 
+    def snapshot(self, slot: int = 0):
+        """
+        Saves the game state in the given slot. Snapshots are lost when the server restarts.
+        """
+        self._client.snapshot(slot)
+
+    def restore(self, slot: int = 0):
+        """
+        Restores the game state saved in the given slot, e.g. to run several rollouts from the same state.
+
+        Returns:
+            tuple: A tuple containing:
+                - observation (array-like): The observation when the snapshot was taken.
+                - info (dict): Additional environment information.
+        """
+        observation, terminated, info = self._client.restore(slot)
+        self._last_observation = observation
+        self._last_info = info
+        info["terminated"] = terminated
+        info["server_time"] += self._cumulated_info["server_time"]
+        info["game_time"] += self._cumulated_info["game_time"]
+        return observation, info
+
+    def episode_stats(self):
+        """
+        Returns the statistics of the episodes that ended since the last call (at most the last 64), see info["episode"].
+        """
+        return self._client.episode_stats()
+
+    def metrics(self, names=None):
+        """
+        Returns the metrics of the server (tps, memory, server_time, game_time, frames, steps, resets, episodes and the ones of later versions),
+        only the given names if any. Unlike the info, they aren't copied on every step. Counters restart with the server.
+        """
+        return self._client.metrics(names)
+
+    def dump_trace(self):
+        """
+        Writes the server trace events (chrome trace format) to the log directory.
+        """
+        self._client.dump_trace()
+
     def close(self):
         """
         Closes the environment and free all resources.
@@ -0,0 +1,178 @@
+#include "pch.h"
+#include "Benchmark.hpp"
+#include "BenchClient.hpp"
+#include "HighwayPursuitServer.hpp"
+#include "SampleAgent.hpp"
+#include <cstdio>
+#include <filesystem>
+#include <random>
+
+namespace HighwayPursuitBench
+{
+    namespace
+    {
+        constexpr int FRAMESKIP = 4;
+        constexpr uint32_t WIDTH = 160;
+        constexpr uint32_t HEIGHT = 120;
+
+        std::string StatsPath()
+        {
+            return (std::filesystem::temp_directory_path() / ("hp-bench-agent-" + std::to_string(std::random_device()()) + ".csv")).string();
+        }
+
+        // Same game as the bench clients, the sample plugin plays the episodes
+        std::unique_ptr<HighwayPursuitServer> CreateAgentServer(uint32_t episodes, const std::string& config, const std::string& statsPath,
+            uint32_t maxEpisodeSteps = ServerParams::AgentParams::DEFAULT_MAX_EPISODE_STEPS)
+        {
+            Data::ServerParams params(false, FRAMESKIP, ServerParams::RenderParams(WIDTH, HEIGHT, true), ServerParams::TraceParams(false, 0, "."),
+                "hp-bench-agent-", ServerParams::ReplayParams("", ""), ServerParams::TrajectoryParams("", false), ServerParams::ReplayBufferParams(""),
+                ServerParams::PoolParams(false), ServerParams::AffinityParams(0, 0), ServerParams::EpisodeParams(false), ServerParams::ActionParams(0.0f, 0),
+                ServerParams::AgentParams(HP_SAMPLE_AGENT_PATH, config, episodes, statsPath, maxEpisodeSteps));
+            return std::make_unique<HighwayPursuitServer>(params, std::make_unique<Synthetic::SyntheticGame>(Synthetic::SyntheticGameParams(WIDTH, HEIGHT, 42, 0)));
+        }
+
+        // The policy of the plugin driven through a client, one record per episode
+        std::vector<Data::EpisodeRecord> PlayThroughClient(uint32_t episodes)
+        {
+            BenchClient client(FRAMESKIP, WIDTH, HEIGHT);
+            client.Connect();
+            const Data::ServerInfo& info = client.ServerInfo();
+            SampleAgentPolicy policy(static_cast<size_t>(info.obsWidth) * info.obsHeight * info.obsChannels, 0);
+
+            std::vector<Data::EpisodeRecord> records;
+            for (uint32_t episode = 0; episode < episodes; ++episode)
+            {
+                client.Reset(episode == 0);
+                Data::EpisodeRecord record{};
+                Data::Termination termination(false, false);
+                while (!termination.IsDone())
+                {
+                    termination = client.Step(policy.Act(client.Observation()));
+                    record.steps++;
+                    record.episodeReturn += client.LastReward();
+                }
+                record.terminated = termination.terminated;
+                records.push_back(record);
+            }
+            client.Close();
+            return records;
+        }
+
+        size_t CountLines(const std::string& path)
+        {
+            std::ifstream file(path);
+            std::string line;
+            size_t lines = 0;
+            while (std::getline(file, line))
+            {
+                lines++;
+            }
+            return lines;
+        }
+    }
+
+    void RegisterAgentBenchmarks(BenchmarkSuite& suite)
+    {
+        // The plugin acting in the step loop plays the same episodes as its policy through the shared memory protocol
+        suite.AddCheck("agent_plugin_matches_client", 50, [](uint64_t iterations)
+            {
+                uint32_t episodes = static_cast<uint32_t>(iterations);
+                std::unique_ptr<HighwayPursuitServer> server = CreateAgentServer(episodes, "", "");
+                auto start = std::chrono::steady_clock::now();
+                server->Run();
+                double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+                const Agents::AgentReport& report = server->LastAgentReport();
+                std::vector<Data::EpisodeRecord> expected = PlayThroughClient(episodes);
+
+                std::string failure;
+                if (report.episodes.size() != expected.size())
+                {
+                    failure = "the agent played " + std::to_string(report.episodes.size()) + " of " + std::to_string(episodes) + " episodes";
+                }
+                for (size_t i = 0; i < expected.size() && failure.empty(); ++i)
+                {
+                    const Data::EpisodeRecord& record = report.episodes[i];
+                    if (record.index != i + 1 || record.steps != expected[i].steps || record.episodeReturn != expected[i].episodeReturn
+                        || record.terminated != expected[i].terminated)
+                    {
+                        failure = "episode " + std::to_string(i + 1) + " of the agent doesn't match the client";
+                    }
+                }
+                return BenchmarkResult{ "", "ms", ms, false, iterations, failure };
+            }
+        );
+
+        // Rollout throughput without any round trip, the records are written to the stats file
+        suite.Add("agent_plugin_steps_per_second", 200, [](uint64_t iterations)
+            {
+                uint32_t episodes = static_cast<uint32_t>(iterations);
+                std::string path = StatsPath();
+                std::unique_ptr<HighwayPursuitServer> server = CreateAgentServer(episodes, "", path);
+                auto start = std::chrono::steady_clock::now();
+                server->Run();
+                double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+                uint64_t steps = server->LastAgentReport().steps;
+                size_t lines = CountLines(path);
+                std::remove(path.c_str());
+
+                std::string failure;
+                if (lines != episodes + 1)
+                {
+                    failure = "the stats file has " + std::to_string(lines) + " lines for " + std::to_string(episodes) + " episodes";
+                }
+                return BenchmarkResult{ "", "steps/s", steps / seconds, true, steps, failure };
+            }
+        );
+
+        // Episodes longer than the step cap are truncated at the cap, the other ones end as usual
+        suite.AddCheck("agent_plugin_step_cap", 20, [](uint64_t iterations)
+            {
+                constexpr uint32_t MAX_STEPS = 8;
+                uint32_t episodes = static_cast<uint32_t>(iterations);
+                std::unique_ptr<HighwayPursuitServer> server = CreateAgentServer(episodes, "", "", MAX_STEPS);
+                auto start = std::chrono::steady_clock::now();
+                server->Run();
+                double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+                const Agents::AgentReport& report = server->LastAgentReport();
+
+                std::string failure;
+                if (report.episodes.size() != episodes)
+                {
+                    failure = "the agent played " + std::to_string(report.episodes.size()) + " of " + std::to_string(episodes) + " episodes";
+                }
+                bool truncated = false;
+                for (size_t i = 0; i < report.episodes.size() && failure.empty(); ++i)
+                {
+                    const Data::EpisodeRecord& record = report.episodes[i];
+                    truncated = truncated || record.truncated != 0;
+                    if (record.steps > MAX_STEPS || (record.truncated != 0) != (record.steps == MAX_STEPS))
+                    {
+                        failure = "episode " + std::to_string(i + 1) + " lasted " + std::to_string(record.steps) + " steps with a cap of " + std::to_string(MAX_STEPS);
+                    }
+                }
+                if (failure.empty() && !truncated)
+                {
+                    failure = "no episode reached the cap";
+                }
+                return BenchmarkResult{ "", "ms", ms, false, iterations, failure };
+            }
+        );
+
+        // A plugin refusing its config stops the server before the first episode
+        suite.Add("agent_plugin_refused", 1, [](uint64_t iterations)
+            {
+                std::unique_ptr<HighwayPursuitServer> server = CreateAgentServer(1, "refuse", "");
+                auto start = std::chrono::steady_clock::now();
+                server->Run();
+                double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+                std::string failure;
+                if (!server->LastAgentReport().episodes.empty())
+                {
+                    failure = "the refused agent played";
+                }
+                return BenchmarkResult{ "", "ms", ms, false, iterations, failure };
+            }
+        );
+    }
+}
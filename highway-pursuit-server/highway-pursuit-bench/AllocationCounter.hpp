@@ -0,0 +1,9 @@
+#pragma once
+#include <cstdint>
+
+namespace HighwayPursuitBench
+{
+    // Number of calls to the global operator new (all threads, aligned overloads included) since the start of the process,
+    // counted by the replacement operators in AllocationCounter.cpp
+    uint64_t AllocationCount();
+}
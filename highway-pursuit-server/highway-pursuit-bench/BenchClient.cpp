@@ -0,0 +1,307 @@
+#include "BenchClient.hpp"
+#include "HighwayPursuitServer.hpp"
+
+namespace HighwayPursuitBench
+{
+    BenchClient::BenchClient(int frameskip, uint32_t width, uint32_t height, uint32_t frameCostUs, Data::ActionEncoding actionEncoding, const BenchRecording& recording,
+        const ServerParams::AffinityParams& affinity, const ServerParams::EpisodeParams& episode, const ServerParams::ActionParams& actions,
+        const Data::PipelineConfig& pipeline, const ServerParams::SpectatorParams& spectator)
+        : _params(false, frameskip, ServerParams::RenderParams(width, height, true), ServerParams::TraceParams(false, 0, "."), UniquePrefix(),
+            ServerParams::ReplayParams(recording.actionLogPath, ""), ServerParams::TrajectoryParams(recording.trajectoryDirectory, true),
+            ServerParams::ReplayBufferParams(recording.replayBufferName), ServerParams::PoolParams(false), affinity, episode, actions,
+            ServerParams::AgentParams("", "", 0, ""), ServerParams::StartupParams(""), spectator,
+            ServerParams::VideoParams(recording.videoPath, recording.videoDownsample, recording.videoInterval)),
+        _gameParams(width, height, 42, frameCostUs),
+        _actionEncoding(actionEncoding),
+        _pipelineConfig(pipeline),
+        _serverInfo(0, 0, 0, 0),
+        _closed(false),
+        _stalled(false),
+        _supervisor(nullptr),
+        _supervisionId(0)
+    {
+    }
+
+    BenchClient::BenchClient(std::unique_ptr<Pool::ParkedInstance> instance)
+        : _params(false, 1, ServerParams::RenderParams(0, 0, false), ServerParams::TraceParams(false, 0, "."), instance->Prefix()),
+        _gameParams(0, 0, 0, 0),
+        _actionEncoding(ActionEncoding::BITMASK),
+        _pipelineConfig(),
+        _serverInfo(0, 0, 0, 0),
+        _closed(false),
+        _stalled(false),
+        _supervisor(nullptr),
+        _supervisionId(0),
+        _parkedInstance(std::move(instance))
+    {
+    }
+
+    BenchClient::~BenchClient()
+    {
+        if (_supervisor != nullptr)
+        {
+            _supervisor->Unwatch(_supervisionId);
+        }
+
+        if (!_closed && !_stalled && (_serverThread.joinable() || (_parkedInstance != nullptr && _instructionSM != nullptr)))
+        {
+            try
+            {
+                Close();
+            }
+            catch (const std::exception& e)
+            {
+                std::cerr << "Failed to close the server: " << e.what() << std::endl;
+            }
+        }
+
+        if (_serverThread.joinable())
+        {
+            _serverThread.join();
+        }
+    }
+
+    void BenchClient::Connect()
+    {
+        if (_parkedInstance != nullptr)
+        {
+            // The server is already waiting on the first handshake
+            Pool::HandshakeResources resources = _parkedInstance->TakeResources();
+            _lockServerPool = std::move(resources.lockServerPool);
+            _lockClientPool = std::move(resources.lockClientPool);
+            _returnCodeSM = std::move(resources.returnCodeSM);
+            _serverInfoSM = std::move(resources.serverInfoSM);
+            _serverInfoExSM = std::move(resources.serverInfoExSM);
+            _heartbeatSM = std::move(resources.heartbeatSM);
+        }
+        else
+        {
+            _lockServerPool = Platform::NamedSemaphore::Create(_params.serverMutexName, 0, 1);
+            _lockClientPool = Platform::NamedSemaphore::Create(_params.clientMutexName, 0, 1);
+            _returnCodeSM = Platform::SharedMemory::Create(_params.returnCodeMemoryName, sizeof(ReturnCode));
+            _serverInfoSM = Platform::SharedMemory::Create(_params.serverInfoMemoryName, sizeof(Data::ServerInfo));
+            *static_cast<uint8_t*>(_returnCodeSM->Data()) = static_cast<uint8_t>(ErrorCode::NOT_ACK);
+            if (_actionEncoding == ActionEncoding::BITMASK)
+            {
+                _serverInfoExSM = Platform::SharedMemory::Create(_params.serverInfoExMemoryName, ServerInfoEx::SECTION_SIZE);
+                if (_pipelineConfig.version != 0)
+                {
+                    _pipelineConfigSM = Platform::SharedMemory::Create(_params.pipelineConfigMemoryName, sizeof(PipelineConfig));
+                    *static_cast<PipelineConfig*>(_pipelineConfigSM->Data()) = _pipelineConfig;
+                }
+            }
+
+            Data::ServerParams params = _params;
+            Synthetic::SyntheticGameParams gameParams = _gameParams;
+            _serverThread = std::thread([params, gameParams]()
+                {
+                    HighwayPursuitServer server(params, std::make_unique<Synthetic::SyntheticGame>(gameParams));
+                    server.Run();
+                }
+            );
+        }
+
+        Sync();
+        _serverInfo = *static_cast<Data::ServerInfo*>(_serverInfoSM->Data());
+        if (_serverInfoExSM != nullptr && static_cast<ServerInfoEx*>(_serverInfoExSM->Data())->actionEncoding != _actionEncoding)
+        {
+            throw std::runtime_error("The server didn't accept the bitmask action encoding");
+        }
+        size_t actionSize = _actionEncoding == ActionEncoding::BITMASK ? sizeof(uint32_t) : _serverInfo.actionCount;
+
+        size_t observationSize = static_cast<size_t>(_serverInfo.obsHeight) * _serverInfo.obsWidth * _serverInfo.obsChannels;
+        _instructionSM = Platform::SharedMemory::Create(_params.instructionMemoryName, sizeof(Instruction));
+        _observationSM = Platform::SharedMemory::Create(_params.observationMemoryName, observationSize, true);
+        _infoSM = Platform::SharedMemory::Create(_params.infoMemoryName, sizeof(Info));
+        _rewardSM = Platform::SharedMemory::Create(_params.rewardMemoryName, sizeof(Reward));
+        _actionSM = Platform::SharedMemory::Create(_params.actionMemoryName, actionSize);
+        _terminationSM = Platform::SharedMemory::Create(_params.terminationMemoryName, sizeof(Termination));
+        if (_serverInfoExSM != nullptr)
+        {
+            _instructionArgumentSM = Platform::SharedMemory::Create(_params.instructionArgumentMemoryName, sizeof(InstructionArgument));
+            _actionRepeatSM = Platform::SharedMemory::Create(_params.actionRepeatMemoryName, sizeof(ActionRepeat));
+            _episodeStatsSM = Platform::SharedMemory::Create(_params.episodeStatsMemoryName, sizeof(Data::EpisodeStats));
+            uint32_t metricsBlockSize = static_cast<ServerInfoEx*>(_serverInfoExSM->Data())->metricsSchema.blockSize;
+            if (metricsBlockSize != 0)
+            {
+                _metricsSM = Platform::SharedMemory::Create(_params.metricsMemoryName, metricsBlockSize);
+            }
+            if (static_cast<ServerInfoEx*>(_serverInfoExSM->Data())->autoReset != 0)
+            {
+                _finalObservationSM = Platform::SharedMemory::Create(_params.finalObservationMemoryName, observationSize, true);
+            }
+        }
+        Sync();
+    }
+
+    void BenchClient::Reset(bool newGame)
+    {
+        SendInstruction(newGame ? InstructionCode::RESET_NEW_GAME : InstructionCode::RESET_NEW_LIFE);
+    }
+
+    Data::Termination BenchClient::Step(uint32_t actionMask, uint32_t repeat)
+    {
+        if (_actionRepeatSM != nullptr)
+        {
+            *static_cast<ActionRepeat*>(_actionRepeatSM->Data()) = ActionRepeat(repeat);
+        }
+        else if (repeat != 0)
+        {
+            throw std::runtime_error("Repeat counts need the protocol extensions");
+        }
+        if (_actionEncoding == ActionEncoding::BITMASK)
+        {
+            *static_cast<uint32_t*>(_actionSM->Data()) = actionMask;
+        }
+        else
+        {
+            uint8_t* actions = static_cast<uint8_t*>(_actionSM->Data());
+            for (uint32_t i = 0; i < _serverInfo.actionCount; ++i)
+            {
+                actions[i] = static_cast<uint8_t>((actionMask >> i) & 1u);
+            }
+        }
+        SendInstruction(InstructionCode::STEP);
+        return *static_cast<Termination*>(_terminationSM->Data());
+    }
+
+    void BenchClient::Ping()
+    {
+        SendInstruction(InstructionCode::PING);
+    }
+
+    void BenchClient::Snapshot(uint32_t slot)
+    {
+        *static_cast<InstructionArgument*>(_instructionArgumentSM->Data()) = InstructionArgument(slot);
+        SendInstruction(InstructionCode::SNAPSHOT);
+    }
+
+    Data::Termination BenchClient::Restore(uint32_t slot)
+    {
+        *static_cast<InstructionArgument*>(_instructionArgumentSM->Data()) = InstructionArgument(slot);
+        SendInstruction(InstructionCode::RESTORE);
+        return *static_cast<Termination*>(_terminationSM->Data());
+    }
+
+    void BenchClient::Close()
+    {
+        _closed = true;
+        SendInstruction(InstructionCode::CLOSE);
+        if (_serverThread.joinable())
+        {
+            _serverThread.join();
+        }
+    }
+
+    void BenchClient::Supervise(Supervision::Supervisor& supervisor)
+    {
+        if (_heartbeatSM == nullptr)
+        {
+            throw std::runtime_error("Only parked servers can be supervised");
+        }
+        _supervisionId = supervisor.Watch(static_cast<const Heartbeat*>(_heartbeatSM->Data()), _returnCodeSM->Data(), _lockClientPool.get());
+        _supervisor = &supervisor;
+    }
+
+    bool BenchClient::HasStalled() const
+    {
+        return _stalled;
+    }
+
+    const Data::ServerInfo& BenchClient::ServerInfo() const
+    {
+        return _serverInfo;
+    }
+
+    const uint8_t* BenchClient::Observation() const
+    {
+        return static_cast<const uint8_t*>(_observationSM->Data());
+    }
+
+    const uint8_t* BenchClient::FinalObservation() const
+    {
+        return static_cast<const uint8_t*>(_finalObservationSM->Data());
+    }
+
+    float BenchClient::LastReward() const
+    {
+        return static_cast<const Reward*>(_rewardSM->Data())->reward;
+    }
+
+    Data::Info BenchClient::LastInfo() const
+    {
+        return *static_cast<const Info*>(_infoSM->Data());
+    }
+
+    const Data::EpisodeStats& BenchClient::EpisodeStats() const
+    {
+        return *static_cast<const Data::EpisodeStats*>(_episodeStatsSM->Data());
+    }
+
+    uint32_t BenchClient::ServerObservationPageSize() const
+    {
+        return _serverInfoExSM != nullptr ? static_cast<const ServerInfoEx*>(_serverInfoExSM->Data())->observationPageSize : 0;
+    }
+
+    size_t BenchClient::ObservationPageSize() const
+    {
+        return _observationSM->PageSize();
+    }
+
+    uint64_t BenchClient::MetricU64(const std::string& name) const
+    {
+        uint64_t value;
+        std::memcpy(&value, FindMetric(name, MetricType::U64), sizeof(value));
+        return value;
+    }
+
+    double BenchClient::MetricF64(const std::string& name) const
+    {
+        double value;
+        std::memcpy(&value, FindMetric(name, MetricType::F64), sizeof(value));
+        return value;
+    }
+
+    const uint8_t* BenchClient::FindMetric(const std::string& name, Data::MetricType type) const
+    {
+        const MetricsSchema& schema = static_cast<const ServerInfoEx*>(_serverInfoExSM->Data())->metricsSchema;
+        for (uint32_t index = 0; index < schema.metricCount && _metricsSM != nullptr; ++index)
+        {
+            if (name == schema.metrics[index].name && schema.metrics[index].type == type)
+            {
+                return static_cast<const uint8_t*>(_metricsSM->Data()) + schema.metrics[index].offset;
+            }
+        }
+        throw std::runtime_error("The server doesn't publish the metric " + name);
+    }
+
+    void BenchClient::SendInstruction(Data::InstructionCode code)
+    {
+        *static_cast<Instruction*>(_instructionSM->Data()) = Instruction(code);
+        Sync();
+    }
+
+    void BenchClient::Sync()
+    {
+        _lockServerPool->Release();
+        if (!_lockClientPool->Wait(TIMEOUT))
+        {
+            throw HighwayPursuitException(ErrorCode::CLIENT_TIMEOUT);
+        }
+
+        ErrorCode code = static_cast<ErrorCode>(*static_cast<uint8_t*>(_returnCodeSM->Data()));
+        _stalled = _stalled || code == ErrorCode::STALLED;
+        if (code != ErrorCode::ACKNOWLEDGED)
+        {
+            throw HighwayPursuitException(code);
+        }
+    }
+
+    std::string BenchClient::UniquePrefix()
+    {
+        // Several benchmark processes can run at the same time
+        static std::atomic<uint32_t> instanceCount(0);
+        auto now = std::chrono::steady_clock::now().time_since_epoch().count();
+        return "hp-bench-" + std::to_string(now % 1000000007) + "-" + std::to_string(instanceCount++) + "-";
+    }
+}
@@ -0,0 +1,108 @@
+#pragma once
+#include "pch.h"
+#include "Data/ServerTypes.hpp"
+#include "Platform/Platform.hpp"
+#include "Pool/WarmPool.hpp"
+#include "Supervision/Supervisor.hpp"
+#include "Synthetic/SyntheticGame.hpp"
+
+namespace HighwayPursuitBench
+{
+    // What the server records, nothing when empty
+    struct BenchRecording
+    {
+        std::string actionLogPath;
+        std::string trajectoryDirectory;
+        std::string replayBufferName;
+        std::string videoPath = ""; // no video if empty
+        uint32_t videoDownsample = 1;
+        uint32_t videoInterval = 1;
+    };
+
+    // Client side of the shared memory protocol (mirrors the python client), talking to a server
+    // running the synthetic game on a thread of the current process, or to a parked server from a warm pool
+    class BenchClient
+    {
+    public:
+        static constexpr uint32_t TIMEOUT = 10000; // in ms
+
+        // BYTE_PER_ACTION behaves like a legacy client (no protocol extension section)
+        BenchClient(int frameskip, uint32_t width, uint32_t height, uint32_t frameCostUs = 0,
+            Data::ActionEncoding actionEncoding = Data::ActionEncoding::BITMASK, const BenchRecording& recording = BenchRecording(),
+            const Data::ServerParams::AffinityParams& affinity = Data::ServerParams::AffinityParams(0, 0),
+            const Data::ServerParams::EpisodeParams& episode = Data::ServerParams::EpisodeParams(false),
+            const Data::ServerParams::ActionParams& actions = Data::ServerParams::ActionParams(0.0f, 0),
+            const Data::PipelineConfig& pipeline = Data::PipelineConfig(),
+            const Data::ServerParams::SpectatorParams& spectator = Data::ServerParams::SpectatorParams("", 0.0f));
+        // Takes the handshake resources over, the server runs in the instance's process
+        explicit BenchClient(std::unique_ptr<Pool::ParkedInstance> instance);
+        ~BenchClient();
+
+        // Resources are created and the server info read, same two handshakes as the python client
+        void Connect();
+        void Reset(bool newGame);
+        // Bit i of the mask set if action i is taken (the action index with discrete actions), repeated for the frameskip with repeat 0
+        Data::Termination Step(uint32_t actionMask, uint32_t repeat = 0);
+        void Ping();
+        // Only with the protocol extensions (bitmask encoding)
+        void Snapshot(uint32_t slot);
+        Data::Termination Restore(uint32_t slot);
+        void Close();
+        // Only for parked servers (they publish a heartbeat), until the client is destroyed
+        void Supervise(Supervision::Supervisor& supervisor);
+        // The supervisor killed the server, its instructions throw STALLED
+        bool HasStalled() const;
+
+        const Data::ServerInfo& ServerInfo() const;
+        const uint8_t* Observation() const;
+        // Auto-reset: last observation of the episode that ended on the last step
+        const uint8_t* FinalObservation() const;
+        float LastReward() const;
+        Data::Info LastInfo() const;
+        // Only with the protocol extensions
+        const Data::EpisodeStats& EpisodeStats() const;
+        // Page size the server reported for its view of the observations, and the one of the client's view
+        uint32_t ServerObservationPageSize() const;
+        size_t ObservationPageSize() const;
+        // Looked up by name in the schema of the extended info, throws if the server doesn't publish it
+        uint64_t MetricU64(const std::string& name) const;
+        double MetricF64(const std::string& name) const;
+        // Shared resources prefix unique to the process and the client
+        static std::string UniquePrefix();
+
+    private:
+        const Data::ServerParams _params;
+        const Synthetic::SyntheticGameParams _gameParams;
+        const Data::ActionEncoding _actionEncoding;
+        const Data::PipelineConfig _pipelineConfig; // written only if enabled (non-zero version)
+        std::unique_ptr<Platform::NamedSemaphore> _lockServerPool;
+        std::unique_ptr<Platform::NamedSemaphore> _lockClientPool;
+        std::unique_ptr<Platform::SharedMemory> _returnCodeSM;
+        std::unique_ptr<Platform::SharedMemory> _serverInfoSM;
+        std::unique_ptr<Platform::SharedMemory> _serverInfoExSM;
+        std::unique_ptr<Platform::SharedMemory> _instructionSM;
+        std::unique_ptr<Platform::SharedMemory> _observationSM;
+        std::unique_ptr<Platform::SharedMemory> _infoSM;
+        std::unique_ptr<Platform::SharedMemory> _rewardSM;
+        std::unique_ptr<Platform::SharedMemory> _actionSM;
+        std::unique_ptr<Platform::SharedMemory> _terminationSM;
+        std::unique_ptr<Platform::SharedMemory> _instructionArgumentSM;
+        std::unique_ptr<Platform::SharedMemory> _heartbeatSM;
+        std::unique_ptr<Platform::SharedMemory> _finalObservationSM;
+        std::unique_ptr<Platform::SharedMemory> _actionRepeatSM;
+        std::unique_ptr<Platform::SharedMemory> _pipelineConfigSM;
+        std::unique_ptr<Platform::SharedMemory> _episodeStatsSM;
+        std::unique_ptr<Platform::SharedMemory> _metricsSM;
+        Data::ServerInfo _serverInfo;
+        std::thread _serverThread;
+        bool _closed;
+        bool _stalled;
+        Supervision::Supervisor* _supervisor;
+        uint64_t _supervisionId;
+        std::unique_ptr<Pool::ParkedInstance> _parkedInstance; // waits for the server to exit, destroyed first
+
+        const uint8_t* FindMetric(const std::string& name, Data::MetricType type) const;
+        void SendInstruction(Data::InstructionCode code);
+        void Sync();
+    };
+}
@@ -0,0 +1,175 @@
+#include "Benchmark.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+#include <sstream>
+
+namespace HighwayPursuitBench
+{
+    void BenchmarkSuite::Add(const std::string& name, uint64_t iterations, Case benchmarkCase)
+    {
+        _entries.push_back(Entry{ name, iterations, benchmarkCase, true });
+    }
+
+    void BenchmarkSuite::AddCheck(const std::string& name, uint64_t iterations, Case checkCase)
+    {
+        _entries.push_back(Entry{ name, iterations, checkCase, false });
+    }
+
+    std::vector<BenchmarkResult> BenchmarkSuite::Run(const std::string& filter, int repetitions, double iterationScale) const
+    {
+        std::vector<BenchmarkResult> results;
+        for (const Entry& entry : _entries)
+        {
+            if (!filter.empty() && entry.name.find(filter) == std::string::npos)
+            {
+                continue;
+            }
+
+            uint64_t iterations = entry.scaled ? std::max<uint64_t>(1, static_cast<uint64_t>(entry.iterations * iterationScale)) : entry.iterations;
+            std::vector<BenchmarkResult> measurements;
+            for (int i = 0; i < repetitions; ++i)
+            {
+                measurements.push_back(entry.benchmarkCase(iterations));
+            }
+
+            std::sort(measurements.begin(), measurements.end(),
+                [](const BenchmarkResult& a, const BenchmarkResult& b) { return a.value < b.value; });
+            BenchmarkResult median = measurements[measurements.size() / 2];
+            median.name = entry.name;
+            for (const BenchmarkResult& measurement : measurements)
+            {
+                if (!measurement.failure.empty())
+                {
+                    median.failure = measurement.failure;
+                }
+            }
+
+            std::cerr << median.name << ": " << median.value << " " << median.unit;
+            std::cerr << (median.failure.empty() ? "" : " FAILED: " + median.failure) << std::endl;
+            results.push_back(median);
+        }
+        return results;
+    }
+
+    std::string ToJson(const std::vector<BenchmarkResult>& results)
+    {
+        std::ostringstream json;
+        json.precision(10);
+        json << "{\"benchmarks\":[";
+        for (size_t i = 0; i < results.size(); ++i)
+        {
+            const BenchmarkResult& result = results[i];
+            json << (i == 0 ? "\n" : ",\n")
+                << "{\"name\":\"" << result.name << "\",\"unit\":\"" << result.unit << "\",\"value\":" << result.value
+                << ",\"higher_is_better\":" << (result.higherIsBetter ? "true" : "false")
+                << ",\"iterations\":" << result.iterations;
+            if (!result.failure.empty())
+            {
+                json << ",\"failure\":\"" << result.failure << "\"";
+            }
+            json << "}";
+        }
+        json << "\n]}\n";
+        return json.str();
+    }
+
+    namespace
+    {
+        std::string ReadString(const std::string& object, const std::string& key)
+        {
+            std::string pattern = "\"" + key + "\":\"";
+            size_t start = object.find(pattern);
+            if (start == std::string::npos)
+            {
+                return "";
+            }
+            start += pattern.size();
+            return object.substr(start, object.find('"', start) - start);
+        }
+
+        std::string ReadRaw(const std::string& object, const std::string& key)
+        {
+            std::string pattern = "\"" + key + "\":";
+            size_t start = object.find(pattern);
+            if (start == std::string::npos)
+            {
+                return "";
+            }
+            start += pattern.size();
+            return object.substr(start, object.find_first_of(",}", start) - start);
+        }
+    }
+
+    // Only parses the format written by ToJson
+    std::vector<BenchmarkResult> ParseJson(const std::string& json)
+    {
+        std::vector<BenchmarkResult> results;
+        size_t position = json.find('[');
+        while (position != std::string::npos)
+        {
+            size_t begin = json.find('{', position);
+            size_t end = json.find('}', begin);
+            if (begin == std::string::npos || end == std::string::npos)
+            {
+                break;
+            }
+
+            std::string object = json.substr(begin, end - begin + 1);
+            BenchmarkResult result;
+            result.name = ReadString(object, "name");
+            result.unit = ReadString(object, "unit");
+            result.value = std::stod(ReadRaw(object, "value"));
+            result.higherIsBetter = ReadRaw(object, "higher_is_better") == "true";
+            result.iterations = std::stoull(ReadRaw(object, "iterations"));
+            results.push_back(result);
+            position = end + 1;
+        }
+        return results;
+    }
+
+    int CountFailures(const std::vector<BenchmarkResult>& results)
+    {
+        return static_cast<int>(std::count_if(results.begin(), results.end(),
+            [](const BenchmarkResult& result) { return !result.failure.empty(); }));
+    }
+
+    int CompareToBaseline(const std::vector<BenchmarkResult>& results, const std::vector<BenchmarkResult>& baseline, double threshold)
+    {
+        int regressions = 0;
+        for (const BenchmarkResult& result : results)
+        {
+            auto reference = std::find_if(baseline.begin(), baseline.end(),
+                [&result](const BenchmarkResult& b) { return b.name == result.name; });
+            if (reference == baseline.end() || reference->value == 0.0)
+            {
+                std::cerr << result.name << ": no baseline" << std::endl;
+                continue;
+            }
+
+            // Positive when the result is worse than the baseline
+            double change = (result.value - reference->value) / reference->value;
+            double degradation = result.higherIsBetter ? -change : change;
+            bool isRegression = degradation > threshold;
+            regressions += isRegression ? 1 : 0;
+
+            char line[256];
+            std::snprintf(line, sizeof(line), "%-32s %14.2f -> %14.2f %-8s %+7.1f%% %s",
+                result.name.c_str(), reference->value, result.value, result.unit.c_str(), 100.0 * change, isRegression ? "REGRESSION" : "ok");
+            std::cerr << line << std::endl;
+        }
+        return regressions;
+    }
+
+    namespace
+    {
+        // The pointer itself is volatile, every store to it is kept
+        const void* volatile Sink = nullptr;
+    }
+
+    void DoNotOptimize(const void* pointer)
+    {
+        Sink = pointer;
+    }
+}
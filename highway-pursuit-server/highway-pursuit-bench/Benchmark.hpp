@@ -0,0 +1,101 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace HighwayPursuitBench
+{
+    struct BenchmarkResult
+    {
+        std::string name;
+        std::string unit;
+        double value;
+        bool higherIsBetter;
+        uint64_t iterations;
+        std::string failure = ""; // set when a check of the case doesn't hold
+    };
+
+    // Runs the registered cases, each repetition returns one measurement and the median is kept
+    class BenchmarkSuite
+    {
+    public:
+        using Case = std::function<BenchmarkResult(uint64_t iterations)>;
+
+        void Add(const std::string& name, uint64_t iterations, Case benchmarkCase);
+        // Correctness checks keep their iteration count whatever the --scale, their outcome must not depend on it
+        void AddCheck(const std::string& name, uint64_t iterations, Case checkCase);
+        std::vector<BenchmarkResult> Run(const std::string& filter, int repetitions, double iterationScale) const;
+
+    private:
+        struct Entry
+        {
+            std::string name;
+            uint64_t iterations;
+            Case benchmarkCase;
+            bool scaled;
+        };
+
+        std::vector<Entry> _entries;
+    };
+
+    // Machine-readable output, one result per line
+    std::string ToJson(const std::vector<BenchmarkResult>& results);
+    std::vector<BenchmarkResult> ParseJson(const std::string& json);
+
+    int CountFailures(const std::vector<BenchmarkResult>& results);
+
+    // Prints the comparison and returns the number of results worse than the baseline by more than threshold (relative)
+    int CompareToBaseline(const std::vector<BenchmarkResult>& results, const std::vector<BenchmarkResult>& baseline, double threshold);
+
+    // Average duration of one call in nanoseconds
+    template <typename F>
+    double MeasureNsPerOp(uint64_t iterations, F&& operation)
+    {
+        auto start = std::chrono::steady_clock::now();
+        for (uint64_t i = 0; i < iterations; ++i)
+        {
+            operation(i);
+        }
+        auto elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start);
+        return elapsed.count() / static_cast<double>(iterations);
+    }
+
+    // Nanoseconds per iteration of a check, check(i) returns the failure of iteration i (empty if it holds).
+    // Stops at the first failure.
+    template <typename F>
+    BenchmarkResult MeasureCheck(uint64_t iterations, F&& check)
+    {
+        BenchmarkResult result{ "", "ns/op", 0.0, false, iterations };
+        auto start = std::chrono::steady_clock::now();
+        for (uint64_t i = 0; i < iterations && result.failure.empty(); ++i)
+        {
+            result.failure = check(i);
+        }
+        auto elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start);
+        result.value = elapsed.count() / static_cast<double>(iterations);
+        return result;
+    }
+
+    // Keeps the compiler from optimizing a computation away
+    void DoNotOptimize(const void* pointer);
+
+    // Registration of the cases of each file
+    void RegisterKernelBenchmarks(BenchmarkSuite& suite);
+    void RegisterPlacementBenchmarks(BenchmarkSuite& suite);
+    void RegisterPoolBenchmarks(BenchmarkSuite& suite);
+    void RegisterServerBenchmarks(BenchmarkSuite& suite);
+    void RegisterSnapshotBenchmarks(BenchmarkSuite& suite);
+    void RegisterReplayBenchmarks(BenchmarkSuite& suite);
+    void RegisterReplayBufferBenchmarks(BenchmarkSuite& suite);
+    void RegisterTrajectoryBenchmarks(BenchmarkSuite& suite);
+    void RegisterVectorizedBenchmarks(BenchmarkSuite& suite);
+    void RegisterPipelineBenchmarks(BenchmarkSuite& suite);
+    void RegisterControlBlockBenchmarks(BenchmarkSuite& suite);
+    void RegisterAgentBenchmarks(BenchmarkSuite& suite);
+    void RegisterStartupBenchmarks(BenchmarkSuite& suite);
+    void RegisterSpectatorBenchmarks(BenchmarkSuite& suite);
+    void RegisterVideoBenchmarks(BenchmarkSuite& suite);
+    void RegisterTraceBenchmarks(BenchmarkSuite& suite);
+}
@@ -0,0 +1,158 @@
+#include "pch.h"
+#include "Benchmark.hpp"
+#include "Data/ServerTypes.hpp"
+#include "Platform/Platform.hpp"
+
+namespace HighwayPursuitBench
+{
+    namespace
+    {
+        // The per-step fields of the client and the server side by side, as a single packed block would hold them
+#pragma pack(push, 1)
+        struct PackedControl
+        {
+            Data::Instruction instruction;
+            uint32_t actionMask;
+            Data::ActionRepeat actionRepeat;
+            Data::InstructionArgument argument;
+            Data::ReturnCode returnCode;
+            Data::Termination termination;
+            Data::Reward reward;
+            Data::Info info;
+
+            PackedControl() : instruction(Data::InstructionCode::SKIP), actionMask(0), actionRepeat(0), argument(0),
+                returnCode(static_cast<uint32_t>(Data::ErrorCode::NOT_ACK)), termination(false, false), reward(0.0f), info(0.0f, 0.0f, 0.0f, 0.0f) {}
+        };
+#pragma pack(pop)
+        static_assert(sizeof(PackedControl) < Data::CACHE_LINE_SIZE, "The packed fields must share a cache line");
+
+        // The stores of a client or server writing its fields, volatile so that every iteration reaches the cache
+        template <typename Fields>
+        void WriteClientFields(volatile Fields& fields, uint64_t i)
+        {
+            fields.actionMask = static_cast<uint32_t>(i);
+            fields.instruction.code = Data::InstructionCode::STEP;
+        }
+
+        template <typename Fields>
+        void WriteServerFields(volatile Fields& fields, uint64_t i)
+        {
+            fields.reward.reward = static_cast<float>(i);
+            fields.info.serverTime = static_cast<float>(i);
+            fields.termination.truncated = static_cast<uint8_t>(i & 1);
+        }
+
+        // Nanoseconds per iteration of writers running at once, each pinned to its own logical processor while there are enough.
+        // write(writer, i) does the stores of a writer.
+        template <typename Write>
+        BenchmarkResult MeasureWriters(uint32_t writerCount, uint64_t iterations, Write write)
+        {
+            uint32_t processorCount = std::max(1u, std::thread::hardware_concurrency());
+            std::atomic<uint32_t> ready(0);
+            std::atomic<bool> start(false);
+            std::vector<std::string> failures(writerCount);
+
+            std::vector<std::thread> threads;
+            for (uint32_t writer = 0; writer < writerCount; ++writer)
+            {
+                threads.emplace_back([&, writer]()
+                    {
+                        uint32_t processor = writer % std::min(processorCount, 64u);
+                        if (!Platform::SetCurrentThreadAffinity(uint64_t(1) << processor))
+                        {
+                            failures[writer] = "Failed to pin the writer to the processor " + std::to_string(processor);
+                        }
+                        ready++;
+                        while (!start.load())
+                        {
+                            std::this_thread::yield();
+                        }
+                        for (uint64_t i = 0; i < iterations; ++i)
+                        {
+                            write(writer, i);
+                        }
+                    }
+                );
+            }
+            while (ready.load() < writerCount)
+            {
+                std::this_thread::yield();
+            }
+
+            auto begin = std::chrono::steady_clock::now();
+            start = true;
+            for (std::thread& thread : threads)
+            {
+                thread.join();
+            }
+            double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - begin).count() / static_cast<double>(iterations);
+
+            BenchmarkResult result{ "", "ns/op", ns, false, iterations };
+            for (const std::string& failure : failures)
+            {
+                if (result.failure.empty() && !failure.empty())
+                {
+                    result.failure = failure;
+                }
+            }
+            return result;
+        }
+    }
+
+    void RegisterControlBlockBenchmarks(BenchmarkSuite& suite)
+    {
+        // A client storing its action while the server stores its outputs, the lines bounce between the cores when the fields share one
+        suite.Add("control_block_client_server_packed", 2000000, [](uint64_t iterations)
+            {
+                std::unique_ptr<PackedControl> block = std::make_unique<PackedControl>();
+                return MeasureWriters(2, iterations, [&](uint32_t writer, uint64_t i)
+                    {
+                        PackedControl& control = *block;
+                        writer == 0 ? WriteClientFields(control, i) : WriteServerFields(control, i);
+                    }
+                );
+            }
+        );
+        suite.Add("control_block_client_server_aligned", 2000000, [](uint64_t iterations)
+            {
+                std::unique_ptr<Data::ControlBlock> block = std::make_unique<Data::ControlBlock>();
+                return MeasureWriters(2, iterations, [&](uint32_t writer, uint64_t i)
+                    {
+                        Data::ControlBlock& control = *block;
+                        writer == 0 ? WriteClientFields(control.client, i) : WriteServerFields(control.server, i);
+                    }
+                );
+            }
+        );
+
+        // Workers of a vectorized server writing the outputs of their slots, consecutive in the sections
+        uint32_t slotCount = std::max(2u, std::min(8u, std::thread::hardware_concurrency()));
+        suite.Add("control_block_slots_packed_x" + std::to_string(slotCount), 2000000, [slotCount](uint64_t iterations)
+            {
+                std::vector<PackedControl> blocks(slotCount);
+                return MeasureWriters(slotCount, iterations, [&](uint32_t writer, uint64_t i)
+                    {
+                        PackedControl& control = blocks[writer];
+                        WriteServerFields(control, i);
+                    }
+                );
+            }
+        );
+        suite.Add("control_block_slots_aligned_x" + std::to_string(slotCount), 2000000, [slotCount](uint64_t iterations)
+            {
+                std::vector<Data::ControlBlock> blocks(slotCount);
+                BenchmarkResult result = MeasureWriters(slotCount, iterations, [&](uint32_t writer, uint64_t i)
+                    {
+                        Data::ControlBlock& control = blocks[writer];
+                        WriteServerFields(control.server, i);
+                    }
+                );
+                if (result.failure.empty() && reinterpret_cast<uintptr_t>(blocks.data()) % Data::CACHE_LINE_SIZE != 0)
+                {
+                    result.failure = "The control blocks don't start on a cache line";
+                }
+                return result;
+            }
+        );
+    }
+}
@@ -0,0 +1,115 @@
+#include "pch.h"
+#include <algorithm>
+#include "Benchmark.hpp"
+
+using namespace HighwayPursuitBench;
+
+namespace
+{
+    void PrintUsage()
+    {
+        std::cerr << "Usage: highway-pursuit-bench [--output <results.json>] [--baseline <baseline.json>] [--threshold <ratio>]"
+            << " [--filter <substring>] [--repetitions <n>] [--scale <iteration multiplier>]" << std::endl;
+    }
+
+    std::string ReadFile(const std::string& path)
+    {
+        std::ifstream reader(path);
+        if (!reader.is_open())
+        {
+            throw std::runtime_error("Couldn't open " + path);
+        }
+        std::ostringstream content;
+        content << reader.rdbuf();
+        return content.str();
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    std::string outputPath;
+    std::string baselinePath;
+    std::string filter;
+    double threshold = 0.10;
+    int repetitions = 3;
+    double iterationScale = 1.0;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if (arg == "--help" || i + 1 >= argc)
+        {
+            PrintUsage();
+            return arg == "--help" ? 0 : 2;
+        }
+
+        std::string value = argv[++i];
+        if (arg == "--output") outputPath = value;
+        else if (arg == "--baseline") baselinePath = value;
+        else if (arg == "--filter") filter = value;
+        else if (arg == "--threshold") threshold = std::stod(value);
+        else if (arg == "--repetitions") repetitions = std::max(1, std::stoi(value));
+        else if (arg == "--scale") iterationScale = std::stod(value);
+        else
+        {
+            PrintUsage();
+            return 2;
+        }
+    }
+
+    try
+    {
+        BenchmarkSuite suite;
+        RegisterKernelBenchmarks(suite);
+        RegisterServerBenchmarks(suite);
+        RegisterSnapshotBenchmarks(suite);
+        RegisterReplayBenchmarks(suite);
+        RegisterReplayBufferBenchmarks(suite);
+        RegisterTrajectoryBenchmarks(suite);
+        RegisterPoolBenchmarks(suite);
+        RegisterPlacementBenchmarks(suite);
+        RegisterVectorizedBenchmarks(suite);
+        RegisterPipelineBenchmarks(suite);
+        RegisterControlBlockBenchmarks(suite);
+        RegisterAgentBenchmarks(suite);
+        RegisterStartupBenchmarks(suite);
+        RegisterSpectatorBenchmarks(suite);
+        RegisterVideoBenchmarks(suite);
+        RegisterTraceBenchmarks(suite);
+        std::vector<BenchmarkResult> results = suite.Run(filter, repetitions, iterationScale);
+
+        std::string json = ToJson(results);
+        if (outputPath.empty())
+        {
+            std::cout << json;
+        }
+        else
+        {
+            std::ofstream writer(outputPath, std::ios::trunc);
+            writer << json;
+        }
+
+        int failures = CountFailures(results);
+        if (failures > 0)
+        {
+            std::cerr << failures << " benchmark(s) failed their checks" << std::endl;
+            return 4;
+        }
+
+        if (!baselinePath.empty())
+        {
+            int regressions = CompareToBaseline(results, ParseJson(ReadFile(baselinePath)), threshold);
+            if (regressions > 0)
+            {
+                std::cerr << regressions << " benchmark(s) regressed by more than " << 100.0 * threshold << "%" << std::endl;
+                return 1;
+            }
+        }
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << "Benchmark failed: " << e.what() << std::endl;
+        return 3;
+    }
+    return 0;
+}
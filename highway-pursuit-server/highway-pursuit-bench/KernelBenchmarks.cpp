@@ -0,0 +1,128 @@
+#include "pch.h"
+#include "Benchmark.hpp"
+#include "BenchClient.hpp"
+#include "Observation/ObservationKernels.hpp"
+
+namespace HighwayPursuitBench
+{
+    namespace
+    {
+        struct Resolution
+        {
+            uint32_t width;
+            uint32_t height;
+        };
+
+        const Resolution RESOLUTIONS[] = { { 160, 120 }, { 320, 240 }, { 640, 480 } };
+
+        std::vector<uint8_t> MakeFrame(const Data::BufferFormat& format)
+        {
+            std::vector<uint8_t> frame(format.Size());
+            for (size_t i = 0; i < frame.size(); ++i)
+            {
+                frame[i] = static_cast<uint8_t>(i * 31);
+            }
+            return frame;
+        }
+
+        std::string ResolutionName(const Resolution& resolution)
+        {
+            return std::to_string(resolution.width) + "x" + std::to_string(resolution.height);
+        }
+
+        // Bandwidth of the server writing the observations of 8 slots at 640x480 in a shared section then of the client reading them,
+        // in GB of copied frames per second
+        BenchmarkResult MeasureSectionCopy(bool largePages, uint64_t iterations)
+        {
+            constexpr uint32_t SLOTS = 8;
+            Data::BufferFormat format(640, 480, 4);
+            std::vector<uint8_t> source = MakeFrame(format);
+            std::unique_ptr<Platform::SharedMemory> section = Platform::SharedMemory::Create(BenchClient::UniquePrefix() + "obs",
+                static_cast<size_t>(format.Size()) * SLOTS, largePages);
+            uint8_t* observations = static_cast<uint8_t*>(section->Data());
+
+            uint64_t checksum = 0;
+            double ns = MeasureNsPerOp(iterations, [&](uint64_t)
+                {
+                    for (uint32_t slot = 0; slot < SLOTS; ++slot)
+                    {
+                        Observation::CopyFrame(observations + static_cast<size_t>(slot) * format.Size(), source.data(), format);
+                    }
+                    checksum ^= Observation::Checksum(observations, section->Size());
+                    DoNotOptimize(&checksum);
+                }
+            );
+
+            BenchmarkResult result{ "", "GB/s", static_cast<double>(section->Size()) / ns, true, iterations };
+            if (section->PageSize() != Platform::GetPageSize() && (!largePages || section->PageSize() != Platform::GetLargePageSize()))
+            {
+                result.failure = "the section reports pages of " + std::to_string(section->PageSize()) + " bytes";
+            }
+            return result;
+        }
+    }
+
+    void RegisterKernelBenchmarks(BenchmarkSuite& suite)
+    {
+        for (const Resolution& resolution : RESOLUTIONS)
+        {
+            // Fewer iterations for bigger frames, roughly the same duration for all the resolutions
+            uint64_t iterations = 2000 * (640 * 480) / (resolution.width * resolution.height);
+
+            suite.Add("observation_copy_" + ResolutionName(resolution), iterations, [resolution](uint64_t iterations)
+                {
+                    Data::BufferFormat format(resolution.width, resolution.height, 4);
+                    std::vector<uint8_t> source = MakeFrame(format);
+                    std::vector<uint8_t> destination(format.Size());
+                    double ns = MeasureNsPerOp(iterations, [&](uint64_t)
+                        {
+                            Observation::CopyFrame(destination.data(), source.data(), format);
+                            DoNotOptimize(destination.data());
+                        }
+                    );
+                    return BenchmarkResult{ "", "ns/frame", ns, false, iterations };
+                }
+            );
+
+            suite.Add("observation_bgrx_to_rgb_" + ResolutionName(resolution), iterations, [resolution](uint64_t iterations)
+                {
+                    Data::BufferFormat format(resolution.width, resolution.height, 4);
+                    std::vector<uint8_t> source = MakeFrame(format);
+                    std::vector<uint8_t> destination(static_cast<size_t>(format.width) * format.height * 3);
+                    double ns = MeasureNsPerOp(iterations, [&](uint64_t)
+                        {
+                            Observation::ConvertBGRXToRGB(destination.data(), source.data(), format);
+                            DoNotOptimize(destination.data());
+                        }
+                    );
+                    return BenchmarkResult{ "", "ns/frame", ns, false, iterations };
+                }
+            );
+
+            suite.Add("observation_checksum_" + ResolutionName(resolution), iterations, [resolution](uint64_t iterations)
+                {
+                    Data::BufferFormat format(resolution.width, resolution.height, 4);
+                    std::vector<uint8_t> source = MakeFrame(format);
+                    uint64_t checksum = 0;
+                    double ns = MeasureNsPerOp(iterations, [&](uint64_t)
+                        {
+                            checksum ^= Observation::Checksum(source.data(), source.size());
+                            DoNotOptimize(&checksum);
+                        }
+                    );
+                    return BenchmarkResult{ "", "ns/frame", ns, false, iterations };
+                }
+            );
+        }
+
+        // Large pages where the system allows them (transparent huge pages of the shared memory on linux), normal pages otherwise
+        for (bool largePages : { false, true })
+        {
+            suite.Add(std::string("section_copy_") + (largePages ? "large" : "normal") + "_pages", 200, [largePages](uint64_t iterations)
+                {
+                    return MeasureSectionCopy(largePages, iterations);
+                }
+            );
+        }
+    }
+}
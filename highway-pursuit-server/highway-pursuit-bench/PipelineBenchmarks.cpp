@@ -0,0 +1,164 @@
+#include "pch.h"
+#include "Benchmark.hpp"
+#include "BenchClient.hpp"
+
+namespace HighwayPursuitBench
+{
+    namespace
+    {
+        constexpr uint32_t WIDTH = 160;
+        constexpr uint32_t HEIGHT = 120;
+        constexpr uint32_t REMOVED_POWERUPS = 3;
+        constexpr float REWARD_SCALE = 1.0f / 500.0f;
+        constexpr uint32_t NO_REWARD_TIMEOUT = 8;
+        constexpr uint32_t LIVES_PER_GAME = 3;
+
+        // The standard wrapper stack
+        Data::PipelineConfig StandardPipeline()
+        {
+            Data::PipelineConfig config;
+            config.version = Data::PipelineConfig::VERSION;
+            config.actionTransform = Data::ActionTransform::DISCRETE;
+            config.removedActions = REMOVED_POWERUPS;
+            config.rewardScale = REWARD_SCALE;
+            config.noRewardTimeout = NO_REWARD_TIMEOUT;
+            config.livesPerGame = LIVES_PER_GAME;
+            config.observationTransform = Data::ObservationTransform::RGB_DOWNSAMPLE;
+            return config;
+        }
+
+        // Discrete actions of the stack: the noop most of the time and braking often, so that the player stops and the timeout expires
+        uint32_t NextDiscreteAction(uint64_t& rng)
+        {
+            rng = rng * 6364136223846793005ull + 1442695040888963407ull;
+            uint32_t draw = static_cast<uint32_t>(rng >> 33) % 10;
+            if (draw < 4)
+            {
+                return 0;
+            }
+            if (draw < 6)
+            {
+                return 1 + static_cast<uint32_t>(Data::Input::Brake);
+            }
+            return draw - 5; // Accelerate to Fire
+        }
+
+        // RGBDownsampleWrapper on the frame the python client reads (first 3 channels)
+        bool MatchesDownsample(const uint8_t* frame, uint32_t channels, const uint8_t* observation)
+        {
+            uint32_t outWidth = (WIDTH + 2) / 3;
+            for (uint32_t y = 0; y < HEIGHT; ++y)
+            {
+                for (uint32_t x = 0; x < outWidth; ++x)
+                {
+                    for (uint32_t c = 0; c < 3; ++c)
+                    {
+                        uint32_t column = 3 * x + c;
+                        uint8_t expected = column < WIDTH ? frame[(static_cast<size_t>(y) * WIDTH + column) * channels + c] : 0;
+                        if (observation[(static_cast<size_t>(y) * outWidth + x) * 3 + c] != expected)
+                        {
+                            return false;
+                        }
+                    }
+                }
+            }
+            return true;
+        }
+    }
+
+    void RegisterPipelineBenchmarks(BenchmarkSuite& suite)
+    {
+        // A server running the standard stack returns what the wrappers return on top of a plain server with the same seed
+        suite.AddCheck("pipeline_matches_wrappers", 2000, [](uint64_t iterations)
+            {
+                BenchClient plain(4, WIDTH, HEIGHT);
+                BenchClient native(4, WIDTH, HEIGHT, 0, Data::ActionEncoding::BITMASK, BenchRecording(), Data::ServerParams::AffinityParams(0, 0),
+                    Data::ServerParams::EpisodeParams(false), Data::ServerParams::ActionParams(0.0f, 0), StandardPipeline());
+                plain.Connect();
+                native.Connect();
+
+                BenchmarkResult result{ "", "ns/op", 0.0, false, iterations };
+                const Data::ServerInfo& info = native.ServerInfo();
+                if (info.actionCount != Data::HighwayPursuitConstants::ACTION_COUNT - REMOVED_POWERUPS + 1 || info.obsWidth != (WIDTH + 2) / 3 || info.obsChannels != 3)
+                {
+                    result.failure = "the server info doesn't describe the transformed env";
+                    return result;
+                }
+
+                // State of the wrappers, the first reset uses a life
+                uint32_t livesLeft = LIVES_PER_GAME - 1;
+                uint32_t stepsWithoutReward = 0;
+                uint64_t truncations = 0;
+                uint64_t newGames = 0;
+                plain.Reset(true);
+                native.Reset(false);
+
+                uint64_t rng = 7;
+                auto start = std::chrono::steady_clock::now();
+                for (uint64_t i = 0; i < iterations && result.failure.empty(); ++i)
+                {
+                    uint32_t action = NextDiscreteAction(rng);
+                    Data::Termination plainTermination = plain.Step(action == 0 ? 0 : 1u << (action - 1));
+                    Data::Termination nativeTermination = native.Step(action);
+
+                    stepsWithoutReward = plain.LastReward() != 0.0f ? 0 : stepsWithoutReward + 1;
+                    bool truncated = stepsWithoutReward > NO_REWARD_TIMEOUT;
+                    if (native.LastReward() != plain.LastReward() * REWARD_SCALE || nativeTermination.terminated != plainTermination.terminated
+                        || (nativeTermination.truncated != 0) != truncated)
+                    {
+                        result.failure = "the reward or termination diverged at step " + std::to_string(i);
+                    }
+                    else if (!MatchesDownsample(plain.Observation(), plain.ServerInfo().obsChannels, native.Observation()))
+                    {
+                        result.failure = "the observation diverged at step " + std::to_string(i);
+                    }
+                    else if (nativeTermination.IsDone())
+                    {
+                        truncations += truncated ? 1 : 0;
+                        bool newGame = livesLeft == 0;
+                        livesLeft = newGame ? LIVES_PER_GAME - 1 : livesLeft - 1;
+                        newGames += newGame ? 1 : 0;
+                        stepsWithoutReward = 0;
+                        plain.Reset(newGame);
+                        native.Reset(false);
+                        if (!MatchesDownsample(plain.Observation(), plain.ServerInfo().obsChannels, native.Observation()))
+                        {
+                            result.failure = "the reset diverged after step " + std::to_string(i);
+                        }
+                    }
+                }
+                result.value = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / iterations;
+                plain.Close();
+                native.Close();
+                if (result.failure.empty() && (truncations == 0 || newGames == 0))
+                {
+                    result.failure = "no episode was truncated by the timeout or ended a game";
+                }
+                return result;
+            }
+        );
+
+        // Steps of the standard stack, transforms included
+        suite.Add("pipeline_steps_per_second", 20000, [](uint64_t iterations)
+            {
+                BenchClient client(1, WIDTH, HEIGHT, 0, Data::ActionEncoding::BITMASK, BenchRecording(), Data::ServerParams::AffinityParams(0, 0),
+                    Data::ServerParams::EpisodeParams(false), Data::ServerParams::ActionParams(0.0f, 0), StandardPipeline());
+                client.Connect();
+                client.Reset(false);
+
+                uint64_t rng = 11;
+                auto start = std::chrono::steady_clock::now();
+                for (uint64_t i = 0; i < iterations; ++i)
+                {
+                    if (client.Step(NextDiscreteAction(rng)).IsDone())
+                    {
+                        client.Reset(false);
+                    }
+                }
+                double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+                client.Close();
+                return BenchmarkResult{ "", "steps/s", iterations / seconds, true, iterations };
+            }
+        );
+    }
+}
@@ -0,0 +1,125 @@
+#include "pch.h"
+#include "Benchmark.hpp"
+#include "BenchClient.hpp"
+#include "Placement/CorePlacement.hpp"
+
+namespace HighwayPursuitBench
+{
+    namespace
+    {
+        constexpr uint32_t WIDTH = 160;
+        constexpr uint32_t HEIGHT = 120;
+
+        // Ping round trips of instances running at once, each client pinned on its own thread along with its server when pinned.
+        // The instances connect before any of them is timed.
+        BenchmarkResult MeasureHandoffLatency(uint32_t instanceCount, bool pinned, uint64_t iterations)
+        {
+            std::vector<double> ns(instanceCount, 0.0);
+            std::vector<std::string> failures(instanceCount);
+            std::mutex mutex;
+            std::condition_variable connectedCondition;
+            uint32_t connected = 0;
+
+            std::vector<std::thread> threads;
+            for (uint32_t instance = 0; instance < instanceCount; ++instance)
+            {
+                threads.emplace_back([&, instance]()
+                    {
+                        bool counted = false;
+                        try
+                        {
+                            Placement::CorePlacement placement = pinned ? Placement::AutoPlacement(instance, instanceCount) : Placement::CorePlacement{ 0, 0, 0 };
+                            if (placement.clientCores != 0 && (!Platform::SetCurrentThreadAffinity(placement.clientCores)
+                                || Platform::GetCurrentThreadAffinity() != placement.clientCores))
+                            {
+                                throw std::runtime_error("Failed to pin the client thread to the cores " + std::to_string(placement.clientCores));
+                            }
+
+                            BenchClient client(1, WIDTH, HEIGHT, 0, Data::ActionEncoding::BITMASK, BenchRecording(),
+                                Data::ServerParams::AffinityParams(placement.gameCores, placement.serverCores));
+                            client.Connect();
+                            client.Reset(true);
+                            {
+                                std::unique_lock<std::mutex> lock(mutex);
+                                connected++;
+                                counted = true;
+                                connectedCondition.notify_all();
+                                connectedCondition.wait(lock, [&]() { return connected == instanceCount; });
+                            }
+                            ns[instance] = MeasureNsPerOp(iterations, [&](uint64_t) { client.Ping(); });
+                            client.Close();
+                        }
+                        catch (const std::exception& e)
+                        {
+                            failures[instance] = e.what();
+                            // The others don't wait for a failed instance
+                            std::lock_guard<std::mutex> lock(mutex);
+                            if (!counted)
+                            {
+                                connected++;
+                                connectedCondition.notify_all();
+                            }
+                        }
+                    }
+                );
+            }
+            for (std::thread& thread : threads)
+            {
+                thread.join();
+            }
+
+            BenchmarkResult result{ "", "ns/op", 0.0, false, iterations };
+            for (uint32_t instance = 0; instance < instanceCount; ++instance)
+            {
+                result.value += ns[instance] / instanceCount;
+                if (result.failure.empty() && !failures[instance].empty())
+                {
+                    result.failure = "instance " + std::to_string(instance) + ": " + failures[instance];
+                }
+            }
+            return result;
+        }
+    }
+
+    void RegisterPlacementBenchmarks(BenchmarkSuite& suite)
+    {
+        // One instance per logical processor, more than that only measures the time slices of the scheduler
+        uint32_t instanceCount = std::max(2u, std::thread::hardware_concurrency());
+        for (bool pinned : { false, true })
+        {
+            std::string name = std::string("handoff_rtt_") + (pinned ? "pinned" : "unpinned") + "_x" + std::to_string(instanceCount);
+            suite.Add(name, 5000, [instanceCount, pinned](uint64_t iterations)
+                {
+                    return MeasureHandoffLatency(instanceCount, pinned, iterations);
+                }
+            );
+        }
+
+        // Instances get their own physical core while there are enough, and share them evenly after
+        suite.Add("auto_placement_layout", 1, [](uint64_t iterations)
+            {
+                std::vector<std::vector<uint32_t>> cores{ { 0, 4 }, { 1, 5 }, { 2, 6 }, { 3, 7 } };
+                auto start = std::chrono::steady_clock::now();
+                Placement::CorePlacement spread = Placement::AutoPlacement(1, 2, cores);
+                Placement::CorePlacement wrapped = Placement::AutoPlacement(5, 6, cores);
+                Placement::CorePlacement single = Placement::AutoPlacement(0, 1, { { 3 } });
+                double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / 3;
+
+                BenchmarkResult result{ "", "ns/op", ns, false, iterations };
+                if (spread.gameCores != (1u << 2) || spread.serverCores != (1u << 6) || spread.clientCores != spread.serverCores)
+                {
+                    result.failure = "2 instances on 4 cores aren't spread over every other core";
+                }
+                else if (wrapped.gameCores != (1u << 1) || wrapped.serverCores != (1u << 5))
+                {
+                    result.failure = "6 instances on 4 cores aren't placed round-robin";
+                }
+                else if (single.gameCores != (1u << 3) || single.serverCores != (1u << 3))
+                {
+                    result.failure = "Without SMT the threads of an instance don't share their core";
+                }
+                return result;
+            }
+        );
+    }
+}
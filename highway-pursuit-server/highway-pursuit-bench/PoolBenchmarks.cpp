@@ -0,0 +1,255 @@
+#include "pch.h"
+#include "Benchmark.hpp"
+#include "BenchClient.hpp"
+#include "Pool/WarmPool.hpp"
+#include "Supervision/Supervisor.hpp"
+#include <random>
+
+namespace HighwayPursuitBench
+{
+    namespace
+    {
+        constexpr uint32_t STARTUP_DELAY = 100; // in ms, stands in for the injection and the intro of the game
+        constexpr uint32_t START_TIMEOUT = 5000; // in ms
+        constexpr uint32_t ACQUIRE_TIMEOUT = 10000; // in ms
+
+        // Pool of highway-pursuit-standin processes, a non-zero exit code makes every start fail
+        Pool::WarmPoolParams StandInPool(uint32_t size, int exitCode = 0, uint64_t framesBeforeHanging = 0)
+        {
+            std::vector<std::string> command{ HP_STANDIN_PATH, Pool::WarmPoolParams::PREFIX_PLACEHOLDER, std::to_string(STARTUP_DELAY),
+                std::to_string(exitCode), std::to_string(framesBeforeHanging) };
+            return Pool::WarmPoolParams(size, command, "hp-bench-pool-" + std::to_string(std::random_device()()) + "-", START_TIMEOUT);
+        }
+
+        template <typename Predicate>
+        bool WaitFor(uint32_t timeoutMs, Predicate&& predicate)
+        {
+            auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+            while (!predicate())
+            {
+                if (std::chrono::steady_clock::now() > deadline)
+                {
+                    return false;
+                }
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+            return true;
+        }
+
+        double MsSince(std::chrono::steady_clock::time_point start)
+        {
+            return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        }
+
+        std::unique_ptr<Pool::ParkedInstance> AcquireInstance(Pool::WarmPool& pool)
+        {
+            std::unique_ptr<Pool::ParkedInstance> instance = pool.Acquire(ACQUIRE_TIMEOUT);
+            if (instance == nullptr)
+            {
+                throw std::runtime_error("No instance parked before the timeout");
+            }
+            return instance;
+        }
+
+        // Time to the first observation of an acquired instance, the client closes the server after
+        double TimeToFirstObservation(Pool::WarmPool& pool, std::chrono::steady_clock::time_point start)
+        {
+            BenchClient client(AcquireInstance(pool));
+            client.Connect();
+            client.Reset(true);
+            double ms = MsSince(start);
+            client.Step(1u);
+            client.Close();
+            return ms;
+        }
+    }
+
+    void RegisterPoolBenchmarks(BenchmarkSuite& suite)
+    {
+        // What a client waits without a pool: starting a server until its first observation
+        suite.Add("pool_cold_start", 5, [](uint64_t iterations)
+            {
+                double totalMs = 0.0;
+                for (uint64_t i = 0; i < iterations; ++i)
+                {
+                    auto start = std::chrono::steady_clock::now();
+                    Pool::WarmPool pool(StandInPool(1));
+                    totalMs += TimeToFirstObservation(pool, start);
+                }
+                return BenchmarkResult{ "", "ms", totalMs / iterations, false, iterations };
+            }
+        );
+
+        // Same with a parked instance, the startup delay of the servers mustn't show
+        suite.Add("pool_warm_start", 20, [](uint64_t iterations)
+            {
+                constexpr uint32_t POOL_SIZE = 2;
+                Pool::WarmPool pool(StandInPool(POOL_SIZE));
+                double totalMs = 0.0;
+                for (uint64_t i = 0; i < iterations; ++i)
+                {
+                    // Refilled in the background between the acquisitions
+                    if (!WaitFor(START_TIMEOUT, [&pool]() { return pool.ParkedCount() == POOL_SIZE; }))
+                    {
+                        BenchmarkResult result{ "", "ms", 0.0, false, iterations };
+                        result.failure = "The pool wasn't refilled before the timeout";
+                        return result;
+                    }
+                    totalMs += TimeToFirstObservation(pool, std::chrono::steady_clock::now());
+                }
+
+                BenchmarkResult result{ "", "ms", totalMs / iterations, false, iterations };
+                Pool::WarmPoolStats stats = pool.Stats();
+                if (stats.failed != 0 || stats.acquired != iterations)
+                {
+                    result.failure = std::to_string(stats.failed) + " failed start(s), " + std::to_string(stats.acquired) + " acquired instance(s)";
+                }
+                else if (result.value >= STARTUP_DELAY)
+                {
+                    result.failure = "Acquiring a parked instance took longer than starting one";
+                }
+                return result;
+            }
+        );
+
+        // Instances that exit before parking are counted as failed and never handed out
+        suite.Add("pool_failed_start_detection", 1, [](uint64_t iterations)
+            {
+                auto start = std::chrono::steady_clock::now();
+                Pool::WarmPool pool(StandInPool(1, 3));
+                bool detected = WaitFor(START_TIMEOUT, [&pool]() { return pool.Stats().failed > 0; });
+                BenchmarkResult result{ "", "ms", MsSince(start), false, iterations };
+                if (!detected)
+                {
+                    result.failure = "The failed start wasn't detected";
+                }
+                else if (pool.Acquire(10) != nullptr)
+                {
+                    result.failure = "A failed instance was acquired";
+                }
+                return result;
+            }
+        );
+
+        // A hung server is killed once it's busy without a heartbeat for the stall timeout, its client gets STALLED (truncating the
+        // episode) and fails over to a spare, while another client sharing the supervisor keeps stepping
+        suite.Add("supervisor_failover", 1, [](uint64_t iterations)
+            {
+                constexpr uint32_t STALL_TIMEOUT = 200; // in ms
+                constexpr uint64_t FRAMES_BEFORE_HANGING = 400;
+                Supervision::Supervisor supervisor{ Supervision::SupervisorParams(STALL_TIMEOUT) };
+                Pool::WarmPool spares(StandInPool(2));
+                Pool::WarmPool hanging(StandInPool(1, 0, FRAMES_BEFORE_HANGING));
+
+                BenchClient other(AcquireInstance(spares));
+                other.Connect();
+                other.Supervise(supervisor);
+                other.Reset(true);
+                std::atomic<bool> done(false);
+                double otherMaxStepMs = 0.0;
+                uint64_t otherSteps = 0;
+                std::string otherFailure;
+                std::thread otherThread([&]()
+                    {
+                        try
+                        {
+                            while (!done)
+                            {
+                                auto start = std::chrono::steady_clock::now();
+                                if (other.Step(1u).IsDone())
+                                {
+                                    other.Reset(false);
+                                }
+                                otherMaxStepMs = std::max(otherMaxStepMs, MsSince(start));
+                                otherSteps++;
+                            }
+                        }
+                        catch (const std::exception& e)
+                        {
+                            otherFailure = e.what();
+                        }
+                    }
+                );
+
+                BenchClient stalling(AcquireInstance(hanging));
+                stalling.Connect();
+                stalling.Supervise(supervisor);
+                stalling.Reset(true);
+                auto stepStart = std::chrono::steady_clock::now();
+                try
+                {
+                    while (true)
+                    {
+                        stepStart = std::chrono::steady_clock::now();
+                        if (stalling.Step(1u).IsDone())
+                        {
+                            stalling.Reset(false);
+                        }
+                    }
+                }
+                catch (const Data::HighwayPursuitException& e)
+                {
+                    if (e.code != Data::ErrorCode::STALLED)
+                    {
+                        throw;
+                    }
+                }
+                double detectionMs = MsSince(stepStart);
+
+                BenchClient replacement(AcquireInstance(spares));
+                replacement.Connect();
+                replacement.Supervise(supervisor);
+                replacement.Reset(true);
+                double failoverMs = MsSince(stepStart);
+                done = true;
+                otherThread.join();
+
+                BenchmarkResult result{ "", "ms", detectionMs, false, iterations };
+                if (!otherFailure.empty() || otherSteps == 0)
+                {
+                    result.failure = "The other client failed: " + otherFailure;
+                }
+                else if (detectionMs < STALL_TIMEOUT || detectionMs > 3 * STALL_TIMEOUT)
+                {
+                    result.failure = "Stall detected after " + std::to_string(detectionMs) + " ms";
+                }
+                else if (otherMaxStepMs >= STALL_TIMEOUT)
+                {
+                    result.failure = "The other client was stalled for " + std::to_string(otherMaxStepMs) + " ms";
+                }
+                else if (supervisor.StallCount() != 1 || !stalling.HasStalled())
+                {
+                    result.failure = std::to_string(supervisor.StallCount()) + " stall(s) detected";
+                }
+                else if (failoverMs - detectionMs >= STARTUP_DELAY)
+                {
+                    result.failure = "Failing over took longer than starting a server";
+                }
+                return result;
+            }
+        );
+
+        // Destroying a pool wakes its parked servers up so they exit, none is killed after the exit timeout
+        suite.Add("pool_discard_parked", 1, [](uint64_t iterations)
+            {
+                constexpr uint32_t POOL_SIZE = 4;
+                auto pool = std::make_unique<Pool::WarmPool>(StandInPool(POOL_SIZE));
+                if (!WaitFor(START_TIMEOUT, [&pool]() { return pool->ParkedCount() == POOL_SIZE; }))
+                {
+                    BenchmarkResult result{ "", "ms", 0.0, false, iterations };
+                    result.failure = "The pool wasn't filled before the timeout";
+                    return result;
+                }
+
+                auto start = std::chrono::steady_clock::now();
+                pool.reset();
+                BenchmarkResult result{ "", "ms", MsSince(start), false, iterations };
+                if (result.value >= Pool::ParkedInstance::EXIT_TIMEOUT)
+                {
+                    result.failure = "Parked servers didn't exit when discarded";
+                }
+                return result;
+            }
+        );
+    }
+}
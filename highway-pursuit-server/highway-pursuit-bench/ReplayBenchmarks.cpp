@@ -0,0 +1,126 @@
+#include "pch.h"
+#include "Benchmark.hpp"
+#include "BenchClient.hpp"
+#include "HighwayPursuitServer.hpp"
+#include "Replay/ActionLog.hpp"
+#include <cstdio>
+#include <filesystem>
+#include <random>
+
+namespace HighwayPursuitBench
+{
+    namespace
+    {
+        constexpr int FRAMESKIP = 4;
+        constexpr uint32_t WIDTH = 160;
+        constexpr uint32_t HEIGHT = 120;
+
+        std::string LogPath(const std::string& name)
+        {
+            return (std::filesystem::temp_directory_path() / ("hp-bench-" + name + "-" + std::to_string(std::random_device()()) + ".hpal")).string();
+        }
+
+        // Plays an episode mixing every recorded instruction kind, with sticky actions and repeat counts. Returns the number of instructions sent.
+        uint64_t RecordSession(const std::string& path, uint64_t steps)
+        {
+            std::mt19937 random(3);
+            BenchClient client(FRAMESKIP, WIDTH, HEIGHT, 0, Data::ActionEncoding::BITMASK, BenchRecording{ path, "", "" },
+                Data::ServerParams::AffinityParams(0, 0), Data::ServerParams::EpisodeParams(false), Data::ServerParams::ActionParams(0.25f, 7));
+            client.Connect();
+            client.Reset(true);
+            uint64_t instructions = 1;
+            for (uint64_t i = 0; i < steps; ++i)
+            {
+                if (i == steps / 4)
+                {
+                    client.Snapshot(1);
+                    instructions++;
+                }
+                if (client.Step(random() & 0xFFu, random() % 6).IsDone())
+                {
+                    client.Reset(false);
+                    instructions++;
+                }
+                if (i == steps / 2)
+                {
+                    client.Restore(1);
+                    instructions++;
+                }
+                instructions++;
+            }
+            client.Close();
+            return instructions + 1;
+        }
+
+        Replay::ReplayReport ReplaySession(const std::string& path)
+        {
+            Data::ServerParams params(true, FRAMESKIP, ServerParams::RenderParams(WIDTH, HEIGHT, true), ServerParams::TraceParams(false, 0, "."),
+                "hp-bench-replay-", ServerParams::ReplayParams("", path));
+            HighwayPursuitServer server(params, std::make_unique<Synthetic::SyntheticGame>(Synthetic::SyntheticGameParams(WIDTH, HEIGHT, 42, 0)));
+            server.Run();
+            return server.LastReplayReport();
+        }
+
+        void CorruptChecksum(const std::string& path, uint64_t record)
+        {
+            std::fstream file(path, std::ios::binary | std::ios::in | std::ios::out);
+            std::streamoff offset = sizeof(Replay::ActionLogHeader) + record * sizeof(Replay::ActionLogRecord) + offsetof(Replay::ActionLogRecord, observationChecksum);
+            uint64_t checksum = 0;
+            file.seekg(offset);
+            file.read(reinterpret_cast<char*>(&checksum), sizeof(checksum));
+            checksum ^= 1;
+            file.seekp(offset);
+            file.write(reinterpret_cast<const char*>(&checksum), sizeof(checksum));
+        }
+    }
+
+    void RegisterReplayBenchmarks(BenchmarkSuite& suite)
+    {
+        // A recorded session replays without divergence, without a client and with the real-time option ignored.
+        // The sticky actions are drawn again from the seed of the log.
+        suite.Add("replay_steps_per_second", 5000, [](uint64_t iterations)
+            {
+                std::string path = LogPath("replay");
+                uint64_t instructions = RecordSession(path, iterations);
+
+                auto start = std::chrono::steady_clock::now();
+                Replay::ReplayReport report = ReplaySession(path);
+                double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+                std::remove(path.c_str());
+
+                std::string failure;
+                if (report.diverged)
+                {
+                    failure = report.ToString();
+                }
+                else if (report.replayedRecords != instructions)
+                {
+                    failure = "replayed " + std::to_string(report.replayedRecords) + " instructions, " + std::to_string(instructions) + " were recorded";
+                }
+                return BenchmarkResult{ "", "steps/s", iterations / seconds, true, iterations, failure };
+            }
+        );
+
+        // A corrupted observation checksum is reported at its record
+        suite.Add("replay_detects_divergence", 1000, [](uint64_t iterations)
+            {
+                std::string path = LogPath("divergence");
+                uint64_t instructions = RecordSession(path, iterations);
+                uint64_t corruptedRecord = instructions / 3;
+                CorruptChecksum(path, corruptedRecord);
+
+                auto start = std::chrono::steady_clock::now();
+                Replay::ReplayReport report = ReplaySession(path);
+                double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+                std::remove(path.c_str());
+
+                std::string failure;
+                if (!report.diverged || report.divergentRecord != corruptedRecord || report.expectedFrame != report.actualFrame)
+                {
+                    failure = "expected a checksum divergence at instruction " + std::to_string(corruptedRecord) + ": " + report.ToString();
+                }
+                return BenchmarkResult{ "", "ms", ms, false, iterations, failure };
+            }
+        );
+    }
+}
@@ -0,0 +1,169 @@
+#include "pch.h"
+#include "Benchmark.hpp"
+#include "BenchClient.hpp"
+#include "ReplayBuffer/SharedReplayBuffer.hpp"
+#include <random>
+
+namespace HighwayPursuitBench
+{
+    namespace
+    {
+        using ReplayBuffer::SharedReplayBuffer;
+
+        std::string BufferName(const std::string& name)
+        {
+            return "hp-bench-" + name + "-" + std::to_string(std::random_device()());
+        }
+
+        // Observations of the concurrency check: every 32 bits word holds the writer and its transition counter
+        uint32_t Pattern(uint32_t writer, uint32_t counter)
+        {
+            return (writer << 24) | (counter & 0xFFFFFFu);
+        }
+
+        void FillPattern(std::vector<uint32_t>& observation, uint32_t writer, uint32_t counter)
+        {
+            std::fill(observation.begin(), observation.end(), Pattern(writer, counter));
+        }
+
+        bool HasPattern(const std::vector<uint32_t>& observation, uint32_t writer, uint32_t counter)
+        {
+            uint32_t expected = Pattern(writer, counter);
+            return std::all_of(observation.begin(), observation.end(), [expected](uint32_t word) { return word == expected; });
+        }
+    }
+
+    void RegisterReplayBufferBenchmarks(BenchmarkSuite& suite)
+    {
+        // One writer appending 160x120 observations
+        suite.Add("replay_buffer_append", 20000, [](uint64_t iterations)
+            {
+                constexpr uint32_t OBSERVATION_SIZE = 160 * 120 * 4;
+                std::unique_ptr<SharedReplayBuffer> buffer = SharedReplayBuffer::Create(BufferName("append"), 1024, OBSERVATION_SIZE);
+                std::vector<uint8_t> observation(OBSERVATION_SIZE, 0x7F);
+                uint64_t ticket = SharedReplayBuffer::NO_TICKET;
+
+                // The first lap measures page faults
+                for (uint32_t i = 0; i < buffer->Capacity(); ++i)
+                {
+                    ticket = buffer->Append(Trajectory::TransitionKind::STEP, observation.data(), i, 0.0f, Data::Termination(false, false), ticket);
+                }
+                double ns = MeasureNsPerOp(iterations, [&](uint64_t i)
+                    {
+                        ticket = buffer->Append(Trajectory::TransitionKind::STEP, observation.data(), static_cast<uint32_t>(i), 0.0f, Data::Termination(false, false), ticket);
+                    }
+                );
+                return BenchmarkResult{ "", "ns/op", ns, false, iterations };
+            }
+        );
+
+        // Writers lapping a small ring while a reader samples steps: no torn or mismatched step may be read
+        suite.Add("replay_buffer_concurrent_sample", 200000, [](uint64_t iterations)
+            {
+                constexpr uint32_t WRITERS = 4;
+                constexpr uint32_t OBSERVATION_WORDS = 1024;
+                std::unique_ptr<SharedReplayBuffer> buffer = SharedReplayBuffer::Create(BufferName("concurrent"), 64, OBSERVATION_WORDS * sizeof(uint32_t));
+
+                std::atomic<bool> stop(false);
+                std::vector<std::thread> writers;
+                for (uint32_t writer = 1; writer <= WRITERS; ++writer)
+                {
+                    writers.emplace_back([&buffer, &stop, writer]()
+                        {
+                            std::vector<uint32_t> observation(OBSERVATION_WORDS);
+                            uint64_t ticket = SharedReplayBuffer::NO_TICKET;
+                            for (uint32_t counter = 0; !stop.load(std::memory_order_relaxed); ++counter)
+                            {
+                                FillPattern(observation, writer, counter);
+                                Trajectory::TransitionKind kind = counter == 0 ? Trajectory::TransitionKind::RESET : Trajectory::TransitionKind::STEP;
+                                ticket = buffer->Append(kind, observation.data(), counter, static_cast<float>(writer), Data::Termination(false, false), ticket);
+                            }
+                        }
+                    );
+                }
+
+                // Sampling starts once the ring went around
+                while (buffer->NextTicket() < 2 * buffer->Capacity())
+                {
+                    std::this_thread::yield();
+                }
+
+                std::vector<uint32_t> observation(OBSERVATION_WORDS);
+                std::vector<uint32_t> nextObservation(OBSERVATION_WORDS);
+                std::mt19937_64 random(13);
+                uint64_t sampled = 0;
+                std::string failure;
+                auto start = std::chrono::steady_clock::now();
+                for (uint64_t i = 0; i < iterations; ++i)
+                {
+                    uint64_t end = buffer->NextTicket();
+                    uint64_t begin = end - buffer->Capacity();
+                    ReplayBuffer::ReplayTransition transition;
+                    uint64_t ticket = begin + random() % (end - begin);
+                    if (!buffer->TryReadStep(ticket, transition, reinterpret_cast<uint8_t*>(observation.data()), reinterpret_cast<uint8_t*>(nextObservation.data())))
+                    {
+                        continue;
+                    }
+
+                    sampled++;
+                    uint32_t writer = static_cast<uint32_t>(transition.reward);
+                    if (failure.empty() && (!HasPattern(nextObservation, writer, transition.actionMask) || !HasPattern(observation, writer, transition.actionMask - 1)))
+                    {
+                        failure = "sampled an inconsistent step at ticket " + std::to_string(ticket);
+                    }
+                }
+                double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+                stop = true;
+                for (std::thread& writer : writers)
+                {
+                    writer.join();
+                }
+                if (failure.empty() && sampled == 0)
+                {
+                    failure = "no step could be sampled";
+                }
+                return BenchmarkResult{ "", "samples/s", sampled / seconds, true, iterations, failure };
+            }
+        );
+
+        // Server appending its steps, the learner reads back the last one as the client received it
+        suite.Add("replay_buffer_server_steps", 5000, [](uint64_t iterations)
+            {
+                constexpr uint32_t WIDTH = 160;
+                constexpr uint32_t HEIGHT = 120;
+                std::string name = BufferName("server");
+                std::unique_ptr<SharedReplayBuffer> buffer = SharedReplayBuffer::Create(name, 256, WIDTH * HEIGHT * 4);
+
+                BenchClient client(4, WIDTH, HEIGHT, 0, Data::ActionEncoding::BITMASK, BenchRecording{ "", "", name });
+                client.Connect();
+                client.Reset(true);
+                const uint32_t actions = 1u << static_cast<uint32_t>(Data::Input::Accelerate);
+
+                std::string failure;
+                std::vector<uint8_t> observation(buffer->ObservationSize());
+                std::vector<uint8_t> nextObservation(buffer->ObservationSize());
+                auto start = std::chrono::steady_clock::now();
+                for (uint64_t i = 0; i < iterations; ++i)
+                {
+                    if (client.Step(actions).IsDone())
+                    {
+                        client.Reset(false);
+                        continue;
+                    }
+
+                    ReplayBuffer::ReplayTransition transition;
+                    if (failure.empty() && (!buffer->TryReadStep(buffer->NextTicket() - 1, transition, observation.data(), nextObservation.data())
+                        || transition.actionMask != actions || transition.reward != client.LastReward()
+                        || std::memcmp(nextObservation.data(), client.Observation(), nextObservation.size()) != 0))
+                    {
+                        failure = "step " + std::to_string(i) + " differs from what the client received";
+                    }
+                }
+                double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+                client.Close();
+                return BenchmarkResult{ "", "steps/s", iterations / seconds, true, iterations, failure };
+            }
+        );
+    }
+}
@@ -0,0 +1,54 @@
+#include "Agents/AgentPlugin.h"
+#include "SampleAgent.hpp"
+#include <new>
+#include <string>
+
+// Agent plugin run by the benchmarks. Its config is either empty or "refuse", which makes create fail.
+namespace
+{
+    struct SampleAgent
+    {
+        HighwayPursuitBench::SampleAgentPolicy policy;
+        uint64_t episodes;
+        double episodeReturn;
+    };
+
+    void* Create(const HpAgentSpec* spec, const char* config)
+    {
+        if (std::string(config) == "refuse" || spec->actionCount < 4)
+        {
+            return nullptr;
+        }
+        size_t observationSize = static_cast<size_t>(spec->obsWidth) * spec->obsHeight * spec->obsChannels;
+        return new (std::nothrow) SampleAgent{ HighwayPursuitBench::SampleAgentPolicy(observationSize, spec->seed), 0, 0.0 };
+    }
+
+    void Destroy(void* agent)
+    {
+        delete static_cast<SampleAgent*>(agent);
+    }
+
+    void Reset(void* agent, const uint8_t*)
+    {
+        SampleAgent* sample = static_cast<SampleAgent*>(agent);
+        sample->episodes++;
+        sample->episodeReturn = 0.0;
+    }
+
+    uint32_t Act(void* agent, const uint8_t* observation)
+    {
+        return static_cast<SampleAgent*>(agent)->policy.Act(observation);
+    }
+
+    void Feedback(void* agent, const HpAgentFeedback* feedback)
+    {
+        static_cast<SampleAgent*>(agent)->episodeReturn += feedback->reward;
+    }
+
+    const HpAgentApi API = { HP_AGENT_ABI_VERSION, Create, Destroy, Reset, Act, Feedback };
+}
+
+extern "C" HP_AGENT_EXPORT const HpAgentApi* hp_agent_api(void)
+{
+    return &API;
+}
@@ -0,0 +1,44 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+namespace HighwayPursuitBench
+{
+    // Policy of the sample agent plugin, also run by the benchmarks through a client to compare the two.
+    // Always accelerates (so that it crashes into the obstacles) and steers on a hash of the observation.
+    class SampleAgentPolicy
+    {
+    public:
+        static constexpr uint32_t ACCELERATE = 1u << 0;
+        static constexpr uint32_t STEER_LEFT = 1u << 2;
+        static constexpr uint32_t STEER_RIGHT = 1u << 3;
+        static constexpr size_t STRIDE = 61; // bytes hashed, prime so that every channel is sampled
+
+        SampleAgentPolicy(size_t observationSize, uint64_t seed) : _observationSize(observationSize), _seed(seed)
+        {
+        }
+
+        uint32_t Act(const uint8_t* observation) const
+        {
+            // FNV-1a over a sample of the pixels
+            uint64_t hash = 1469598103934665603ull ^ _seed;
+            for (size_t i = 0; i < _observationSize; i += STRIDE)
+            {
+                hash = (hash ^ observation[i]) * 1099511628211ull;
+            }
+            switch (hash % 3)
+            {
+            case 0:
+                return ACCELERATE | STEER_LEFT;
+            case 1:
+                return ACCELERATE | STEER_RIGHT;
+            default:
+                return ACCELERATE;
+            }
+        }
+
+    private:
+        size_t _observationSize;
+        uint64_t _seed;
+    };
+}
@@ -0,0 +1,446 @@
+#include "pch.h"
+#include "Benchmark.hpp"
+#include "BenchClient.hpp"
+#include "AllocationCounter.hpp"
+#include "Observation/ObservationKernels.hpp"
+
+namespace HighwayPursuitBench
+{
+    namespace
+    {
+        constexpr uint32_t WIDTH = 160;
+        constexpr uint32_t HEIGHT = 120;
+        constexpr uint64_t WARMUP_STEPS = 200;
+
+        // Accelerate and fire, keeps the episodes going for a while
+        const uint32_t STEP_ACTIONS = (1u << static_cast<uint32_t>(Data::Input::Accelerate)) | (1u << static_cast<uint32_t>(Data::Input::Fire));
+
+        void StepOrReset(BenchClient& client)
+        {
+            if (client.Step(STEP_ACTIONS).IsDone())
+            {
+                client.Reset(false);
+            }
+        }
+
+        // Accelerate without firing, the player crashes into the obstacles
+        const uint32_t CRASH_ACTIONS = 1u << static_cast<uint32_t>(Data::Input::Accelerate);
+
+        // Steps of episodes that keep ending, resets included: the client resets them or the server does (auto-reset)
+        BenchmarkResult MeasureEpisodeThroughput(bool autoReset, uint64_t iterations)
+        {
+            BenchClient client(4, WIDTH, HEIGHT, 0, Data::ActionEncoding::BITMASK, BenchRecording(),
+                Data::ServerParams::AffinityParams(0, 0), Data::ServerParams::EpisodeParams(autoReset));
+            client.Connect();
+            client.Reset(true);
+
+            uint64_t episodes = 0;
+            auto start = std::chrono::steady_clock::now();
+            for (uint64_t i = 0; i < iterations; ++i)
+            {
+                if (client.Step(CRASH_ACTIONS).IsDone())
+                {
+                    episodes++;
+                    if (!autoReset)
+                    {
+                        client.Reset(false);
+                    }
+                }
+            }
+            double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            client.Close();
+
+            BenchmarkResult result{ "", "steps/s", iterations / seconds, true, iterations };
+            if (episodes == 0)
+            {
+                result.failure = "no episode ended";
+            }
+            return result;
+        }
+
+        BenchmarkResult MeasureStepThroughput(int frameskip, uint64_t iterations, Data::ActionEncoding actionEncoding = Data::ActionEncoding::BITMASK)
+        {
+            BenchClient client(frameskip, WIDTH, HEIGHT, 0, actionEncoding);
+            client.Connect();
+            client.Reset(true);
+            for (uint64_t i = 0; i < WARMUP_STEPS; ++i)
+            {
+                StepOrReset(client);
+            }
+
+            // Only the steps are timed, resets of terminated episodes are excluded
+            std::chrono::steady_clock::duration stepTime(0);
+            for (uint64_t i = 0; i < iterations; ++i)
+            {
+                auto start = std::chrono::steady_clock::now();
+                Data::Termination termination = client.Step(STEP_ACTIONS);
+                stepTime += std::chrono::steady_clock::now() - start;
+                if (termination.IsDone())
+                {
+                    client.Reset(false);
+                }
+            }
+            client.Close();
+
+            double seconds = std::chrono::duration<double>(stepTime).count();
+            return BenchmarkResult{ "", "steps/s", iterations / seconds, true, iterations };
+        }
+    }
+
+    void RegisterServerBenchmarks(BenchmarkSuite& suite)
+    {
+        // Round trip of an instruction that does no work: semaphore handoff + shared memory
+        suite.Add("handshake_rtt", 20000, [](uint64_t iterations)
+            {
+                BenchClient client(1, WIDTH, HEIGHT);
+                client.Connect();
+                client.Reset(true);
+                double ns = MeasureNsPerOp(iterations, [&](uint64_t) { client.Ping(); });
+                client.Close();
+                return BenchmarkResult{ "", "ns/op", ns, false, iterations };
+            }
+        );
+
+        for (int frameskip : { 1, 4, 8 })
+        {
+            suite.Add("step_frameskip_" + std::to_string(frameskip), 20000, [frameskip](uint64_t iterations)
+                {
+                    return MeasureStepThroughput(frameskip, iterations);
+                }
+            );
+        }
+
+        // Legacy clients (one byte per action) still work
+        suite.Add("step_frameskip_4_byte_actions", 20000, [](uint64_t iterations)
+            {
+                return MeasureStepThroughput(4, iterations, Data::ActionEncoding::BYTE_PER_ACTION);
+            }
+        );
+
+        // Steady state steps (resets of terminated episodes included) must not allocate, in the server or the client
+        suite.Add("step_allocations", 20000, [](uint64_t iterations)
+            {
+                BenchClient client(4, WIDTH, HEIGHT);
+                client.Connect();
+                client.Reset(true);
+                for (uint64_t i = 0; i < WARMUP_STEPS; ++i)
+                {
+                    StepOrReset(client);
+                }
+
+                uint64_t allocationsBefore = AllocationCount();
+                for (uint64_t i = 0; i < iterations; ++i)
+                {
+                    StepOrReset(client);
+                }
+                uint64_t allocations = AllocationCount() - allocationsBefore;
+                client.Close();
+
+                BenchmarkResult result{ "", "allocs/step", static_cast<double>(allocations) / iterations, false, iterations };
+                if (allocations > 0)
+                {
+                    result.failure = std::to_string(allocations) + " allocations in " + std::to_string(iterations) + " steps";
+                }
+                return result;
+            }
+        );
+
+        for (bool autoReset : { false, true })
+        {
+            suite.Add(std::string("episode_steps_per_second_") + (autoReset ? "auto_reset" : "explicit_reset"), 20000, [autoReset](uint64_t iterations)
+                {
+                    return MeasureEpisodeThroughput(autoReset, iterations);
+                }
+            );
+        }
+
+        // Same seed and actions: the auto-reset step returns the terminal reward and termination with the observation of the explicit reset,
+        // and keeps the terminal observation of the explicit step
+        suite.AddCheck("auto_reset_matches_explicit", 2000, [](uint64_t iterations)
+            {
+                BenchClient explicitClient(1, WIDTH, HEIGHT);
+                BenchClient autoClient(1, WIDTH, HEIGHT, 0, Data::ActionEncoding::BITMASK, BenchRecording(),
+                    Data::ServerParams::AffinityParams(0, 0), Data::ServerParams::EpisodeParams(true));
+                explicitClient.Connect();
+                autoClient.Connect();
+                explicitClient.Reset(true);
+                autoClient.Reset(true);
+                size_t observationSize = static_cast<size_t>(WIDTH) * HEIGHT * explicitClient.ServerInfo().obsChannels;
+
+                uint64_t episodes = 0;
+                BenchmarkResult result = MeasureCheck(iterations, [&](uint64_t i) -> std::string
+                    {
+                        Data::Termination explicitTermination = explicitClient.Step(CRASH_ACTIONS);
+                        Data::Termination autoTermination = autoClient.Step(CRASH_ACTIONS);
+                        if (explicitTermination.IsDone() != autoTermination.IsDone() || explicitClient.LastReward() != autoClient.LastReward())
+                        {
+                            return "the reward or termination diverged at step " + std::to_string(i);
+                        }
+                        if (!explicitTermination.IsDone())
+                        {
+                            bool same = Observation::Checksum(explicitClient.Observation(), observationSize) == Observation::Checksum(autoClient.Observation(), observationSize);
+                            return same ? "" : "the observation diverged at step " + std::to_string(i);
+                        }
+
+                        episodes++;
+                        uint64_t terminalChecksum = Observation::Checksum(explicitClient.Observation(), observationSize);
+                        explicitClient.Reset(false);
+                        if (terminalChecksum != Observation::Checksum(autoClient.FinalObservation(), observationSize))
+                        {
+                            return "the final observation of the episode ending at step " + std::to_string(i) + " wasn't kept";
+                        }
+                        if (Observation::Checksum(explicitClient.Observation(), observationSize) != Observation::Checksum(autoClient.Observation(), observationSize))
+                        {
+                            return "the first observation of the episode after step " + std::to_string(i) + " differs from an explicit reset";
+                        }
+                        return "";
+                    }
+                );
+                explicitClient.Close();
+                autoClient.Close();
+                if (result.failure.empty() && episodes == 0)
+                {
+                    result.failure = "no episode ended";
+                }
+                return result;
+            }
+        );
+
+        // The records of the server match the returns and lengths the client accumulates, every third episode starts a new game.
+        // The step ending an episode stops at the frame of the crash.
+        suite.AddCheck("episode_stats_match_client", 20000, [](uint64_t iterations)
+            {
+                BenchClient client(4, WIDTH, HEIGHT);
+                client.Connect();
+                client.Reset(true);
+
+                float episodeReturn = 0.0f;
+                uint32_t steps = 0;
+                uint64_t episodes = 0;
+                BenchmarkResult result = MeasureCheck(iterations, [&](uint64_t i) -> std::string
+                    {
+                        Data::Termination termination = client.Step(CRASH_ACTIONS);
+                        episodeReturn += client.LastReward();
+                        steps++;
+                        const Data::EpisodeStats& stats = client.EpisodeStats();
+                        if (stats.finishedCount != episodes + (termination.IsDone() ? 1 : 0))
+                        {
+                            return "the server counted " + std::to_string(stats.finishedCount) + " episodes at step " + std::to_string(i);
+                        }
+                        if (!termination.IsDone())
+                        {
+                            return "";
+                        }
+
+                        const Data::EpisodeRecord& record = stats.records[episodes % Data::EpisodeStats::RING_SIZE];
+                        episodes++;
+                        if (record.index != episodes || record.steps != steps || record.episodeReturn != episodeReturn
+                            || record.frames > 4ull * steps || record.frames <= 4ull * (steps - 1) || record.life != (episodes - 1) % 3 + 1 || record.terminated != termination.terminated)
+                        {
+                            return "the record of episode " + std::to_string(episodes) + " doesn't match the client";
+                        }
+                        episodeReturn = 0.0f;
+                        steps = 0;
+                        client.Reset(episodes % 3 == 0);
+                        return "";
+                    }
+                );
+                client.Close();
+                if (result.failure.empty() && episodes <= Data::EpisodeStats::RING_SIZE)
+                {
+                    result.failure = "the ring didn't wrap, only " + std::to_string(episodes) + " episodes ended";
+                }
+                return result;
+            }
+        );
+
+        // The metrics block follows the counters of the client and the info, read by name through the schema
+        suite.AddCheck("metrics_match_info", 4000, [](uint64_t iterations)
+            {
+                BenchClient client(4, WIDTH, HEIGHT);
+                client.Connect();
+                client.Reset(true);
+
+                uint64_t steps = 0;
+                uint64_t resets = 1;
+                double readNs = 0.0;
+                BenchmarkResult result = MeasureCheck(iterations, [&](uint64_t i) -> std::string
+                    {
+                        steps++;
+                        if (client.Step(CRASH_ACTIONS).IsDone())
+                        {
+                            client.Reset(false);
+                            resets++;
+                        }
+
+                        auto start = std::chrono::steady_clock::now();
+                        uint64_t metricSteps = client.MetricU64("steps");
+                        uint64_t metricResets = client.MetricU64("resets");
+                        uint64_t metricFrames = client.MetricU64("frames");
+                        uint64_t metricEpisodes = client.MetricU64("episodes");
+                        readNs += std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+                        if (metricSteps != steps || metricResets != resets || metricEpisodes != resets - 1 || metricFrames > 4 * steps || metricFrames < steps)
+                        {
+                            return "the counters diverged from the client at step " + std::to_string(i);
+                        }
+                        if (std::abs(client.MetricF64("server_time") - client.LastInfo().serverTime) > 1e-3)
+                        {
+                            return "the server time diverged from the info at step " + std::to_string(i);
+                        }
+                        return "";
+                    }
+                );
+                // Only the reads are measured
+                result.value = readNs / iterations;
+                client.Close();
+                return result;
+            }
+        );
+
+        // Frames of more than a large page: the server reports the pages of its view of the observations, the same as the client's on this system
+        suite.AddCheck("observation_page_size", 500, [](uint64_t iterations)
+            {
+                BenchClient client(1, 1024, 768);
+                client.Connect();
+                client.Reset(true);
+                BenchmarkResult result = MeasureCheck(iterations, [&](uint64_t) -> std::string
+                    {
+                        if (client.Step(CRASH_ACTIONS).IsDone())
+                        {
+                            client.Reset(false);
+                        }
+                        return "";
+                    }
+                );
+
+                size_t pageSize = client.ServerObservationPageSize();
+                if (pageSize != Platform::GetPageSize() && pageSize != Platform::GetLargePageSize())
+                {
+                    result.failure = "the server reported pages of " + std::to_string(pageSize) + " bytes";
+                }
+                else if (pageSize != client.ObservationPageSize())
+                {
+                    result.failure = "the server and the client views have pages of " + std::to_string(pageSize) + " and "
+                        + std::to_string(client.ObservationPageSize()) + " bytes";
+                }
+                client.Close();
+                return result;
+            }
+        );
+
+        // Same seed, same sticky actions: the observations only depend on the seed
+        suite.AddCheck("sticky_actions_reproducible", 2000, [](uint64_t iterations)
+            {
+                auto makeClient = [](uint64_t seed)
+                    {
+                        return std::make_unique<BenchClient>(1, WIDTH, HEIGHT, 0, Data::ActionEncoding::BITMASK, BenchRecording(),
+                            Data::ServerParams::AffinityParams(0, 0), Data::ServerParams::EpisodeParams(false), Data::ServerParams::ActionParams(0.5f, seed));
+                    };
+                std::unique_ptr<BenchClient> clients[] = { makeClient(11), makeClient(11), makeClient(12) };
+                for (std::unique_ptr<BenchClient>& client : clients)
+                {
+                    client->Connect();
+                    client->Reset(true);
+                }
+                size_t observationSize = static_cast<size_t>(WIDTH) * HEIGHT * clients[0]->ServerInfo().obsChannels;
+
+                bool seedsDiverged = false;
+                BenchmarkResult result = MeasureCheck(iterations, [&](uint64_t i) -> std::string
+                    {
+                        // Alternating actions, a kept action shows in the observations
+                        uint32_t actionMask = 1u << static_cast<uint32_t>(i % 2 == 0 ? Data::Input::SteerL : Data::Input::SteerR);
+                        bool done = false;
+                        for (std::unique_ptr<BenchClient>& client : clients)
+                        {
+                            done = client->Step(actionMask).IsDone() || done;
+                        }
+                        uint64_t checksums[3];
+                        for (int c = 0; c < 3; ++c)
+                        {
+                            checksums[c] = Observation::Checksum(clients[c]->Observation(), observationSize);
+                        }
+                        seedsDiverged = seedsDiverged || checksums[0] != checksums[2];
+                        if (done)
+                        {
+                            for (std::unique_ptr<BenchClient>& client : clients)
+                            {
+                                client->Reset(true);
+                            }
+                        }
+                        return checksums[0] == checksums[1] ? "" : "two servers with the same seed diverged at step " + std::to_string(i);
+                    }
+                );
+                for (std::unique_ptr<BenchClient>& client : clients)
+                {
+                    client->Close();
+                }
+                if (result.failure.empty() && !seedsDiverged)
+                {
+                    result.failure = "servers with different seeds drew the same sticky actions";
+                }
+                return result;
+            }
+        );
+
+        // A step repeated for 2 * frameskip frames ends where two steps of the frameskip do
+        suite.AddCheck("action_repeat_matches_frameskip", 2000, [](uint64_t iterations)
+            {
+                BenchClient repeated(4, WIDTH, HEIGHT);
+                BenchClient skipped(4, WIDTH, HEIGHT);
+                repeated.Connect();
+                skipped.Connect();
+                repeated.Reset(true);
+                skipped.Reset(true);
+                size_t observationSize = static_cast<size_t>(WIDTH) * HEIGHT * repeated.ServerInfo().obsChannels;
+
+                BenchmarkResult result = MeasureCheck(iterations, [&](uint64_t i) -> std::string
+                    {
+                        bool repeatedDone = repeated.Step(STEP_ACTIONS, 8).IsDone();
+                        bool skippedDone = skipped.Step(STEP_ACTIONS).IsDone();
+                        float skippedReward = skipped.LastReward();
+                        if (!skippedDone)
+                        {
+                            skippedDone = skipped.Step(STEP_ACTIONS).IsDone();
+                            skippedReward += skipped.LastReward();
+                        }
+
+                        if (repeatedDone != skippedDone || repeated.LastReward() != skippedReward
+                            || Observation::Checksum(repeated.Observation(), observationSize) != Observation::Checksum(skipped.Observation(), observationSize))
+                        {
+                            return "the repeated step diverged from the frameskip at step " + std::to_string(i);
+                        }
+                        if (repeatedDone)
+                        {
+                            repeated.Reset(false);
+                            skipped.Reset(false);
+                        }
+                        return "";
+                    }
+                );
+                repeated.Close();
+                skipped.Close();
+                return result;
+            }
+        );
+
+        suite.Add("reset_latency", 5000, [](uint64_t iterations)
+            {
+                BenchClient client(4, WIDTH, HEIGHT);
+                client.Connect();
+                client.Reset(true);
+                std::chrono::steady_clock::duration resetTime(0);
+                for (uint64_t i = 0; i < iterations; ++i)
+                {
+                    StepOrReset(client);
+                    auto start = std::chrono::steady_clock::now();
+                    client.Reset(i % 2 == 0);
+                    resetTime += std::chrono::steady_clock::now() - start;
+                }
+                client.Close();
+
+                double ns = std::chrono::duration<double, std::nano>(resetTime).count() / iterations;
+                return BenchmarkResult{ "", "ns/op", ns, false, iterations };
+            }
+        );
+    }
+}
@@ -0,0 +1,259 @@
+#include "pch.h"
+#include "Benchmark.hpp"
+#include "BenchClient.hpp"
+#include "Platform/Platform.hpp"
+#include "Snapshot/SnapshotEngine.hpp"
+#include <random>
+#include <set>
+
+namespace HighwayPursuitBench
+{
+    namespace
+    {
+        constexpr size_t REGION_COUNT = 4;
+        constexpr size_t REGION_SIZE = 4 * 1024 * 1024;
+        constexpr size_t PAGES_WRITTEN = 64; // per iteration
+
+        // A few page-aligned regions standing in for the game's data sections and heap
+        class SyntheticAddressSpace
+        {
+        public:
+            SyntheticAddressSpace() : _random(7)
+            {
+                for (size_t i = 0; i < REGION_COUNT; ++i)
+                {
+                    uint8_t* region = static_cast<uint8_t*>(Platform::AllocatePages(REGION_SIZE));
+                    for (size_t offset = 0; offset < REGION_SIZE; offset += sizeof(uint32_t))
+                    {
+                        uint32_t value = _random();
+                        std::memcpy(region + offset, &value, sizeof(value));
+                    }
+                    _regions.push_back(region);
+                }
+            }
+
+            ~SyntheticAddressSpace()
+            {
+                for (uint8_t* region : _regions)
+                {
+                    Platform::FreePages(region, REGION_SIZE);
+                }
+            }
+
+            void Track(Snapshot::SnapshotEngine& engine)
+            {
+                for (uint8_t* region : _regions)
+                {
+                    engine.TrackRegion(region, REGION_SIZE);
+                }
+            }
+
+            // Writes a few bytes in random pages, returns the number of distinct pages written
+            size_t WriteRandomPages(size_t count)
+            {
+                size_t pageSize = Platform::GetPageSize();
+                std::set<uintptr_t> pages;
+                for (size_t i = 0; i < count; ++i)
+                {
+                    uint8_t* region = _regions[_random() % _regions.size()];
+                    size_t offset = _random() % REGION_SIZE;
+                    region[offset] ^= 0x5A;
+                    pages.insert(reinterpret_cast<uintptr_t>(region + offset) / pageSize);
+                }
+                return pages.size();
+            }
+
+            std::vector<uint8_t> Copy() const
+            {
+                std::vector<uint8_t> copy(REGION_COUNT * REGION_SIZE);
+                for (size_t i = 0; i < _regions.size(); ++i)
+                {
+                    std::memcpy(copy.data() + i * REGION_SIZE, _regions[i], REGION_SIZE);
+                }
+                return copy;
+            }
+
+            bool Equals(const std::vector<uint8_t>& copy) const
+            {
+                for (size_t i = 0; i < _regions.size(); ++i)
+                {
+                    if (std::memcmp(copy.data() + i * REGION_SIZE, _regions[i], REGION_SIZE) != 0)
+                    {
+                        return false;
+                    }
+                }
+                return true;
+            }
+
+        private:
+            std::mt19937 _random;
+            std::vector<uint8_t*> _regions;
+        };
+    }
+
+    void RegisterSnapshotBenchmarks(BenchmarkSuite& suite)
+    {
+        // Restore of the slot last captured/restored: only the pages written since are copied back
+        suite.Add("snapshot_restore_dirty_pages", 500, [](uint64_t iterations)
+            {
+                SyntheticAddressSpace memory;
+                Snapshot::SnapshotEngine engine(1, true);
+                memory.Track(engine);
+                std::vector<uint8_t> reference = memory.Copy();
+                engine.Capture(0);
+
+                std::string failure;
+                std::chrono::steady_clock::duration restoreTime(0);
+                for (uint64_t i = 0; i < iterations; ++i)
+                {
+                    size_t pagesWritten = memory.WriteRandomPages(PAGES_WRITTEN);
+                    auto start = std::chrono::steady_clock::now();
+                    Snapshot::RestoreStats stats = engine.Restore(0);
+                    restoreTime += std::chrono::steady_clock::now() - start;
+                    if (stats.copiedPages != pagesWritten && failure.empty())
+                    {
+                        failure = "copied " + std::to_string(stats.copiedPages) + " pages, " + std::to_string(pagesWritten) + " were written";
+                    }
+                }
+                if (!memory.Equals(reference) && failure.empty())
+                {
+                    failure = "memory differs from the snapshot after restore";
+                }
+
+                double ns = std::chrono::duration<double, std::nano>(restoreTime).count() / iterations;
+                return BenchmarkResult{ "", "ns/op", ns, false, iterations, failure };
+            }
+        );
+
+        // Switching between two slots: pages are compared to the image, only the ones that differ are copied
+        suite.Add("snapshot_restore_other_slot", 50, [](uint64_t iterations)
+            {
+                SyntheticAddressSpace memory;
+                Snapshot::SnapshotEngine engine(2, true);
+                memory.Track(engine);
+                std::vector<uint8_t> references[2];
+                references[0] = memory.Copy();
+                engine.Capture(0);
+                memory.WriteRandomPages(PAGES_WRITTEN);
+                references[1] = memory.Copy();
+                engine.Capture(1);
+
+                std::string failure;
+                std::chrono::steady_clock::duration restoreTime(0);
+                for (uint64_t i = 0; i < iterations; ++i)
+                {
+                    uint32_t slot = static_cast<uint32_t>(i % 2);
+                    memory.WriteRandomPages(PAGES_WRITTEN);
+                    auto start = std::chrono::steady_clock::now();
+                    engine.Restore(slot);
+                    restoreTime += std::chrono::steady_clock::now() - start;
+                    if (!memory.Equals(references[slot]) && failure.empty())
+                    {
+                        failure = "memory differs from slot " + std::to_string(slot) + " after restore";
+                    }
+                }
+
+                double ns = std::chrono::duration<double, std::nano>(restoreTime).count() / iterations;
+                return BenchmarkResult{ "", "ns/op", ns, false, iterations, failure };
+            }
+        );
+
+        // Reference point: copying the whole tracked memory
+        suite.Add("snapshot_full_copy", 50, [](uint64_t iterations)
+            {
+                SyntheticAddressSpace memory;
+                std::vector<uint8_t> copy;
+                double ns = MeasureNsPerOp(iterations, [&](uint64_t)
+                    {
+                        copy = memory.Copy();
+                        DoNotOptimize(copy.data());
+                    }
+                );
+                return BenchmarkResult{ "", "ns/op", ns, false, iterations };
+            }
+        );
+
+        // A restore of a slot never captured is refused without stopping the server, and only that instruction reports the error
+        suite.AddCheck("snapshot_invalid_restore_recovers", 20, [](uint64_t iterations)
+            {
+                BenchClient client(4, 160, 120);
+                client.Connect();
+                client.Reset(true);
+                BenchmarkResult result = MeasureCheck(iterations, [&](uint64_t)
+                    {
+                        try
+                        {
+                            client.Restore(1);
+                            return std::string("the restore of an empty slot was acknowledged");
+                        }
+                        catch (const Data::HighwayPursuitException& e)
+                        {
+                            if (e.code != Data::ErrorCode::INVALID_SNAPSHOT)
+                            {
+                                return "the restore of an empty slot failed with the error " + std::to_string(static_cast<int>(e.code));
+                            }
+                        }
+                        try
+                        {
+                            client.Ping();
+                            client.Step(0);
+                        }
+                        catch (const Data::HighwayPursuitException& e)
+                        {
+                            return "the instructions after the refused restore failed with the error " + std::to_string(static_cast<int>(e.code));
+                        }
+                        return std::string();
+                    }
+                );
+                client.Close();
+                return result;
+            }
+        );
+
+        // Through the protocol: replaying the same actions from a restored snapshot gives the same frames and rewards
+        suite.Add("snapshot_restore_synthetic", 2000, [](uint64_t iterations)
+            {
+                constexpr int ROLLOUT_STEPS = 10;
+                const uint32_t actions = (1u << static_cast<uint32_t>(Data::Input::Accelerate)) | (1u << static_cast<uint32_t>(Data::Input::Fire));
+
+                BenchClient client(4, 160, 120);
+                client.Connect();
+                client.Reset(true);
+                client.Snapshot(0);
+
+                size_t observationSize = static_cast<size_t>(client.ServerInfo().obsWidth) * client.ServerInfo().obsHeight * client.ServerInfo().obsChannels;
+                std::vector<uint8_t> expectedObservation;
+                float expectedReturn = 0.0f;
+                std::string failure;
+                std::chrono::steady_clock::duration restoreTime(0);
+                for (uint64_t i = 0; i < iterations; ++i)
+                {
+                    float rolloutReturn = 0.0f;
+                    for (int step = 0; step < ROLLOUT_STEPS && !client.Step(actions).IsDone(); ++step)
+                    {
+                        rolloutReturn += client.LastReward();
+                    }
+
+                    if (i == 0)
+                    {
+                        expectedObservation.assign(client.Observation(), client.Observation() + observationSize);
+                        expectedReturn = rolloutReturn;
+                    }
+                    else if (failure.empty() && (rolloutReturn != expectedReturn
+                        || std::memcmp(expectedObservation.data(), client.Observation(), observationSize) != 0))
+                    {
+                        failure = "rollout " + std::to_string(i) + " diverged from the first one";
+                    }
+
+                    auto start = std::chrono::steady_clock::now();
+                    client.Restore(0);
+                    restoreTime += std::chrono::steady_clock::now() - start;
+                }
+                client.Close();
+
+                double ns = std::chrono::duration<double, std::nano>(restoreTime).count() / iterations;
+                return BenchmarkResult{ "", "ns/op", ns, false, iterations, failure };
+            }
+        );
+    }
+}
@@ -0,0 +1,134 @@
+#include "pch.h"
+#include "Benchmark.hpp"
+#include "BenchClient.hpp"
+#include "Observation/ObservationKernels.hpp"
+#include "Spectator/SpectatorTap.hpp"
+
+namespace HighwayPursuitBench
+{
+    namespace
+    {
+        constexpr uint32_t WIDTH = 160;
+        constexpr uint32_t HEIGHT = 120;
+
+        // Accelerate without firing, the episodes keep ending
+        const uint32_t CRASH_ACTIONS = 1u << static_cast<uint32_t>(Data::Input::Accelerate);
+
+        struct ViewerResult
+        {
+            uint64_t reads = 0;
+            uint64_t tornReads = 0; // copies whose checksum doesn't match the stats
+            uint64_t regressions = 0; // frames older than the previous read
+        };
+
+        BenchClient CreateClient(const std::string& tapName, float maxFps)
+        {
+            return BenchClient(1, WIDTH, HEIGHT, 0, Data::ActionEncoding::BITMASK, BenchRecording(), Data::ServerParams::AffinityParams(0, 0),
+                Data::ServerParams::EpisodeParams(false), Data::ServerParams::ActionParams(0.0f, 0), Data::PipelineConfig(),
+                Data::ServerParams::SpectatorParams(tapName, maxFps));
+        }
+
+        void Play(BenchClient& client, uint64_t steps)
+        {
+            for (uint64_t i = 0; i < steps; ++i)
+            {
+                if (client.Step(CRASH_ACTIONS).IsDone())
+                {
+                    client.Reset(false);
+                }
+            }
+        }
+    }
+
+    void RegisterSpectatorBenchmarks(BenchmarkSuite& suite)
+    {
+        // Viewers read the frame while the server publishes every observation: no copy is torn and the frames only move forward.
+        // Nanoseconds per step of the client with the viewers reading.
+        uint32_t viewerCount = std::max(1u, std::min(4u, std::thread::hardware_concurrency() / 2));
+        suite.Add("spectator_tear_free_x" + std::to_string(viewerCount), 20000, [viewerCount](uint64_t iterations)
+            {
+                std::string tapName = BenchClient::UniquePrefix() + "spectator";
+                BenchClient client = CreateClient(tapName, 0.0f);
+                client.Connect();
+                client.Reset(true);
+
+                std::atomic<bool> stop(false);
+                std::vector<ViewerResult> results(viewerCount);
+                std::vector<std::thread> viewers;
+                for (uint32_t viewer = 0; viewer < viewerCount; ++viewer)
+                {
+                    viewers.emplace_back([&, viewer]()
+                        {
+                            std::unique_ptr<Spectator::SpectatorTap> tap = Spectator::SpectatorTap::Open(tapName);
+                            std::vector<uint8_t> observation(tap->ObservationSize());
+                            Spectator::SpectatorStats stats;
+                            uint64_t lastFrames = 0;
+                            ViewerResult& result = results[viewer];
+                            while (!stop.load())
+                            {
+                                if (!tap->TryRead(stats, observation.data()))
+                                {
+                                    continue;
+                                }
+                                result.reads++;
+                                result.tornReads += Observation::Checksum(observation.data(), observation.size()) != stats.checksum ? 1 : 0;
+                                result.regressions += stats.frames < lastFrames ? 1 : 0;
+                                lastFrames = stats.frames;
+                            }
+                        }
+                    );
+                }
+
+                auto start = std::chrono::steady_clock::now();
+                Play(client, iterations);
+                double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / iterations;
+                stop = true;
+                for (std::thread& viewer : viewers)
+                {
+                    viewer.join();
+                }
+                client.Close();
+
+                BenchmarkResult result{ "", "ns/op", ns, false, iterations };
+                for (uint32_t viewer = 0; viewer < viewerCount && result.failure.empty(); ++viewer)
+                {
+                    const ViewerResult& viewerResult = results[viewer];
+                    if (viewerResult.tornReads != 0 || viewerResult.regressions != 0)
+                    {
+                        result.failure = "viewer " + std::to_string(viewer) + " read " + std::to_string(viewerResult.tornReads) + " torn frames and "
+                            + std::to_string(viewerResult.regressions) + " older frames out of " + std::to_string(viewerResult.reads);
+                    }
+                    else if (viewerResult.reads == 0)
+                    {
+                        result.failure = "viewer " + std::to_string(viewer) + " didn't read any frame";
+                    }
+                }
+                return result;
+            }
+        );
+
+        // The server publishes at most at the configured rate, however fast it steps
+        suite.Add("spectator_throttled", 20000, [](uint64_t iterations)
+            {
+                constexpr float MAX_FPS = 1000.0f;
+                std::string tapName = BenchClient::UniquePrefix() + "spectator";
+                BenchClient client = CreateClient(tapName, MAX_FPS);
+                client.Connect();
+                auto start = std::chrono::steady_clock::now();
+                client.Reset(true);
+                Play(client, iterations);
+                double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+                std::unique_ptr<Spectator::SpectatorTap> tap = Spectator::SpectatorTap::Open(tapName);
+                uint64_t published = tap->PublishedCount();
+                client.Close();
+
+                BenchmarkResult result{ "", "publishes/s", published / seconds, false, iterations };
+                if (published == 0 || published > seconds * MAX_FPS + 1)
+                {
+                    result.failure = std::to_string(published) + " frames published in " + std::to_string(seconds) + " s";
+                }
+                return result;
+            }
+        );
+    }
+}
@@ -0,0 +1,64 @@
+#include "pch.h"
+#include "Observation/ObservationKernels.hpp"
+#include "Spectator/SpectatorTap.hpp"
+
+// Viewer of a spectator tap: prints the stats of the latest frame once per second and checks the copies against their checksum.
+// Usage: highway-pursuit-spectator <name> [seconds] [ppm path, the latest frame is written there]
+int main(int argc, char* argv[])
+{
+    if (argc < 2)
+    {
+        std::cerr << "Usage: " << argv[0] << " <name> [seconds] [ppm path]" << std::endl;
+        return 1;
+    }
+    std::string name = argv[1];
+    int seconds = argc > 2 ? std::stoi(argv[2]) : 10;
+    std::string ppmPath = argc > 3 ? argv[3] : "";
+
+    try
+    {
+        std::unique_ptr<Spectator::SpectatorTap> tap = Spectator::SpectatorTap::Open(name);
+        Data::BufferFormat format = tap->Format();
+        std::vector<uint8_t> observation(tap->ObservationSize());
+        Spectator::SpectatorStats stats{};
+        uint64_t reads = 0;
+        uint64_t tornReads = 0;
+
+        // Reads as fast as possible in between the prints, like a busy dashboard
+        auto end = std::chrono::steady_clock::now() + std::chrono::seconds(seconds);
+        auto nextPrint = std::chrono::steady_clock::now();
+        while (std::chrono::steady_clock::now() < end)
+        {
+            if (tap->TryRead(stats, observation.data()))
+            {
+                reads++;
+                tornReads += Observation::Checksum(observation.data(), observation.size()) != stats.checksum ? 1 : 0;
+            }
+            if (std::chrono::steady_clock::now() >= nextPrint)
+            {
+                std::cout << "frames " << stats.frames << " steps " << stats.steps << " episodes " << stats.episodes << " reward " << stats.reward
+                    << " tps " << stats.tps << " published " << tap->PublishedCount() << " reads " << reads << " torn " << tornReads << std::endl;
+                nextPrint += std::chrono::seconds(1);
+            }
+        }
+
+        if (!ppmPath.empty() && reads > 0)
+        {
+            // Binary PPM of the first three channels (BGR(X) frames are swapped to RGB)
+            std::ofstream file(ppmPath, std::ios::binary);
+            file << "P6\n" << format.width << " " << format.height << "\n255\n";
+            for (size_t pixel = 0; pixel < static_cast<size_t>(format.width) * format.height; ++pixel)
+            {
+                const uint8_t* p = observation.data() + pixel * format.channels;
+                uint8_t rgb[3] = { p[format.channels >= 3 ? 2 : 0], p[format.channels >= 3 ? 1 : 0], p[0] };
+                file.write(reinterpret_cast<const char*>(rgb), 3);
+            }
+        }
+        return tornReads == 0 ? 0 : 4;
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << e.what() << std::endl;
+        return 3;
+    }
+}
@@ -0,0 +1,88 @@
+#include "pch.h"
+#include "HighwayPursuitServer.hpp"
+#include "Synthetic/SyntheticGame.hpp"
+
+namespace
+{
+    // Synthetic game whose updates stop completing after a number of frames, like a hung game
+    class HangingGame : public Services::GameBackend, public Services::IUpdateService
+    {
+    public:
+        HangingGame(const Synthetic::SyntheticGameParams& params, uint64_t framesBeforeHanging)
+            : _game(params), _framesBeforeHanging(framesBeforeHanging), _frames(0)
+        {
+        }
+
+        Services::IEpisodeService& Episode() override { return _game.Episode(); }
+        Services::IScoreService& Score() override { return _game.Score(); }
+        Services::IInputService& Input() override { return _game.Input(); }
+        Services::IRenderingService& Rendering() override { return _game.Rendering(); }
+        Services::IUpdateService& Update() override { return *this; }
+        Services::IStateService& State() override { return _game.State(); }
+
+        void EnableCustomTime() override { _game.EnableCustomTime(); }
+        void UpdateTime() override { _game.UpdateTime(); }
+
+        bool WaitUpdate(uint32_t timeoutMs) override
+        {
+            if (_frames++ < _framesBeforeHanging)
+            {
+                return _game.WaitUpdate(timeoutMs);
+            }
+
+            // Longer than the game timeout, only a supervisor ends it
+            std::this_thread::sleep_for(std::chrono::hours(1));
+            return false;
+        }
+
+    private:
+        Synthetic::SyntheticGame _game;
+        const uint64_t _framesBeforeHanging;
+        uint64_t _frames;
+    };
+}
+
+// Parked server of the synthetic game, started by a warm pool like the launcher would start the injected one.
+// The startup delay stands in for the injection and the game's intro, a non-zero exit code fails the start instead of parking,
+// and the game can hang after a number of frames. With a startup image, the first server writes it and the next ones boot from it.
+int main(int argc, char* argv[])
+{
+    if (argc < 3)
+    {
+        std::cerr << "Usage: highway-pursuit-standin <shared resources prefix> <startup delay ms> [<exit code>] [<frames before hanging>] [<startup image>]" << std::endl;
+        return 1;
+    }
+
+    std::string prefix = argv[1];
+    int startupDelayMs = std::stoi(argv[2]);
+    int failureCode = argc > 3 ? std::stoi(argv[3]) : 0;
+    uint64_t framesBeforeHanging = argc > 4 ? std::stoull(argv[4]) : 0;
+    std::string imagePath = argc > 5 ? argv[5] : "";
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(startupDelayMs));
+    if (failureCode != 0)
+    {
+        return failureCode;
+    }
+
+    constexpr uint32_t WIDTH = 160;
+    constexpr uint32_t HEIGHT = 120;
+    Data::ServerParams params(false, 4, Data::ServerParams::RenderParams(WIDTH, HEIGHT, true), Data::ServerParams::TraceParams(false, 0, "."), prefix,
+        Data::ServerParams::ReplayParams("", ""), Data::ServerParams::TrajectoryParams("", false), Data::ServerParams::ReplayBufferParams(""),
+        Data::ServerParams::PoolParams(true), Data::ServerParams::AffinityParams(0, 0), Data::ServerParams::EpisodeParams(false),
+        Data::ServerParams::ActionParams(0.0f, 0), Data::ServerParams::AgentParams("", "", 0, ""), Data::ServerParams::StartupParams(imagePath));
+    Synthetic::SyntheticGameParams gameParams(WIDTH, HEIGHT, 42, 0);
+    std::unique_ptr<Services::GameBackend> backend;
+    if (framesBeforeHanging > 0)
+    {
+        backend = std::make_unique<HangingGame>(gameParams, framesBeforeHanging);
+    }
+    else
+    {
+        backend = std::make_unique<Synthetic::SyntheticGame>(gameParams);
+    }
+
+    HighwayPursuitServer server(params, std::move(backend));
+    server.Run();
+    return 0;
+}
@@ -0,0 +1,296 @@
+#include "pch.h"
+#include "Benchmark.hpp"
+#include "BenchClient.hpp"
+#include "HighwayPursuitServer.hpp"
+#include "Platform/Platform.hpp"
+#include "Snapshot/SnapshotEngine.hpp"
+#include "Synthetic/SyntheticGame.hpp"
+#include <filesystem>
+#include <random>
+
+namespace HighwayPursuitBench
+{
+    namespace
+    {
+        constexpr int FRAMESKIP = 4;
+        constexpr uint32_t WIDTH = 160;
+        constexpr uint32_t HEIGHT = 120;
+        constexpr uint32_t FRAME_COST_US = 16000; // a frame of the game at 60 fps
+        constexpr uint32_t START_TIMEOUT = 5000; // in ms
+        constexpr uint32_t ACQUIRE_TIMEOUT = 10000; // in ms
+
+        std::string ImagePath()
+        {
+            return (std::filesystem::temp_directory_path() / ("hp-bench-startup-" + std::to_string(std::random_device()()) + ".img")).string();
+        }
+
+        // The sample agent plays the episodes once the game has booted, none only measures the boot
+        Agents::AgentReport RunServer(uint32_t episodes, uint32_t frameCostUs, const std::string& imagePath, double& ms)
+        {
+            Data::ServerParams params(false, FRAMESKIP, ServerParams::RenderParams(WIDTH, HEIGHT, true), ServerParams::TraceParams(false, 0, "."),
+                "hp-bench-startup-", ServerParams::ReplayParams("", ""), ServerParams::TrajectoryParams("", false), ServerParams::ReplayBufferParams(""),
+                ServerParams::PoolParams(false), ServerParams::AffinityParams(0, 0), ServerParams::EpisodeParams(false), ServerParams::ActionParams(0.0f, 0),
+                ServerParams::AgentParams(HP_SAMPLE_AGENT_PATH, "", episodes, ""), ServerParams::StartupParams(imagePath));
+            auto start = std::chrono::steady_clock::now();
+            HighwayPursuitServer server(params, std::make_unique<Synthetic::SyntheticGame>(Synthetic::SyntheticGameParams(WIDTH, HEIGHT, 42, frameCostUs)));
+            server.Run();
+            ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            return server.LastAgentReport();
+        }
+
+        // Tracked memory of a process that keeps the handle of an object of its own, different in every process, like the game's pointers
+        // to its devices and window
+        class ProcessMemory
+        {
+        public:
+            static constexpr size_t SIZE = 2 * 4096;
+            static constexpr size_t HANDLE_OFFSET = 64;
+            static constexpr uint64_t KEY = 1;
+
+            // Boots the process: the same memory in every process except for the handle
+            ProcessMemory(uint32_t handle) : _engine(1, false), _memory(static_cast<uint8_t*>(Platform::AllocatePages(SIZE)))
+            {
+                for (size_t offset = 0; offset < SIZE; offset += sizeof(uint32_t))
+                {
+                    uint32_t value = static_cast<uint32_t>(offset * 2654435761u);
+                    std::memcpy(_memory + offset, &value, sizeof(value));
+                }
+                std::memcpy(_memory + HANDLE_OFFSET, &handle, sizeof(handle));
+                _engine.TrackRegion(_memory, SIZE, Snapshot::WriteDetection::NONE);
+                _baseline = _engine.ReadMemory();
+            }
+
+            ~ProcessMemory()
+            {
+                Platform::FreePages(_memory, SIZE);
+            }
+
+            // The state the image skips to, the intro can replace the handle by the one of an object it creates
+            void PlayIntro(bool createsObject)
+            {
+                std::memset(_memory + SIZE / 2, 0x42, 256);
+                if (createsObject)
+                {
+                    _memory[HANDLE_OFFSET] ^= 0x1;
+                }
+            }
+
+            Snapshot::SnapshotEngine& Engine() { return _engine; }
+            const std::vector<uint8_t>& Baseline() const { return _baseline; }
+            std::vector<uint8_t> Memory() const { return _engine.ReadMemory(); }
+
+        private:
+            Snapshot::SnapshotEngine _engine;
+            uint8_t* _memory;
+            std::vector<uint8_t> _baseline;
+        };
+
+        // The third process loads the image validated by the second one, with its own handle. Empty if it did
+        std::string CheckRelocation(const std::string& path, bool introCreatesObject)
+        {
+            uint64_t userData = 0;
+            {
+                ProcessMemory writer(0x1000);
+                writer.PlayIntro(introCreatesObject);
+                writer.Engine().SaveImage(path, ProcessMemory::KEY, 0, writer.Baseline());
+            }
+            {
+                ProcessMemory validator(0x2000);
+                std::vector<uint8_t> boot = validator.Memory();
+                if (validator.Engine().LoadImage(path, ProcessMemory::KEY, userData, validator.Baseline()) || validator.Memory() != boot)
+                {
+                    return "an image that isn't validated was loaded";
+                }
+                validator.PlayIntro(introCreatesObject);
+                if (validator.Engine().MatchesImage(path, ProcessMemory::KEY, validator.Baseline()) == introCreatesObject)
+                {
+                    return introCreatesObject ? "an image with a handle created by the intro was validated" : "the relocated image doesn't match the intro";
+                }
+                // Validated regardless, the loader has to refuse what it can't relocate
+                validator.Engine().SaveImage(path, ProcessMemory::KEY, 0, validator.Baseline(), true);
+            }
+            ProcessMemory loader(0x3000);
+            ProcessMemory expected(0x3000);
+            expected.PlayIntro(introCreatesObject);
+            std::vector<uint8_t> boot = loader.Memory();
+            bool loaded = loader.Engine().LoadImage(path, ProcessMemory::KEY, userData, loader.Baseline());
+            if (loaded != !introCreatesObject)
+            {
+                return loaded ? "an image with a handle created by the intro was loaded" : "the validated image wasn't loaded";
+            }
+            if (loader.Memory() != (loaded ? expected.Memory() : boot))
+            {
+                return loaded ? "the loaded image doesn't hold the handle of the loading process" : "a refused image changed the memory";
+            }
+            return "";
+        }
+
+        // Hash of the observations and rewards of a rollout of a highway-pursuit-standin process started with the image, the game
+        // state lives at other addresses in every process
+        uint64_t PlayStandIn(const std::string& imagePath, uint64_t steps)
+        {
+            std::vector<std::string> command{ HP_STANDIN_PATH, Pool::WarmPoolParams::PREFIX_PLACEHOLDER, "0", "0", "0", imagePath };
+            Pool::WarmPool pool(Pool::WarmPoolParams(1, command, "hp-bench-startup-" + std::to_string(std::random_device()()) + "-", START_TIMEOUT));
+            std::unique_ptr<Pool::ParkedInstance> instance = pool.Acquire(ACQUIRE_TIMEOUT);
+            if (instance == nullptr)
+            {
+                throw std::runtime_error("No instance parked before the timeout");
+            }
+            BenchClient client(std::move(instance));
+            client.Connect();
+            const Data::ServerInfo& info = client.ServerInfo();
+            size_t observationSize = static_cast<size_t>(info.obsWidth) * info.obsHeight * info.obsChannels;
+
+            uint64_t hash = 1469598103934665603ull;
+            auto mix = [&hash](const void* data, size_t size)
+                {
+                    for (size_t i = 0; i < size; ++i)
+                    {
+                        hash = (hash ^ static_cast<const uint8_t*>(data)[i]) * 1099511628211ull;
+                    }
+                };
+            client.Reset(true);
+            for (uint64_t i = 0; i < steps; ++i)
+            {
+                if (client.Step(1u << (i % info.actionCount)).IsDone())
+                {
+                    client.Reset(false);
+                }
+                float reward = client.LastReward();
+                mix(&reward, sizeof(reward));
+                mix(client.Observation(), observationSize);
+            }
+            client.Close();
+            return hash;
+        }
+
+        bool SameEpisodes(const Agents::AgentReport& a, const Agents::AgentReport& b)
+        {
+            if (a.steps != b.steps || a.episodes.size() != b.episodes.size())
+            {
+                return false;
+            }
+            for (size_t i = 0; i < a.episodes.size(); ++i)
+            {
+                if (a.episodes[i].frames != b.episodes[i].frames || a.episodes[i].episodeReturn != b.episodes[i].episodeReturn)
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        // Milliseconds from the creation of the game to the server being ready, with the intro skipped or the image loaded
+        BenchmarkResult MeasureBoot(uint64_t iterations, bool fromImage)
+        {
+            std::string path = ImagePath();
+            double ms = 0.0;
+            if (fromImage)
+            {
+                RunServer(0, 0, path, ms);
+            }
+            double total = 0.0;
+            for (uint64_t i = 0; i < iterations; ++i)
+            {
+                RunServer(0, FRAME_COST_US, fromImage ? path : "", ms);
+                total += ms;
+            }
+            std::error_code error;
+            std::filesystem::remove(path, error);
+            return BenchmarkResult{ "", "ms", total / iterations, false, iterations };
+        }
+    }
+
+    void RegisterStartupBenchmarks(BenchmarkSuite& suite)
+    {
+        // The first server writes the image and the second one loads it (the file isn't written again),
+        // both play the same episodes as a server that skips the intro
+        suite.AddCheck("startup_image_matches_intro", 20, [](uint64_t iterations)
+            {
+                uint32_t episodes = static_cast<uint32_t>(iterations);
+                std::string path = ImagePath();
+                double ms = 0.0;
+                Agents::AgentReport intro = RunServer(episodes, 0, "", ms);
+                Agents::AgentReport written = RunServer(episodes, 0, path, ms);
+                std::error_code error;
+                auto writeTime = std::filesystem::last_write_time(path, error);
+                Agents::AgentReport loaded = RunServer(episodes, 0, path, ms);
+
+                std::string failure;
+                if (error)
+                {
+                    failure = "the first server didn't write the image";
+                }
+                else if (std::filesystem::last_write_time(path, error) != writeTime)
+                {
+                    failure = "the second server wrote the image instead of loading it";
+                }
+                else if (!SameEpisodes(intro, written) || !SameEpisodes(intro, loaded))
+                {
+                    failure = "the episodes played from the image differ from the ones after the intro";
+                }
+                std::filesystem::remove(path, error);
+                return BenchmarkResult{ "", "ms", ms, false, iterations, failure };
+            }
+        );
+
+        // The image written by one process loads in another one, whose allocations are elsewhere, and plays the same steps
+        suite.AddCheck("startup_image_across_processes", 200, [](uint64_t iterations)
+            {
+                std::string path = ImagePath();
+                auto start = std::chrono::steady_clock::now();
+                uint64_t intro = PlayStandIn(path, iterations);
+                std::error_code error;
+                auto writeTime = std::filesystem::last_write_time(path, error);
+                uint64_t loaded = PlayStandIn(path, iterations);
+                double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+                std::string failure;
+                if (error)
+                {
+                    failure = "the first process didn't write the image";
+                }
+                else if (std::filesystem::last_write_time(path, error) != writeTime)
+                {
+                    failure = "the second process wrote the image instead of loading it";
+                }
+                else if (intro != loaded)
+                {
+                    failure = "the steps played from the image differ from the ones after the intro";
+                }
+                std::filesystem::remove(path, error);
+                return BenchmarkResult{ "", "ms", ms, false, iterations, failure };
+            }
+        );
+
+        // An image holding handles of its process is relocated to the handles of the loading process, once a second process validated it.
+        // A handle the intro changed can't be relocated, the image is refused
+        suite.AddCheck("startup_image_relocation", 1, [](uint64_t iterations)
+            {
+                std::string path = ImagePath();
+                auto start = std::chrono::steady_clock::now();
+                std::string failure = CheckRelocation(path, false);
+                if (failure.empty())
+                {
+                    failure = CheckRelocation(path, true);
+                }
+                double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+                std::error_code error;
+                std::filesystem::remove(path, error);
+                return BenchmarkResult{ "", "ms", ms, false, iterations, failure };
+            }
+        );
+
+        // The intro waits for game updates, loading the image only maps it
+        suite.Add("startup_boot_intro", 10, [](uint64_t iterations)
+            {
+                return MeasureBoot(iterations, false);
+            }
+        );
+        suite.Add("startup_boot_image", 10, [](uint64_t iterations)
+            {
+                return MeasureBoot(iterations, true);
+            }
+        );
+    }
+}
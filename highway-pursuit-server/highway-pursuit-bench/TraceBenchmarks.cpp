@@ -0,0 +1,104 @@
+#include "pch.h"
+#include "Benchmark.hpp"
+#include "Tracing/TraceRecorder.hpp"
+#include <filesystem>
+#include <random>
+#include <set>
+
+namespace HighwayPursuitBench
+{
+    namespace
+    {
+        constexpr size_t MEMORY_BUDGET = 1 << 20;
+        constexpr uint32_t EVENTS_PER_THREAD = 16;
+
+        std::string TracePath()
+        {
+            return (std::filesystem::temp_directory_path() / ("hp-bench-trace-" + std::to_string(std::random_device()()) + ".json")).string();
+        }
+
+        void RecordEvents()
+        {
+            for (uint32_t i = 0; i < EVENTS_PER_THREAD; ++i)
+            {
+                int64_t now = Tracing::TraceRecorder::NowUs();
+                Tracing::TraceRecorder::Record("Event", now, now);
+            }
+        }
+
+        // Events of a dump and the threads they come from
+        void ReadTrace(const std::string& path, uint64_t& events, std::set<std::string>& threads)
+        {
+            std::ifstream file(path);
+            std::string line;
+            events = 0;
+            while (std::getline(file, line))
+            {
+                size_t tid = line.find("\"tid\":");
+                if (tid != std::string::npos)
+                {
+                    events++;
+                    threads.insert(line.substr(tid, line.find('}', tid) - tid));
+                }
+            }
+        }
+    }
+
+    void RegisterTraceBenchmarks(BenchmarkSuite& suite)
+    {
+        // Each configuration hands a buffer to its first threads, the extra ones aren't traced, and a thread traced by a previous
+        // configuration (a previous server of the process) claims a buffer of the new one
+        suite.AddCheck("trace_threads_per_configure", 1, [](uint64_t iterations)
+            {
+                constexpr uint32_t TRACED_THREADS = 3;
+                constexpr uint32_t RECORDING_THREADS = 5;
+                std::string failure;
+                auto start = std::chrono::steady_clock::now();
+
+                Tracing::TraceRecorder::Configure(true, MEMORY_BUDGET, TRACED_THREADS);
+                RecordEvents();
+                std::vector<std::thread> threads;
+                for (uint32_t i = 1; i < RECORDING_THREADS; ++i)
+                {
+                    threads.emplace_back(RecordEvents);
+                }
+                for (std::thread& thread : threads)
+                {
+                    thread.join();
+                }
+                std::string path = TracePath();
+                uint64_t events = 0;
+                std::set<std::string> tracedThreads;
+                if (!Tracing::TraceRecorder::Dump(path))
+                {
+                    failure = "the first trace wasn't written";
+                }
+                ReadTrace(path, events, tracedThreads);
+                std::filesystem::remove(path);
+                if (failure.empty() && (tracedThreads.size() != TRACED_THREADS || events != TRACED_THREADS * EVENTS_PER_THREAD))
+                {
+                    failure = std::to_string(events) + " events of " + std::to_string(tracedThreads.size()) + " threads traced with "
+                        + std::to_string(TRACED_THREADS) + " buffers";
+                }
+
+                Tracing::TraceRecorder::Configure(true, MEMORY_BUDGET, 1);
+                RecordEvents();
+                tracedThreads.clear();
+                if (failure.empty() && !Tracing::TraceRecorder::Dump(path))
+                {
+                    failure = "the second trace wasn't written";
+                }
+                ReadTrace(path, events, tracedThreads);
+                std::filesystem::remove(path);
+                if (failure.empty() && events != EVENTS_PER_THREAD)
+                {
+                    failure = "the thread traced by the first configuration recorded " + std::to_string(events) + " events in the second one";
+                }
+                Tracing::TraceRecorder::Configure(false, 0, 0);
+
+                double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+                return BenchmarkResult{ "", "ms", ms, false, iterations, failure };
+            }
+        );
+    }
+}
@@ -0,0 +1,127 @@
+#include "pch.h"
+#include "Benchmark.hpp"
+#include "BenchClient.hpp"
+#include "Observation/ObservationKernels.hpp"
+#include "Trajectory/TrajectoryReader.hpp"
+#include <filesystem>
+#include <random>
+
+namespace HighwayPursuitBench
+{
+    namespace
+    {
+        constexpr uint32_t WIDTH = 160;
+        constexpr uint32_t HEIGHT = 120;
+
+        struct ExpectedTransition
+        {
+            uint64_t checksum;
+            uint32_t actionMask;
+            float reward;
+        };
+
+        std::string TrajectoryDirectory(const std::string& name)
+        {
+            return (std::filesystem::temp_directory_path() / ("hp-bench-" + name + "-" + std::to_string(std::random_device()()))).string();
+        }
+
+        // Records a session, returns what the client received for each transition, in order
+        std::vector<ExpectedTransition> RecordSession(const std::string& directory, uint64_t steps, double& stepsPerSecond)
+        {
+            std::mt19937 random(5);
+            BenchClient client(4, WIDTH, HEIGHT, 0, Data::ActionEncoding::BITMASK, BenchRecording{ "", directory, "" });
+            client.Connect();
+            size_t observationSize = static_cast<size_t>(WIDTH) * HEIGHT * client.ServerInfo().obsChannels;
+
+            std::vector<ExpectedTransition> transitions;
+            transitions.reserve(steps + 1);
+            client.Reset(true);
+            transitions.push_back(ExpectedTransition{ Observation::Checksum(client.Observation(), observationSize), 0, 0.0f });
+
+            auto start = std::chrono::steady_clock::now();
+            for (uint64_t i = 0; i < steps; ++i)
+            {
+                uint32_t actionMask = random() & 0xFFu;
+                bool done = client.Step(actionMask).IsDone();
+                transitions.push_back(ExpectedTransition{ Observation::Checksum(client.Observation(), observationSize), actionMask, client.LastReward() });
+                if (done)
+                {
+                    client.Reset(false);
+                    transitions.push_back(ExpectedTransition{ Observation::Checksum(client.Observation(), observationSize), 0, 0.0f });
+                }
+            }
+            stepsPerSecond = steps / std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+            // The writer drains its queue when the server shuts down
+            client.Close();
+            return transitions;
+        }
+    }
+
+    void RegisterTrajectoryBenchmarks(BenchmarkSuite& suite)
+    {
+        // Step throughput while recording; every transition that wasn't dropped reads back as the client received it
+        suite.Add("trajectory_record_steps_per_second", 5000, [](uint64_t iterations)
+            {
+                std::string directory = TrajectoryDirectory("record");
+                double stepsPerSecond = 0.0;
+                std::vector<ExpectedTransition> expected = RecordSession(directory, iterations, stepsPerSecond);
+
+                std::string failure;
+                {
+                    Trajectory::TrajectoryReader reader(directory);
+                    std::vector<uint8_t> observation(reader.Format().Size());
+                    uint64_t previousSequence = 0;
+                    for (size_t i = 0; i < reader.Size() && failure.empty(); ++i)
+                    {
+                        const Trajectory::TrajectoryIndexEntry& entry = reader.Entry(i);
+                        reader.ReadObservation(i, observation.data());
+                        if (entry.sequence >= expected.size() || (i > 0 && entry.sequence <= previousSequence))
+                        {
+                            failure = "transition " + std::to_string(i) + " has an invalid sequence number";
+                            break;
+                        }
+
+                        const ExpectedTransition& transition = expected[entry.sequence];
+                        if (Observation::Checksum(observation.data(), observation.size()) != transition.checksum
+                            || entry.actionMask != transition.actionMask || entry.reward != transition.reward)
+                        {
+                            failure = "transition " + std::to_string(entry.sequence) + " differs from what the client received";
+                        }
+                        previousSequence = entry.sequence;
+                    }
+                    if (failure.empty() && reader.Size() == 0)
+                    {
+                        failure = "no transition recorded";
+                    }
+                }
+                std::filesystem::remove_all(directory);
+                return BenchmarkResult{ "", "steps/s", stepsPerSecond, true, iterations, failure };
+            }
+        );
+
+        // Random access read of a recorded (compressed) observation
+        suite.Add("trajectory_random_read", 20000, [](uint64_t iterations)
+            {
+                std::string directory = TrajectoryDirectory("read");
+                double stepsPerSecond = 0.0;
+                RecordSession(directory, 2000, stepsPerSecond);
+
+                double ns = 0.0;
+                {
+                    Trajectory::TrajectoryReader reader(directory);
+                    std::vector<uint8_t> observation(reader.Format().Size());
+                    std::mt19937 random(11);
+                    ns = MeasureNsPerOp(iterations, [&](uint64_t)
+                        {
+                            reader.ReadObservation(random() % reader.Size(), observation.data());
+                            DoNotOptimize(observation.data());
+                        }
+                    );
+                }
+                std::filesystem::remove_all(directory);
+                return BenchmarkResult{ "", "ns/op", ns, false, iterations };
+            }
+        );
+    }
+}
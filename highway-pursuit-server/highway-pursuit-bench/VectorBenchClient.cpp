@@ -0,0 +1,178 @@
+#include "VectorBenchClient.hpp"
+#include "BenchClient.hpp"
+#include "Vectorized/VectorizedServer.hpp"
+
+namespace HighwayPursuitBench
+{
+    VectorBenchClient::VectorBenchClient(uint32_t slotCount, uint32_t threadCount, int frameskip, uint32_t width, uint32_t height, uint64_t seed, uint32_t frameCostUs,
+        bool autoReset)
+        : _params(false, frameskip, ServerParams::RenderParams(width, height, true), ServerParams::TraceParams(false, 0, "."), BenchClient::UniquePrefix(),
+            ServerParams::ReplayParams("", ""), ServerParams::TrajectoryParams("", false), ServerParams::ReplayBufferParams(""), ServerParams::PoolParams(false),
+            ServerParams::AffinityParams(0, 0), ServerParams::EpisodeParams(autoReset)),
+        _slotCount(slotCount),
+        _threadCount(threadCount),
+        _gameParams(width, height, seed, frameCostUs),
+        _serverInfo(0, 0, 0, 0),
+        _stolenCount(0),
+        _closed(false)
+    {
+    }
+
+    VectorBenchClient::~VectorBenchClient()
+    {
+        if (!_closed && _serverThread.joinable())
+        {
+            try
+            {
+                Close();
+            }
+            catch (const std::exception& e)
+            {
+                std::cerr << "Failed to close the server: " << e.what() << std::endl;
+            }
+        }
+
+        if (_serverThread.joinable())
+        {
+            _serverThread.join();
+        }
+    }
+
+    void VectorBenchClient::Connect()
+    {
+        _lockServerPool = Platform::NamedSemaphore::Create(_params.serverMutexName, 0, 1);
+        _lockClientPool = Platform::NamedSemaphore::Create(_params.clientMutexName, 0, 1);
+        _returnCodeSM = Platform::SharedMemory::Create(_params.returnCodeMemoryName, sizeof(ReturnCode));
+        _serverInfoSM = Platform::SharedMemory::Create(_params.serverInfoMemoryName, sizeof(Data::ServerInfo));
+        _serverInfoExSM = Platform::SharedMemory::Create(_params.serverInfoExMemoryName, ServerInfoEx::SECTION_SIZE);
+        *static_cast<uint8_t*>(_returnCodeSM->Data()) = static_cast<uint8_t>(ErrorCode::NOT_ACK);
+
+        Data::ServerParams params = _params;
+        Synthetic::SyntheticGameParams gameParams = _gameParams;
+        uint32_t slotCount = _slotCount;
+        uint32_t threadCount = _threadCount;
+        _serverThread = std::thread([this, params, gameParams, slotCount, threadCount]()
+            {
+                std::vector<std::unique_ptr<Services::GameBackend>> backends;
+                for (uint32_t slot = 0; slot < slotCount; ++slot)
+                {
+                    Synthetic::SyntheticGameParams slotParams(gameParams.width, gameParams.height, gameParams.seed + slot, gameParams.frameCostUs);
+                    backends.push_back(std::make_unique<Synthetic::SyntheticGame>(slotParams));
+                }
+                Vectorized::VectorizedServer server(params, std::move(backends), threadCount);
+                server.Run();
+                _stolenCount = server.StolenCount();
+            }
+        );
+
+        Sync();
+        _serverInfo = *static_cast<Data::ServerInfo*>(_serverInfoSM->Data());
+        if (static_cast<ServerInfoEx*>(_serverInfoExSM->Data())->vectorSlots != _slotCount)
+        {
+            throw std::runtime_error("The server doesn't host the expected number of environments");
+        }
+
+        _instructionSM = Platform::SharedMemory::Create(_params.instructionMemoryName, sizeof(Instruction));
+        _observationSM = Platform::SharedMemory::Create(_params.observationMemoryName, ObservationSize() * _slotCount, true);
+        _infoSM = Platform::SharedMemory::Create(_params.infoMemoryName, sizeof(Info) * _slotCount);
+        _rewardSM = Platform::SharedMemory::Create(_params.rewardMemoryName, sizeof(Data::Reward) * _slotCount);
+        _actionSM = Platform::SharedMemory::Create(_params.actionMemoryName, sizeof(uint32_t) * _slotCount);
+        _terminationSM = Platform::SharedMemory::Create(_params.terminationMemoryName, sizeof(Data::Termination) * _slotCount);
+        _slotInstructionSM = Platform::SharedMemory::Create(_params.slotInstructionMemoryName, sizeof(SlotInstruction) * _slotCount);
+        if (static_cast<ServerInfoEx*>(_serverInfoExSM->Data())->autoReset != 0)
+        {
+            _finalObservationSM = Platform::SharedMemory::Create(_params.finalObservationMemoryName, ObservationSize() * _slotCount, true);
+        }
+        for (uint32_t slot = 0; slot < _slotCount; ++slot)
+        {
+            static_cast<SlotInstruction*>(_slotInstructionSM->Data())[slot] = SlotInstruction(InstructionCode::SKIP);
+        }
+        Sync();
+    }
+
+    void VectorBenchClient::SetSlot(uint32_t slot, Data::InstructionCode code, uint32_t actionMask)
+    {
+        static_cast<SlotInstruction*>(_slotInstructionSM->Data())[slot] = SlotInstruction(code);
+        static_cast<uint32_t*>(_actionSM->Data())[slot] = actionMask;
+    }
+
+    void VectorBenchClient::RunBatch()
+    {
+        SendInstruction(InstructionCode::STEP_BATCH);
+        for (uint32_t slot = 0; slot < _slotCount; ++slot)
+        {
+            static_cast<SlotInstruction*>(_slotInstructionSM->Data())[slot].code = InstructionCode::SKIP;
+        }
+    }
+
+    void VectorBenchClient::Close()
+    {
+        _closed = true;
+        SendInstruction(InstructionCode::CLOSE);
+        if (_serverThread.joinable())
+        {
+            _serverThread.join();
+        }
+    }
+
+    uint32_t VectorBenchClient::SlotCount() const
+    {
+        return _slotCount;
+    }
+
+    Data::ErrorCode VectorBenchClient::SlotResult(uint32_t slot) const
+    {
+        return static_cast<const SlotInstruction*>(_slotInstructionSM->Data())[slot].result;
+    }
+
+    const uint8_t* VectorBenchClient::Observation(uint32_t slot) const
+    {
+        return static_cast<const uint8_t*>(_observationSM->Data()) + ObservationSize() * slot;
+    }
+
+    size_t VectorBenchClient::ObservationSize() const
+    {
+        return static_cast<size_t>(_serverInfo.obsHeight) * _serverInfo.obsWidth * _serverInfo.obsChannels;
+    }
+
+    float VectorBenchClient::Reward(uint32_t slot) const
+    {
+        return static_cast<const Data::Reward*>(_rewardSM->Data())[slot].reward;
+    }
+
+    Data::Termination VectorBenchClient::Termination(uint32_t slot) const
+    {
+        return static_cast<const Data::Termination*>(_terminationSM->Data())[slot];
+    }
+
+    const uint8_t* VectorBenchClient::FinalObservation(uint32_t slot) const
+    {
+        return static_cast<const uint8_t*>(_finalObservationSM->Data()) + ObservationSize() * slot;
+    }
+
+    uint64_t VectorBenchClient::StolenCount() const
+    {
+        return _stolenCount;
+    }
+
+    void VectorBenchClient::SendInstruction(Data::InstructionCode code)
+    {
+        *static_cast<Instruction*>(_instructionSM->Data()) = Instruction(code);
+        Sync();
+    }
+
+    void VectorBenchClient::Sync()
+    {
+        _lockServerPool->Release();
+        if (!_lockClientPool->Wait(TIMEOUT))
+        {
+            throw HighwayPursuitException(ErrorCode::CLIENT_TIMEOUT);
+        }
+
+        ErrorCode code = static_cast<ErrorCode>(*static_cast<uint8_t*>(_returnCodeSM->Data()));
+        if (code != ErrorCode::ACKNOWLEDGED)
+        {
+            throw HighwayPursuitException(code);
+        }
+    }
+}
@@ -0,0 +1,62 @@
+#pragma once
+#include "pch.h"
+#include "Data/ServerTypes.hpp"
+#include "Platform/Platform.hpp"
+#include "Synthetic/SyntheticGame.hpp"
+
+namespace HighwayPursuitBench
+{
+    // Client of a vectorized server hosting synthetic games (slot i seeded with seed + i), running on a thread of the current process
+    class VectorBenchClient
+    {
+    public:
+        static constexpr uint32_t TIMEOUT = 10000; // in ms
+
+        VectorBenchClient(uint32_t slotCount, uint32_t threadCount, int frameskip, uint32_t width, uint32_t height, uint64_t seed, uint32_t frameCostUs = 0,
+            bool autoReset = false);
+        ~VectorBenchClient();
+
+        void Connect();
+        // Instruction of the slot in the next batch, SKIP by default
+        void SetSlot(uint32_t slot, Data::InstructionCode code, uint32_t actionMask = 0);
+        // Runs every slot in one round trip, the slot instructions are reset to SKIP
+        void RunBatch();
+        void Close();
+
+        uint32_t SlotCount() const;
+        Data::ErrorCode SlotResult(uint32_t slot) const;
+        const uint8_t* Observation(uint32_t slot) const;
+        size_t ObservationSize() const;
+        float Reward(uint32_t slot) const;
+        Data::Termination Termination(uint32_t slot) const;
+        // Auto-reset: last observation of the episode that ended in the last batch
+        const uint8_t* FinalObservation(uint32_t slot) const;
+        uint64_t StolenCount() const;
+
+    private:
+        const Data::ServerParams _params;
+        const uint32_t _slotCount;
+        const uint32_t _threadCount;
+        const Synthetic::SyntheticGameParams _gameParams;
+        std::unique_ptr<Platform::NamedSemaphore> _lockServerPool;
+        std::unique_ptr<Platform::NamedSemaphore> _lockClientPool;
+        std::unique_ptr<Platform::SharedMemory> _returnCodeSM;
+        std::unique_ptr<Platform::SharedMemory> _serverInfoSM;
+        std::unique_ptr<Platform::SharedMemory> _serverInfoExSM;
+        std::unique_ptr<Platform::SharedMemory> _instructionSM;
+        std::unique_ptr<Platform::SharedMemory> _observationSM;
+        std::unique_ptr<Platform::SharedMemory> _infoSM;
+        std::unique_ptr<Platform::SharedMemory> _rewardSM;
+        std::unique_ptr<Platform::SharedMemory> _actionSM;
+        std::unique_ptr<Platform::SharedMemory> _terminationSM;
+        std::unique_ptr<Platform::SharedMemory> _slotInstructionSM;
+        std::unique_ptr<Platform::SharedMemory> _finalObservationSM;
+        Data::ServerInfo _serverInfo;
+        std::atomic<uint64_t> _stolenCount;
+        std::thread _serverThread;
+        bool _closed;
+
+        void SendInstruction(Data::InstructionCode code);
+        void Sync();
+    };
+}
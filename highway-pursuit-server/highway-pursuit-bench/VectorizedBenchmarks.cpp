@@ -0,0 +1,202 @@
+#include "pch.h"
+#include "Benchmark.hpp"
+#include "BenchClient.hpp"
+#include "VectorBenchClient.hpp"
+#include "Observation/ObservationKernels.hpp"
+#include "Vectorized/WorkStealingPool.hpp"
+
+namespace HighwayPursuitBench
+{
+    namespace
+    {
+        constexpr uint32_t WIDTH = 160;
+        constexpr uint32_t HEIGHT = 120;
+        constexpr uint64_t SEED = 42; // seed of the games of BenchClient
+
+        const uint32_t STEP_ACTIONS = (1u << static_cast<uint32_t>(Data::Input::Accelerate)) | (1u << static_cast<uint32_t>(Data::Input::Fire));
+
+        // Resets every slot on the first batch, then steps them. Terminated slots are reset in the next batch.
+        BenchmarkResult MeasureVectorizedThroughput(uint32_t slotCount, uint32_t threadCount, uint64_t iterations)
+        {
+            VectorBenchClient client(slotCount, threadCount, 1, WIDTH, HEIGHT, SEED);
+            client.Connect();
+            for (uint32_t slot = 0; slot < slotCount; ++slot)
+            {
+                client.SetSlot(slot, Data::InstructionCode::RESET_NEW_GAME);
+            }
+            client.RunBatch();
+
+            std::vector<bool> done(slotCount, false);
+            auto start = std::chrono::steady_clock::now();
+            for (uint64_t i = 0; i < iterations; ++i)
+            {
+                for (uint32_t slot = 0; slot < slotCount; ++slot)
+                {
+                    client.SetSlot(slot, done[slot] ? Data::InstructionCode::RESET_NEW_LIFE : Data::InstructionCode::STEP, STEP_ACTIONS);
+                }
+                client.RunBatch();
+                for (uint32_t slot = 0; slot < slotCount; ++slot)
+                {
+                    done[slot] = client.Termination(slot).IsDone();
+                }
+            }
+            double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+            BenchmarkResult result{ "", "steps/s", iterations * slotCount / seconds, true, iterations };
+            for (uint32_t slot = 0; slot < slotCount && result.failure.empty(); ++slot)
+            {
+                if (client.SlotResult(slot) != Data::ErrorCode::ACKNOWLEDGED)
+                {
+                    result.failure = "slot " + std::to_string(slot) + " failed with code " + std::to_string(static_cast<int>(client.SlotResult(slot)));
+                }
+            }
+            client.Close();
+            return result;
+        }
+    }
+
+    void RegisterVectorizedBenchmarks(BenchmarkSuite& suite)
+    {
+        // Environment steps of 8 games hosted by one server, one round trip per batch
+        suite.Add("vectorized_steps_per_second_k8", 2000, [](uint64_t iterations)
+            {
+                return MeasureVectorizedThroughput(8, std::max(1u, std::thread::hardware_concurrency()), iterations);
+            }
+        );
+
+        // A slot behaves like a server of its own: same seed and actions, same observations
+        suite.AddCheck("vectorized_matches_single", 200, [](uint64_t iterations)
+            {
+                BenchClient single(1, WIDTH, HEIGHT);
+                single.Connect();
+                single.Reset(true);
+                VectorBenchClient vectorized(4, 2, 1, WIDTH, HEIGHT, SEED);
+                vectorized.Connect();
+                for (uint32_t slot = 0; slot < vectorized.SlotCount(); ++slot)
+                {
+                    vectorized.SetSlot(slot, Data::InstructionCode::RESET_NEW_GAME);
+                }
+                vectorized.RunBatch();
+                size_t observationSize = vectorized.ObservationSize();
+
+                BenchmarkResult result{ "", "ns/op", 0.0, false, iterations };
+                auto start = std::chrono::steady_clock::now();
+                for (uint64_t i = 0; i < iterations && result.failure.empty(); ++i)
+                {
+                    bool singleDone = single.Step(STEP_ACTIONS).IsDone();
+                    for (uint32_t slot = 0; slot < vectorized.SlotCount(); ++slot)
+                    {
+                        vectorized.SetSlot(slot, Data::InstructionCode::STEP, slot == 0 ? STEP_ACTIONS : 0);
+                    }
+                    vectorized.RunBatch();
+
+                    if (Observation::Checksum(single.Observation(), observationSize) != Observation::Checksum(vectorized.Observation(0), observationSize)
+                        || single.LastReward() != vectorized.Reward(0) || singleDone != vectorized.Termination(0).IsDone())
+                    {
+                        result.failure = "slot 0 diverged from the single server at step " + std::to_string(i);
+                    }
+                    else if (singleDone)
+                    {
+                        single.Reset(false);
+                        vectorized.SetSlot(0, Data::InstructionCode::RESET_NEW_LIFE);
+                        vectorized.RunBatch();
+                    }
+                }
+                result.value = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / iterations;
+                single.Close();
+                vectorized.Close();
+                return result;
+            }
+        );
+
+        // Slots whose episode ends start the next one in the same batch, the client never resets them
+        suite.AddCheck("vectorized_auto_reset", 2000, [](uint64_t iterations)
+            {
+                const uint32_t crashActions = 1u << static_cast<uint32_t>(Data::Input::Accelerate);
+                VectorBenchClient client(4, 2, 4, WIDTH, HEIGHT, SEED, 0, true);
+                client.Connect();
+                for (uint32_t slot = 0; slot < client.SlotCount(); ++slot)
+                {
+                    client.SetSlot(slot, Data::InstructionCode::RESET_NEW_GAME);
+                }
+                client.RunBatch();
+
+                BenchmarkResult result{ "", "ns/op", 0.0, false, iterations };
+                uint64_t episodes = 0;
+                auto start = std::chrono::steady_clock::now();
+                for (uint64_t i = 0; i < iterations && result.failure.empty(); ++i)
+                {
+                    for (uint32_t slot = 0; slot < client.SlotCount(); ++slot)
+                    {
+                        client.SetSlot(slot, Data::InstructionCode::STEP, crashActions);
+                    }
+                    client.RunBatch();
+                    for (uint32_t slot = 0; slot < client.SlotCount() && result.failure.empty(); ++slot)
+                    {
+                        if (client.SlotResult(slot) != Data::ErrorCode::ACKNOWLEDGED)
+                        {
+                            result.failure = "slot " + std::to_string(slot) + " wasn't reset after its episode ended";
+                        }
+                        else if (client.Termination(slot).IsDone())
+                        {
+                            episodes++;
+                            size_t observationSize = client.ObservationSize();
+                            if (Observation::Checksum(client.FinalObservation(slot), observationSize) == Observation::Checksum(client.Observation(slot), observationSize))
+                            {
+                                result.failure = "slot " + std::to_string(slot) + " returned its final observation as the first one of the next episode";
+                            }
+                        }
+                    }
+                }
+                result.value = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / iterations;
+                client.Close();
+                if (result.failure.empty() && episodes == 0)
+                {
+                    result.failure = "no episode ended";
+                }
+                return result;
+            }
+        );
+
+        // Tasks of the first thread cost much more than the others, which must steal them
+        suite.Add("work_stealing_balance", 100, [](uint64_t iterations)
+            {
+                constexpr uint32_t TASK_COUNT = 64;
+                Vectorized::WorkStealingPool pool(4);
+                std::vector<std::atomic<uint32_t>> runs(TASK_COUNT);
+                for (std::atomic<uint32_t>& run : runs)
+                {
+                    run = 0;
+                }
+
+                double ns = MeasureNsPerOp(iterations, [&](uint64_t)
+                    {
+                        pool.Run(TASK_COUNT, [&](uint32_t task)
+                            {
+                                if (task < TASK_COUNT / pool.ThreadCount())
+                                {
+                                    std::this_thread::sleep_for(std::chrono::microseconds(50));
+                                }
+                                runs[task]++;
+                            }
+                        );
+                    }
+                );
+
+                BenchmarkResult result{ "", "ns/op", ns, false, iterations };
+                for (uint32_t task = 0; task < TASK_COUNT && result.failure.empty(); ++task)
+                {
+                    if (runs[task] != iterations)
+                    {
+                        result.failure = "task " + std::to_string(task) + " ran " + std::to_string(runs[task]) + " times instead of " + std::to_string(iterations);
+                    }
+                }
+                if (result.failure.empty() && pool.StolenCount() == 0)
+                {
+                    result.failure = "no task was stolen";
+                }
+                return result;
+            }
+        );
+    }
+}
@@ -0,0 +1,204 @@
+#include "pch.h"
+#include "Benchmark.hpp"
+#include "BenchClient.hpp"
+#include "Video/VideoRecorder.hpp"
+#include <filesystem>
+#include <random>
+
+namespace HighwayPursuitBench
+{
+    namespace
+    {
+        constexpr uint32_t WIDTH = 160;
+        constexpr uint32_t HEIGHT = 120;
+        constexpr int FRAMESKIP = 4;
+        constexpr uint32_t DOWNSAMPLE = 2;
+        constexpr uint32_t INTERVAL = 3;
+
+        // Accelerate without firing, the episodes keep ending
+        const uint32_t CRASH_ACTIONS = 1u << static_cast<uint32_t>(Data::Input::Accelerate);
+
+        std::string VideoPath(const std::string& name)
+        {
+            return (std::filesystem::temp_directory_path() / ("hp-bench-" + name + "-" + std::to_string(std::random_device()()) + ".y4m")).string();
+        }
+
+        struct VideoFile
+        {
+            std::string header;
+            uint64_t frameCount = 0;
+            std::vector<uint8_t> firstFrame; // planes of the first frame
+        };
+
+        // Frames of a y4m video whose frames have frameSize bytes of planes, the failure is set if the file isn't made of whole frames
+        VideoFile ReadVideo(const std::string& path, size_t frameSize, std::string& failure)
+        {
+            VideoFile video;
+            std::ifstream file(path, std::ios::binary);
+            if (!std::getline(file, video.header))
+            {
+                failure = "the video has no header";
+                return video;
+            }
+
+            uint64_t size = std::filesystem::file_size(path);
+            uint64_t frameBytes = 6 + frameSize; // "FRAME\n" and the planes
+            uint64_t dataSize = size - video.header.size() - 1;
+            if (dataSize % frameBytes != 0)
+            {
+                failure = "the video doesn't hold whole frames";
+                return video;
+            }
+            video.frameCount = dataSize / frameBytes;
+
+            std::string frameHeader;
+            if (video.frameCount > 0 && (!std::getline(file, frameHeader) || frameHeader != "FRAME"))
+            {
+                failure = "the first frame has no header";
+                return video;
+            }
+            video.firstFrame.resize(video.frameCount > 0 ? frameSize : 0);
+            file.read(reinterpret_cast<char*>(video.firstFrame.data()), video.firstFrame.size());
+            return video;
+        }
+
+        // Y, U and V planes of a BGR(X) observation averaged over blocks, in floating point
+        std::vector<double> ReferencePlanes(const uint8_t* observation, uint32_t channels)
+        {
+            uint32_t width = WIDTH / DOWNSAMPLE;
+            uint32_t height = HEIGHT / DOWNSAMPLE;
+            size_t planeSize = static_cast<size_t>(width) * height;
+            std::vector<double> planes(3 * planeSize);
+            for (uint32_t y = 0; y < height; ++y)
+            {
+                for (uint32_t x = 0; x < width; ++x)
+                {
+                    double bgr[3] = { 0.0, 0.0, 0.0 };
+                    for (uint32_t dy = 0; dy < DOWNSAMPLE; ++dy)
+                    {
+                        for (uint32_t dx = 0; dx < DOWNSAMPLE; ++dx)
+                        {
+                            const uint8_t* pixel = observation + ((static_cast<size_t>(y) * DOWNSAMPLE + dy) * WIDTH + x * DOWNSAMPLE + dx) * channels;
+                            for (uint32_t channel = 0; channel < 3; ++channel)
+                            {
+                                bgr[channel] += pixel[channel] / static_cast<double>(DOWNSAMPLE * DOWNSAMPLE);
+                            }
+                        }
+                    }
+                    double b = bgr[0], g = bgr[1], r = bgr[2];
+                    size_t i = static_cast<size_t>(y) * width + x;
+                    planes[i] = 16.0 + 0.257 * r + 0.504 * g + 0.098 * b;
+                    planes[planeSize + i] = 128.0 - 0.148 * r - 0.291 * g + 0.439 * b;
+                    planes[2 * planeSize + i] = 128.0 + 0.439 * r - 0.368 * g - 0.071 * b;
+                }
+            }
+            return planes;
+        }
+    }
+
+    void RegisterVideoBenchmarks(BenchmarkSuite& suite)
+    {
+        // Step throughput while recording one observation in INTERVAL, downsampled; the first frame is the reset observation
+        // and every recorded observation is either written or counted as dropped
+        suite.Add("video_record_steps_per_second", 5000, [](uint64_t iterations)
+            {
+                std::string path = VideoPath("record");
+                BenchRecording recording;
+                recording.videoPath = path;
+                recording.videoDownsample = DOWNSAMPLE;
+                recording.videoInterval = INTERVAL;
+
+                std::vector<double> expectedFirstFrame;
+                uint64_t observations = 1;
+                uint64_t dropped = 0;
+                double stepsPerSecond = 0.0;
+                {
+                    BenchClient client(FRAMESKIP, WIDTH, HEIGHT, 0, Data::ActionEncoding::BITMASK, recording);
+                    client.Connect();
+                    client.Reset(true);
+                    expectedFirstFrame = ReferencePlanes(client.Observation(), client.ServerInfo().obsChannels);
+
+                    auto start = std::chrono::steady_clock::now();
+                    for (uint64_t i = 0; i < iterations; ++i)
+                    {
+                        observations++;
+                        if (client.Step(CRASH_ACTIONS).IsDone())
+                        {
+                            client.Reset(false);
+                            observations++;
+                        }
+                    }
+                    stepsPerSecond = iterations / std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+                    // Published before the last observation is submitted
+                    dropped = client.MetricU64("video_dropped");
+                    client.Close();
+                }
+
+                std::string failure;
+                size_t planeSize = static_cast<size_t>(WIDTH / DOWNSAMPLE) * (HEIGHT / DOWNSAMPLE);
+                VideoFile video = ReadVideo(path, 3 * planeSize, failure);
+                uint64_t recorded = (observations + INTERVAL - 1) / INTERVAL;
+                std::string expectedHeader = "YUV4MPEG2 W" + std::to_string(WIDTH / DOWNSAMPLE) + " H" + std::to_string(HEIGHT / DOWNSAMPLE)
+                    + " F60:" + std::to_string(FRAMESKIP * INTERVAL) + " Ip A1:1 C444";
+                if (failure.empty() && video.header != expectedHeader)
+                {
+                    failure = "unexpected header '" + video.header + "'";
+                }
+                if (failure.empty() && (video.frameCount > recorded || video.frameCount + dropped + 1 < recorded))
+                {
+                    failure = std::to_string(video.frameCount) + " frames written and " + std::to_string(dropped) + " dropped out of "
+                        + std::to_string(recorded) + " recorded";
+                }
+                for (size_t i = 0; i < video.firstFrame.size() && failure.empty(); ++i)
+                {
+                    // The server converts in fixed point
+                    if (std::abs(video.firstFrame[i] - expectedFirstFrame[i]) > 1.5)
+                    {
+                        failure = "sample " + std::to_string(i) + " of the first frame differs from the reset observation";
+                    }
+                }
+                std::filesystem::remove(path);
+                return BenchmarkResult{ "", "steps/s", stepsPerSecond, true, iterations, failure };
+            }
+        );
+
+        // Submitting full size frames much faster than they're written: submits stay a copy, the frames that find the queue full
+        // are dropped and every frame is either in the file or counted as dropped
+        suite.Add("video_submit_overflow", 2000, [](uint64_t iterations)
+            {
+                constexpr uint32_t FULL_WIDTH = 640;
+                constexpr uint32_t FULL_HEIGHT = 480;
+                Data::BufferFormat format(FULL_WIDTH, FULL_HEIGHT, 4);
+                std::vector<uint8_t> observation(format.Size());
+                std::mt19937 random(3);
+                for (uint8_t& value : observation)
+                {
+                    value = static_cast<uint8_t>(random());
+                }
+
+                std::string path = VideoPath("overflow");
+                double ns = 0.0;
+                uint64_t dropped = 0;
+                {
+                    Video::VideoRecorder recorder(Data::ServerParams::VideoParams(path, 1, 1, 8), format, 60, 1);
+                    ns = MeasureNsPerOp(iterations, [&](uint64_t i)
+                        {
+                            observation[0] = static_cast<uint8_t>(i);
+                            recorder.Submit(observation.data());
+                        }
+                    );
+                    dropped = recorder.DroppedFrames();
+                }
+
+                std::string failure;
+                VideoFile video = ReadVideo(path, 3 * static_cast<size_t>(FULL_WIDTH) * FULL_HEIGHT, failure);
+                if (failure.empty() && video.frameCount + dropped != iterations)
+                {
+                    failure = std::to_string(video.frameCount) + " frames written and " + std::to_string(dropped) + " dropped out of " + std::to_string(iterations);
+                }
+                std::filesystem::remove(path);
+                return BenchmarkResult{ "", "ns/op", ns, false, iterations, failure };
+            }
+        );
+    }
+}
@@ -8,7 +8,7 @@
 
 int main(int argc, char* argv[])
 {
-    HighwayPursuitLauncher::launch(argc, argv);
+    return HighwayPursuitLauncher::launch(argc, argv);
 }
 
 namespace HighwayPursuitLauncher
@@ -48,6 +48,12 @@ namespace HighwayPursuitLauncher
             
             // Inject the DLL into the target process
             auto args = Shared::HighwayPursuitArgs(isRealTime, frameSkip, renderWidth, renderHeight, renderEnabled, argv[ARG_LOG_DIR_PATH], argv[ARG_SHARED_RESOURCES_PREFIX]);
+            if (!processOptions(argc, argv, args))
+            {
+                std::cerr << "Invalid optional arguments" << std::endl;
+                return ExitCode::InvalidArgs;
+            }
+
             if (!Injection::CreateAndInject(targetExe, targetDll, args))
             {
                 return ExitCode::InjectionFailed;
@@ -92,13 +98,36 @@ namespace HighwayPursuitLauncher
         }
     }
 
+    // Parse a list of logical processors (e.g. 0,2-3) to an affinity mask
+    static uint64_t parseCoreList(const std::string& list)
+    {
+        uint64_t mask = 0;
+        std::istringstream stream(list);
+        std::string range;
+        while (std::getline(stream, range, ','))
+        {
+            size_t dash = range.find('-');
+            unsigned long first = std::stoul(range.substr(0, dash));
+            unsigned long last = dash == std::string::npos ? first : std::stoul(range.substr(dash + 1));
+            if (last >= 64 || first > last)
+            {
+                throw std::invalid_argument("Invalid processor range '" + range + "'");
+            }
+            for (unsigned long processor = first; processor <= last; ++processor)
+            {
+                mask |= 1ull << processor;
+            }
+        }
+        return mask;
+    }
+
     // Function to process command-line arguments
     static bool processArgs(int argc, char* argv[], std::string& targetExeOut, std::string& targetDllOut)
     {
         // Check if we have the right number of arguments
-        if (argc != TOTAL_ARGS)
+        if (argc < TOTAL_ARGS)
         {
-            std::cerr << "Invalid total args, expected " << TOTAL_ARGS << " got " << argc << std::endl;
+            std::cerr << "Invalid total args, expected at least " << TOTAL_ARGS << " got " << argc << std::endl;
             return false;
         }
 
@@ -134,4 +163,159 @@ namespace HighwayPursuitLauncher
 
         return true;
     }
+
+    // Parse the optional args that follow the positional ones, in the format --name=value
+    static bool processOptions(int argc, char* argv[], Shared::HighwayPursuitArgs& args)
+    {
+        for (int i = TOTAL_ARGS; i < argc; ++i)
+        {
+            std::string option(argv[i]);
+            size_t separator = option.find('=');
+            if (separator == std::string::npos)
+            {
+                std::cerr << "Option '" << option << "' is not in the format --name=value" << std::endl;
+                return false;
+            }
+
+            std::string name = option.substr(0, separator);
+            std::string value = option.substr(separator + 1);
+            if (name == OPT_TRACE)
+            {
+                args.traceEnabled = parseBool(value);
+            }
+            else if (name == OPT_TRACE_MEMORY_BUDGET)
+            {
+                args.traceMemoryBudget = static_cast<uint32_t>(std::stoul(value));
+            }
+            else if (name == OPT_RECORD_ACTIONS)
+            {
+                strncpy_s(args.actionLogPath, value.c_str(), MAX_PATH - 1);
+            }
+            else if (name == OPT_REPLAY)
+            {
+                strncpy_s(args.replayPath, value.c_str(), MAX_PATH - 1);
+            }
+            else if (name == OPT_TRAJECTORY_DIR)
+            {
+                strncpy_s(args.trajectoryDir, value.c_str(), MAX_PATH - 1);
+            }
+            else if (name == OPT_TRAJECTORY_COMPRESSION)
+            {
+                args.trajectoryCompression = parseBool(value);
+            }
+            else if (name == OPT_REPLAY_BUFFER)
+            {
+                strncpy_s(args.replayBufferName, value.c_str(), Shared::HighwayPursuitArgs::prefixMaxSize - 1);
+            }
+            else if (name == OPT_PARKED)
+            {
+                args.parked = parseBool(value);
+            }
+            else if (name == OPT_GAME_CORES)
+            {
+                args.gameCores = parseCoreList(value);
+            }
+            else if (name == OPT_SERVER_CORES)
+            {
+                args.serverCores = parseCoreList(value);
+            }
+            else if (name == OPT_PLACEMENT)
+            {
+                size_t slash = value.find('/');
+                if (slash == std::string::npos)
+                {
+                    std::cerr << "Placement '" << value << "' is not in the format index/count" << std::endl;
+                    return false;
+                }
+                args.placementIndex = static_cast<uint32_t>(std::stoul(value.substr(0, slash)));
+                args.placementCount = static_cast<uint32_t>(std::stoul(value.substr(slash + 1)));
+                if (args.placementIndex >= args.placementCount)
+                {
+                    std::cerr << "Placement index out of range" << std::endl;
+                    return false;
+                }
+            }
+            else if (name == OPT_AUTO_RESET)
+            {
+                args.autoReset = parseBool(value);
+            }
+            else if (name == OPT_STICKY_ACTIONS)
+            {
+                args.stickyProbability = std::stof(value);
+                if (args.stickyProbability < 0.0f || args.stickyProbability > 1.0f)
+                {
+                    std::cerr << "Sticky action probability out of [0, 1]" << std::endl;
+                    return false;
+                }
+            }
+            else if (name == OPT_SEED)
+            {
+                args.seed = std::stoull(value);
+            }
+            else if (name == OPT_AGENT)
+            {
+                strncpy_s(args.agentPath, value.c_str(), MAX_PATH - 1);
+            }
+            else if (name == OPT_AGENT_CONFIG)
+            {
+                strncpy_s(args.agentConfig, value.c_str(), Shared::HighwayPursuitArgs::agentConfigMaxSize - 1);
+            }
+            else if (name == OPT_AGENT_EPISODES)
+            {
+                args.agentEpisodes = static_cast<uint32_t>(std::stoul(value));
+            }
+            else if (name == OPT_AGENT_MAX_STEPS)
+            {
+                args.agentMaxSteps = static_cast<uint32_t>(std::stoul(value));
+            }
+            else if (name == OPT_AGENT_STATS)
+            {
+                strncpy_s(args.agentStatsPath, value.c_str(), MAX_PATH - 1);
+            }
+            else if (name == OPT_STARTUP_IMAGE)
+            {
+                strncpy_s(args.startupImagePath, value.c_str(), MAX_PATH - 1);
+            }
+            else if (name == OPT_SPECTATOR)
+            {
+                strncpy_s(args.spectatorName, value.c_str(), Shared::HighwayPursuitArgs::prefixMaxSize - 1);
+            }
+            else if (name == OPT_SPECTATOR_FPS)
+            {
+                args.spectatorFps = std::stof(value);
+                if (args.spectatorFps < 0.0f)
+                {
+                    std::cerr << "Negative spectator rate" << std::endl;
+                    return false;
+                }
+            }
+            else if (name == OPT_VIDEO)
+            {
+                strncpy_s(args.videoPath, value.c_str(), MAX_PATH - 1);
+            }
+            else if (name == OPT_VIDEO_DOWNSAMPLE)
+            {
+                args.videoDownsample = static_cast<uint32_t>(std::stoul(value));
+            }
+            else if (name == OPT_VIDEO_INTERVAL)
+            {
+                args.videoInterval = static_cast<uint32_t>(std::stoul(value));
+            }
+            else if (name == OPT_VIDEO_QUEUE)
+            {
+                args.videoQueue = static_cast<uint32_t>(std::stoul(value));
+                if (args.videoQueue == 0)
+                {
+                    std::cerr << "The video queue needs room for a frame" << std::endl;
+                    return false;
+                }
+            }
+            else
+            {
+                std::cerr << "Unknown option '" << name << "'" << std::endl;
+                return false;
+            }
+        }
+        return true;
+    }
 }
@@ -1,6 +1,7 @@
 #pragma once
 #include <string>
 #include <windows.h>
+#include "HighwayPursuitArgs.hpp"
 
 namespace HighwayPursuitLauncher
 {
@@ -14,7 +15,35 @@ namespace HighwayPursuitLauncher
     const int ARG_ENABLE_RENDERING = 6;
     const int ARG_LOG_DIR_PATH = 7;
     const int ARG_SHARED_RESOURCES_PREFIX = 8;
-    const int TOTAL_ARGS = 9;
+    const int TOTAL_ARGS = 9; // Optional args of the form --name=value can follow
+
+    // Optional args
+    const std::string OPT_TRACE = "--trace";
+    const std::string OPT_TRACE_MEMORY_BUDGET = "--trace-memory-budget";
+    const std::string OPT_RECORD_ACTIONS = "--record-actions";
+    const std::string OPT_REPLAY = "--replay";
+    const std::string OPT_TRAJECTORY_DIR = "--trajectory-dir";
+    const std::string OPT_TRAJECTORY_COMPRESSION = "--trajectory-compression";
+    const std::string OPT_REPLAY_BUFFER = "--replay-buffer";
+    const std::string OPT_PARKED = "--parked";
+    const std::string OPT_GAME_CORES = "--game-cores"; // list of logical processors, e.g. 0,2-3
+    const std::string OPT_SERVER_CORES = "--server-cores";
+    const std::string OPT_PLACEMENT = "--placement"; // automatic placement of instance i out of n, as i/n
+    const std::string OPT_AUTO_RESET = "--auto-reset";
+    const std::string OPT_STICKY_ACTIONS = "--sticky-actions"; // probability of each frame to keep the previous action
+    const std::string OPT_SEED = "--seed";
+    const std::string OPT_AGENT = "--agent"; // agent plugin played instead of serving a client
+    const std::string OPT_AGENT_CONFIG = "--agent-config";
+    const std::string OPT_AGENT_EPISODES = "--agent-episodes";
+    const std::string OPT_AGENT_MAX_STEPS = "--agent-max-steps"; // per episode, 0: no cap
+    const std::string OPT_AGENT_STATS = "--agent-stats"; // csv of the episodes of the agent
+    const std::string OPT_STARTUP_IMAGE = "--startup-image"; // game state after the intro, written by the first instance
+    const std::string OPT_SPECTATOR = "--spectator"; // name of the section of the latest frame for viewers
+    const std::string OPT_SPECTATOR_FPS = "--spectator-fps";
+    const std::string OPT_VIDEO = "--video"; // y4m video of the observations
+    const std::string OPT_VIDEO_DOWNSAMPLE = "--video-downsample";
+    const std::string OPT_VIDEO_INTERVAL = "--video-interval"; // one observation out of n is recorded
+    const std::string OPT_VIDEO_QUEUE = "--video-queue"; // frames waiting to be written, further ones are dropped
 
     // Exit codes as enum
     enum ExitCode : int
@@ -30,4 +59,6 @@ namespace HighwayPursuitLauncher
     static bool processArgs(int argc, char* argv[], std::string& targetExe, std::string& targetDll);
     static bool parseBool(std::string str);
     static bool tryParseResolution(const std::string& arg, unsigned int& width, unsigned int& height);
+    static uint64_t parseCoreList(const std::string& list);
+    static bool processOptions(int argc, char* argv[], Shared::HighwayPursuitArgs& args);
 }
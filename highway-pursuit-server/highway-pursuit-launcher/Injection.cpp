@@ -118,7 +118,7 @@ namespace Injection
     }
 
 
-    bool CreateAndInject(const std::string& targetExePath, const std::string& dllPath, const HighwayPursuitArgs& args)
+    bool CreateAndInject(const std::string& targetExePath, const std::string& dllPath, const HighwayPursuitArgs& launchArgs)
     {
         std::string targetDllPath = GetFullPath(dllPath);
 
@@ -132,6 +132,10 @@ namespace Injection
             return false;
         }
 
+        // Pinned by Initialize before the game runs
+        HighwayPursuitArgs args = launchArgs;
+        args.gameThreadId = pi.dwThreadId;
+
         // Inject DLL
         if (!InjectDll(pi.hProcess, targetDllPath))
         {
@@ -0,0 +1,74 @@
+#include "../pch.h"
+#include "ActionScheduler.hpp"
+#include <algorithm>
+
+namespace Actions
+{
+    namespace
+    {
+        // Draws are compared on their 32 high bits
+        constexpr double DRAW_RANGE = 4294967296.0;
+
+        // splitmix64, spreads consecutive seeds (instance i uses seed + i) and never returns the 0 state of xorshift for them
+        uint64_t MixSeed(uint64_t seed)
+        {
+            uint64_t z = seed + 0x9E3779B97F4A7C15ull;
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+            z ^= z >> 31;
+            return z != 0 ? z : 1;
+        }
+    }
+
+    ActionScheduler::ActionScheduler(const Data::ServerParams::ActionParams& params, int frameskip)
+        : _frameskip(frameskip),
+        _stickyThreshold(static_cast<uint64_t>(std::clamp(params.stickyProbability, 0.0f, 1.0f) * DRAW_RANGE)),
+        _rng(MixSeed(params.seed))
+    {
+    }
+
+    int ActionScheduler::FrameCount(uint32_t repeat) const
+    {
+        if (repeat == 0)
+        {
+            return _frameskip;
+        }
+        return static_cast<int>(std::min(repeat, Data::ActionRepeat::MAX_FRAMES));
+    }
+
+    Data::InputSet ActionScheduler::FrameActions(const Data::InputSet& requested)
+    {
+        // The generator only advances with sticky actions, runs without them don't depend on the seed
+        if (_stickyThreshold != 0 && (Next() >> 32) < _stickyThreshold)
+        {
+            return _previous;
+        }
+        _previous = requested;
+        return requested;
+    }
+
+    void ActionScheduler::ResetEpisode()
+    {
+        _previous = Data::InputSet();
+    }
+
+    ActionScheduler::State ActionScheduler::Capture() const
+    {
+        return State{ _rng, _previous.Mask() };
+    }
+
+    void ActionScheduler::Restore(const State& state)
+    {
+        _rng = state.rng;
+        _previous = Data::InputSet::FromMask(state.previousMask);
+    }
+
+    uint64_t ActionScheduler::Next()
+    {
+        // xorshift64, like the synthetic game
+        _rng ^= _rng << 13;
+        _rng ^= _rng >> 7;
+        _rng ^= _rng << 17;
+        return _rng;
+    }
+}
@@ -0,0 +1,39 @@
+#pragma once
+#include "../Data/ServerTypes.hpp"
+
+namespace Actions
+{
+    // Frames of a step and the action applied on each of them. The action of a step is repeated for its repeat count (the frameskip
+    // by default); with sticky actions each frame keeps the action of the previous frame with a fixed probability instead.
+    // The draws come from a generator seeded per instance, runs with the same seed and actions are reproducible.
+    class ActionScheduler
+    {
+    public:
+        // Saved with the snapshots, rollouts from a snapshot draw the same sticky actions
+        struct State
+        {
+            uint64_t rng;
+            uint32_t previousMask;
+        };
+
+        ActionScheduler(const Data::ServerParams::ActionParams& params, int frameskip);
+
+        // Frames of a step with the given repeat count, 0 for the frameskip and clamped to ActionRepeat::MAX_FRAMES
+        int FrameCount(uint32_t repeat) const;
+        // Action applied on the next frame of the step, draws once with sticky actions
+        Data::InputSet FrameActions(const Data::InputSet& requested);
+        // New episodes start without a previous action
+        void ResetEpisode();
+
+        State Capture() const;
+        void Restore(const State& state);
+
+    private:
+        const int _frameskip;
+        const uint64_t _stickyThreshold; // draws below it keep the previous action, 0 without sticky actions
+        uint64_t _rng;
+        Data::InputSet _previous;
+
+        uint64_t Next();
+    };
+}
@@ -0,0 +1,91 @@
+#include "../pch.h"
+#include "AgentHost.hpp"
+
+namespace Agents
+{
+    AgentHost::AgentHost(const std::string& pluginPath, const HpAgentSpec& spec, const std::string& config)
+        : _library(Platform::SharedLibrary::Load(pluginPath)),
+        _api(nullptr),
+        _agent(nullptr)
+    {
+        HpAgentEntryPoint entryPoint = reinterpret_cast<HpAgentEntryPoint>(_library->Symbol(HP_AGENT_ENTRY_POINT));
+        if (entryPoint == nullptr)
+        {
+            throw std::runtime_error(pluginPath + " doesn't export " HP_AGENT_ENTRY_POINT);
+        }
+        _api = entryPoint();
+        if (_api == nullptr || _api->abiVersion != HP_AGENT_ABI_VERSION)
+        {
+            throw std::runtime_error(pluginPath + " isn't an agent plugin of ABI version " + std::to_string(HP_AGENT_ABI_VERSION));
+        }
+        if (_api->create == nullptr || _api->destroy == nullptr || _api->reset == nullptr || _api->act == nullptr)
+        {
+            throw std::runtime_error(pluginPath + " doesn't implement every required function of the agent ABI");
+        }
+
+        _agent = _api->create(&spec, config.c_str());
+        if (_agent == nullptr)
+        {
+            throw std::runtime_error(pluginPath + " couldn't create an agent with the config '" + config + "'");
+        }
+    }
+
+    AgentHost::~AgentHost()
+    {
+        _api->destroy(_agent);
+    }
+
+    void AgentHost::Reset(const uint8_t* observation)
+    {
+        _api->reset(_agent, observation);
+    }
+
+    uint32_t AgentHost::Act(const uint8_t* observation)
+    {
+        return _api->act(_agent, observation);
+    }
+
+    void AgentHost::Feedback(float reward, const Data::Termination& termination)
+    {
+        if (_api->feedback != nullptr)
+        {
+            HpAgentFeedback feedback{ reward, termination.terminated, termination.truncated };
+            _api->feedback(_agent, &feedback);
+        }
+    }
+
+    std::string AgentReport::ToString() const
+    {
+        double returns = 0.0;
+        for (const Data::EpisodeRecord& episode : episodes)
+        {
+            returns += episode.episodeReturn;
+        }
+        std::ostringstream oss;
+        oss << "Agent played " << episodes.size() << " episodes in " << steps << " steps";
+        if (!episodes.empty())
+        {
+            oss << ", mean return " << returns / episodes.size();
+        }
+        return oss.str();
+    }
+
+    void AgentReport::WriteCsv(const std::string& path) const
+    {
+        std::ofstream file(path, std::ios::trunc);
+        if (!file)
+        {
+            throw std::runtime_error("Couldn't open " + path);
+        }
+        file << "index,steps,frames,life,return,wall_time,game_time,terminated,truncated\n";
+        for (const Data::EpisodeRecord& episode : episodes)
+        {
+            file << episode.index << ',' << episode.steps << ',' << episode.frames << ',' << episode.life << ',' << episode.episodeReturn << ','
+                << episode.wallTime << ',' << episode.gameTime << ',' << static_cast<int>(episode.terminated) << ',' << static_cast<int>(episode.truncated) << '\n';
+        }
+        if (!file)
+        {
+            throw std::runtime_error("Couldn't write " + path);
+        }
+    }
+}
@@ -0,0 +1,39 @@
+#pragma once
+#include "../Data/ServerTypes.hpp"
+#include "../Platform/Platform.hpp"
+#include "AgentPlugin.h"
+
+namespace Agents
+{
+    // Agent created by a plugin library (see AgentPlugin.h), destroyed before the library is unloaded
+    class AgentHost
+    {
+    public:
+        // Throws if the library isn't a plugin of this ABI version, or if the plugin refuses the environment
+        AgentHost(const std::string& pluginPath, const HpAgentSpec& spec, const std::string& config);
+        ~AgentHost();
+
+        void Reset(const uint8_t* observation);
+        uint32_t Act(const uint8_t* observation);
+        void Feedback(float reward, const Data::Termination& termination);
+
+    private:
+        AgentHost(const AgentHost&) = delete;
+        AgentHost& operator=(const AgentHost&) = delete;
+
+        std::unique_ptr<Platform::SharedLibrary> _library;
+        const HpAgentApi* _api;
+        void* _agent;
+    };
+
+    // Episodes an agent played in the server
+    struct AgentReport
+    {
+        uint64_t steps = 0;
+        std::vector<Data::EpisodeRecord> episodes;
+
+        std::string ToString() const;
+        // One line per episode after a header line
+        void WriteCsv(const std::string& path) const;
+    };
+}
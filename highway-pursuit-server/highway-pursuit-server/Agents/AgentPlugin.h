@@ -0,0 +1,65 @@
+/*
+ * C ABI of the agent plugins: shared libraries that the server loads to act in its step loop, without a client.
+ * A plugin exports hp_agent_api, which returns its function table. The server creates one agent, resets it at the start
+ * of every episode and asks it for the action of every step. Observations are given in place and are only valid during the call.
+ * Episodes also end when the server truncates them (--agent-max-steps), the feedback reports it.
+ */
+#ifndef HP_AGENT_PLUGIN_H
+#define HP_AGENT_PLUGIN_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define HP_AGENT_ABI_VERSION 1
+#define HP_AGENT_ENTRY_POINT "hp_agent_api"
+
+#if defined(_WIN32)
+#define HP_AGENT_EXPORT __declspec(dllexport)
+#else
+#define HP_AGENT_EXPORT __attribute__((visibility("default")))
+#endif
+
+/* The environment the agent acts in, given at creation */
+typedef struct HpAgentSpec
+{
+    uint32_t abiVersion; /* of the server */
+    uint32_t obsWidth;
+    uint32_t obsHeight;
+    uint32_t obsChannels; /* observations are height x width x obsChannels bytes, 4 BGRX bytes per pixel (blue, green, red, unused) */
+    uint32_t actionCount; /* bit i of an action is the input i */
+    uint32_t frameskip;
+    uint64_t seed; /* of the run, for stochastic agents */
+} HpAgentSpec;
+
+/* Outcome of the last action */
+typedef struct HpAgentFeedback
+{
+    float reward;
+    uint8_t terminated;
+    uint8_t truncated;
+} HpAgentFeedback;
+
+typedef struct HpAgentApi
+{
+    uint32_t abiVersion; /* HP_AGENT_ABI_VERSION the plugin was built with, the server refuses other versions */
+    /* Returns the state of a new agent, NULL if it can't act in this environment. config is the agent option string (may be empty). */
+    void* (*create)(const HpAgentSpec* spec, const char* config);
+    void (*destroy)(void* agent);
+    /* Start of an episode, with its first observation */
+    void (*reset)(void* agent, const uint8_t* observation);
+    /* Action for the observation, bit i set if input i is held */
+    uint32_t (*act)(void* agent, const uint8_t* observation);
+    /* Optional (NULL if unused): reward and termination of the last action */
+    void (*feedback)(void* agent, const HpAgentFeedback* feedback);
+} HpAgentApi;
+
+typedef const HpAgentApi* (*HpAgentEntryPoint)(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HP_AGENT_PLUGIN_H */
@@ -1,140 +1,361 @@
 #include "pch.h"
 #include "CommunicationManager.hpp"
+#include "Tracing/TraceRecorder.hpp"
+#include "Observation/ObservationKernels.hpp"
+#include "Pipeline/TransformPipeline.hpp"
 
 CommunicationManager::CommunicationManager(const ServerParams& args)
     : _args(args),
     _cleanLastErrorOnNextRequest(false),
     _serverInfo(ServerInfo(0, 0, 0, 0)),
+    _actionEncoding(ActionEncoding::BYTE_PER_ACTION),
+    _slotCount(1),
     _lockServerPool(nullptr),
     _lockClientPool(nullptr),
     _returnCodeSM(nullptr),
     _serverInfoSM(nullptr),
+    _serverInfoExSM(nullptr),
     _instructionSM(nullptr),
     _observationSM(nullptr),
     _infoSM(nullptr),
     _rewardSM(nullptr),
     _actionSM(nullptr),
     _terminationSM(nullptr),
-    _fileMappings({}),
-    _mapViews({})
+    _instructionArgumentSM(nullptr),
+    _slotInstructionSM(nullptr),
+    _finalObservationSM(nullptr),
+    _actionRepeatSM(nullptr),
+    _episodeStatsSM(nullptr),
+    _metricsSM(nullptr),
+    _heartbeat(nullptr)
 {
    
 }
 
 CommunicationManager::~CommunicationManager()
 {
-    for (auto handle: _mapViews)
+    // Mappings and semaphores are released by their owners
+}
+
+void CommunicationManager::OpenHeartbeat()
+{
+    _heartbeat = static_cast<Heartbeat*>(TryConnectToSharedMemory(_args.heartbeatMemoryName, Heartbeat::SECTION_SIZE));
+    if (_heartbeat != nullptr)
     {
-        UnmapViewOfFile(handle);
+        _heartbeat->processId.store(Platform::CurrentProcessId(), std::memory_order_relaxed);
+        SetHeartbeatState(HeartbeatState::STARTING);
     }
+}
 
-    for (auto pBuffer : _fileMappings)
+void CommunicationManager::Beat()
+{
+    // The slots of a vectorized server beat concurrently
+    if (_heartbeat != nullptr)
     {
-        UnmapViewOfFile(pBuffer);
+        _heartbeat->beat.fetch_add(1, std::memory_order_release);
     }
+}
 
-    if (_lockServerPool != nullptr)
+void CommunicationManager::SetHeartbeatState(HeartbeatState state)
+{
+    if (_heartbeat != nullptr)
     {
-        CloseHandle(_lockServerPool);
+        _heartbeat->state.store(static_cast<uint32_t>(state), std::memory_order_release);
+        Beat();
     }
+}
 
-    if (_lockClientPool != nullptr)
+void CommunicationManager::Park()
+{
+    std::unique_ptr<Platform::NamedSemaphore> lockReady = Platform::NamedSemaphore::Open(_args.readyMutexName);
+    if (!lockReady->Release())
     {
-        CloseHandle(_lockClientPool);
+        throw std::runtime_error("Failed to release semaphore.");
     }
 }
 
-void CommunicationManager::Connect(const ServerInfo& serverInfo)
+bool CommunicationManager::Connect(const ServerInfo& serverInfo, const ServerInfoEx& serverInfoEx)
 {
     // Update current server info
     _serverInfo = serverInfo;
 
     // Open synchronization semaphores mutex
-    _lockServerPool = OpenSemaphoreA(SYNCHRONIZE | SEMAPHORE_MODIFY_STATE, false, _args.serverMutexName.c_str());
-    if (_lockServerPool == nullptr)
-    {
-        throw std::runtime_error("Couldn't get semaphore, error " + std::to_string(GetLastError()));
-    }
+    _lockServerPool = Platform::NamedSemaphore::Open(_args.serverMutexName);
+    _lockClientPool = Platform::NamedSemaphore::Open(_args.clientMutexName);
 
-    _lockClientPool = OpenSemaphoreA(SYNCHRONIZE | SEMAPHORE_MODIFY_STATE, true, _args.clientMutexName.c_str());
-    if (_lockClientPool == nullptr)
-    {
-        throw std::runtime_error("Couldn't get semaphore, error " + std::to_string(GetLastError()));
-    }
-
-    SyncOnClientQuery([this]()
+    bool discarded = false;
+    SyncOnClientQuery([this, &serverInfo, &serverInfoEx, &discarded]()
         {
-            _returnCodeSM = ConnectToSharedMemory(_args.returnCodeMemoryName, sizeof(ServerInfo));
-            _serverInfoSM = ConnectToSharedMemory(_args.serverInfoMemoryName, sizeof(ReturnCode));
+            _returnCodeSM = ConnectToSharedMemory(_args.returnCodeMemoryName, sizeof(ReturnCode));
+            if (_args.poolParams.parked && ReadFromBuffer<ErrorCode>(_returnCodeSM) == ErrorCode::DISCARDED)
+            {
+                discarded = true;
+                return;
+            }
+            _serverInfoSM = ConnectToSharedMemory(_args.serverInfoMemoryName, sizeof(ServerInfo));
+
+            // Only clients that know the extended protocol create its section
+            _serverInfoExSM = TryConnectToSharedMemory(_args.serverInfoExMemoryName, ServerInfoEx::SECTION_SIZE);
+            if (_serverInfoExSM != nullptr)
+            {
+                _actionEncoding = serverInfoEx.actionEncoding;
+                _slotCount = serverInfoEx.vectorSlots;
+                ServerInfoEx extendedInfo = serverInfoEx;
+                Metrics::Describe(extendedInfo.metricsSchema);
+                WriteToBuffer(extendedInfo, _serverInfoExSM);
+
+                // Clients get the info of the transformed environment
+                void* pipelineConfigSM = TryConnectToSharedMemory(_args.pipelineConfigMemoryName, sizeof(PipelineConfig));
+                if (pipelineConfigSM != nullptr)
+                {
+                    _pipelineConfig = ReadFromBuffer<PipelineConfig>(pipelineConfigSM);
+                    _serverInfo = Pipeline::TransformPipeline::Describe(_pipelineConfig, serverInfo);
+                }
+            }
+            // Legacy clients can't address the slots of a vectorized server
+            else if (serverInfoEx.vectorSlots > 1)
+            {
+                throw HighwayPursuitException(ErrorCode::UNSUPPORTED_INSTRUCTION);
+            }
 
             WriteACK();
             WriteToBuffer(_serverInfo, _serverInfoSM);
-        }
+        },
+        _args.poolParams.parked ? PARKED_TIMEOUT : CLIENT_TIMEOUT
     );
+    if (discarded)
+    {
+        return false;
+    }
 
     SyncOnClientQuery([this]()
         {
-            size_t actionSize = _serverInfo.actionCount;
-            size_t observationSize = _serverInfo.obsWidth* _serverInfo.obsHeight* _serverInfo.obsChannels;
+            size_t actionSize = _actionEncoding == ActionEncoding::BITMASK ? sizeof(uint32_t) : _serverInfo.actionCount;
 
+            // Slots follow each other in the sections
             _instructionSM = ConnectToSharedMemory(_args.instructionMemoryName, sizeof(Instruction));
-            _observationSM = ConnectToSharedMemory(_args.observationMemoryName, observationSize);
-            _infoSM = ConnectToSharedMemory(_args.infoMemoryName, sizeof(Info));
-            _rewardSM = ConnectToSharedMemory(_args.rewardMemoryName, sizeof(Instruction));
-            _actionSM = ConnectToSharedMemory(_args.actionMemoryName, actionSize);
-            _terminationSM = ConnectToSharedMemory(_args.terminationMemoryName, sizeof(Termination));
+            _observationSM = ConnectToSharedMemory(_args.observationMemoryName, ObservationSize() * _slotCount, true);
+            if (_serverInfoExSM != nullptr)
+            {
+                ServerInfoEx extendedInfo = ReadFromBuffer<ServerInfoEx>(_serverInfoExSM);
+                extendedInfo.observationPageSize = static_cast<uint32_t>(_sharedMemories.back()->PageSize());
+                WriteToBuffer(extendedInfo, _serverInfoExSM);
+            }
+            _infoSM = ConnectToSharedMemory(_args.infoMemoryName, sizeof(Info) * _slotCount);
+            _rewardSM = ConnectToSharedMemory(_args.rewardMemoryName, sizeof(Reward) * _slotCount);
+            _actionSM = ConnectToSharedMemory(_args.actionMemoryName, actionSize * _slotCount);
+            _terminationSM = ConnectToSharedMemory(_args.terminationMemoryName, sizeof(Termination) * _slotCount);
+            if (_serverInfoExSM != nullptr)
+            {
+                _instructionArgumentSM = TryConnectToSharedMemory(_args.instructionArgumentMemoryName, sizeof(InstructionArgument));
+                _actionRepeatSM = TryConnectToSharedMemory(_args.actionRepeatMemoryName, sizeof(ActionRepeat) * _slotCount);
+                _episodeStatsSM = TryConnectToSharedMemory(_args.episodeStatsMemoryName, sizeof(EpisodeStats) * _slotCount);
+                _metricsSM = TryConnectToSharedMemory(_args.metricsMemoryName, static_cast<size_t>(Metrics::BlockSize()) * _slotCount);
+            }
+            if (_slotCount > 1)
+            {
+                _slotInstructionSM = ConnectToSharedMemory(_args.slotInstructionMemoryName, sizeof(SlotInstruction) * _slotCount);
+            }
+            // Clients that don't need the last observations of the episodes don't create it
+            if (_args.episodeParams.autoReset)
+            {
+                _finalObservationSM = TryConnectToSharedMemory(_args.finalObservationMemoryName, ObservationSize() * _slotCount, true);
+            }
         }
     );
+    return true;
+}
+
+void CommunicationManager::ConnectDetached(const ServerInfo& serverInfo, const PipelineConfig& pipelineConfig)
+{
+    _pipelineConfig = pipelineConfig;
+    _serverInfo = Pipeline::TransformPipeline::Describe(pipelineConfig, serverInfo);
+    _actionEncoding = ActionEncoding::BITMASK;
+
+    _returnCodeSM = AllocateDetachedSection(sizeof(ReturnCode));
+    _serverInfoSM = AllocateDetachedSection(sizeof(ServerInfo));
+    _serverInfoExSM = AllocateDetachedSection(ServerInfoEx::SECTION_SIZE);
+    _instructionSM = AllocateDetachedSection(sizeof(Instruction));
+    _observationSM = AllocateDetachedSection(ObservationSize());
+    _infoSM = AllocateDetachedSection(sizeof(Info));
+    _rewardSM = AllocateDetachedSection(sizeof(Reward));
+    _actionSM = AllocateDetachedSection(sizeof(uint32_t));
+    _terminationSM = AllocateDetachedSection(sizeof(Termination));
+    _instructionArgumentSM = AllocateDetachedSection(sizeof(InstructionArgument));
+    _actionRepeatSM = AllocateDetachedSection(sizeof(ActionRepeat));
+    WriteToBuffer(_serverInfo, _serverInfoSM);
+    WriteACK();
+}
+
+const PipelineConfig& CommunicationManager::GetPipelineConfig() const
+{
+    return _pipelineConfig;
+}
+
+BufferFormat CommunicationManager::ObservationFormat() const
+{
+    return BufferFormat(_serverInfo.obsWidth, _serverInfo.obsHeight, _serverInfo.obsChannels);
+}
+
+void CommunicationManager::FeedActions(uint32_t actionMask)
+{
+    WriteToBuffer(actionMask, _actionSM);
+}
+
+void CommunicationManager::FeedInstructionArgument(uint32_t argument)
+{
+    WriteToBuffer(InstructionArgument(argument), _instructionArgumentSM);
+}
+
+void CommunicationManager::FeedActionRepeat(uint32_t frames)
+{
+    WriteToBuffer(ActionRepeat(frames), _actionRepeatSM);
 }
 
 // ExecuteOnInstruction method
-void CommunicationManager::ExecuteOnInstruction(std::function<void(InstructionCode)> handler)
+void CommunicationManager::ExecuteOnInstruction(Utils::FunctionRef<void(InstructionCode)> handler)
 {
     SyncOnClientQuery([this, handler]()
     {
         Instruction instruction = ReadFromBuffer<Instruction>(_instructionSM);
+        SetHeartbeatState(HeartbeatState::BUSY);
         handler(instruction.code);
+        SetHeartbeatState(HeartbeatState::IDLE);
     });
 }
 
+uint32_t CommunicationManager::SlotCount() const
+{
+    return _slotCount;
+}
+
+InstructionCode CommunicationManager::ReadSlotInstruction(uint32_t slot)
+{
+    return SlotBuffer<SlotInstruction>(_slotInstructionSM, slot)->code;
+}
+
+void CommunicationManager::WriteSlotResult(uint32_t slot, ErrorCode result)
+{
+    SlotBuffer<SlotInstruction>(_slotInstructionSM, slot)->result = result;
+}
+
 // ReadActions method
-std::vector<Input> CommunicationManager::ReadActions()
+InputSet CommunicationManager::ReadActions(uint32_t slot)
+{
+    return InputSet::FromMask(ReadActionMask(slot));
+}
+
+uint32_t CommunicationManager::ReadActionMask(uint32_t slot)
 {
+    if (_actionSM == nullptr)
+    {
+        throw std::runtime_error("Invalid buffer in ReadActionMask");
+    }
+
+    if (_actionEncoding == ActionEncoding::BITMASK)
+    {
+        return *SlotBuffer<uint32_t>(_actionSM, slot);
+    }
+
     uint32_t actionCount = _serverInfo.actionCount;
-    std::vector<Input> actions;
+    InputSet actions;
 
     // Convert each non-zero byte to the corresponding action
-    std::vector<uint8_t> actionsTaken(actionCount);
-    ReadArrayFromBuffer<uint8_t>(actionsTaken, _actionSM, actionCount);
+    const uint8_t* actionsTaken = static_cast<const uint8_t*>(_actionSM);
     for (uint32_t actionIndex = 0; actionIndex < actionCount; ++actionIndex)
     {
         if (actionsTaken[actionIndex] != 0)
         {
-            actions.push_back(InputUtils::IndexToInput(actionIndex));
+            actions.Add(InputUtils::IndexToInput(actionIndex));
         }
     }
-    return actions;
+    return actions.Mask();
 }
 
-void CommunicationManager::WriteObservationBuffer(void* observationData, const BufferFormat& format)
+uint32_t CommunicationManager::ReadActionRepeat(uint32_t slot)
 {
-    // This is faster than memcpy
-    RtlCopyMemory(_observationSM, observationData, format.Size());
+    if (_actionRepeatSM == nullptr)
+    {
+        return 0;
+    }
+    return SlotBuffer<ActionRepeat>(_actionRepeatSM, slot)->frames;
+}
+
+bool CommunicationManager::HasInstructionArgument() const
+{
+    return _instructionArgumentSM != nullptr;
+}
+
+uint32_t CommunicationManager::ReadInstructionArgument()
+{
+    return ReadFromBuffer<InstructionArgument>(_instructionArgumentSM).value;
 }
 
-void CommunicationManager::WriteInfoBuffer(const Info& info)
+void CommunicationManager::WriteObservationBuffer(void* observationData, const BufferFormat& format, uint32_t slot)
 {
-    WriteToBuffer(info, _infoSM);
+    HP_TRACE_SCOPE("WriteObservation");
+    uint8_t* destination = SlotBuffer<uint8_t>(_observationSM, 0) + ObservationSize() * slot;
+    const uint8_t* frame = static_cast<const uint8_t*>(observationData);
+    switch (_pipelineConfig.observationTransform)
+    {
+    case ObservationTransform::RGB_DOWNSAMPLE:
+        Observation::DownsampleRGB(destination, frame, format);
+        break;
+    case ObservationTransform::GRAYSCALE:
+        Observation::ConvertToGrayscale(destination, frame, format);
+        break;
+    default:
+        Observation::CopyFrame(destination, observationData, format);
+        break;
+    }
 }
 
-void CommunicationManager::WriteRewardBuffer(const Reward& reward)
+const void* CommunicationManager::ObservationBuffer(uint32_t slot) const
 {
-    WriteToBuffer(reward, _rewardSM);
+    return static_cast<const uint8_t*>(_observationSM) + ObservationSize() * slot;
+}
+
+void CommunicationManager::KeepFinalObservation(uint32_t slot)
+{
+    HP_TRACE_SCOPE("KeepFinalObservation");
+    if (_finalObservationSM != nullptr)
+    {
+        std::memcpy(static_cast<uint8_t*>(_finalObservationSM) + ObservationSize() * slot, ObservationBuffer(slot), ObservationSize());
+    }
 }
 
-void CommunicationManager::WriteTerminationBuffer(const Termination& termination)
+uint64_t CommunicationManager::ObservationChecksum() const
 {
-    WriteToBuffer(termination, _terminationSM);
+    HP_TRACE_SCOPE("ObservationChecksum");
+    return Observation::Checksum(_observationSM, ObservationSize());
+}
+
+EpisodeStats* CommunicationManager::EpisodeStatsSection(uint32_t slot)
+{
+    return _episodeStatsSM != nullptr ? SlotBuffer<EpisodeStats>(_episodeStatsSM, slot) : nullptr;
+}
+
+Metrics::MetricsWriter CommunicationManager::MetricsBlock(uint32_t slot)
+{
+    return Metrics::MetricsWriter(_metricsSM != nullptr ? static_cast<uint8_t*>(_metricsSM) + static_cast<size_t>(Metrics::BlockSize()) * slot : nullptr);
+}
+
+void CommunicationManager::WriteInfoBuffer(const Info& info, uint32_t slot)
+{
+    HP_TRACE_SCOPE("WriteInfo");
+    *SlotBuffer<Info>(_infoSM, slot) = info;
+}
+
+void CommunicationManager::WriteRewardBuffer(const Reward& reward, uint32_t slot)
+{
+    HP_TRACE_SCOPE("WriteReward");
+    *SlotBuffer<Reward>(_rewardSM, slot) = reward;
+}
+
+void CommunicationManager::WriteTerminationBuffer(const Termination& termination, uint32_t slot)
+{
+    HP_TRACE_SCOPE("WriteTermination");
+    *SlotBuffer<Termination>(_terminationSM, slot) = termination;
 }
 
 void CommunicationManager::WriteACK()
@@ -144,7 +365,9 @@ void CommunicationManager::WriteACK()
 
 void CommunicationManager::WriteNonFatalError(const ErrorCode& code)
 {
+    // Only answers this instruction, the next one starts acknowledged again
     WriteToBuffer(code, _returnCodeSM);
+    _cleanLastErrorOnNextRequest = true;
 }
 
 void CommunicationManager::WriteException(const HighwayPursuitException& exception)
@@ -152,10 +375,9 @@ void CommunicationManager::WriteException(const HighwayPursuitException& excepti
     WriteToBuffer(exception.code, _returnCodeSM);
 }
 
-void CommunicationManager::SyncOnClientQuery(std::function<void()> onQuery)
+void CommunicationManager::SyncOnClientQuery(Utils::FunctionRef<void()> onQuery, uint32_t timeoutMs)
 {
-    DWORD error = WaitForSingleObject(_lockServerPool, CLIENT_TIMEOUT);
-    if (!error)
+    if (_lockServerPool->Wait(timeoutMs))
     {
         try
         {
@@ -171,22 +393,21 @@ void CommunicationManager::SyncOnClientQuery(std::function<void()> onQuery)
         {
             // Answer to the client
             WriteException(e);
-            ReleaseSemaphore(_lockClientPool, 1, nullptr);
+            _lockClientPool->Release();
             throw;
         }
         catch (...)
         {
             // Answer to the client
             WriteException(HighwayPursuitException(ErrorCode::NATIVE_ERROR));
-            ReleaseSemaphore(_lockClientPool, 1, nullptr);
+            _lockClientPool->Release();
             throw;
         }
 
         // Answer to the client
-        bool res = ReleaseSemaphore(_lockClientPool, 1, nullptr);
-        if (!res)
+        if (!_lockClientPool->Release())
         {
-            throw std::runtime_error("Failed to release semaphore. Error "+std::to_string(GetLastError()));
+            throw std::runtime_error("Failed to release semaphore.");
         }
     }
     else
@@ -195,34 +416,30 @@ void CommunicationManager::SyncOnClientQuery(std::function<void()> onQuery)
     }
 }
 
-LPVOID CommunicationManager::ConnectToSharedMemory(const std::string& name, DWORD size)
+void* CommunicationManager::ConnectToSharedMemory(const std::string& name, size_t size, bool largePages)
 {
-    HANDLE hMapFile = OpenFileMappingA(
-        FILE_MAP_ALL_ACCESS, // Request read/write access
-        FALSE,               // Do not inherit the handle
-        name.c_str() // Name of the shared memory
-    );
-
-    if (hMapFile == nullptr)
-    {
-        throw std::runtime_error("Couldn't open FileMapping, error " + std::to_string(GetLastError()));
-    }
-
-    LPVOID pBuf = MapViewOfFile(
-        hMapFile,            // Handle to the map object
-        FILE_MAP_ALL_ACCESS, // Read/write access
-        0,
-        0,
-        size                 // Size of the mapping
-    );
+    _sharedMemories.push_back(Platform::SharedMemory::Open(name, size, largePages));
+    return _sharedMemories.back()->Data();
+}
 
-    if (pBuf == nullptr)
+void* CommunicationManager::TryConnectToSharedMemory(const std::string& name, size_t size, bool largePages)
+{
+    std::unique_ptr<Platform::SharedMemory> sharedMemory = Platform::SharedMemory::TryOpen(name, size, largePages);
+    if (sharedMemory == nullptr)
     {
-        throw std::runtime_error("Couldn't get MapView, error " + std::to_string(GetLastError()));
+        return nullptr;
     }
+    _sharedMemories.push_back(std::move(sharedMemory));
+    return _sharedMemories.back()->Data();
+}
 
-    _mapViews.push_back(pBuf);
-    _fileMappings.push_back(hMapFile);
+void* CommunicationManager::AllocateDetachedSection(size_t size)
+{
+    _detachedSections.emplace_back(size, static_cast<uint8_t>(0));
+    return _detachedSections.back().data();
+}
 
-    return pBuf;
-}
\ No newline at end of file
+size_t CommunicationManager::ObservationSize() const
+{
+    return static_cast<size_t>(_serverInfo.obsWidth) * _serverInfo.obsHeight * _serverInfo.obsChannels;
+}
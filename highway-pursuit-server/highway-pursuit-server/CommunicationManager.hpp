@@ -1,7 +1,8 @@
 #pragma once
 #include "Data/ServerTypes.hpp"
-#include <locale>
-#include <codecvt>
+#include "Platform/Platform.hpp"
+#include "Utils/FunctionRef.hpp"
+#include "Metrics/MetricsBlock.hpp"
 
 using namespace Data;
 
@@ -9,17 +10,56 @@ class CommunicationManager
 {
 public:
     static constexpr uint32_t CLIENT_TIMEOUT = 300000; // Timeout in ms
+    static constexpr uint32_t PARKED_TIMEOUT = 3600000; // Wait of a parked server for its client, in ms
 
     CommunicationManager(const ServerParams& args);
     ~CommunicationManager();
 
-    void Connect(const ServerInfo& serverInfo);
-    void ExecuteOnInstruction(std::function<void(InstructionCode)> handler);
-    std::vector<Input> ReadActions();
-    void WriteObservationBuffer(void* observationData, const BufferFormat& format);
-    void WriteInfoBuffer(const Info& info);
-    void WriteRewardBuffer(const Reward& reward);
-    void WriteTerminationBuffer(const Termination& termination);
+    // The heartbeat section is optional, created by supervised clients before the server starts
+    void OpenHeartbeat();
+    // Called on every game frame, from the threads stepping the environments. Does nothing without the section
+    void Beat();
+    void SetHeartbeatState(HeartbeatState state);
+    // Signals the warm pool that started this server that it's waiting for a client
+    void Park();
+    // The extended info (with the metrics schema) is only sent to clients that create its section, so is the pipeline config read.
+    // Returns false if the pool discarded the parked server instead of handing it to a client.
+    bool Connect(const ServerInfo& serverInfo, const ServerInfoEx& serverInfoEx);
+    // Without a client (replays): the sections live in process memory and the inputs are fed by the server
+    void ConnectDetached(const ServerInfo& serverInfo, const PipelineConfig& pipelineConfig = PipelineConfig());
+    // Written by the client, default if it didn't create the section. Its observation transform is applied by WriteObservationBuffer.
+    const PipelineConfig& GetPipelineConfig() const;
+    // Of the observations written, once connected
+    BufferFormat ObservationFormat() const;
+    void FeedActions(uint32_t actionMask);
+    void FeedInstructionArgument(uint32_t argument);
+    void FeedActionRepeat(uint32_t frames);
+    void ExecuteOnInstruction(Utils::FunctionRef<void(InstructionCode)> handler);
+    // Environments in the sections, more than one for vectorized servers. The slot methods can be called from several threads, one per slot.
+    uint32_t SlotCount() const;
+    InstructionCode ReadSlotInstruction(uint32_t slot);
+    void WriteSlotResult(uint32_t slot, ErrorCode result);
+    InputSet ReadActions(uint32_t slot = 0);
+    // Action as written by the client, not validated: a bitmask, or an index with discrete actions
+    uint32_t ReadActionMask(uint32_t slot = 0);
+    // 0 (the frameskip) for clients without the section
+    uint32_t ReadActionRepeat(uint32_t slot = 0);
+    bool HasInstructionArgument() const;
+    uint32_t ReadInstructionArgument();
+    // format is the one of the frame, transformed to ObservationFormat
+    void WriteObservationBuffer(void* observationData, const BufferFormat& format, uint32_t slot = 0);
+    // Last observation written
+    const void* ObservationBuffer(uint32_t slot = 0) const;
+    // Auto-reset: copies the last observation of the episode before the reset overwrites it, does nothing without the section
+    void KeepFinalObservation(uint32_t slot = 0);
+    uint64_t ObservationChecksum() const;
+    // Only with the protocol extensions, nullptr if the client didn't create the section
+    EpisodeStats* EpisodeStatsSection(uint32_t slot = 0);
+    // Detached if the client didn't create the metrics section
+    Metrics::MetricsWriter MetricsBlock(uint32_t slot = 0);
+    void WriteInfoBuffer(const Info& info, uint32_t slot = 0);
+    void WriteRewardBuffer(const Reward& reward, uint32_t slot = 0);
+    void WriteTerminationBuffer(const Termination& termination, uint32_t slot = 0);
     void WriteACK();
     void WriteNonFatalError(const ErrorCode& code);
     void WriteException(const HighwayPursuitException& exception);
@@ -27,25 +67,50 @@ public:
 private:
     ServerParams _args;
     ServerInfo _serverInfo;
+    PipelineConfig _pipelineConfig;
+    ActionEncoding _actionEncoding;
+    uint32_t _slotCount;
 
-    HANDLE _lockServerPool;
-    HANDLE _lockClientPool;
+    std::unique_ptr<Platform::NamedSemaphore> _lockServerPool;
+    std::unique_ptr<Platform::NamedSemaphore> _lockClientPool;
 
     void* _returnCodeSM;
     void* _serverInfoSM;
+    void* _serverInfoExSM;
     void* _instructionSM;
     void* _observationSM;
     void* _infoSM;
     void* _rewardSM;
     void* _actionSM;
     void* _terminationSM;
+    void* _instructionArgumentSM;
+    void* _slotInstructionSM;
+    void* _finalObservationSM;
+    void* _actionRepeatSM;
+    void* _episodeStatsSM;
+    void* _metricsSM;
+    Heartbeat* _heartbeat;
 
     bool _cleanLastErrorOnNextRequest;
-    std::vector<HANDLE> _fileMappings;
-    std::vector<LPVOID> _mapViews;
+    std::vector<std::unique_ptr<Platform::SharedMemory>> _sharedMemories;
+    std::vector<std::vector<uint8_t>> _detachedSections;
 
-    void SyncOnClientQuery(std::function<void()> onQuery);
-    LPVOID ConnectToSharedMemory(const std::string& name, DWORD size);
+    void SyncOnClientQuery(Utils::FunctionRef<void()> onQuery, uint32_t timeoutMs = CLIENT_TIMEOUT);
+    // largePages for the big sections (observations), see Platform::SharedMemory
+    void* ConnectToSharedMemory(const std::string& name, size_t size, bool largePages = false);
+    void* TryConnectToSharedMemory(const std::string& name, size_t size, bool largePages = false);
+    void* AllocateDetachedSection(size_t size);
+    size_t ObservationSize() const;
+
+    template <typename T>
+    static T* SlotBuffer(void* pBuffer, uint32_t slot)
+    {
+        if (pBuffer == nullptr)
+        {
+            throw std::runtime_error("Invalid buffer in SlotBuffer");
+        }
+        return reinterpret_cast<T*>(pBuffer) + slot;
+    }
     
     template <typename T>
     static void WriteToBuffer(const T& data, void* pBuffer)
@@ -69,16 +134,5 @@ private:
         T data = *pSrc;
         return data;
     }
-
-    template <typename T>
-    static void ReadArrayFromBuffer(std::vector<T>& returnBuffer, void* pBuffer, size_t count)
-    {
-        if (pBuffer == nullptr)
-        {
-            throw std::runtime_error("Invalid buffer in ReadArrayFromBuffer");
-        }
-        returnBuffer.resize(count);
-        std::memcpy(returnBuffer.data(), pBuffer, count * sizeof(T));
-    }
 };
 
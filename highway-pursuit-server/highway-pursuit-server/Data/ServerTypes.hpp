@@ -1,7 +1,5 @@
 #pragma once
 #include "../pch.h"
-#include "MinHook.h"
-#include "D3D8.hpp"
 
 namespace Data
 {
@@ -15,23 +13,10 @@ namespace Data
         UNSUPPORTED_BACKBUFFER_FORMAT = 4,
         UNKNOWN_ACTION = 5,
         ENVIRONMENT_NOT_RESET = 6,
-    };
-
-    class MinHookException : public std::runtime_error
-    {
-    public:
-        const MH_STATUS code;
-
-        MinHookException(MH_STATUS code)
-            : std::runtime_error(FormatErrorMessage(code)), code(code) {}
-
-    private:
-        static std::string FormatErrorMessage(MH_STATUS code)
-        {
-            std::ostringstream oss;
-            oss << "MinHook error: 0x" << std::setfill('0') << std::hex << static_cast<int>(code);
-            return oss.str();
-        }
+        INVALID_SNAPSHOT = 7,
+        UNSUPPORTED_INSTRUCTION = 8,
+        DISCARDED = 9, // written by a warm pool instead of a client, the parked server exits
+        STALLED = 10, // written by a supervisor that killed the server, the episode is truncated
     };
 
     class HighwayPursuitException : public std::runtime_error
@@ -54,12 +39,9 @@ namespace Data
     class HighwayPursuitConstants
     {
     public:
-        static constexpr GUID IID_IDirectInput8A = { 0xBF798030,0x483A,0x4DA2, {0xAA,0x99,0x5D,0x64,0xED,0x36,0x97,0x00} };
-        static constexpr GUID GUID_SysKeyboard = { 0x6F1D2B61,0xD5A0,0x11CF,{ 0xBF,0xC7,0x44,0x45,0x53,0x54,0x00,0x00} };
-        static const UINT D3D8_SDK_VERSION = 0xDC;
-        static const DWORD DINPUT_VERSION = 0x800;
-        static const uint32_t CHEATED_CONSTANT_LIVES = 3;
-        static const uint32_t ACTION_COUNT = 8;
+        static constexpr uint32_t CHEATED_CONSTANT_LIVES = 3;
+        static constexpr uint32_t ACTION_COUNT = 8;
+        static constexpr uint32_t SNAPSHOT_SLOTS = 8;
     };
 
     struct BufferFormat
@@ -76,10 +58,10 @@ namespace Data
 
         }
 
-        BufferFormat(const D3DSURFACE_DESC& surface) :
-            width(surface.Width),
-            height(surface.Height),
-            channels(FormatToChannels(surface.Format))
+        BufferFormat(uint32_t width, uint32_t height, uint32_t channels) :
+            width(width),
+            height(height),
+            channels(channels)
         {
         }
 
@@ -88,17 +70,6 @@ namespace Data
         {
             return width * height * channels;
         }
-
-        static uint32_t FormatToChannels(D3DFORMAT format)
-        {
-            switch (format)
-            {
-            case D3DFORMAT::D3DFMT_X8R8G8B8:
-                return 4;
-            default:
-                throw new HighwayPursuitException(ErrorCode::UNSUPPORTED_BACKBUFFER_FORMAT);
-            }
-        }
     };
 
     enum class Input : uint32_t
@@ -133,6 +104,44 @@ namespace Data
         }
     };
 
+    // Inputs held during a step, one bit per input (bit i is the input of index i)
+    class InputSet
+    {
+    public:
+        InputSet() : _mask(0)
+        {
+        }
+
+        static InputSet FromMask(uint32_t mask)
+        {
+            if ((mask >> HighwayPursuitConstants::ACTION_COUNT) != 0)
+            {
+                throw HighwayPursuitException(ErrorCode::UNKNOWN_ACTION);
+            }
+            InputSet inputs;
+            inputs._mask = mask;
+            return inputs;
+        }
+
+        void Add(Input input)
+        {
+            _mask |= 1u << static_cast<uint32_t>(input);
+        }
+
+        bool Contains(Input input) const
+        {
+            return (_mask & (1u << static_cast<uint32_t>(input))) != 0;
+        }
+
+        uint32_t Mask() const
+        {
+            return _mask;
+        }
+
+    private:
+        uint32_t _mask;
+    };
+
 
 #pragma pack(push, 1)
     struct ReturnCode
@@ -158,11 +167,82 @@ namespace Data
         }
     };
 
+    // How the client writes the actions of a step in the action section
+    enum class ActionEncoding : uint32_t
+    {
+        BYTE_PER_ACTION = 0, // actionCount bytes, non-zero if the action is taken (legacy clients)
+        BITMASK = 1 // a single uint32_t, bit i set if action i is taken
+    };
+
+    enum class MetricType : uint32_t
+    {
+        U64 = 0,
+        F64 = 1
+    };
+
+    struct MetricDescriptor
+    {
+        static constexpr size_t NAME_SIZE = 24;
+
+        char name[NAME_SIZE]; // null terminated
+        MetricType type;
+        uint32_t offset; // in bytes, from the start of the block of the slot
+    };
+
+    // Layout of the metrics section, advertised once in the extended info. The section holds one block of blockSize bytes per slot,
+    // each metric at a fixed offset of its block. Later versions only append metrics, clients read the ones they know by name.
+    struct MetricsSchema
+    {
+        static constexpr uint32_t MAX_METRICS = 64;
+
+        uint32_t metricCount;
+        uint32_t blockSize;
+        MetricDescriptor metrics[MAX_METRICS];
+
+        MetricsSchema() : metricCount(0), blockSize(0), metrics() {}
+    };
+
+    // Protocol extensions, in an optional section created by the client before the first handshake.
+    // Clients that don't create it keep the original protocol.
+    // Version 1: encoding of the actions in the action section
+    // Version 2: SNAPSHOT/RESTORE, their slot is read from the instruction argument section
+    // Version 3: vectorized servers, the sections hold vectorSlots environments and STEP_BATCH runs them all
+    // Version 4: auto-reset, a step ending the episode starts the next one and keeps its last observation in the final observation section
+    // Version 5: repeat count of each step in the action repeat section
+    // Version 6: transforms of the pipeline config section
+    // Version 7: records of the finished episodes in the episode stats section
+    // Version 8: schema of the metrics section
+    // Version 9: page size of the server's view of the observations, large when the sections are backed by large pages
+    struct ServerInfoEx
+    {
+        static constexpr uint32_t VERSION = 9;
+        static constexpr size_t SECTION_SIZE = 4096; // fixed, leaves room for the fields of later versions
+
+        uint32_t version;
+        ActionEncoding actionEncoding;
+        uint32_t snapshotSlots;
+        uint32_t vectorSlots; // 1 for a server hosting a single environment
+        uint32_t autoReset; // 1 if the server resets the episodes that end on a step
+        MetricsSchema metricsSchema; // filled by the CommunicationManager
+        uint32_t observationPageSize; // of the server's view of the observations, written in the second handshake (0 before)
+
+        ServerInfoEx(ActionEncoding actionEncoding, uint32_t snapshotSlots, uint32_t vectorSlots = 1, bool autoReset = false)
+            : version(VERSION), actionEncoding(actionEncoding), snapshotSlots(snapshotSlots), vectorSlots(vectorSlots), autoReset(autoReset ? 1 : 0),
+            metricsSchema(), observationPageSize(0) {}
+    };
+    static_assert(sizeof(ServerInfoEx) <= ServerInfoEx::SECTION_SIZE, "The extended info must fit its section");
+
     enum class InstructionCode : uint32_t
     {
+        SKIP = 0, // slot of a batch left as is
         RESET_NEW_LIFE = 1,
         RESET_NEW_GAME = 2,
         STEP = 3,
+        DUMP_TRACE = 4,
+        PING = 5,
+        SNAPSHOT = 6,
+        RESTORE = 7,
+        STEP_BATCH = 8, // vectorized servers, every slot runs its slot instruction
         CLOSE = 0xFF
     };
 
@@ -173,6 +253,93 @@ namespace Data
         Instruction(InstructionCode code) : code(code) {}
     };
 
+    // One environment of a batch: the client writes the instruction (SKIP, STEP or a reset), the server answers in result.
+    // Errors of a slot don't affect the others, the batch itself is acknowledged.
+    struct SlotInstruction
+    {
+        InstructionCode code;
+        ErrorCode result;
+
+        SlotInstruction(InstructionCode code) : code(code), result(ErrorCode::NOT_ACK) {}
+    };
+
+    // Frames the action of the next STEP is repeated for, 0 for the frameskip. Only with the protocol extensions, one per slot.
+    struct ActionRepeat
+    {
+        static constexpr uint32_t MAX_FRAMES = 64; // larger counts are clamped
+
+        uint32_t frames;
+
+        ActionRepeat(uint32_t frames) : frames(frames) {}
+    };
+
+    // How the server maps the actions written by the client to the inputs of the game
+    enum class ActionTransform : uint32_t
+    {
+        NONE = 0, // action i is input i
+        DISCRETE = 1, // a single uint32_t index per step: 0 takes no input, i takes input i - 1
+    };
+
+    // How the server writes the frames to the observation section
+    enum class ObservationTransform : uint32_t
+    {
+        NONE = 0, // frame as rendered
+        RGB_DOWNSAMPLE = 1, // 3 channels and a third of the columns, channel c of column x from column 3x + c of the frame
+        GRAYSCALE = 2, // 1 channel, luma of the BGR channels
+    };
+
+    // Transforms applied to every step by the server instead of the python wrappers, only with the protocol extensions.
+    // Written by the client in an optional section before the first handshake, the server info then describes the transformed
+    // actions and observations. A zeroed section (version 0) leaves every transform disabled.
+    struct PipelineConfig
+    {
+        static constexpr uint32_t VERSION = 1;
+
+        uint32_t version;
+        ActionTransform actionTransform;
+        uint32_t removedActions; // last inputs the client can't take (3 for the powerups)
+        float rewardScale; // the reward of a step is multiplied by it, 0 is read as 1
+        uint32_t noRewardTimeout; // steps without reward before the episode is truncated, 0 disables the timeout
+        uint32_t livesPerGame; // resets start a new game once the lives are spent, 0 disables the accounting
+        ObservationTransform observationTransform;
+
+        PipelineConfig()
+            : version(0), actionTransform(ActionTransform::NONE), removedActions(0), rewardScale(1.0f), noRewardTimeout(0), livesPerGame(0),
+            observationTransform(ObservationTransform::NONE) {}
+    };
+
+    // Argument of the instructions that take one (snapshot slot), only with the protocol extensions
+    struct InstructionArgument
+    {
+        uint32_t value;
+
+        InstructionArgument(uint32_t value) : value(value) {}
+    };
+
+    // Statistics of a finished episode, from its reset to the step that ended it
+    struct EpisodeRecord
+    {
+        uint64_t index; // of the episode in the server, from 1
+        uint64_t frames;
+        uint32_t steps;
+        uint32_t life; // lives of the game used so far, this episode included
+        float episodeReturn; // sum of the rewards the client got (transformed by the pipeline)
+        float wallTime; // in seconds
+        float gameTime; // in seconds, spent in game updates
+        uint8_t terminated; // like the Termination of the last step
+        uint8_t truncated;
+    };
+
+    // Ring of the last finished episodes, in an optional section created by the client after the first handshake (one per slot).
+    // The server only writes it while handling an instruction, the client reads it between instructions.
+    struct EpisodeStats
+    {
+        static constexpr uint32_t RING_SIZE = 64;
+
+        uint64_t finishedCount; // episode i (from 1) is in records[(i - 1) % RING_SIZE] while i > finishedCount - RING_SIZE
+        EpisodeRecord records[RING_SIZE];
+    };
+
     struct Info
     {
         float tps;
@@ -214,6 +381,68 @@ namespace Data
     };
 #pragma pack(pop)
 
+    enum class HeartbeatState : uint32_t
+    {
+        STARTING = 0, // zeroed section, the game isn't past its intro yet
+        IDLE = 1, // waiting for the client
+        BUSY = 2, // handling an instruction, the beat has to advance
+        EXITED = 3
+    };
+
+    // Published by the server loop in an optional section created by the client, read by supervisors to detect stalls
+    struct Heartbeat
+    {
+        static constexpr size_t SECTION_SIZE = 64;
+
+        std::atomic<uint64_t> beat; // advances on every game frame and instruction
+        std::atomic<uint32_t> state; // HeartbeatState
+        std::atomic<uint32_t> processId; // of the server, for supervisors to kill it
+    };
+    static_assert(sizeof(Heartbeat) <= Heartbeat::SECTION_SIZE, "The heartbeat must fit its section");
+    static_assert(std::atomic<uint64_t>::is_always_lock_free, "The heartbeat is shared between processes");
+
+    // Unit of coherence of the processors we target, fields written by different threads shouldn't share one
+    constexpr size_t CACHE_LINE_SIZE = 64;
+
+    // Fields the client writes for an instruction, read by the server
+    struct alignas(CACHE_LINE_SIZE) ClientControl
+    {
+        Instruction instruction;
+        uint32_t actionMask;
+        ActionRepeat actionRepeat;
+        InstructionArgument argument;
+
+        ClientControl() : instruction(InstructionCode::SKIP), actionMask(0), actionRepeat(0), argument(0) {}
+    };
+
+    // Fields the server writes once it handled an instruction, read by the client
+    struct alignas(CACHE_LINE_SIZE) ServerControl
+    {
+        ReturnCode returnCode;
+        Termination termination;
+        Reward reward;
+        Info info;
+
+        ServerControl() : returnCode(static_cast<uint32_t>(ErrorCode::NOT_ACK)), termination(false, false), reward(0.0f), info(0.0f, 0.0f, 0.0f, 0.0f) {}
+    };
+
+    // The per-step fields grouped by writer, as a single block for spin-wait handshakes would hold them: a store of one side would otherwise
+    // invalidate the line the other side spins on. Each group gets its own line and a block a whole number of lines, so the blocks of
+    // consecutive slots (as in the per-slot arrays of a vectorized server) don't share lines either.
+    struct ControlBlock
+    {
+        ClientControl client;
+        ServerControl server;
+    };
+    static_assert(sizeof(ClientControl) == CACHE_LINE_SIZE, "The client fields must fit one cache line");
+    static_assert(sizeof(ServerControl) == CACHE_LINE_SIZE, "The server fields must fit one cache line");
+    static_assert(alignof(ControlBlock) == CACHE_LINE_SIZE, "Control blocks must start on a cache line");
+    static_assert(offsetof(ControlBlock, client) % CACHE_LINE_SIZE == 0 && offsetof(ControlBlock, server) % CACHE_LINE_SIZE == 0,
+        "Each writer must own its cache line");
+    static_assert(offsetof(ControlBlock, server) - offsetof(ControlBlock, client) >= CACHE_LINE_SIZE, "The client and the server must not share a cache line");
+    static_assert(sizeof(ControlBlock) % CACHE_LINE_SIZE == 0, "The control blocks of consecutive slots must not share a cache line");
+    static_assert(std::is_standard_layout<ControlBlock>::value && std::is_trivially_copyable<ControlBlock>::value, "The control block is meant to be shared between processes");
+
 
     struct ServerParams
     {
@@ -229,34 +458,266 @@ namespace Data
             }
         };
 
+        struct TraceParams
+        {
+            const bool traceEnabled;
+            const uint32_t memoryBudget; // in bytes, shared by all traced threads
+            const std::string outputDirectory;
+
+            TraceParams(bool traceEnabled, uint32_t memoryBudget, const std::string& outputDirectory)
+                : traceEnabled(traceEnabled), memoryBudget(memoryBudget), outputDirectory(outputDirectory)
+            {
+            }
+        };
+
+        struct ReplayParams
+        {
+            const std::string recordPath; // action log written while serving a client, none if empty
+            const std::string replayPath; // action log replayed instead of serving a client, none if empty
+
+            ReplayParams(const std::string& recordPath, const std::string& replayPath)
+                : recordPath(recordPath), replayPath(replayPath)
+            {
+            }
+
+            bool IsReplaying() const
+            {
+                return !replayPath.empty();
+            }
+        };
+
+        struct TrajectoryParams
+        {
+            static constexpr uint32_t DEFAULT_CHUNK_TRANSITIONS = 4096;
+            static constexpr uint32_t DEFAULT_QUEUE_CAPACITY = 256;
+
+            const std::string outputDirectory; // transitions are recorded to this directory, none if empty
+            const bool compressed;
+            const uint32_t chunkTransitions; // transitions per chunk file
+            const uint32_t queueCapacity; // transitions waiting to be written, further ones are dropped
+
+            TrajectoryParams(const std::string& outputDirectory, bool compressed,
+                uint32_t chunkTransitions = DEFAULT_CHUNK_TRANSITIONS, uint32_t queueCapacity = DEFAULT_QUEUE_CAPACITY)
+                : outputDirectory(outputDirectory), compressed(compressed), chunkTransitions(chunkTransitions), queueCapacity(queueCapacity)
+            {
+            }
+
+            bool IsEnabled() const
+            {
+                return !outputDirectory.empty();
+            }
+        };
+
+        struct ReplayBufferParams
+        {
+            const std::string sharedMemoryName; // replay buffer created by the learner, none if empty
+
+            ReplayBufferParams(const std::string& sharedMemoryName)
+                : sharedMemoryName(sharedMemoryName)
+            {
+            }
+
+            bool IsEnabled() const
+            {
+                return !sharedMemoryName.empty();
+            }
+        };
+
+        struct PoolParams
+        {
+            const bool parked; // started by a warm pool: signals it once the game is ready, then waits for a client
+
+            PoolParams(bool parked)
+                : parked(parked)
+            {
+            }
+        };
+
+        struct AffinityParams
+        {
+            const uint64_t gameCores; // bit i pins the thread to logical processor i, not pinned if 0
+            const uint64_t serverCores;
+
+            AffinityParams(uint64_t gameCores, uint64_t serverCores)
+                : gameCores(gameCores), serverCores(serverCores)
+            {
+            }
+        };
+
+        struct EpisodeParams
+        {
+            // A step ending the episode also resets it: the client gets the terminal reward and termination with the first observation
+            // of the next episode, the last observation of the episode is kept in the final observation section
+            const bool autoReset;
+
+            EpisodeParams(bool autoReset)
+                : autoReset(autoReset)
+            {
+            }
+        };
+
+        struct ActionParams
+        {
+            const float stickyProbability; // each frame keeps the action of the previous frame with this probability, 0 disables sticky actions
+            const uint64_t seed; // of the sticky action draws, instance i of a vectorized server uses seed + i
+
+            ActionParams(float stickyProbability, uint64_t seed)
+                : stickyProbability(stickyProbability), seed(seed)
+            {
+            }
+        };
+
+        struct AgentParams
+        {
+            static constexpr uint32_t DEFAULT_MAX_EPISODE_STEPS = 27000; // 108000 frames at the default frameskip of 4
+
+            const std::string pluginPath; // agent plugin (Agents/AgentPlugin.h) played instead of serving a client, none if empty
+            const std::string config; // passed to the plugin as is
+            const uint32_t episodes; // played before the server exits
+            const std::string statsPath; // csv of the records of the episodes, none if empty
+            const uint32_t maxEpisodeSteps; // episodes are truncated after this many steps, so that an agent that never dies still ends them. 0: no cap
+
+            AgentParams(const std::string& pluginPath, const std::string& config, uint32_t episodes, const std::string& statsPath,
+                uint32_t maxEpisodeSteps = DEFAULT_MAX_EPISODE_STEPS)
+                : pluginPath(pluginPath), config(config), episodes(episodes), statsPath(statsPath), maxEpisodeSteps(maxEpisodeSteps)
+            {
+            }
+
+            bool IsEnabled() const
+            {
+                return !pluginPath.empty();
+            }
+        };
+
+        struct StartupParams
+        {
+            const std::string imagePath; // game state once the intro is skipped, loaded if it matches the game and written otherwise. None if empty
+
+            StartupParams(const std::string& imagePath) : imagePath(imagePath)
+            {
+            }
+
+            bool HasImage() const
+            {
+                return !imagePath.empty();
+            }
+        };
+
+        struct SpectatorParams
+        {
+            const std::string sharedMemoryName; // section of the latest frame created by the server for viewers, none if empty
+            const float maxFps; // publishes per second at most, 0: after every observation
+
+            SpectatorParams(const std::string& sharedMemoryName, float maxFps) : sharedMemoryName(sharedMemoryName), maxFps(maxFps)
+            {
+            }
+
+            bool IsEnabled() const
+            {
+                return !sharedMemoryName.empty();
+            }
+        };
+
+        struct VideoParams
+        {
+            static constexpr uint32_t DEFAULT_QUEUE_CAPACITY = 64;
+
+            const std::string outputPath; // y4m video of the observations, none if empty
+            const uint32_t downsample; // each video pixel averages a downsample x downsample block of the observation
+            const uint32_t frameInterval; // one observation in frameInterval is recorded
+            const uint32_t queueCapacity; // frames waiting to be written, further ones are dropped
+
+            VideoParams(const std::string& outputPath, uint32_t downsample, uint32_t frameInterval, uint32_t queueCapacity = DEFAULT_QUEUE_CAPACITY)
+                : outputPath(outputPath), downsample(downsample), frameInterval(frameInterval), queueCapacity(queueCapacity)
+            {
+            }
+
+            bool IsEnabled() const
+            {
+                return !outputPath.empty();
+            }
+        };
+
         const bool isRealTime;
         const int frameskip;
         const RenderParams renderParams;
+        const TraceParams traceParams;
+        const ReplayParams replayParams;
+        const TrajectoryParams trajectoryParams;
+        const ReplayBufferParams replayBufferParams;
+        const PoolParams poolParams;
+        const AffinityParams affinityParams;
+        const EpisodeParams episodeParams;
+        const ActionParams actionParams;
+        const AgentParams agentParams;
+        const StartupParams startupParams;
+        const SpectatorParams spectatorParams;
+        const VideoParams videoParams;
+        const std::string sharedResourcesPrefix;
         const std::string serverMutexName;
         const std::string clientMutexName;
         const std::string returnCodeMemoryName;
         const std::string serverInfoMemoryName;
+        const std::string serverInfoExMemoryName;
         const std::string instructionMemoryName;
         const std::string observationMemoryName;
         const std::string infoMemoryName;
         const std::string rewardMemoryName;
         const std::string actionMemoryName;
         const std::string terminationMemoryName;
-
-        ServerParams(bool isRealTime, int frameskip, const RenderParams& renderOptions, const std::string& sharedResourcesPrefix)
+        const std::string instructionArgumentMemoryName;
+        const std::string readyMutexName;
+        const std::string heartbeatMemoryName;
+        const std::string slotInstructionMemoryName;
+        const std::string finalObservationMemoryName;
+        const std::string actionRepeatMemoryName;
+        const std::string pipelineConfigMemoryName;
+        const std::string episodeStatsMemoryName;
+        const std::string metricsMemoryName;
+
+        ServerParams(bool isRealTime, int frameskip, const RenderParams& renderOptions, const TraceParams& traceOptions, const std::string& sharedResourcesPrefix,
+            const ReplayParams& replayOptions = ReplayParams("", ""), const TrajectoryParams& trajectoryOptions = TrajectoryParams("", false),
+            const ReplayBufferParams& replayBufferOptions = ReplayBufferParams(""), const PoolParams& poolOptions = PoolParams(false),
+            const AffinityParams& affinityOptions = AffinityParams(0, 0), const EpisodeParams& episodeOptions = EpisodeParams(false),
+            const ActionParams& actionOptions = ActionParams(0.0f, 0), const AgentParams& agentOptions = AgentParams("", "", 0, ""),
+            const StartupParams& startupOptions = StartupParams(""), const SpectatorParams& spectatorOptions = SpectatorParams("", 0.0f),
+            const VideoParams& videoOptions = VideoParams("", 1, 1))
             : isRealTime(isRealTime),
             frameskip(frameskip),
             renderParams(renderOptions),
+            traceParams(traceOptions),
+            replayParams(replayOptions),
+            trajectoryParams(trajectoryOptions),
+            replayBufferParams(replayBufferOptions),
+            poolParams(poolOptions),
+            affinityParams(affinityOptions),
+            episodeParams(episodeOptions),
+            actionParams(actionOptions),
+            agentParams(agentOptions),
+            startupParams(startupOptions),
+            spectatorParams(spectatorOptions),
+            videoParams(videoOptions),
+            sharedResourcesPrefix(sharedResourcesPrefix),
             serverMutexName(sharedResourcesPrefix + serverMutexId),
             clientMutexName(sharedResourcesPrefix + clientMutexId),
             returnCodeMemoryName(sharedResourcesPrefix + returnCodeMemoryId),
             serverInfoMemoryName(sharedResourcesPrefix + serverInfoMemoryId),
+            serverInfoExMemoryName(sharedResourcesPrefix + serverInfoExMemoryId),
             instructionMemoryName(sharedResourcesPrefix + instructionMemoryId),
             observationMemoryName(sharedResourcesPrefix + observationMemoryId),
             infoMemoryName(sharedResourcesPrefix + infoMemoryId),
             rewardMemoryName(sharedResourcesPrefix + rewardMemoryId),
             actionMemoryName(sharedResourcesPrefix + actionMemoryId),
-            terminationMemoryName(sharedResourcesPrefix + terminationMemoryId)
+            terminationMemoryName(sharedResourcesPrefix + terminationMemoryId),
+            instructionArgumentMemoryName(sharedResourcesPrefix + instructionArgumentMemoryId),
+            readyMutexName(sharedResourcesPrefix + readyMutexId),
+            heartbeatMemoryName(sharedResourcesPrefix + heartbeatMemoryId),
+            slotInstructionMemoryName(sharedResourcesPrefix + slotInstructionMemoryId),
+            finalObservationMemoryName(sharedResourcesPrefix + finalObservationMemoryId),
+            actionRepeatMemoryName(sharedResourcesPrefix + actionRepeatMemoryId),
+            pipelineConfigMemoryName(sharedResourcesPrefix + pipelineConfigMemoryId),
+            episodeStatsMemoryName(sharedResourcesPrefix + episodeStatsMemoryId),
+            metricsMemoryName(sharedResourcesPrefix + metricsMemoryId)
         {
         }
 
@@ -271,5 +732,15 @@ namespace Data
         static constexpr const char* rewardMemoryId = "5";
         static constexpr const char* actionMemoryId = "6";
         static constexpr const char* terminationMemoryId = "7";
+        static constexpr const char* serverInfoExMemoryId = "8";
+        static constexpr const char* instructionArgumentMemoryId = "9";
+        static constexpr const char* readyMutexId = "r";
+        static constexpr const char* heartbeatMemoryId = "h";
+        static constexpr const char* slotInstructionMemoryId = "s";
+        static constexpr const char* finalObservationMemoryId = "f";
+        static constexpr const char* actionRepeatMemoryId = "p";
+        static constexpr const char* pipelineConfigMemoryId = "w";
+        static constexpr const char* episodeStatsMemoryId = "e";
+        static constexpr const char* metricsMemoryId = "m";
     };
 }
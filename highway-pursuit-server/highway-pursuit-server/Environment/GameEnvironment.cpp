@@ -0,0 +1,191 @@
+#include "../pch.h"
+#include "GameEnvironment.hpp"
+#include "../CommunicationManager.hpp"
+#include "../Tracing/TraceRecorder.hpp"
+
+namespace Environment
+{
+    using namespace Data;
+
+    GameEnvironment::GameEnvironment(Services::GameBackend& backend, CommunicationManager& communicationManager, const ServerParams::ActionParams& actionParams, int frameskip)
+        : _backend(backend),
+        _communicationManager(communicationManager),
+        _scheduler(std::make_unique<Actions::ActionScheduler>(actionParams, frameskip)),
+        _initialized(false),
+        _lastTermination(false, false),
+        _frames(0),
+        _steps(0),
+        _resets(0),
+        _serverTime(0),
+        _gameTime(0)
+    {
+    }
+
+    Services::GameBackend& GameEnvironment::Backend()
+    {
+        return _backend;
+    }
+
+    void GameEnvironment::WaitGameUpdate()
+    {
+        HP_TRACE_SCOPE("WaitGameUpdate");
+        _backend.Update().UpdateTime();
+        if (!_backend.Update().WaitUpdate(GAME_TIMEOUT))
+        {
+            throw HighwayPursuitException(ErrorCode::GAME_TIMEOUT);
+        }
+        // Long steps keep beating, the supervisor only kills a server whose game stopped updating
+        _communicationManager.Beat();
+    }
+
+    void GameEnvironment::SkipIntro()
+    {
+        _backend.Episode().NewGame();
+        _backend.Rendering().ResetZoomLevel();
+        WaitGameUpdate();
+        WaitGameUpdate();
+    }
+
+    void GameEnvironment::SetPipeline(std::unique_ptr<Pipeline::TransformPipeline> pipeline)
+    {
+        _pipeline = std::move(pipeline);
+    }
+
+    void GameEnvironment::SetScheduler(std::unique_ptr<Actions::ActionScheduler> scheduler)
+    {
+        _scheduler = std::move(scheduler);
+    }
+
+    Stats::EpisodeTracker& GameEnvironment::Episodes()
+    {
+        return _episodes;
+    }
+
+    bool GameEnvironment::IsInitialized() const
+    {
+        return _initialized;
+    }
+
+    const Termination& GameEnvironment::LastTermination() const
+    {
+        return _lastTermination;
+    }
+
+    bool GameEnvironment::Reset(bool startNewGame)
+    {
+        auto serverStart = std::chrono::steady_clock::now();
+
+        // New game is called on the first episode because it fully resets the game state
+        startNewGame = _pipeline->OnReset(startNewGame || !_initialized);
+        if (startNewGame)
+        {
+            _backend.Episode().NewGame();
+            _initialized = true;
+        }
+        else if (!_lastTermination.terminated)
+        {
+            _backend.Episode().NewLife();
+        }
+
+        // Wait for one frame for the rendering buffer to update
+        WaitGameUpdate();
+
+        _lastTermination = Termination(false, false);
+        _scheduler->ResetEpisode();
+        _episodes.OnReset(startNewGame, GameTime());
+        _resets++;
+        _serverTime += std::chrono::steady_clock::now() - serverStart;
+        return startNewGame;
+    }
+
+    // Nothing in the steady state of a step allocates (see the step_allocations benchmark)
+    GameEnvironment::StepResult GameEnvironment::Step(uint32_t actionMask, uint32_t actionRepeat, Utils::FunctionRef<void(Utils::FunctionRef<void()>)> runFrame)
+    {
+        auto serverStart = std::chrono::steady_clock::now();
+        _steps++;
+        StepResult result{ _pipeline->MapActions(actionMask), 0.0f, 0 };
+        uint32_t frameCount = static_cast<uint32_t>(_scheduler->FrameCount(actionRepeat));
+
+        int cumulatedReward = 0;
+        auto processFrame = [this, &result, &cumulatedReward]()
+            {
+                HP_TRACE_SCOPE("Frame");
+                _backend.Input().SetInput(_scheduler->FrameActions(result.actions));
+
+                // Apply action and get next state
+                auto gameStart = std::chrono::steady_clock::now();
+                WaitGameUpdate();
+                _gameTime += std::chrono::steady_clock::now() - gameStart;
+
+                cumulatedReward += static_cast<int>(_backend.Score().PullReward());
+                _backend.Update().UpdateTime();
+                _frames++;
+
+                // Check termination (death)
+                _lastTermination = Termination(_backend.Episode().PullTerminated(), false);
+            };
+        while (result.frames < frameCount && !_lastTermination.IsDone())
+        {
+            runFrame(processFrame);
+            result.frames++;
+        }
+
+        // The timeout can truncate the episode, the reward is scaled once the step is done
+        _lastTermination = _pipeline->OnStep(cumulatedReward, _lastTermination);
+        result.reward = _pipeline->MapReward(cumulatedReward);
+        _serverTime += std::chrono::steady_clock::now() - serverStart;
+        _episodes.OnStep(result.reward, result.frames, _lastTermination, GameTime());
+        return result;
+    }
+
+    GameEnvironment::StepResult GameEnvironment::Step(uint32_t actionMask, uint32_t actionRepeat)
+    {
+        return Step(actionMask, actionRepeat, [](Utils::FunctionRef<void()> frame) { frame(); });
+    }
+
+    GameEnvironment::State GameEnvironment::Capture() const
+    {
+        return State{ _lastTermination, _scheduler->Capture(), _pipeline->Capture(), _episodes.Capture() };
+    }
+
+    void GameEnvironment::Restore(const State& state)
+    {
+        _lastTermination = state.lastTermination;
+        _scheduler->Restore(state.scheduler);
+        _pipeline->Restore(state.pipeline);
+        _episodes.Restore(state.episodes);
+    }
+
+    uint64_t GameEnvironment::Frames() const
+    {
+        return _frames;
+    }
+
+    uint64_t GameEnvironment::Steps() const
+    {
+        return _steps;
+    }
+
+    float GameEnvironment::ServerTime() const
+    {
+        return std::chrono::duration<float>(_serverTime).count();
+    }
+
+    float GameEnvironment::GameTime() const
+    {
+        return std::chrono::duration<float>(_gameTime).count();
+    }
+
+    void GameEnvironment::PublishMetrics(Metrics::MetricsWriter& metrics, float tps, float memory) const
+    {
+        // Only read by the clients that know them, each value costs a store
+        metrics.Set(Metrics::Metric::TPS, static_cast<double>(tps));
+        metrics.Set(Metrics::Metric::MEMORY, static_cast<double>(memory));
+        metrics.Set(Metrics::Metric::SERVER_TIME, std::chrono::duration<double>(_serverTime).count());
+        metrics.Set(Metrics::Metric::GAME_TIME, std::chrono::duration<double>(_gameTime).count());
+        metrics.Set(Metrics::Metric::FRAMES, _frames);
+        metrics.Set(Metrics::Metric::STEPS, _steps);
+        metrics.Set(Metrics::Metric::RESETS, _resets);
+        metrics.Set(Metrics::Metric::EPISODES, _episodes.FinishedCount());
+    }
+}
@@ -0,0 +1,90 @@
+#pragma once
+#include "../Data/ServerTypes.hpp"
+#include "../Services/GameBackend.hpp"
+#include "../Actions/ActionScheduler.hpp"
+#include "../Pipeline/TransformPipeline.hpp"
+#include "../Stats/EpisodeTracker.hpp"
+#include "../Metrics/MetricsBlock.hpp"
+#include "../Utils/FunctionRef.hpp"
+
+class CommunicationManager;
+
+namespace Environment
+{
+    // One game environment: the reset, step and episode rules shared by HighwayPursuitServer and the slots of VectorizedServer.
+    // Drives the services of a backend and counts what the metrics report, the outputs are written by the server.
+    class GameEnvironment
+    {
+    public:
+        static constexpr int GAME_TIMEOUT = 10000; // results in an error if the game fails to update
+
+        // What a rollout depends on outside of the game's memory, saved with the snapshots
+        struct State
+        {
+            Data::Termination lastTermination = Data::Termination(false, false);
+            Actions::ActionScheduler::State scheduler;
+            Pipeline::TransformPipeline::State pipeline;
+            Stats::EpisodeTracker::State episodes;
+        };
+
+        struct StepResult
+        {
+            Data::InputSet actions; // mapped by the transforms, before the sticky actions
+            float reward; // mapped by the transforms
+            uint32_t frames;
+        };
+
+        // Every game frame beats the heartbeat of the communication manager, from the thread running the environment
+        GameEnvironment(Services::GameBackend& backend, CommunicationManager& communicationManager, const Data::ServerParams::ActionParams& actionParams, int frameskip);
+
+        Services::GameBackend& Backend();
+        // Waits for the game to run one frame
+        void WaitGameUpdate();
+        // Calling new game skips the intro, the initial zoom out is skipped and the fade out completes in 2 frames
+        void SkipIntro();
+
+        // Transforms of the client (or of the action log), set once connected
+        void SetPipeline(std::unique_ptr<Pipeline::TransformPipeline> pipeline);
+        // Replays use the sticky actions of their action log
+        void SetScheduler(std::unique_ptr<Actions::ActionScheduler> scheduler);
+        Stats::EpisodeTracker& Episodes();
+
+        // The first episode was started
+        bool IsInitialized() const;
+        const Data::Termination& LastTermination() const;
+
+        // Starts an episode: a new game the first time or when asked (the transforms can turn a new life into a new game), else the
+        // game respawns the player by itself unless the last episode wasn't terminated (truncated ones included).
+        // Returns true if a new game was started
+        bool Reset(bool startNewGame);
+        // Plays the action for the frames of the step (frameskip or repeat count), sticky actions can keep the previous one.
+        // Returns early if the episode ends. runFrame runs each frame, e.g. paced to real time
+        StepResult Step(uint32_t actionMask, uint32_t actionRepeat, Utils::FunctionRef<void(Utils::FunctionRef<void()>)> runFrame);
+        StepResult Step(uint32_t actionMask, uint32_t actionRepeat);
+
+        State Capture() const;
+        void Restore(const State& state);
+
+        uint64_t Frames() const;
+        uint64_t Steps() const;
+        // In seconds: the time spent in Reset and Step, and the part of it waiting for the game
+        float ServerTime() const;
+        float GameTime() const;
+        // tps and memory are measured by the server, the other metrics are the ones of the environment
+        void PublishMetrics(Metrics::MetricsWriter& metrics, float tps, float memory) const;
+
+    private:
+        Services::GameBackend& _backend;
+        CommunicationManager& _communicationManager;
+        std::unique_ptr<Actions::ActionScheduler> _scheduler;
+        std::unique_ptr<Pipeline::TransformPipeline> _pipeline;
+        Stats::EpisodeTracker _episodes;
+        bool _initialized;
+        Data::Termination _lastTermination;
+        uint64_t _frames;
+        uint64_t _steps;
+        uint64_t _resets;
+        std::chrono::steady_clock::duration _serverTime;
+        std::chrono::steady_clock::duration _gameTime;
+    };
+}
@@ -12,6 +12,17 @@ const std::string HPLogger::logPattern = "log_*";
 
 std::mutex HPLoggerLock;
 
+static std::tm ToLocalTime(std::time_t time)
+{
+    std::tm localTime;
+#ifdef _WIN32
+    localtime_s(&localTime, &time);
+#else
+    localtime_r(&time, &localTime);
+#endif
+    return localTime;
+}
+
 void HPLogger::SetLogDir(const std::string& logDirectoryPath)
 {
     if (!std::filesystem::exists(logDirectoryPath))
@@ -21,9 +32,7 @@ void HPLogger::SetLogDir(const std::string& logDirectoryPath)
     logDirectory = logDirectoryPath;
 
     // Create a string stream to format the date and time
-    std::time_t now = std::time(nullptr);
-    std::tm localTime;
-    localtime_s(&localTime, &now);
+    std::tm localTime = ToLocalTime(std::time(nullptr));
     std::ostringstream oss;
     oss << std::put_time(&localTime, "%Y%m%d_%H%M%S");
     std::string timestamp = oss.str();
@@ -75,9 +84,7 @@ void HPLogger::Log(const std::string& message, const std::string& level)
     std::ofstream writer(logFilePath, std::ios::app);
     if (writer.is_open())
     {
-        std::time_t now = std::time(nullptr);
-        std::tm localTime;
-        localtime_s(&localTime, &now);
+        std::tm localTime = ToLocalTime(std::time(nullptr));
         writer << "[" << level << "] " << std::put_time(&localTime, "%Y-%m-%d %H:%M:%S")
             << " - " << message << std::endl;
     }
@@ -1,91 +1,101 @@
 #include "pch.h"
 #include "HighwayPursuitServer.hpp"
+#include "Observation/ObservationKernels.hpp"
 
-HighwayPursuitServer::HighwayPursuitServer(const Data::ServerParams& options)
+HighwayPursuitServer::HighwayPursuitServer(const Data::ServerParams& options, std::unique_ptr<GameBackend> backend)
     : _options(options),
-    _firstEpisodeInitialized(false),
+    _backend(std::move(backend)),
     _serverTerminated(false),
-    _totalEllapsedFrames(0),
-    _lastStepTermination(false, false),
     _currentInfo(Data::Info(0.0f, 0.0f, 0.0f, 0.0f)),
-    _startTick(0),
-    _cumulatedServerTicks(0),
-    _cumulatedGameTicks(0)
+    _metricsFrames(0),
+    _traceDumpCount(0),
+    _lastStepAction(0),
+    _lastStepRepeat(0),
+    _lastStepReward(0.0f),
+    _isReplaying(false),
+    _isRunningAgent(false),
+    _lastReplayTicket(ReplayBuffer::SharedReplayBuffer::NO_TICKET)
 {
     // num/den is the period in seconds, den/num is therefore the frequency in hertz
     auto ticks_per_s = (static_cast<float>(std::chrono::high_resolution_clock::period::den) / std::chrono::high_resolution_clock::period::num);
     TICKS_PER_FRAME = ticks_per_s / FPS;
     TICKS_PER_MS = ticks_per_s / 1000.0f;
 
-    // Hook manager
-    _hookManager = std::make_shared<HookManager>();
+    // Trace buffers are allocated once, before any event is recorded
+    Tracing::TraceRecorder::Configure(_options.traceParams.traceEnabled, _options.traceParams.memoryBudget, TRACED_THREADS);
 
     // init communication manager
     _communicationManager = std::make_unique<CommunicationManager>(options);
 
-    // init update semaphores
-    _lockUpdatePool = CreateSemaphore(nullptr, 0, 1, nullptr);
-    _lockServerPool = CreateSemaphore(nullptr, 0, 1, nullptr);
-
-    // Install static hooks/services
-    LARGE_INTEGER frequency;
-    frequency.QuadPart = PERFORMANCE_COUNTER_FREQUENCY;
-    _windowService = std::make_unique<WindowService>(_hookManager);
-    _episodeService = std::make_unique<EpisodeService>(_hookManager);
-    _updateService = std::make_unique<UpdateService>(_hookManager, _options.isRealTime, _lockServerPool, _lockUpdatePool, FPS, frequency);
-    _scoreService = std::make_unique<ScoreService>(_hookManager);
-    _cheatService = std::make_unique<CheatService>(_hookManager);
-
-    // These need the app to be partly initialized to properly hook
-    _renderingService = std::make_shared<RenderingService>(_hookManager, _options.renderParams);
-    _renderingService->SetFullscreenFlag(false);
-    _inputService = std::make_shared<InputService>(_hookManager);
-    _hookManager->EnableHooks();
+    // Services are owned by the backend, which shuts the game down when destroyed
+    _updateService = &_backend->Update();
+    _renderingService = &_backend->Rendering();
+    _inputService = &_backend->Input();
+    _stateService = &_backend->State();
+    _environment = std::make_unique<Environment::GameEnvironment>(*_backend, *_communicationManager, options.actionParams, options.frameskip);
+
+    // Observation and environment state of each snapshot, the game's back buffer isn't part of the snapshot
+    _snapshotObservations.resize(_stateService->GetSnapshotSlotCount());
+    _snapshotStates.resize(_stateService->GetSnapshotSlotCount());
 }
 
 HighwayPursuitServer::~HighwayPursuitServer()
 {
-    // Try to shutdown game, release semaphore to ensure the game sees the notification
-    try
-    {
-        _updateService->NotifyShutdown();
-        ReleaseSemaphore(_lockUpdatePool, 1, nullptr);
-    }
-    catch (std::exception e)
-    {
-        HPLogger::LogException(e);
-    }
-
-    // Release all hooks/semaphores
-    _hookManager->Release();
-    CloseHandle(_lockUpdatePool);
-    CloseHandle(_lockServerPool);
+    // Keep the trace of the last run
+    DumpTrace();
 }
 
 void HighwayPursuitServer::Run()
 {
     try
     {
-        // Wait for game to be initialized
-        WaitGameUpdate();
-        // Enable custom qpc
-        _updateService->EnableCustomTime();
-        SkipIntro();
-
-        // Get server info now that the D3D device is initialized
-        BufferFormat buffer = _renderingService->GetBufferFormat();
-        ServerInfo serverInfo(
-            buffer.height,
-            buffer.width,
-            buffer.channels,
-            _inputService->GetInputCount()
-        );
+        // The game thread is pinned at injection, this one runs the server
+        if (_options.affinityParams.serverCores != 0 && !Platform::SetCurrentThreadAffinity(_options.affinityParams.serverCores))
+        {
+            HPLogger::LogWarning("Failed to pin the server thread to the cores " + std::to_string(_options.affinityParams.serverCores));
+        }
+        _communicationManager->OpenHeartbeat();
+        ServerInfo serverInfo = StartGame();
+        if (_options.replayParams.IsReplaying())
+        {
+            ReplayActionLog(serverInfo);
+            return;
+        }
+        if (_options.agentParams.IsEnabled())
+        {
+            RunAgent(serverInfo);
+            return;
+        }
+
+        ServerInfoEx serverInfoEx(ActionEncoding::BITMASK, _stateService->GetSnapshotSlotCount(), 1, _options.episodeParams.autoReset);
+
+        // Pooled servers are started before their client, the startup above is done by the time it connects
+        if (_options.poolParams.parked)
+        {
+            _communicationManager->Park();
+        }
 
         // Setup the communication
-        _communicationManager->Connect(serverInfo);
+        if (!_communicationManager->Connect(serverInfo, serverInfoEx))
+        {
+            HPLogger::LogInfo("Discarded by the warm pool before serving a client");
+            _communicationManager->SetHeartbeatState(HeartbeatState::EXITED);
+            return;
+        }
+        _communicationManager->SetHeartbeatState(HeartbeatState::IDLE);
+        const PipelineConfig& pipelineConfig = _communicationManager->GetPipelineConfig();
+        _environment->SetPipeline(std::make_unique<Pipeline::TransformPipeline>(pipelineConfig, serverInfo.actionCount));
+        _environment->Episodes().Attach(_communicationManager->EpisodeStatsSection());
+        _metrics = _communicationManager->MetricsBlock();
+        OpenRecorders();
+        if (!_options.replayParams.recordPath.empty())
+        {
+            _actionLog = std::make_unique<Replay::ActionLogWriter>(_options.replayParams.recordPath,
+                Replay::ActionLogHeader(_options.frameskip, serverInfo, _options.actionParams, pipelineConfig));
+        }
 
         // For performance metrics
-        _startTick = GetTickCount64();
+        _metricsStart = std::chrono::steady_clock::now();
 
         // Main request/response loop
         while (!_serverTerminated)
@@ -95,41 +105,195 @@ void HighwayPursuitServer::Run()
         }
     }
     // Exception handling for the server thread
-    catch (HighwayPursuitException e)
+    catch (const HighwayPursuitException& e)
     {
         HPLogger::LogException(e);
         _communicationManager->WriteException(e);
     }
-    catch (std::exception e)
+    catch (const std::exception& e)
     {
         HPLogger::LogException(e);
         _communicationManager->WriteException(HighwayPursuitException(ErrorCode::NATIVE_ERROR));
     }
+    _communicationManager->SetHeartbeatState(HeartbeatState::EXITED);
+}
+
+const Replay::ReplayReport& HighwayPursuitServer::LastReplayReport() const
+{
+    return _replayReport;
+}
+
+const Agents::AgentReport& HighwayPursuitServer::LastAgentReport() const
+{
+    return _agentReport;
+}
+
+ServerInfo HighwayPursuitServer::StartGame()
+{
+    // Wait for game to be initialized
+    _environment->WaitGameUpdate();
+    // Enable custom qpc
+    _updateService->EnableCustomTime();
+    BootGame();
+    // The game has loaded its key bindings by now
+    _inputService->LoadBindings();
+
+    // Get server info now that the D3D device is initialized
+    BufferFormat buffer = _renderingService->GetBufferFormat();
+    return ServerInfo(
+        buffer.height,
+        buffer.width,
+        buffer.channels,
+        _inputService->GetInputCount()
+    );
+}
+
+void HighwayPursuitServer::ReplayActionLog(const ServerInfo& serverInfo)
+{
+    Replay::ActionLogReader log(_options.replayParams.replayPath);
+    const Replay::ActionLogHeader& header = log.Header();
+    if (header.frameskip != _options.frameskip || header.obsWidth != serverInfo.obsWidth
+        || header.obsHeight != serverInfo.obsHeight || header.obsChannels != serverInfo.obsChannels)
+    {
+        throw std::runtime_error("The action log was recorded with a different frameskip or resolution");
+    }
+    // The sticky actions of the log, whatever the options
+    _environment->SetScheduler(std::make_unique<Actions::ActionScheduler>(ServerParams::ActionParams(header.stickyProbability, header.seed), _options.frameskip));
+
+    // The transforms of the log too, the records hold the actions and checksums the client saw
+    _environment->SetPipeline(std::make_unique<Pipeline::TransformPipeline>(header.pipelineConfig, serverInfo.actionCount));
+
+    // Instructions are fed directly, the game runs at max speed
+    _communicationManager->ConnectDetached(serverInfo, header.pipelineConfig);
+    OpenRecorders();
+    _isReplaying = true;
+    _replayReport = Replay::ReplayReport();
+    _metricsStart = std::chrono::steady_clock::now();
+
+    for (const Replay::ActionLogRecord& record : log.Records())
+    {
+        _communicationManager->FeedActions(record.actionMask);
+        _communicationManager->FeedInstructionArgument(record.argument);
+        _communicationManager->FeedActionRepeat(record.code == InstructionCode::STEP ? record.argument : 0);
+        HandleInstruction(record.code);
+        _replayReport.replayedRecords++;
+
+        uint64_t checksum = record.observationChecksum != 0 ? _communicationManager->ObservationChecksum() : 0;
+        if (_environment->Frames() != record.frame || checksum != record.observationChecksum)
+        {
+            _replayReport.diverged = true;
+            _replayReport.divergentRecord = _replayReport.replayedRecords - 1;
+            _replayReport.divergentCode = record.code;
+            _replayReport.expectedFrame = record.frame;
+            _replayReport.actualFrame = _environment->Frames();
+            _replayReport.expectedChecksum = record.observationChecksum;
+            _replayReport.actualChecksum = checksum;
+            break;
+        }
+        if (_serverTerminated)
+        {
+            break;
+        }
+    }
+
+    _isReplaying = false;
+    HPLogger::LogInfo(_replayReport.ToString());
+}
+
+void HighwayPursuitServer::RunAgent(const ServerInfo& serverInfo)
+{
+    // The agent sees the observations of the default transforms, the step cap ends the episodes of agents that don't die
+    PipelineConfig pipelineConfig;
+    _environment->SetPipeline(std::make_unique<Pipeline::TransformPipeline>(pipelineConfig, serverInfo.actionCount, _options.agentParams.maxEpisodeSteps));
+    _communicationManager->ConnectDetached(serverInfo, pipelineConfig);
+    OpenRecorders();
+
+    ServerInfo observed = Pipeline::TransformPipeline::Describe(pipelineConfig, serverInfo);
+    HpAgentSpec spec{ HP_AGENT_ABI_VERSION, observed.obsWidth, observed.obsHeight, observed.obsChannels, observed.actionCount,
+        static_cast<uint32_t>(_options.frameskip), _options.actionParams.seed };
+    Agents::AgentHost agent(_options.agentParams.pluginPath, spec, _options.agentParams.config);
+
+    // Instructions are fed directly like in replays, the agent reads the observation in place between them
+    _isRunningAgent = true;
+    _agentReport = Agents::AgentReport();
+    _metricsStart = std::chrono::steady_clock::now();
+    for (uint32_t episode = 0; episode < _options.agentParams.episodes; ++episode)
+    {
+        HandleInstruction(episode == 0 ? InstructionCode::RESET_NEW_GAME : InstructionCode::RESET_NEW_LIFE);
+        agent.Reset(static_cast<const uint8_t*>(_communicationManager->ObservationBuffer()));
+        while (!_environment->LastTermination().IsDone())
+        {
+            _communicationManager->FeedActions(agent.Act(static_cast<const uint8_t*>(_communicationManager->ObservationBuffer())));
+            _communicationManager->FeedActionRepeat(0);
+            HandleInstruction(InstructionCode::STEP);
+            _agentReport.steps++;
+            agent.Feedback(_lastStepReward, _environment->LastTermination());
+        }
+        _agentReport.episodes.push_back(_environment->Episodes().LastRecord());
+    }
+    _isRunningAgent = false;
+
+    HPLogger::LogInfo(_agentReport.ToString());
+    if (!_options.agentParams.statsPath.empty())
+    {
+        _agentReport.WriteCsv(_options.agentParams.statsPath);
+    }
+}
+
+bool HighwayPursuitServer::HasClient() const
+{
+    return !_isReplaying && !_isRunningAgent;
 }
 
-void HighwayPursuitServer::WaitGameUpdate()
+void HighwayPursuitServer::OpenRecorders()
 {
-    _updateService->UpdateTime();
-    ReleaseSemaphore(_lockUpdatePool, 1, nullptr);
-    DWORD error = WaitForSingleObject(_lockServerPool, GAME_TIMEOUT);
-    if (error)
+    // Transitions hold the observations the client gets
+    BufferFormat format = _communicationManager->ObservationFormat();
+    if (_options.trajectoryParams.IsEnabled())
+    {
+        _trajectoryWriter = std::make_unique<Trajectory::TrajectoryWriter>(_options.trajectoryParams, format);
+    }
+    if (_options.replayBufferParams.IsEnabled())
+    {
+        _replayBuffer = ReplayBuffer::SharedReplayBuffer::Open(_options.replayBufferParams.sharedMemoryName, format.Size());
+    }
+    if (_options.spectatorParams.IsEnabled())
     {
-        throw HighwayPursuitException(ErrorCode::GAME_TIMEOUT);
+        _spectatorTap = Spectator::SpectatorTap::Create(_options.spectatorParams.sharedMemoryName, format);
+    }
+    if (_options.videoParams.IsEnabled())
+    {
+        // Each observation is frameskip frames of gameplay
+        _videoRecorder = std::make_unique<Video::VideoRecorder>(_options.videoParams, format, static_cast<uint32_t>(FPS), _options.frameskip);
     }
 }
 
-void HighwayPursuitServer::SkipIntro()
+void HighwayPursuitServer::BootGame()
 {
-     //Calling new game skips the intro
-     //We then skip the initial zoom out, and wait 2 frames for the fade out the complete
-     _episodeService->NewGame();
-     _renderingService->ResetZoomLevel();
-     WaitGameUpdate();
-     WaitGameUpdate();
+    // The state after the intro is the same for every instance, the first one persists it for the next ones
+    const std::string& imagePath = _options.startupParams.imagePath;
+    if (_options.startupParams.HasImage() && _stateService->LoadImage(imagePath))
+    {
+        HPLogger::LogInfo("Started from the image " + imagePath);
+        return;
+    }
+    _environment->SkipIntro();
+    if (_options.startupParams.HasImage())
+    {
+        if (_stateService->SaveImage(imagePath))
+        {
+            HPLogger::LogInfo("Wrote the startup image " + imagePath);
+        }
+        else
+        {
+            HPLogger::LogWarning("The state after the intro can't be persisted, " + imagePath + " is ignored");
+        }
+    }
 }
 
 void HighwayPursuitServer::HandleInstruction(InstructionCode code)
 {
+    HP_TRACE_SCOPE("HandleInstruction");
     switch (code)
     {
     case InstructionCode::RESET_NEW_LIFE:
@@ -140,20 +304,23 @@ void HighwayPursuitServer::HandleInstruction(InstructionCode code)
         break;
     case InstructionCode::STEP:
         // Return an error if step is called without reset (player dead)
-        if ((!_firstEpisodeInitialized) || _lastStepTermination.IsDone())
+        if (!_environment->IsInitialized() || _environment->LastTermination().IsDone())
         {
             _communicationManager->WriteNonFatalError(ErrorCode::ENVIRONMENT_NOT_RESET);
         }
-        // Step at max speed or real time depending on the option
-        if (_options.isRealTime)
-        {
-            // The frame execution inside step will be wrapped by ExecuteForOneFrame
-            Step([this](std::function<void()> action) { ExecuteForOneFrame(action); });
-        }
-        else
-        {
-            Step();
-        }
+        Step();
+        break;
+    case InstructionCode::DUMP_TRACE:
+        DumpTrace();
+        break;
+    case InstructionCode::SNAPSHOT:
+        CaptureSnapshot();
+        break;
+    case InstructionCode::RESTORE:
+        RestoreSnapshot();
+        break;
+    case InstructionCode::PING:
+        // Only acknowledged, measures the handshake
         break;
     case InstructionCode::CLOSE:
         // Notify end of loop
@@ -162,35 +329,62 @@ void HighwayPursuitServer::HandleInstruction(InstructionCode code)
     default:
         break;
     }
-}
 
-void HighwayPursuitServer::Reset(bool startNewGame)
-{
-    // Force new game the first time
-    if (!_firstEpisodeInitialized)
+    if (_actionLog != nullptr)
     {
-        // New game is called on the first episode because it fully resets the game state
-        _episodeService->NewGame();
-        // Initialize the metrics
-        _currentInfo = Info(0.0f, ComputeMemoryUsage(), static_cast<float>(_cumulatedServerTicks), static_cast<float>(_cumulatedGameTicks));
-        _firstEpisodeInitialized = true;
+        RecordInstruction(code);
     }
-    // Start a new game
-    else if (startNewGame)
+
+    // Replays get the reset from the action log, agents reset between their episodes
+    if (code == InstructionCode::STEP && _options.episodeParams.autoReset && HasClient() && _environment->LastTermination().IsDone())
     {
-        _episodeService->NewGame();
+        AutoReset();
     }
-    // The game respawns the player (new life) naturally unless the last episode wasn't terminated
-    else if (!_lastStepTermination.IsDone())
+}
+
+void HighwayPursuitServer::RecordInstruction(InstructionCode code)
+{
+    HP_TRACE_SCOPE("RecordInstruction");
+    Replay::ActionLogRecord record{};
+    record.frame = _environment->Frames();
+    record.code = code;
+    switch (code)
     {
-        _episodeService->NewLife();
+    case InstructionCode::STEP:
+        record.actionMask = _lastStepAction;
+        record.argument = _lastStepRepeat;
+        record.observationChecksum = _communicationManager->ObservationChecksum();
+        break;
+    case InstructionCode::RESET_NEW_LIFE:
+    case InstructionCode::RESET_NEW_GAME:
+        record.observationChecksum = _communicationManager->ObservationChecksum();
+        break;
+    case InstructionCode::SNAPSHOT:
+    case InstructionCode::RESTORE:
+        record.argument = _communicationManager->HasInstructionArgument() ? _communicationManager->ReadInstructionArgument() : 0;
+        record.observationChecksum = code == InstructionCode::RESTORE ? _communicationManager->ObservationChecksum() : 0;
+        break;
+    default:
+        break;
     }
+    _actionLog->Append(record);
 
-    // Wait for one frame for the rendering buffer to update
-    WaitGameUpdate();
+    // Nothing is lost if the process is killed after the client closed
+    if (code == InstructionCode::CLOSE)
+    {
+        _actionLog->Flush();
+    }
+}
 
-    // Update step variables
-    _lastStepTermination = Termination(false, false);
+void HighwayPursuitServer::Reset(bool startNewGame)
+{
+    // Initialize the metrics
+    if (!_environment->IsInitialized())
+    {
+        _currentInfo.memory = ComputeMemoryUsage();
+    }
+    _environment->Reset(startNewGame);
+    _currentInfo = Info(_currentInfo.tps, _currentInfo.memory, _environment->ServerTime(), _environment->GameTime());
 
     // Return state/info
     _renderingService->Screenshot(
@@ -199,10 +393,89 @@ void HighwayPursuitServer::Reset(bool startNewGame)
             _communicationManager->WriteObservationBuffer(pixelData, format);
         });
     _communicationManager->WriteInfoBuffer(_currentInfo);
+    PublishMetrics();
+    RecordTransition(Trajectory::TransitionKind::RESET, 0, 0.0f);
+    PublishSpectatorFrame(0.0f);
+}
+
+void HighwayPursuitServer::AutoReset()
+{
+    HP_TRACE_SCOPE("AutoReset");
+    _communicationManager->KeepFinalObservation();
+
+    // The reward and termination of the step are left for the client, the reset only writes the observation and info
+    Reset(false);
+    if (_actionLog != nullptr)
+    {
+        RecordInstruction(InstructionCode::RESET_NEW_LIFE);
+    }
+}
+
+void HighwayPursuitServer::CaptureSnapshot()
+{
+    if (!_communicationManager->HasInstructionArgument())
+    {
+        _communicationManager->WriteNonFatalError(ErrorCode::UNSUPPORTED_INSTRUCTION);
+        return;
+    }
+
+    uint32_t slot = _communicationManager->ReadInstructionArgument();
+    if (!_environment->IsInitialized())
+    {
+        _communicationManager->WriteNonFatalError(ErrorCode::ENVIRONMENT_NOT_RESET);
+        return;
+    }
+    if (slot >= _snapshotObservations.size())
+    {
+        _communicationManager->WriteNonFatalError(ErrorCode::INVALID_SNAPSHOT);
+        return;
+    }
+
+    _stateService->Capture(slot);
+    _snapshotStates[slot] = _environment->Capture();
+    _renderingService->Screenshot(
+        [this, slot](void* pixelData, const BufferFormat& format)
+        {
+            std::vector<uint8_t>& observation = _snapshotObservations[slot];
+            observation.resize(format.Size());
+            Observation::CopyFrame(observation.data(), pixelData, format);
+        });
+}
+
+void HighwayPursuitServer::RestoreSnapshot()
+{
+    if (!_communicationManager->HasInstructionArgument())
+    {
+        _communicationManager->WriteNonFatalError(ErrorCode::UNSUPPORTED_INSTRUCTION);
+        return;
+    }
+
+    uint32_t slot = _communicationManager->ReadInstructionArgument();
+    if (slot >= _snapshotObservations.size() || _snapshotObservations[slot].empty())
+    {
+        _communicationManager->WriteNonFatalError(ErrorCode::INVALID_SNAPSHOT);
+        return;
+    }
+
+    if (!_stateService->Restore(slot))
+    {
+        _communicationManager->WriteNonFatalError(ErrorCode::INVALID_SNAPSHOT);
+        return;
+    }
+    _environment->Restore(_snapshotStates[slot]);
+
+    // Same outputs as a step, with the observation saved with the snapshot
+    BufferFormat format = _renderingService->GetBufferFormat();
+    _communicationManager->WriteObservationBuffer(_snapshotObservations[slot].data(), format);
+    _communicationManager->WriteRewardBuffer(Reward(0.0f));
+    _communicationManager->WriteInfoBuffer(_currentInfo);
+    PublishMetrics();
+    _communicationManager->WriteTerminationBuffer(_environment->LastTermination());
+    RecordTransition(Trajectory::TransitionKind::RESTORE, 0, 0.0f);
 }
 
 // TODO: this is wrong because this doesn't take into account time between instructions
-void HighwayPursuitServer::ExecuteForOneFrame(std::function<void()> action)
+void HighwayPursuitServer::ExecuteForOneFrame(Utils::FunctionRef<void()> action)
 {
     auto start = std::chrono::high_resolution_clock::now();
     action();
@@ -229,65 +502,24 @@ void HighwayPursuitServer::ExecuteForOneFrame(std::function<void()> action)
     }
 }
 
-void HighwayPursuitServer::Step(std::function<void(std::function<void()>)> frameWrapper)
+void HighwayPursuitServer::Step()
 {
-    // Time spent server-side measurement
-    ULONGLONG serverComputationStart = GetTickCount64();
-
-    // Get action
-    std::vector<Input> actions = _communicationManager->ReadActions();
-
-    // Repeat action for _options.frameskip frames. Return early if episode ends.
-    int cumulatedReward = 0;
-    auto processFrame = [this, actions, &cumulatedReward]()
+    // Step at max speed or real time depending on the option
+    _lastStepAction = _communicationManager->ReadActionMask();
+    _lastStepRepeat = _communicationManager->ReadActionRepeat();
+    auto runFrame = [this](Utils::FunctionRef<void()> frame)
         {
-            _inputService->SetInput(actions);
-
-            // Apply action and get next state
-            ULONGLONG gameComputationStart = GetTickCount64();
-            WaitGameUpdate();
-            _cumulatedGameTicks += GetTickCount64() - gameComputationStart; // measure time spent on running the game
-
-            // Get reward
-            int reward = _scoreService->PullReward();
-            cumulatedReward += reward;
-
-            // Next step
-            _updateService->UpdateTime();
-            _totalEllapsedFrames++;
-
-            // Check termination (death)
-            bool terminated = _episodeService->PullTerminated();
-            _lastStepTermination = Termination(terminated, false);
-
-            // Handle the metrics that are computed periodically
-            if (_totalEllapsedFrames % PERIODIC_METRICS_FREQUENCY == 0)
+            if (_options.isRealTime && HasClient())
             {
-                ULONGLONG elapsedTicks = GetTickCount64() - _startTick;
-                auto tps = PERIODIC_METRICS_FREQUENCY / (elapsedTicks / 1000.0f);
-
-                float memorySize = ComputeMemoryUsage();
-                _startTick = GetTickCount64();
-
-                _currentInfo.memory = memorySize;
-                _currentInfo.tps = tps;
+                ExecuteForOneFrame(frame);
+            }
+            else
+            {
+                frame();
             }
         };
-
-    int skippedFrames = 0;
-    while (skippedFrames < _options.frameskip && !_lastStepTermination.IsDone())
-    {
-        // Wrapper is here for the real time option
-        if (frameWrapper == nullptr)
-        {
-            processFrame();
-        }
-        else
-        {
-            frameWrapper(processFrame);
-        }
-        skippedFrames++;
-    }
+    Environment::GameEnvironment::StepResult result = _environment->Step(_lastStepAction, _lastStepRepeat, runFrame);
+    UpdatePeriodicMetrics();
 
     // Write return values
     _renderingService->Screenshot(
@@ -296,30 +528,110 @@ void HighwayPursuitServer::Step(std::function<void(std::function<void()>)> frame
             _communicationManager->WriteObservationBuffer(pixelData, format);
         });
 
-    // Stop server-side timer
-    _cumulatedServerTicks += GetTickCount64() - serverComputationStart;
-
     // Update metrics
-    float serverTime = _cumulatedServerTicks / 1000.0f;
-    float gameTime = _cumulatedGameTicks / 1000.0f;
-    _currentInfo = Info(_currentInfo.tps, _currentInfo.memory, serverTime, gameTime);
+    _currentInfo = Info(_currentInfo.tps, _currentInfo.memory, _environment->ServerTime(), _environment->GameTime());
 
-    _communicationManager->WriteRewardBuffer(Reward(static_cast<float>(cumulatedReward)));
+    _lastStepReward = result.reward;
+    _communicationManager->WriteRewardBuffer(Reward(result.reward));
     _communicationManager->WriteInfoBuffer(_currentInfo);
-    _communicationManager->WriteTerminationBuffer(_lastStepTermination);
+    PublishMetrics();
+    _communicationManager->WriteTerminationBuffer(_environment->LastTermination());
+    RecordTransition(Trajectory::TransitionKind::STEP, result.actions.Mask(), result.reward);
+    PublishSpectatorFrame(result.reward);
+}
+
+void HighwayPursuitServer::PublishMetrics()
+{
+    HP_TRACE_SCOPE("PublishMetrics");
+    _environment->PublishMetrics(_metrics, _currentInfo.tps, _currentInfo.memory);
+    _metrics.Set(Metrics::Metric::VIDEO_FRAMES, _videoRecorder != nullptr ? _videoRecorder->WrittenFrames() : 0);
+    _metrics.Set(Metrics::Metric::VIDEO_DROPPED, _videoRecorder != nullptr ? _videoRecorder->DroppedFrames() : 0);
+}
+
+void HighwayPursuitServer::UpdatePeriodicMetrics()
+{
+    uint64_t frames = _environment->Frames();
+    if (frames - _metricsFrames < PERIODIC_METRICS_FREQUENCY)
+    {
+        return;
+    }
+
+    auto now = std::chrono::steady_clock::now();
+    _currentInfo.tps = static_cast<float>((frames - _metricsFrames) / std::chrono::duration<double>(now - _metricsStart).count());
+    _currentInfo.memory = ComputeMemoryUsage();
+    _metricsFrames = frames;
+    _metricsStart = now;
+}
+
+void HighwayPursuitServer::RecordTransition(Trajectory::TransitionKind kind, uint32_t actionMask, float reward)
+{
+    HP_TRACE_SCOPE("RecordTransition");
+    if (_trajectoryWriter != nullptr)
+    {
+        _trajectoryWriter->Push(kind, _communicationManager->ObservationBuffer(), actionMask, reward, _environment->LastTermination());
+    }
+
+    if (_replayBuffer != nullptr)
+    {
+        // Steps are chained to the transition they started from, resets and restores start a new chain
+        uint64_t previousTicket = kind == Trajectory::TransitionKind::STEP ? _lastReplayTicket : ReplayBuffer::SharedReplayBuffer::NO_TICKET;
+        _lastReplayTicket = _replayBuffer->Append(kind, _communicationManager->ObservationBuffer(), actionMask, reward, _environment->LastTermination(), previousTicket);
+    }
+
+    if (_videoRecorder != nullptr)
+    {
+        _videoRecorder->Submit(_communicationManager->ObservationBuffer());
+    }
 }
 
 float HighwayPursuitServer::ComputeMemoryUsage()
 {
-    float memorySize = 0.0f;
+    return Platform::GetWorkingSetSize() / (1024.0f * 1024.0f); // bytes to megabytes
+}
+
+void HighwayPursuitServer::PublishSpectatorFrame(float reward)
+{
+    if (_spectatorTap == nullptr)
+    {
+        return;
+    }
+    auto now = std::chrono::steady_clock::now();
+    if (now < _nextSpectatorPublish)
+    {
+        return;
+    }
+    if (_options.spectatorParams.maxFps > 0.0f)
+    {
+        std::chrono::duration<double> interval(1.0 / _options.spectatorParams.maxFps);
+        _nextSpectatorPublish = now + std::chrono::duration_cast<std::chrono::steady_clock::duration>(interval);
+    }
 
-    HANDLE hProcess = GetCurrentProcess();
-    PROCESS_MEMORY_COUNTERS pmc;
+    HP_TRACE_SCOPE("PublishSpectatorFrame");
+    Spectator::SpectatorStats stats{};
+    stats.frames = _environment->Frames();
+    stats.steps = _environment->Steps();
+    stats.episodes = _environment->Episodes().FinishedCount();
+    stats.reward = reward;
+    stats.tps = _currentInfo.tps;
+    stats.serverTime = _currentInfo.serverTime;
+    stats.gameTime = _currentInfo.gameTime;
+    stats.terminated = _environment->LastTermination().terminated;
+    stats.truncated = _environment->LastTermination().truncated;
+    _spectatorTap->Publish(_communicationManager->ObservationBuffer(), stats);
+}
 
-    if (GetProcessMemoryInfo(hProcess, &pmc, sizeof(pmc)))
+void HighwayPursuitServer::DumpTrace()
+{
+    if (!Tracing::TraceRecorder::IsEnabled())
     {
-        memorySize = pmc.WorkingSetSize / (1024.0f * 1024.0f); // bytes to megabytes
+        return;
     }
 
-    return memorySize;
+    // One file per dump, the prefix is unique to this server instance
+    std::string path = _options.traceParams.outputDirectory + "/trace_" + _options.sharedResourcesPrefix + std::to_string(_traceDumpCount) + ".json";
+    if (Tracing::TraceRecorder::Dump(path))
+    {
+        _traceDumpCount++;
+        HPLogger::LogInfo("Trace written to " + path);
+    }
 }
\ No newline at end of file
@@ -1,62 +1,94 @@
 #pragma once
 #include "Data/ServerTypes.hpp"
+#include "Environment/GameEnvironment.hpp"
 #include "CommunicationManager.hpp"
-#include "HookManager.hpp"
-#include "Injected/CheatService.hpp"
-#include "Injected/EpisodeService.hpp"
-#include "Injected/InputService.hpp"
-#include "Injected/RenderingService.hpp"
-#include "Injected/ScoreService.hpp"
-#include "Injected/UpdateService.hpp"
-#include "Injected/WindowService.hpp"
+#include "Services/GameBackend.hpp"
+#include "Replay/ActionLog.hpp"
+#include "ReplayBuffer/SharedReplayBuffer.hpp"
+#include "Trajectory/TrajectoryWriter.hpp"
+#include "Tracing/TraceRecorder.hpp"
+#include "Agents/AgentHost.hpp"
+#include "Spectator/SpectatorTap.hpp"
+#include "Video/VideoRecorder.hpp"
+#include "Utils/FunctionRef.hpp"
 
-using namespace Injected;
+using namespace Services;
 
 class HighwayPursuitServer
 {
     public:
         static constexpr float FPS = 60.0f;
         static constexpr long PERFORMANCE_COUNTER_FREQUENCY = 1000000;
-        static constexpr int GAME_TIMEOUT = 10000; // results in an error if the game fails to update
         static constexpr int PERIODIC_METRICS_FREQUENCY = static_cast<int>(FPS * 30); // update info every 30s of gameplay
         static constexpr int LOG_FREQUENCY = static_cast<int>(FPS * 60); // update metrics every minute of gameplay
+        static constexpr uint32_t TRACED_THREADS = 2; // the server thread and the game thread
 
-        HighwayPursuitServer(const Data::ServerParams& options);
+        HighwayPursuitServer(const Data::ServerParams& options, std::unique_ptr<GameBackend> backend);
         ~HighwayPursuitServer();
+        // Serves a client, replays an action log when the options have a replay path, or plays an agent plugin when they have one
         void Run();
+        const Replay::ReplayReport& LastReplayReport() const;
+        const Agents::AgentReport& LastAgentReport() const;
 
     private:
         float TICKS_PER_FRAME;
         float TICKS_PER_MS;
         const Data::ServerParams _options; // Game options
         std::unique_ptr<CommunicationManager> _communicationManager;
-        std::shared_ptr<HookManager> _hookManager;
-        std::unique_ptr<WindowService> _windowService;
-        std::unique_ptr<EpisodeService> _episodeService;
-        std::unique_ptr<UpdateService> _updateService;
-        std::unique_ptr<ScoreService> _scoreService;
-        std::unique_ptr<CheatService> _cheatService;
-        // Those has to be initialized from the main thread
-        std::shared_ptr<RenderingService> _renderingService;
-        std::shared_ptr<InputService> _inputService;
+        std::unique_ptr<GameBackend> _backend;
+        // Services owned by the backend
+        IUpdateService* _updateService;
+        IRenderingService* _renderingService;
+        IInputService* _inputService;
+        IStateService* _stateService;
+        // Steps and resets the game, its transforms are configured by the client (or the action log) once connected
+        std::unique_ptr<Environment::GameEnvironment> _environment;
 
-        HANDLE _lockUpdatePool; // Update thread waits for this
-        HANDLE _lockServerPool; // Server thread waits for this
-        std::atomic<bool> _firstEpisodeInitialized;
         std::atomic<bool> _serverTerminated;
-        uint64_t _totalEllapsedFrames;
-        Data::Termination _lastStepTermination;
         Data::Info _currentInfo;
-        ULONGLONG _startTick;
-        ULONGLONG _cumulatedServerTicks;
-        ULONGLONG _cumulatedGameTicks;
+        uint64_t _metricsFrames; // frames at the last update of tps and memory
+        std::chrono::steady_clock::time_point _metricsStart;
+        uint32_t _traceDumpCount;
+        std::vector<std::vector<uint8_t>> _snapshotObservations;
+        std::vector<Environment::GameEnvironment::State> _snapshotStates;
+        Metrics::MetricsWriter _metrics; // attached once connected
+        std::unique_ptr<Replay::ActionLogWriter> _actionLog;
+        uint32_t _lastStepAction; // as written by the client, replays map it again
+        uint32_t _lastStepRepeat;
+        float _lastStepReward;
+        bool _isReplaying;
+        Replay::ReplayReport _replayReport;
+        bool _isRunningAgent;
+        Agents::AgentReport _agentReport;
+        std::unique_ptr<Trajectory::TrajectoryWriter> _trajectoryWriter;
+        std::unique_ptr<ReplayBuffer::SharedReplayBuffer> _replayBuffer;
+        uint64_t _lastReplayTicket; // transition the next step starts from
+        std::unique_ptr<Spectator::SpectatorTap> _spectatorTap;
+        std::chrono::steady_clock::time_point _nextSpectatorPublish;
+        std::unique_ptr<Video::VideoRecorder> _videoRecorder;
 
-        void WaitGameUpdate();
-        void SkipIntro();
+        // Skips the intro, or loads the startup image of the options instead
+        void BootGame();
+        ServerInfo StartGame();
+        void ReplayActionLog(const ServerInfo& serverInfo);
+        void RunAgent(const ServerInfo& serverInfo);
+        bool HasClient() const;
+        void OpenRecorders();
         void HandleInstruction(InstructionCode code);
+        void RecordInstruction(InstructionCode code);
+        void RecordTransition(Trajectory::TransitionKind kind, uint32_t actionMask, float reward);
+        // Throttled to the rate of the options
+        void PublishSpectatorFrame(float reward);
         void Reset(bool startNewGame);
-        void ExecuteForOneFrame(std::function<void()> action);
-        void Step(std::function<void(std::function<void()>)> frameWrapper = nullptr);
+        void AutoReset();
+        void CaptureSnapshot();
+        void RestoreSnapshot();
+        void ExecuteForOneFrame(Utils::FunctionRef<void()> action);
+        void Step();
+        void PublishMetrics();
+        // Every PERIODIC_METRICS_FREQUENCY frames
+        void UpdatePeriodicMetrics();
         float ComputeMemoryUsage();
+        void DumpTrace();
 };
 
@@ -1,5 +1,5 @@
 #pragma once
-#include "../HookManager.hpp"
+#include "HookManager.hpp"
 
 namespace Injected
 {
@@ -1,16 +1,17 @@
 #pragma once
-#include "../HookManager.hpp"
+#include "HookManager.hpp"
+#include "../Services/IEpisodeService.hpp"
 
 namespace Injected
 {
-    class EpisodeService
+    class EpisodeService : public Services::IEpisodeService
     {
     public:
         EpisodeService(std::shared_ptr<HookManager> hookManager);
 
-        void NewGame();
-        void NewLife();
-        bool PullTerminated();
+        void NewGame() override;
+        void NewLife() override;
+        bool PullTerminated() override;
 
     private:
         std::shared_ptr<HookManager> _hookManager;
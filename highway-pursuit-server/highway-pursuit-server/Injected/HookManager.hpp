@@ -1,10 +1,31 @@
 #pragma once
+#include "../framework.h"
 #include "MinHook.h"
-#include "Data/ServerTypes.hpp"
-#include "Data/D3D8.hpp"
+#include "../Data/ServerTypes.hpp"
+#include "D3D8.hpp"
 
 using namespace Data;
 
+namespace Data
+{
+    class MinHookException : public std::runtime_error
+    {
+    public:
+        const MH_STATUS code;
+
+        MinHookException(MH_STATUS code)
+            : std::runtime_error(FormatErrorMessage(code)), code(code) {}
+
+    private:
+        static std::string FormatErrorMessage(MH_STATUS code)
+        {
+            std::ostringstream oss;
+            oss << "MinHook error: 0x" << std::setfill('0') << std::hex << static_cast<int>(code);
+            return oss.str();
+        }
+    };
+}
+
 class HookManager
 {
 public:
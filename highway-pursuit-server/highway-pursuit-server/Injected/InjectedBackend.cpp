@@ -0,0 +1,80 @@
+#include "../pch.h"
+#include "InjectedBackend.hpp"
+
+namespace Injected
+{
+    InjectedBackend::InjectedBackend(const ServerParams& options, float FPS, long performanceCounterFrequency)
+    {
+        // Hook manager
+        _hookManager = std::make_shared<HookManager>();
+
+        // init update semaphores
+        _lockUpdatePool = CreateSemaphore(nullptr, 0, 1, nullptr);
+        _lockServerPool = CreateSemaphore(nullptr, 0, 1, nullptr);
+
+        // Install static hooks/services
+        LARGE_INTEGER frequency;
+        frequency.QuadPart = performanceCounterFrequency;
+        _windowService = std::make_unique<WindowService>(_hookManager);
+        _episodeService = std::make_unique<EpisodeService>(_hookManager);
+        _updateService = std::make_unique<UpdateService>(_hookManager, options.isRealTime, _lockServerPool, _lockUpdatePool, FPS, frequency);
+        _scoreService = std::make_unique<ScoreService>(_hookManager);
+        _cheatService = std::make_unique<CheatService>(_hookManager);
+        _snapshotService = std::make_unique<SnapshotService>(_hookManager, *_scoreService);
+
+        // These need the app to be partly initialized to properly hook
+        _renderingService = std::make_shared<RenderingService>(_hookManager, options.renderParams);
+        _renderingService->SetFullscreenFlag(false);
+        _inputService = std::make_shared<InputService>(_hookManager);
+        _hookManager->EnableHooks();
+    }
+
+    InjectedBackend::~InjectedBackend()
+    {
+        // Try to shutdown game, release semaphore to ensure the game sees the notification
+        try
+        {
+            _updateService->NotifyShutdown();
+            ReleaseSemaphore(_lockUpdatePool, 1, nullptr);
+        }
+        catch (std::exception e)
+        {
+            HPLogger::LogException(e);
+        }
+
+        // Release all hooks/semaphores
+        _hookManager->Release();
+        CloseHandle(_lockUpdatePool);
+        CloseHandle(_lockServerPool);
+    }
+
+    Services::IEpisodeService& InjectedBackend::Episode()
+    {
+        return *_episodeService;
+    }
+
+    Services::IScoreService& InjectedBackend::Score()
+    {
+        return *_scoreService;
+    }
+
+    Services::IInputService& InjectedBackend::Input()
+    {
+        return *_inputService;
+    }
+
+    Services::IRenderingService& InjectedBackend::Rendering()
+    {
+        return *_renderingService;
+    }
+
+    Services::IUpdateService& InjectedBackend::Update()
+    {
+        return *_updateService;
+    }
+
+    Services::IStateService& InjectedBackend::State()
+    {
+        return *_snapshotService;
+    }
+}
@@ -0,0 +1,44 @@
+#pragma once
+#include "../Services/GameBackend.hpp"
+#include "HookManager.hpp"
+#include "CheatService.hpp"
+#include "EpisodeService.hpp"
+#include "InputService.hpp"
+#include "RenderingService.hpp"
+#include "ScoreService.hpp"
+#include "SnapshotService.hpp"
+#include "UpdateService.hpp"
+#include "WindowService.hpp"
+
+namespace Injected
+{
+    // Services hooked into the game process
+    class InjectedBackend : public Services::GameBackend
+    {
+    public:
+        InjectedBackend(const ServerParams& options, float FPS, long performanceCounterFrequency);
+        ~InjectedBackend();
+
+        Services::IEpisodeService& Episode() override;
+        Services::IScoreService& Score() override;
+        Services::IInputService& Input() override;
+        Services::IRenderingService& Rendering() override;
+        Services::IUpdateService& Update() override;
+        Services::IStateService& State() override;
+
+    private:
+        std::shared_ptr<HookManager> _hookManager;
+        std::unique_ptr<WindowService> _windowService;
+        std::unique_ptr<EpisodeService> _episodeService;
+        std::unique_ptr<UpdateService> _updateService;
+        std::unique_ptr<ScoreService> _scoreService;
+        std::unique_ptr<CheatService> _cheatService;
+        std::unique_ptr<SnapshotService> _snapshotService;
+        // Those has to be initialized from the main thread
+        std::shared_ptr<RenderingService> _renderingService;
+        std::shared_ptr<InputService> _inputService;
+
+        HANDLE _lockUpdatePool; // Update thread waits for this
+        HANDLE _lockServerPool; // Server thread waits for this
+    };
+}
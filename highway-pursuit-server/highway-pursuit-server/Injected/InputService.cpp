@@ -5,7 +5,10 @@
 namespace Injected
 {
     InputService::InputService(std::shared_ptr<HookManager> hookManager)
-        : _hookManager(hookManager)
+        : _hookManager(hookManager),
+        _currentInputMask(0),
+        _keyCodes(),
+        _bindingsLoaded(false)
     {
         FindAddresses();
         RegisterHooks();
@@ -16,9 +19,23 @@ namespace Injected
         return HighwayPursuitConstants::ACTION_COUNT;
     }
 
-    void InputService::SetInput(const std::vector<Input>& inputs)
+    void InputService::LoadBindings()
     {
-        _currentInputs = inputs;
+        for (uint32_t index = 0; index < HighwayPursuitConstants::ACTION_COUNT; ++index)
+        {
+            uint32_t keyCode = InputToKeyCode(InputUtils::IndexToInput(index));
+            if (keyCode >= KEYBOARD_STATE_SIZE)
+            {
+                throw std::runtime_error("Invalid key binding " + std::to_string(keyCode));
+            }
+            _keyCodes[index] = static_cast<uint8_t>(keyCode);
+        }
+        _bindingsLoaded = true;
+    }
+
+    void InputService::SetInput(const InputSet& inputs)
+    {
+        _currentInputMask.store(inputs.Mask(), std::memory_order_release);
     }
 
     uint32_t InputService::InputToOffset(Input input)
@@ -66,14 +83,14 @@ namespace Injected
 
         // Create direct input
         HMODULE hInstance = GetModuleHandle(NULL);
-        DirectInput8Wrapper dinput(hInstance, HighwayPursuitConstants::DINPUT_VERSION, HighwayPursuitConstants::IID_IDirectInput8A);
+        DirectInput8Wrapper dinput(hInstance, DirectXConstants::DINPUT_VERSION, DirectXConstants::IID_IDirectInput8A);
         uintptr_t* dinput_vtable = *reinterpret_cast<uintptr_t**>(dinput.DirectInput());
 
         DirectInputRelease_Base = reinterpret_cast<DirectInput8Release_t>(dinput_vtable[MemoryAddresses::DINPUT_RELEASE_OFFSET]);
         DirectInputCreateDevice_Base = reinterpret_cast<DirectInput8CreateDevice_t>(dinput_vtable[MemoryAddresses::DINPUT_CREATE_DEVICE_OFFSET]);
 
         // Create direct input device
-        DirectInputDevice8Wrapper device(dinput.DirectInput(), HighwayPursuitConstants::GUID_SysKeyboard);
+        DirectInputDevice8Wrapper device(dinput.DirectInput(), DirectXConstants::GUID_SysKeyboard);
         uintptr_t* device_vtable = *reinterpret_cast<uintptr_t**>(device.Device());
 
         DirectInputReleaseDevice_Base = reinterpret_cast<DirectInput8ReleaseDevice_t>(device_vtable[MemoryAddresses::DINPUT_RELEASE_DEVICE_OFFSET]);
@@ -112,16 +129,19 @@ namespace Injected
         uint8_t* pDeviceState = reinterpret_cast<uint8_t*>(lpvData);
 
         // Don't do anything in manual control
-        if (pDeviceState[MANUAL_CONTROL_KEY] == ACTIVE_KEY)
+        if (!_bindingsLoaded || deviceSize < KEYBOARD_STATE_SIZE || pDeviceState[MANUAL_CONTROL_KEY] == ACTIVE_KEY)
         {
             return res;
         }
 
-        // Update the modifiedState based on the inputs
-        for (Input input : _currentInputs)
+        // Update the modifiedState based on the inputs, keycodes were resolved once by LoadBindings
+        uint32_t inputMask = _currentInputMask.load(std::memory_order_acquire);
+        for (uint32_t index = 0; index < HighwayPursuitConstants::ACTION_COUNT; ++index)
         {
-            int keycode = InputToKeyCode(input);
-            pDeviceState[keycode] = ACTIVE_KEY;
+            if ((inputMask >> index) & 1u)
+            {
+                pDeviceState[_keyCodes[index]] = ACTIVE_KEY;
+            }
         }
         return res;
     }
@@ -1,24 +1,32 @@
 #pragma once
-#include "../HookManager.hpp"
+#include "HookManager.hpp"
+#include "../Services/IInputService.hpp"
+#include <array>
 
 using namespace Data;
 
 namespace Injected
 {
-    class InputService
+    class InputService : public Services::IInputService
     {
     public:
         InputService(std::shared_ptr<HookManager> hookManager);
-        int GetInputCount();
-        void SetInput(const std::vector<Input>& inputs);
+        int GetInputCount() override;
+        void LoadBindings() override;
+        void SetInput(const InputSet& inputs) override;
 
     private:
         static void HandleD3DERR(D3DERR errorCode);
         static const uint8_t ACTIVE_KEY = 0x80;
         static const uint8_t MANUAL_CONTROL_KEY = 0x2A; // holding left shift enables manual keyboard control
+        static const uint32_t KEYBOARD_STATE_SIZE = 256; // size of the DirectInput keyboard state
 
         std::shared_ptr<HookManager> _hookManager;
-        std::vector<Input> _currentInputs;
+        // Set by the server thread, read by the game thread on every poll
+        std::atomic<uint32_t> _currentInputMask;
+        // DirectInput keycode of each input index, resolved once by LoadBindings
+        std::array<uint8_t, HighwayPursuitConstants::ACTION_COUNT> _keyCodes;
+        std::atomic<bool> _bindingsLoaded;
 
         uint32_t InputToOffset(Input input);
         uint32_t InputToKeyCode(Input input);
@@ -1,6 +1,7 @@
 #include "../pch.h"
 #include "RenderingService.hpp"
 #include "MemoryAddresses.hpp"
+#include "../Tracing/TraceRecorder.hpp"
 
 namespace Injected
 {
@@ -28,7 +29,7 @@ namespace Injected
         }
 
         // Create a D3D8 instance
-        D3D8Wrapper d3d8(HighwayPursuitConstants::D3D8_SDK_VERSION);
+        D3D8Wrapper d3d8(DirectXConstants::D3D8_SDK_VERSION);
 
         // Find d3d8 functions
         uintptr_t* d3d8_vtable = *reinterpret_cast<uintptr_t**>(d3d8.D3D8());
@@ -110,8 +111,9 @@ namespace Injected
         *cameraZoom = FULL_ZOOM;
     }
 
-    void RenderingService::Screenshot(std::function<void(void*, const BufferFormat&)> pixelDataHandler)
+    void RenderingService::Screenshot(Utils::FunctionRef<void(void*, const BufferFormat&)> pixelDataHandler)
     {
+        HP_TRACE_SCOPE("Screenshot");
         // Back buffer method
         D3D8BackBufferSurfaceWrapper backbuffer(Device(), 0, D3DBACKBUFFER_TYPE::MONO);
         BufferFormat format = GetBufferFormatFromSurface(backbuffer.Surface());
@@ -119,7 +121,7 @@ namespace Injected
 
         // Lock pixels
         D3D8LockedRectWrapper lockedRect(backbuffer.Surface(), &renderingRect, LOCK_RECT_FLAGS::D3DLOCK_READONLY);
-        pixelDataHandler(lockedRect.Rect()->pBits, format);
+        pixelDataHandler(lockedRect.Rect().pBits, format);
     }
 
 
@@ -127,7 +129,18 @@ namespace Injected
     {
         D3DSURFACE_DESC desc;
         HandleD3DERR(IDirect3DSurface8_Base::GetDesc(pSurface, &desc));
-        return BufferFormat(desc);
+        return BufferFormat(desc.Width, desc.Height, FormatToChannels(desc.Format));
+    }
+
+    uint32_t RenderingService::FormatToChannels(D3DFORMAT format)
+    {
+        switch (format)
+        {
+        case D3DFORMAT::D3DFMT_X8R8G8B8:
+            return 4;
+        default:
+            throw HighwayPursuitException(ErrorCode::UNSUPPORTED_BACKBUFFER_FORMAT);
+        }
     }
 
     IDirect3DDevice8* RenderingService::Device()
@@ -302,10 +315,9 @@ namespace Injected
         return _pSurface;
     }
 
-    RenderingService::D3D8LockedRectWrapper::D3D8LockedRectWrapper(IDirect3DSurface8* pSurface, CONST RECT* pRect, DWORD Flags) : _pSurface(pSurface)
+    RenderingService::D3D8LockedRectWrapper::D3D8LockedRectWrapper(IDirect3DSurface8* pSurface, CONST RECT* pRect, DWORD Flags) : _lockedRect(), _pSurface(pSurface)
     {
-        _lockedRect = std::make_shared<D3DLOCKED_RECT>();
-        HandleD3DERR(IDirect3DSurface8_Base::LockRect(_pSurface, _lockedRect.get(), pRect, Flags));
+        HandleD3DERR(IDirect3DSurface8_Base::LockRect(_pSurface, &_lockedRect, pRect, Flags));
     }
 
     RenderingService::D3D8LockedRectWrapper::~D3D8LockedRectWrapper()
@@ -313,7 +325,7 @@ namespace Injected
         HandleD3DERR(IDirect3DSurface8_Base::UnlockRect(_pSurface));
     }
 
-    std::shared_ptr<D3DLOCKED_RECT> RenderingService::D3D8LockedRectWrapper::Rect()
+    const D3DLOCKED_RECT& RenderingService::D3D8LockedRectWrapper::Rect() const
     {
         return _lockedRect;
     }
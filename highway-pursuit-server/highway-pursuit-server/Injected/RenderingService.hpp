@@ -1,13 +1,14 @@
 #pragma once
 #include "../Data/ServerTypes.hpp"
-#include "../Data/D3D8.hpp"
-#include "../HookManager.hpp"
+#include "D3D8.hpp"
+#include "HookManager.hpp"
+#include "../Services/IRenderingService.hpp"
 
 namespace Injected
 {
     using namespace Data;
 
-	class RenderingService {
+	class RenderingService : public Services::IRenderingService {
     public:
         void FindAddresses();
 
@@ -19,10 +20,10 @@ namespace Injected
         RenderingService(std::shared_ptr<HookManager> hookManager, const ServerParams::RenderParams& renderParams);
 
         // Methods
-        BufferFormat GetBufferFormat();
+        BufferFormat GetBufferFormat() override;
         void SetFullscreenFlag(bool useFullscreen);
-        void ResetZoomLevel();
-        void Screenshot(std::function<void(void*, const BufferFormat&)> pixelDataHandler);
+        void ResetZoomLevel() override;
+        void Screenshot(Utils::FunctionRef<void(void*, const BufferFormat&)> pixelDataHandler) override;
 
     private:
         static void HandleD3DERR(D3DERR errorCode);
@@ -33,6 +34,7 @@ namespace Injected
         // Private methods
         void RegisterHooks();
         BufferFormat GetBufferFormatFromSurface(IDirect3DSurface8* pSurface);
+        static uint32_t FormatToChannels(D3DFORMAT format);
         IDirect3DDevice8* Device();
 
         // Hooks
@@ -130,12 +132,12 @@ namespace Injected
 
         class D3D8LockedRectWrapper
         {
-            std::shared_ptr<D3DLOCKED_RECT> _lockedRect;
+            D3DLOCKED_RECT _lockedRect; // held by value, screenshots don't allocate
             IDirect3DSurface8* _pSurface;
         public:
             D3D8LockedRectWrapper(IDirect3DSurface8* pSurface, CONST RECT* pRect, DWORD Flags);
             ~D3D8LockedRectWrapper();
-            std::shared_ptr<D3DLOCKED_RECT> Rect();
+            const D3DLOCKED_RECT& Rect() const;
         };
     };
 }
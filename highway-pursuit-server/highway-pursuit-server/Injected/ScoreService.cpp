@@ -17,6 +17,17 @@ namespace Injected
         return scoreDelta;
     }
 
+    uint32_t ScoreService::SaveScore() const
+    {
+        return _newScore;
+    }
+
+    void ScoreService::RestoreScore(uint32_t score)
+    {
+        _lastScore = score;
+        _newScore = score;
+    }
+
     // RegisterHooks method
     void ScoreService::RegisterHooks()
     {
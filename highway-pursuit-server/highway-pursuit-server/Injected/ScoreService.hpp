@@ -1,14 +1,18 @@
 #pragma once
-#include "../HookManager.hpp"
+#include "HookManager.hpp"
+#include "../Services/IScoreService.hpp"
 
 namespace Injected
 {
 
-    class ScoreService
+    class ScoreService : public Services::IScoreService
     {
     public:
         ScoreService(std::shared_ptr<HookManager> hookManager);
-        uint32_t PullReward();
+        uint32_t PullReward() override;
+        // The reward baseline follows the game's score when it is snapshotted/restored
+        uint32_t SaveScore() const;
+        void RestoreScore(uint32_t score);
 
     private:
         std::shared_ptr<HookManager> _hookManager;
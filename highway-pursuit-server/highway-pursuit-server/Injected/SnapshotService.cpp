@@ -0,0 +1,567 @@
+#include "../pch.h"
+#include "SnapshotService.hpp"
+#include <algorithm>
+#include <iterator>
+#include <intrin.h>
+
+namespace Injected
+{
+    namespace
+    {
+        // Size of the reservation starting at base, its pages can be committed or not
+        size_t ReservationSize(uintptr_t base)
+        {
+            size_t size = 0;
+            MEMORY_BASIC_INFORMATION info;
+            while (VirtualQuery(reinterpret_cast<LPCVOID>(base + size), &info, sizeof(info)) != 0
+                && reinterpret_cast<uintptr_t>(info.AllocationBase) == base)
+            {
+                size += info.RegionSize;
+            }
+            return size;
+        }
+    }
+
+    SnapshotService::SnapshotService(std::shared_ptr<HookManager> hookManager, ScoreService& scoreService)
+        : _hookManager(hookManager),
+        _scoreService(scoreService),
+        // Never write-protected, see the class comment
+        _engine(HighwayPursuitConstants::SNAPSHOT_SLOTS, false),
+        _scores(HighwayPursuitConstants::SNAPSHOT_SLOTS, 0),
+        _regionsFrozen(false),
+        _trackedAllocationFreed(false),
+        _allocatedSinceFreeze(false),
+        _crtBase(0),
+        _crtSize(0),
+        _crtIsSystemMsvcrt(false),
+        _crtHeap(nullptr),
+        _heapSequence(0),
+        _captureSequences(HighwayPursuitConstants::SNAPSHOT_SLOTS, 0),
+        _slotsRestorable(HighwayPursuitConstants::SNAPSHOT_SLOTS, false)
+    {
+        FindCrtModule();
+        RegisterHooks();
+    }
+
+    uint32_t SnapshotService::GetSnapshotSlotCount()
+    {
+        return _engine.SlotCount();
+    }
+
+    void SnapshotService::Capture(uint32_t slot)
+    {
+        FreezeRegions();
+        // The heap's metadata only matches the captured segments if it didn't grow another one
+        bool heapTracked = _crtHeap == nullptr || HeapSegmentsTracked();
+        CommitHeapReservations();
+        _engine.Capture(slot);
+        _scores[slot] = _scoreService.SaveScore();
+
+        std::lock_guard<std::mutex> lock(_heapMutex);
+        _captureSequences[slot] = ++_heapSequence;
+        _slotsRestorable[slot] = heapTracked;
+    }
+
+    bool SnapshotService::Restore(uint32_t slot)
+    {
+        // A freed region can't be written back
+        if (_trackedAllocationFreed)
+        {
+            return false;
+        }
+        {
+            // The restored memory could point to heap blocks freed since the capture
+            std::lock_guard<std::mutex> lock(_heapMutex);
+            if (slot >= _slotsRestorable.size() || !_slotsRestorable[slot])
+            {
+                return false;
+            }
+        }
+        CommitHeapReservations();
+        _engine.Restore(slot);
+        _scoreService.RestoreScore(_scores[slot]);
+        return true;
+    }
+
+    bool SnapshotService::SaveImage(const std::string& path)
+    {
+        if (!CanSaveImage())
+        {
+            return false;
+        }
+        CommitHeapReservations();
+        // A second process that reached the memory of the image through the intro validates it for the next ones
+        uint64_t key = ImageKey();
+        bool validated = _engine.MatchesImage(path, key, _bootMemory);
+        _engine.SaveImage(path, key, _scoreService.SaveScore(), _bootMemory, validated);
+        if (validated)
+        {
+            HPLogger::LogInfo("The startup image " + path + " matches the intro of this process, the next ones load it");
+        }
+        return true;
+    }
+
+    bool SnapshotService::LoadImage(const std::string& path)
+    {
+        // The image has the layout of the regions at the boot
+        FreezeRegions();
+        CommitHeapReservations();
+        _bootMemory = _engine.ReadMemory();
+        uint64_t score = 0;
+        if (!_engine.LoadImage(path, ImageKey(), score, _bootMemory))
+        {
+            return false;
+        }
+        _scoreService.RestoreScore(static_cast<uint32_t>(score));
+        return true;
+    }
+
+    uint64_t SnapshotService::ImageKey()
+    {
+        // Build of the game executable and addresses of the regions
+        uintptr_t moduleBase = _hookManager->GetModuleBase();
+        auto dosHeader = reinterpret_cast<const IMAGE_DOS_HEADER*>(moduleBase);
+        auto ntHeaders = reinterpret_cast<const IMAGE_NT_HEADERS*>(moduleBase + dosHeader->e_lfanew);
+        uint64_t key = 1469598103934665603ull;
+        auto mix = [&key](uint64_t value) { key = (key ^ value) * 1099511628211ull; };
+        mix(ntHeaders->FileHeader.TimeDateStamp);
+        mix(ntHeaders->OptionalHeader.SizeOfImage);
+        mix(moduleBase);
+        std::lock_guard<std::mutex> lock(_allocationsMutex);
+        for (const Allocation& allocation : _allocations)
+        {
+            mix(allocation.base);
+            mix(allocation.size);
+        }
+        for (const Allocation& reservation : _heapReservations)
+        {
+            mix(reservation.base);
+            mix(reservation.size);
+        }
+        return key;
+    }
+
+    bool SnapshotService::CanSaveImage()
+    {
+        // Whatever the intro changed has to be in the image
+        std::string reason;
+        if (_bootMemory.empty())
+        {
+            reason = "the regions weren't frozen at the boot";
+        }
+        else if (_crtHeap == nullptr)
+        {
+            reason = "the CRT heap isn't captured";
+        }
+        else if (!HeapSegmentsTracked())
+        {
+            reason = "the CRT heap grew a segment during the intro";
+        }
+        else if (_allocatedSinceFreeze || _trackedAllocationFreed)
+        {
+            reason = "the game allocated or freed memory during the intro";
+        }
+        else
+        {
+            std::lock_guard<std::mutex> lock(_heapMutex);
+            if (!_heapBlocks.empty())
+            {
+                reason = "the game has heap blocks outside its CRT heap";
+            }
+        }
+        if (!reason.empty())
+        {
+            HPLogger::LogWarning("No startup image of the game, " + reason);
+            return false;
+        }
+        return true;
+    }
+
+    void SnapshotService::FreezeRegions()
+    {
+        if (_regionsFrozen)
+        {
+            return;
+        }
+
+        TrackModuleSections();
+        TrackCrtHeap();
+        std::lock_guard<std::mutex> lock(_allocationsMutex);
+        for (const Allocation& allocation : _allocations)
+        {
+            _engine.TrackRegion(reinterpret_cast<void*>(allocation.base), allocation.size, AllocationWriteDetection(allocation));
+        }
+        _regionsFrozen = true;
+    }
+
+    void SnapshotService::TrackModuleSections()
+    {
+        // Writable sections of the game executable (.data, .bss)
+        uintptr_t moduleBase = _hookManager->GetModuleBase();
+        auto dosHeader = reinterpret_cast<const IMAGE_DOS_HEADER*>(moduleBase);
+        auto ntHeaders = reinterpret_cast<const IMAGE_NT_HEADERS*>(moduleBase + dosHeader->e_lfanew);
+        const IMAGE_SECTION_HEADER* section = IMAGE_FIRST_SECTION(ntHeaders);
+        for (WORD i = 0; i < ntHeaders->FileHeader.NumberOfSections; ++i, ++section)
+        {
+            bool isWritable = (section->Characteristics & IMAGE_SCN_MEM_WRITE) != 0;
+            bool isCode = (section->Characteristics & IMAGE_SCN_MEM_EXECUTE) != 0;
+            if (isWritable && !isCode && section->Misc.VirtualSize > 0)
+            {
+                _engine.TrackRegion(reinterpret_cast<void*>(moduleBase + section->VirtualAddress), section->Misc.VirtualSize, Snapshot::WriteDetection::NONE);
+            }
+        }
+    }
+
+    void SnapshotService::TrackCrtHeap()
+    {
+        // Only a heap of the game's own: the system msvcrt serves the system dlls too and ucrtbase allocates from the process heap
+        if (_crtBase == 0 || _crtIsSystemMsvcrt)
+        {
+            return;
+        }
+        typedef intptr_t(__cdecl* GetHeapHandle_t)();
+        auto getHeapHandle = reinterpret_cast<GetHeapHandle_t>(GetProcAddress(reinterpret_cast<HMODULE>(_crtBase), "_get_heap_handle"));
+        if (getHeapHandle == nullptr)
+        {
+            return;
+        }
+        HANDLE heap = reinterpret_cast<HANDLE>(getHeapHandle());
+        if (heap == nullptr || heap == GetProcessHeap())
+        {
+            return;
+        }
+
+        // The whole reservation of each segment: the pages the heap commits or decommits later stay in the snapshot
+        std::vector<Allocation> reservations;
+        PROCESS_HEAP_ENTRY entry{};
+        HeapLock(heap);
+        while (HeapWalk(heap, &entry))
+        {
+            if ((entry.wFlags & PROCESS_HEAP_REGION) == 0)
+            {
+                continue;
+            }
+            MEMORY_BASIC_INFORMATION info;
+            if (VirtualQuery(entry.lpData, &info, sizeof(info)) == 0)
+            {
+                continue;
+            }
+            uintptr_t base = reinterpret_cast<uintptr_t>(info.AllocationBase);
+            if (std::none_of(reservations.begin(), reservations.end(), [base](const Allocation& a) { return a.base == base; }))
+            {
+                reservations.push_back(Allocation{ base, ReservationSize(base) });
+            }
+        }
+        bool walked = GetLastError() == ERROR_NO_MORE_ITEMS;
+        HeapUnlock(heap);
+        if (!walked)
+        {
+            HPLogger::LogWarning("Failed to walk the CRT heap, it isn't part of the snapshots");
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(_heapMutex);
+            _crtHeap = heap;
+            _heapReservations = std::move(reservations);
+            // Put back by a restore from now on
+            for (auto block = _heapBlocks.begin(); block != _heapBlocks.end();)
+            {
+                block = IsInCapturedHeap(block->first) ? _heapBlocks.erase(block) : std::next(block);
+            }
+        }
+        CommitHeapReservations();
+        for (const Allocation& reservation : _heapReservations)
+        {
+            _engine.TrackRegion(reinterpret_cast<void*>(reservation.base), reservation.size, Snapshot::WriteDetection::NONE);
+        }
+    }
+
+    bool SnapshotService::HeapSegmentsTracked()
+    {
+        bool tracked = true;
+        PROCESS_HEAP_ENTRY entry{};
+        HeapLock(_crtHeap);
+        while (HeapWalk(_crtHeap, &entry))
+        {
+            if ((entry.wFlags & PROCESS_HEAP_REGION) != 0 && !IsInCapturedHeap(reinterpret_cast<uintptr_t>(entry.lpData)))
+            {
+                tracked = false;
+            }
+        }
+        HeapUnlock(_crtHeap);
+        return tracked;
+    }
+
+    void SnapshotService::CommitHeapReservations()
+    {
+        // The heap decommits free pages, committed again they read as zeros and the restore can write them
+        for (const Allocation& reservation : _heapReservations)
+        {
+            VirtualAlloc_Base(reinterpret_cast<LPVOID>(reservation.base), reservation.size, MEM_COMMIT, PAGE_READWRITE);
+        }
+    }
+
+    bool SnapshotService::IsInCapturedHeap(uintptr_t address) const
+    {
+        return std::any_of(_heapReservations.begin(), _heapReservations.end(),
+            [address](const Allocation& reservation) { return address >= reservation.base && address < reservation.base + reservation.size; });
+    }
+
+    Snapshot::WriteDetection SnapshotService::AllocationWriteDetection(const Allocation& allocation) const
+    {
+        // Commits inside a watched reservation are watched
+        for (const Allocation& reservation : _watchedReservations)
+        {
+            if (allocation.base >= reservation.base && allocation.base + allocation.size <= reservation.base + reservation.size)
+            {
+                return Snapshot::WriteDetection::WRITE_WATCH;
+            }
+        }
+        return Snapshot::WriteDetection::NONE;
+    }
+
+    bool SnapshotService::IsCalledFromGame(void* returnAddress) const
+    {
+        uintptr_t moduleBase = _hookManager->GetModuleBase();
+        auto dosHeader = reinterpret_cast<const IMAGE_DOS_HEADER*>(moduleBase);
+        auto ntHeaders = reinterpret_cast<const IMAGE_NT_HEADERS*>(moduleBase + dosHeader->e_lfanew);
+        uintptr_t address = reinterpret_cast<uintptr_t>(returnAddress);
+        return address >= moduleBase && address < moduleBase + ntHeaders->OptionalHeader.SizeOfImage;
+    }
+
+    bool SnapshotService::IsCalledFromGameHeap(void* returnAddress) const
+    {
+        uintptr_t address = reinterpret_cast<uintptr_t>(returnAddress);
+        return IsCalledFromGame(returnAddress) || (address >= _crtBase && address < _crtBase + _crtSize);
+    }
+
+    void SnapshotService::FindCrtModule()
+    {
+        // The game's free() runs in its CRT: in the game module when linked statically, else in the imported msvcr*/ucrt dll
+        uintptr_t moduleBase = _hookManager->GetModuleBase();
+        auto dosHeader = reinterpret_cast<const IMAGE_DOS_HEADER*>(moduleBase);
+        auto ntHeaders = reinterpret_cast<const IMAGE_NT_HEADERS*>(moduleBase + dosHeader->e_lfanew);
+        const IMAGE_DATA_DIRECTORY& imports = ntHeaders->OptionalHeader.DataDirectory[IMAGE_DIRECTORY_ENTRY_IMPORT];
+        if (imports.VirtualAddress == 0)
+        {
+            return;
+        }
+        for (auto descriptor = reinterpret_cast<const IMAGE_IMPORT_DESCRIPTOR*>(moduleBase + imports.VirtualAddress); descriptor->Name != 0; ++descriptor)
+        {
+            std::string name(reinterpret_cast<const char*>(moduleBase + descriptor->Name));
+            std::transform(name.begin(), name.end(), name.begin(), [](char c) { return static_cast<char>(std::tolower(static_cast<unsigned char>(c))); });
+            // The api-ms-win-crt sets forward to ucrtbase
+            HMODULE crt = nullptr;
+            if (name.rfind("msvcr", 0) == 0)
+            {
+                crt = GetModuleHandleA(name.c_str());
+                _crtIsSystemMsvcrt = name == "msvcrt.dll";
+            }
+            else if (name.rfind("ucrtbase", 0) == 0 || name.rfind("api-ms-win-crt-", 0) == 0)
+            {
+                crt = GetModuleHandleA("ucrtbase.dll");
+            }
+            if (crt != nullptr)
+            {
+                auto crtBase = reinterpret_cast<uintptr_t>(crt);
+                auto crtDosHeader = reinterpret_cast<const IMAGE_DOS_HEADER*>(crtBase);
+                auto crtNtHeaders = reinterpret_cast<const IMAGE_NT_HEADERS*>(crtBase + crtDosHeader->e_lfanew);
+                _crtBase = crtBase;
+                _crtSize = crtNtHeaders->OptionalHeader.SizeOfImage;
+                return;
+            }
+        }
+    }
+
+    void SnapshotService::RegisterHooks()
+    {
+        SnapshotService::Instance = this;
+
+        HMODULE kernel32 = GetModuleHandleA("kernel32.dll");
+        LPVOID virtualAllocPtr = reinterpret_cast<LPVOID>(GetProcAddress(kernel32, "VirtualAlloc"));
+        LPVOID virtualFreePtr = reinterpret_cast<LPVOID>(GetProcAddress(kernel32, "VirtualFree"));
+        LPVOID heapAllocPtr = reinterpret_cast<LPVOID>(GetProcAddress(kernel32, "HeapAlloc"));
+        LPVOID heapFreePtr = reinterpret_cast<LPVOID>(GetProcAddress(kernel32, "HeapFree"));
+        LPVOID heapReAllocPtr = reinterpret_cast<LPVOID>(GetProcAddress(kernel32, "HeapReAlloc"));
+        if (virtualAllocPtr == nullptr || virtualFreePtr == nullptr || heapAllocPtr == nullptr || heapFreePtr == nullptr || heapReAllocPtr == nullptr)
+        {
+            throw std::runtime_error("Failed to get VirtualAlloc/VirtualFree/HeapAlloc/HeapFree/HeapReAlloc");
+        }
+        _hookManager->RegisterHook(virtualAllocPtr, &VirtualAlloc_StaticHook, &VirtualAlloc_Base);
+        _hookManager->RegisterHook(virtualFreePtr, &VirtualFree_StaticHook, &VirtualFree_Base);
+        _hookManager->RegisterHook(heapAllocPtr, &HeapAlloc_StaticHook, &HeapAlloc_Base);
+        _hookManager->RegisterHook(heapFreePtr, &HeapFree_StaticHook, &HeapFree_Base);
+        _hookManager->RegisterHook(heapReAllocPtr, &HeapReAlloc_StaticHook, &HeapReAlloc_Base);
+    }
+
+    LPVOID SnapshotService::VirtualAlloc_Hook(void* returnAddress, LPVOID lpAddress, SIZE_T dwSize, DWORD flAllocationType, DWORD flProtect)
+    {
+        // The game's reservations record their writes, a commit without reservation reserves too
+        bool isGameCall = IsCalledFromGame(returnAddress) && !_regionsFrozen;
+        bool watch = isGameCall && (flAllocationType & MEM_RESERVE) != 0 && (flAllocationType & (MEM_LARGE_PAGES | MEM_PHYSICAL)) == 0;
+        LPVOID address = watch ? VirtualAlloc_Base(lpAddress, dwSize, flAllocationType | MEM_WRITE_WATCH, flProtect) : nullptr;
+        if (address == nullptr)
+        {
+            watch = false;
+            address = VirtualAlloc_Base(lpAddress, dwSize, flAllocationType, flProtect);
+        }
+        if (address != nullptr && !isGameCall && _regionsFrozen && (flAllocationType & MEM_COMMIT) != 0 && flProtect == PAGE_READWRITE
+            && IsCalledFromGame(returnAddress))
+        {
+            // Outside the regions, a startup image written after it would miss it
+            _allocatedSinceFreeze = true;
+        }
+        if (address == nullptr || !isGameCall)
+        {
+            return address;
+        }
+
+        // Only the game's own read/write memory is tracked, allocations of the server and of the system dlls are not
+        std::lock_guard<std::mutex> lock(_allocationsMutex);
+        if (watch)
+        {
+            _watchedReservations.push_back(Allocation{ reinterpret_cast<uintptr_t>(address), dwSize });
+        }
+        if ((flAllocationType & MEM_COMMIT) != 0 && flProtect == PAGE_READWRITE)
+        {
+            _allocations.push_back(Allocation{ reinterpret_cast<uintptr_t>(address), dwSize });
+        }
+        return address;
+    }
+
+    BOOL SnapshotService::VirtualFree_Hook(LPVOID lpAddress, SIZE_T dwSize, DWORD dwFreeType)
+    {
+        {
+            std::lock_guard<std::mutex> lock(_allocationsMutex);
+            uintptr_t base = reinterpret_cast<uintptr_t>(lpAddress);
+            auto allocation = std::find_if(_allocations.begin(), _allocations.end(),
+                [base](const Allocation& a) { return a.base == base; });
+            if (allocation != _allocations.end() && (dwFreeType & MEM_RELEASE) != 0)
+            {
+                if (_regionsFrozen)
+                {
+                    _trackedAllocationFreed = true;
+                }
+                else
+                {
+                    _allocations.erase(allocation);
+                }
+            }
+            auto reservation = std::find_if(_watchedReservations.begin(), _watchedReservations.end(),
+                [base](const Allocation& a) { return a.base == base; });
+            if (reservation != _watchedReservations.end() && (dwFreeType & MEM_RELEASE) != 0 && !_regionsFrozen)
+            {
+                _watchedReservations.erase(reservation);
+            }
+        }
+        return VirtualFree_Base(lpAddress, dwSize, dwFreeType);
+    }
+
+    void SnapshotService::HeapAlloc_Hook(void* returnAddress, LPVOID block)
+    {
+        if (block == nullptr || !IsCalledFromGameHeap(returnAddress))
+        {
+            return;
+        }
+        uintptr_t address = reinterpret_cast<uintptr_t>(block);
+        std::lock_guard<std::mutex> lock(_heapMutex);
+        if (!IsInCapturedHeap(address))
+        {
+            _heapBlocks[address] = ++_heapSequence;
+        }
+    }
+
+    void SnapshotService::HeapFree_Hook(void* returnAddress, LPVOID block)
+    {
+        if (!IsCalledFromGameHeap(returnAddress))
+        {
+            return;
+        }
+        uintptr_t address = reinterpret_cast<uintptr_t>(block);
+        std::lock_guard<std::mutex> lock(_heapMutex);
+        if (IsInCapturedHeap(address))
+        {
+            return;
+        }
+        // The slots captured while the block was allocated depend on it, a block allocated before the hooks on every slot
+        uint64_t allocated = 0;
+        auto allocation = _heapBlocks.find(address);
+        if (allocation != _heapBlocks.end())
+        {
+            allocated = allocation->second;
+            _heapBlocks.erase(allocation);
+        }
+        for (size_t slot = 0; slot < _captureSequences.size(); ++slot)
+        {
+            if (_captureSequences[slot] > allocated)
+            {
+                _slotsRestorable[slot] = false;
+            }
+        }
+    }
+
+    LPVOID WINAPI SnapshotService::VirtualAlloc_StaticHook(LPVOID lpAddress, SIZE_T dwSize, DWORD flAllocationType, DWORD flProtect)
+    {
+        if (SnapshotService::Instance != nullptr)
+        {
+            return SnapshotService::Instance->VirtualAlloc_Hook(_ReturnAddress(), lpAddress, dwSize, flAllocationType, flProtect);
+        }
+        return VirtualAlloc_Base(lpAddress, dwSize, flAllocationType, flProtect);
+    }
+
+    BOOL WINAPI SnapshotService::VirtualFree_StaticHook(LPVOID lpAddress, SIZE_T dwSize, DWORD dwFreeType)
+    {
+        if (SnapshotService::Instance != nullptr)
+        {
+            return SnapshotService::Instance->VirtualFree_Hook(lpAddress, dwSize, dwFreeType);
+        }
+        return VirtualFree_Base(lpAddress, dwSize, dwFreeType);
+    }
+
+    LPVOID WINAPI SnapshotService::HeapAlloc_StaticHook(HANDLE hHeap, DWORD dwFlags, SIZE_T dwBytes)
+    {
+        LPVOID block = HeapAlloc_Base(hHeap, dwFlags, dwBytes);
+        if (SnapshotService::Instance != nullptr && !InHeapHook)
+        {
+            InHeapHook = true;
+            SnapshotService::Instance->HeapAlloc_Hook(_ReturnAddress(), block);
+            InHeapHook = false;
+        }
+        return block;
+    }
+
+    BOOL WINAPI SnapshotService::HeapFree_StaticHook(HANDLE hHeap, DWORD dwFlags, LPVOID lpMem)
+    {
+        // Before the free, the address can't be handed out again meanwhile
+        if (SnapshotService::Instance != nullptr && lpMem != nullptr && !InHeapHook)
+        {
+            InHeapHook = true;
+            SnapshotService::Instance->HeapFree_Hook(_ReturnAddress(), lpMem);
+            InHeapHook = false;
+        }
+        return HeapFree_Base(hHeap, dwFlags, lpMem);
+    }
+
+    LPVOID WINAPI SnapshotService::HeapReAlloc_StaticHook(HANDLE hHeap, DWORD dwFlags, LPVOID lpMem, SIZE_T dwBytes)
+    {
+        LPVOID block = HeapReAlloc_Base(hHeap, dwFlags, lpMem, dwBytes);
+        // A block that moves is freed and allocated again
+        if (SnapshotService::Instance != nullptr && block != nullptr && block != lpMem && !InHeapHook)
+        {
+            InHeapHook = true;
+            SnapshotService::Instance->HeapFree_Hook(_ReturnAddress(), lpMem);
+            SnapshotService::Instance->HeapAlloc_Hook(_ReturnAddress(), block);
+            InHeapHook = false;
+        }
+        return block;
+    }
+
+    SnapshotService* SnapshotService::Instance = nullptr;
+    SnapshotService::VirtualAlloc_t SnapshotService::VirtualAlloc_Base = nullptr;
+    SnapshotService::VirtualFree_t SnapshotService::VirtualFree_Base = nullptr;
+    thread_local bool SnapshotService::InHeapHook = false;
+    SnapshotService::HeapAlloc_t SnapshotService::HeapAlloc_Base = nullptr;
+    SnapshotService::HeapFree_t SnapshotService::HeapFree_Base = nullptr;
+    SnapshotService::HeapReAlloc_t SnapshotService::HeapReAlloc_Base = nullptr;
+}
@@ -0,0 +1,108 @@
+#pragma once
+#include "HookManager.hpp"
+#include "../Services/IStateService.hpp"
+#include "../Snapshot/SnapshotEngine.hpp"
+#include "ScoreService.hpp"
+#include <unordered_map>
+
+namespace Injected
+{
+    // Snapshots the game module's writable sections, the memory the game allocates with VirtualAlloc and the heap of its CRT.
+    // Regions are frozen on the first capture. The D3D/DirectInput objects, the thread stacks and the other heaps are not part of the snapshot.
+    // Nothing is write-protected, the game's system calls (ReadFile, out parameters) write the tracked memory too:
+    // the game's reservations get MEM_WRITE_WATCH and the system records their written pages, the module sections,
+    // the heap and the other allocations are compared on restore.
+    // The CRT heap is captured whole (its segments, headers and free lists included) when the game has it to itself: a restore puts back
+    // the blocks freed since. It isn't when the CRT uses the process heap or is the system msvcrt shared with other dlls, and the blocks
+    // the heap serves from VirtualAlloc (the largest ones) aren't either. Restored memory could point to such blocks freed since:
+    // a slot is refused once the game (or its CRT dll) freed or reallocated a block that was allocated when the slot was captured.
+    // A capture taken once the heap grew a segment after the first one can't be restored either.
+    // Startup images: with an image, the regions are frozen at the boot instead of the first capture and the memory at the boot is the
+    // baseline of the image. Its pointers to the D3D/DirectInput objects and the window of the writer are relocated to the ones of the
+    // loader (SnapshotEngine::LoadImage), and the image is only loaded once a second process reached the same memory through the intro.
+    // The key holds the addresses of the regions, the memory points into itself. No image is written if the intro allocated memory
+    // outside the regions or if the CRT heap isn't captured.
+    class SnapshotService : public Services::IStateService
+    {
+    public:
+        SnapshotService(std::shared_ptr<HookManager> hookManager, ScoreService& scoreService);
+
+        uint32_t GetSnapshotSlotCount() override;
+        void Capture(uint32_t slot) override;
+        bool Restore(uint32_t slot) override;
+        bool SaveImage(const std::string& path) override;
+        bool LoadImage(const std::string& path) override;
+
+    private:
+        struct Allocation
+        {
+            uintptr_t base;
+            size_t size;
+        };
+
+        std::shared_ptr<HookManager> _hookManager;
+        ScoreService& _scoreService;
+        Snapshot::SnapshotEngine _engine;
+        std::vector<uint32_t> _scores; // the reward baseline lives in the dll, not in the game
+        std::mutex _allocationsMutex;
+        std::vector<Allocation> _allocations;
+        std::vector<Allocation> _watchedReservations; // reserved with MEM_WRITE_WATCH
+        bool _regionsFrozen;
+        bool _trackedAllocationFreed;
+        std::atomic<bool> _allocatedSinceFreeze; // by the game, outside the tracked regions
+        std::vector<uint8_t> _bootMemory; // baseline of the startup image
+        uintptr_t _crtBase; // CRT dll imported by the game, 0 if the CRT is linked statically
+        size_t _crtSize;
+        bool _crtIsSystemMsvcrt;
+        HANDLE _crtHeap; // captured heap, nullptr if shared with other modules
+        std::vector<Allocation> _heapReservations; // segments of the captured heap
+        std::mutex _heapMutex;
+        std::unordered_map<uintptr_t, uint64_t> _heapBlocks; // live blocks of the game outside the captured heap, by allocation sequence
+        uint64_t _heapSequence;
+        std::vector<uint64_t> _captureSequences; // per slot, 0 if never captured
+        std::vector<bool> _slotsRestorable;
+
+        void FreezeRegions();
+        void TrackModuleSections();
+        uint64_t ImageKey();
+        bool CanSaveImage();
+        void TrackCrtHeap();
+        bool HeapSegmentsTracked();
+        void CommitHeapReservations();
+        bool IsInCapturedHeap(uintptr_t address) const;
+        Snapshot::WriteDetection AllocationWriteDetection(const Allocation& allocation) const;
+        bool IsCalledFromGame(void* returnAddress) const;
+        bool IsCalledFromGameHeap(void* returnAddress) const;
+        void FindCrtModule();
+        void RegisterHooks();
+
+        // Hooks
+        static SnapshotService* Instance;
+        LPVOID VirtualAlloc_Hook(void* returnAddress, LPVOID lpAddress, SIZE_T dwSize, DWORD flAllocationType, DWORD flProtect);
+        BOOL VirtualFree_Hook(LPVOID lpAddress, SIZE_T dwSize, DWORD dwFreeType);
+        void HeapAlloc_Hook(void* returnAddress, LPVOID block);
+        void HeapFree_Hook(void* returnAddress, LPVOID block);
+        static thread_local bool InHeapHook; // the hooks allocate, the server's allocations don't come back in
+
+        // Function signatures
+        typedef LPVOID(WINAPI* VirtualAlloc_t)(LPVOID, SIZE_T, DWORD, DWORD);
+        typedef BOOL(WINAPI* VirtualFree_t)(LPVOID, SIZE_T, DWORD);
+        typedef LPVOID(WINAPI* HeapAlloc_t)(HANDLE, DWORD, SIZE_T);
+        typedef BOOL(WINAPI* HeapFree_t)(HANDLE, DWORD, LPVOID);
+        typedef LPVOID(WINAPI* HeapReAlloc_t)(HANDLE, DWORD, LPVOID, SIZE_T);
+
+        // Static hooks (entry points)
+        static LPVOID WINAPI VirtualAlloc_StaticHook(LPVOID lpAddress, SIZE_T dwSize, DWORD flAllocationType, DWORD flProtect);
+        static BOOL WINAPI VirtualFree_StaticHook(LPVOID lpAddress, SIZE_T dwSize, DWORD dwFreeType);
+        static LPVOID WINAPI HeapAlloc_StaticHook(HANDLE hHeap, DWORD dwFlags, SIZE_T dwBytes);
+        static BOOL WINAPI HeapFree_StaticHook(HANDLE hHeap, DWORD dwFlags, LPVOID lpMem);
+        static LPVOID WINAPI HeapReAlloc_StaticHook(HANDLE hHeap, DWORD dwFlags, LPVOID lpMem, SIZE_T dwBytes);
+
+        // Original functions
+        static VirtualAlloc_t VirtualAlloc_Base;
+        static VirtualFree_t VirtualFree_Base;
+        static HeapAlloc_t HeapAlloc_Base;
+        static HeapFree_t HeapFree_Base;
+        static HeapReAlloc_t HeapReAlloc_Base;
+    };
+}
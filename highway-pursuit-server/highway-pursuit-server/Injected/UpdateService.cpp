@@ -33,6 +33,14 @@ namespace Injected
         }
     }
 
+    bool UpdateService::WaitUpdate(uint32_t timeoutMs)
+    {
+        // The game thread waits for this in the update hook, and releases the server once the update is done
+        ReleaseSemaphore(_lockUpdatePool, 1, nullptr);
+        DWORD error = WaitForSingleObject(_lockServerPool, timeoutMs);
+        return error == WAIT_OBJECT_0;
+    }
+
     void UpdateService::NotifyShutdown()
     {
         _useSemaphores = false; // Stop waiting for the semaphore in the main game loop hooks
@@ -1,18 +1,20 @@
 #pragma once
-#include "../HookManager.hpp"
+#include "HookManager.hpp"
+#include "../Services/IUpdateService.hpp"
 
 namespace Injected
 {
-    class UpdateService
+    class UpdateService : public Services::IUpdateService
     {
     public:
         // Constructor
         UpdateService(std::shared_ptr<HookManager> hookManager, bool isRealTime, HANDLE lockServerPool, HANDLE lockUpdatePool, float FPS, LARGE_INTEGER performanceCounterFrequency);
         
         // Methods
-        void UpdateTime();
+        void UpdateTime() override;
+        bool WaitUpdate(uint32_t timeoutMs) override;
         void NotifyShutdown();
-        void EnableCustomTime();
+        void EnableCustomTime() override;
 
     private:
         static constexpr int SERVER_TIMEOUT = 300000; // To avoid waiting infinitely
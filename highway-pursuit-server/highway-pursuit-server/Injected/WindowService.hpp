@@ -1,6 +1,6 @@
 #pragma once
 #include "../Data/ServerTypes.hpp"
-#include "../HookManager.hpp"
+#include "HookManager.hpp"
 
 namespace Injected
 {
@@ -0,0 +1,83 @@
+#include "../pch.h"
+#include "MetricsBlock.hpp"
+
+namespace Metrics
+{
+    using namespace Data;
+
+    namespace
+    {
+        struct MetricDefinition
+        {
+            const char* name;
+            MetricType type;
+        };
+
+        // Indexed by Metric, every value takes 8 bytes
+        constexpr MetricDefinition DEFINITIONS[] = {
+            { "tps", MetricType::F64 },
+            { "memory", MetricType::F64 },
+            { "server_time", MetricType::F64 },
+            { "game_time", MetricType::F64 },
+            { "frames", MetricType::U64 },
+            { "steps", MetricType::U64 },
+            { "resets", MetricType::U64 },
+            { "episodes", MetricType::U64 },
+            { "video_frames", MetricType::U64 },
+            { "video_dropped", MetricType::U64 },
+        };
+        constexpr uint32_t VALUE_SIZE = 8;
+        static_assert(std::size(DEFINITIONS) == static_cast<size_t>(Metric::COUNT), "Every metric needs a definition");
+        static_assert(static_cast<uint32_t>(Metric::COUNT) <= MetricsSchema::MAX_METRICS, "The schema is full");
+
+        uint32_t Offset(Metric metric)
+        {
+            return static_cast<uint32_t>(metric) * VALUE_SIZE;
+        }
+    }
+
+    void Describe(MetricsSchema& schema)
+    {
+        schema.metricCount = static_cast<uint32_t>(Metric::COUNT);
+        schema.blockSize = BlockSize();
+        for (uint32_t index = 0; index < schema.metricCount; ++index)
+        {
+            MetricDescriptor& descriptor = schema.metrics[index];
+            std::snprintf(descriptor.name, MetricDescriptor::NAME_SIZE, "%s", DEFINITIONS[index].name);
+            descriptor.type = DEFINITIONS[index].type;
+            descriptor.offset = Offset(static_cast<Metric>(index));
+        }
+    }
+
+    uint32_t BlockSize()
+    {
+        // Room for the metrics of later versions, the blocks of the slots don't move when some are added
+        return MetricsSchema::MAX_METRICS * VALUE_SIZE;
+    }
+
+    MetricsWriter::MetricsWriter(void* block)
+        : _block(static_cast<uint8_t*>(block))
+    {
+    }
+
+    bool MetricsWriter::IsAttached() const
+    {
+        return _block != nullptr;
+    }
+
+    void MetricsWriter::Set(Metric metric, uint64_t value)
+    {
+        if (_block != nullptr)
+        {
+            std::memcpy(_block + Offset(metric), &value, sizeof(value));
+        }
+    }
+
+    void MetricsWriter::Set(Metric metric, double value)
+    {
+        if (_block != nullptr)
+        {
+            std::memcpy(_block + Offset(metric), &value, sizeof(value));
+        }
+    }
+}
@@ -0,0 +1,40 @@
+#pragma once
+#include "../Data/ServerTypes.hpp"
+
+namespace Metrics
+{
+    // Metrics of the metrics section, in schema order. New metrics are only appended, their offset never changes.
+    enum class Metric : uint32_t
+    {
+        TPS, // frames per second, updated periodically
+        MEMORY, // working set of the server process, in MB
+        SERVER_TIME, // in seconds, spent handling steps
+        GAME_TIME, // in seconds, spent in game updates
+        FRAMES,
+        STEPS,
+        RESETS,
+        EPISODES, // finished episodes, see the episode stats
+        VIDEO_FRAMES, // written by the video recorder
+        VIDEO_DROPPED, // dropped by the video recorder while its queue was full
+        COUNT
+    };
+
+    // Fills the schema advertised in the extended info
+    void Describe(Data::MetricsSchema& schema);
+    // Bytes of the block of a slot
+    uint32_t BlockSize();
+
+    // Writes the values of a slot's block, does nothing when the client didn't create the section
+    class MetricsWriter
+    {
+    public:
+        explicit MetricsWriter(void* block = nullptr);
+
+        bool IsAttached() const;
+        void Set(Metric metric, uint64_t value);
+        void Set(Metric metric, double value);
+
+    private:
+        uint8_t* _block;
+    };
+}
@@ -0,0 +1,90 @@
+#include "../pch.h"
+#include "ObservationKernels.hpp"
+
+namespace Observation
+{
+    void CopyFrame(void* destination, const void* source, const Data::BufferFormat& format)
+    {
+        std::memcpy(destination, source, format.Size());
+    }
+
+    void ConvertBGRXToRGB(uint8_t* destination, const uint8_t* source, const Data::BufferFormat& format)
+    {
+        size_t pixelCount = static_cast<size_t>(format.width) * format.height;
+        for (size_t i = 0; i < pixelCount; ++i)
+        {
+            const uint8_t* pixel = source + 4 * i;
+            uint8_t* out = destination + 3 * i;
+            out[0] = pixel[2];
+            out[1] = pixel[1];
+            out[2] = pixel[0];
+        }
+    }
+
+    void DownsampleRGB(uint8_t* destination, const uint8_t* source, const Data::BufferFormat& format)
+    {
+        constexpr uint32_t OUT_CHANNELS = 3;
+        uint32_t outWidth = DownsampledWidth(format.width);
+        for (uint32_t y = 0; y < format.height; ++y)
+        {
+            const uint8_t* row = source + static_cast<size_t>(y) * format.width * format.channels;
+            uint8_t* out = destination + static_cast<size_t>(y) * outWidth * OUT_CHANNELS;
+            for (uint32_t x = 0; x < outWidth; ++x)
+            {
+                for (uint32_t channel = 0; channel < OUT_CHANNELS; ++channel)
+                {
+                    uint32_t column = OUT_CHANNELS * x + channel;
+                    out[OUT_CHANNELS * x + channel] = column < format.width ? row[static_cast<size_t>(column) * format.channels + channel] : 0;
+                }
+            }
+        }
+    }
+
+    uint32_t DownsampledWidth(uint32_t width)
+    {
+        return (width + 2) / 3;
+    }
+
+    void ConvertToGrayscale(uint8_t* destination, const uint8_t* source, const Data::BufferFormat& format)
+    {
+        // BT.601 weights in 8 bits fixed point, they sum to 256
+        size_t pixelCount = static_cast<size_t>(format.width) * format.height;
+        for (size_t i = 0; i < pixelCount; ++i)
+        {
+            const uint8_t* pixel = source + format.channels * i;
+            destination[i] = static_cast<uint8_t>((29u * pixel[0] + 150u * pixel[1] + 77u * pixel[2] + 128u) >> 8);
+        }
+    }
+
+    uint64_t Checksum(const void* data, size_t size)
+    {
+        // FNV-1a on 64 bits words, four independent lanes so the multiplications don't wait on each other
+        constexpr uint64_t OFFSET_BASIS = 14695981039346656037ull;
+        constexpr uint64_t PRIME = 1099511628211ull;
+        constexpr size_t LANES = 4;
+
+        const uint8_t* bytes = static_cast<const uint8_t*>(data);
+        uint64_t lanes[LANES] = { OFFSET_BASIS, OFFSET_BASIS ^ 1, OFFSET_BASIS ^ 2, OFFSET_BASIS ^ 3 };
+        size_t offset = 0;
+        for (; offset + LANES * sizeof(uint64_t) <= size; offset += LANES * sizeof(uint64_t))
+        {
+            for (size_t lane = 0; lane < LANES; ++lane)
+            {
+                uint64_t word;
+                std::memcpy(&word, bytes + offset + lane * sizeof(uint64_t), sizeof(word));
+                lanes[lane] = (lanes[lane] ^ word) * PRIME;
+            }
+        }
+
+        uint64_t hash = OFFSET_BASIS;
+        for (uint64_t lane : lanes)
+        {
+            hash = (hash ^ lane) * PRIME;
+        }
+        for (; offset < size; ++offset)
+        {
+            hash = (hash ^ bytes[offset]) * PRIME;
+        }
+        return (hash ^ size) * PRIME;
+    }
+}
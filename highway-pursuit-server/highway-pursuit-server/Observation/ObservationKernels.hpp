@@ -0,0 +1,22 @@
+#pragma once
+#include "../Data/ServerTypes.hpp"
+
+namespace Observation
+{
+    // Copies a tightly packed frame
+    void CopyFrame(void* destination, const void* source, const Data::BufferFormat& format);
+
+    // Drops the X channel of a BGRX frame and swaps it to RGB (what the python env returns when rendering)
+    void ConvertBGRXToRGB(uint8_t* destination, const uint8_t* source, const Data::BufferFormat& format);
+
+    // Keeps a third of the columns of a BGR(X) frame: channel c of column x comes from column 3x + c (RGBDownsampleWrapper).
+    // The destination has 3 channels and DownsampledWidth columns, the missing columns of the last ones are 0.
+    void DownsampleRGB(uint8_t* destination, const uint8_t* source, const Data::BufferFormat& format);
+    uint32_t DownsampledWidth(uint32_t width);
+
+    // One luma byte per pixel of a BGR(X) frame
+    void ConvertToGrayscale(uint8_t* destination, const uint8_t* source, const Data::BufferFormat& format);
+
+    // Fast non-cryptographic hash of a frame, only meant to detect that two frames differ (action log replays)
+    uint64_t Checksum(const void* data, size_t size);
+}
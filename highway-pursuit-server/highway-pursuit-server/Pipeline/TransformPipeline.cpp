@@ -0,0 +1,130 @@
+#include "../pch.h"
+#include "TransformPipeline.hpp"
+#include "../Observation/ObservationKernels.hpp"
+
+namespace Pipeline
+{
+    using namespace Data;
+
+    TransformPipeline::TransformPipeline(const PipelineConfig& config, uint32_t inputCount, uint32_t maxEpisodeSteps)
+        : _config(config),
+        _maxEpisodeSteps(maxEpisodeSteps),
+        _allowedMask(0),
+        _stepsWithoutReward(0),
+        _livesLeft(0),
+        _episodeSteps(0)
+    {
+        Validate(config, inputCount);
+        _allowedMask = (1u << (inputCount - config.removedActions)) - 1;
+    }
+
+    ServerInfo TransformPipeline::Describe(const PipelineConfig& config, const ServerInfo& gameInfo)
+    {
+        Validate(config, gameInfo.actionCount);
+        BufferFormat format = ObservationFormat(config.observationTransform, BufferFormat(gameInfo.obsWidth, gameInfo.obsHeight, gameInfo.obsChannels));
+
+        // Discrete actions add the noop
+        uint32_t actionCount = gameInfo.actionCount - config.removedActions;
+        if (config.actionTransform == ActionTransform::DISCRETE)
+        {
+            actionCount++;
+        }
+        return ServerInfo(format.height, format.width, format.channels, actionCount);
+    }
+
+    BufferFormat TransformPipeline::ObservationFormat(ObservationTransform transform, const BufferFormat& frameFormat)
+    {
+        switch (transform)
+        {
+        case ObservationTransform::RGB_DOWNSAMPLE:
+            return BufferFormat(Observation::DownsampledWidth(frameFormat.width), frameFormat.height, 3);
+        case ObservationTransform::GRAYSCALE:
+            return BufferFormat(frameFormat.width, frameFormat.height, 1);
+        default:
+            return frameFormat;
+        }
+    }
+
+    void TransformPipeline::Validate(const PipelineConfig& config, uint32_t inputCount)
+    {
+        if (config.version > PipelineConfig::VERSION || config.actionTransform > ActionTransform::DISCRETE
+            || config.observationTransform > ObservationTransform::GRAYSCALE)
+        {
+            throw HighwayPursuitException(ErrorCode::UNSUPPORTED_INSTRUCTION);
+        }
+        if (config.removedActions >= inputCount || inputCount > HighwayPursuitConstants::ACTION_COUNT)
+        {
+            throw HighwayPursuitException(ErrorCode::UNKNOWN_ACTION);
+        }
+    }
+
+    InputSet TransformPipeline::MapActions(uint32_t action) const
+    {
+        if (_config.actionTransform == ActionTransform::DISCRETE)
+        {
+            if (action == 0)
+            {
+                return InputSet();
+            }
+            if (action > HighwayPursuitConstants::ACTION_COUNT)
+            {
+                throw HighwayPursuitException(ErrorCode::UNKNOWN_ACTION);
+            }
+            action = 1u << (action - 1);
+        }
+        // Removed inputs are unknown to the client, like the inputs past the action count
+        if ((action & ~_allowedMask) != 0)
+        {
+            throw HighwayPursuitException(ErrorCode::UNKNOWN_ACTION);
+        }
+        return InputSet::FromMask(action);
+    }
+
+    float TransformPipeline::MapReward(int reward) const
+    {
+        return _config.rewardScale != 0.0f ? reward * _config.rewardScale : static_cast<float>(reward);
+    }
+
+    Termination TransformPipeline::OnStep(int reward, const Termination& termination)
+    {
+        _stepsWithoutReward = reward != 0 ? 0 : _stepsWithoutReward + 1;
+        _episodeSteps++;
+        if ((_config.noRewardTimeout != 0 && _stepsWithoutReward > _config.noRewardTimeout)
+            || (_maxEpisodeSteps != 0 && _episodeSteps >= _maxEpisodeSteps))
+        {
+            return Termination(termination.terminated != 0, true);
+        }
+        return termination;
+    }
+
+    bool TransformPipeline::OnReset(bool startNewGame)
+    {
+        _stepsWithoutReward = 0;
+        _episodeSteps = 0;
+        if (_config.livesPerGame == 0)
+        {
+            return startNewGame;
+        }
+
+        // The reset starting a game uses its first life
+        if (startNewGame || _livesLeft == 0)
+        {
+            _livesLeft = _config.livesPerGame - 1;
+            return true;
+        }
+        _livesLeft--;
+        return false;
+    }
+
+    TransformPipeline::State TransformPipeline::Capture() const
+    {
+        return State{ _stepsWithoutReward, _livesLeft, _episodeSteps };
+    }
+
+    void TransformPipeline::Restore(const State& state)
+    {
+        _stepsWithoutReward = state.stepsWithoutReward;
+        _livesLeft = state.livesLeft;
+        _episodeSteps = state.episodeSteps;
+    }
+}
@@ -0,0 +1,49 @@
+#pragma once
+#include "../Data/ServerTypes.hpp"
+
+namespace Pipeline
+{
+    // Transforms of a PipelineConfig, applied to every step of an environment in place of the python wrappers:
+    // MultiBinaryToDiscrete and RemovePowerups (actions), TransformReward (reward scale), NoRewardTimeout (truncation),
+    // LivesPerGame (resets) and RGBDownsample (observations, written by the CommunicationManager).
+    // Each transform is enabled on its own by its field of the config, a default config leaves the steps unchanged.
+    class TransformPipeline
+    {
+    public:
+        // Saved with the snapshots, rollouts from a snapshot keep the timeouts and lives of the episode
+        struct State
+        {
+            uint32_t stepsWithoutReward;
+            uint32_t livesLeft;
+            uint32_t episodeSteps;
+        };
+
+        // maxEpisodeSteps caps the episodes on the server side, outside the config of the client (agent runs), 0 disables it
+        TransformPipeline(const Data::PipelineConfig& config, uint32_t inputCount, uint32_t maxEpisodeSteps = 0);
+
+        // Info the client gets for a game described by gameInfo
+        static Data::ServerInfo Describe(const Data::PipelineConfig& config, const Data::ServerInfo& gameInfo);
+        static Data::BufferFormat ObservationFormat(Data::ObservationTransform transform, const Data::BufferFormat& frameFormat);
+        // Throws UNSUPPORTED_INSTRUCTION for unknown transforms, UNKNOWN_ACTION if more inputs are removed than the game has
+        static void Validate(const Data::PipelineConfig& config, uint32_t inputCount);
+
+        // Inputs of the action written by the client (bitmask, or index with discrete actions)
+        Data::InputSet MapActions(uint32_t action) const;
+        float MapReward(int reward) const;
+        // Counts a step with its untransformed reward, truncates the episode once the no-reward timeout is exceeded or the step cap reached
+        Data::Termination OnStep(int reward, const Data::Termination& termination);
+        // Whether a reset starts a new game: requested ones, and every one once the lives of the game are spent
+        bool OnReset(bool startNewGame);
+
+        State Capture() const;
+        void Restore(const State& state);
+
+    private:
+        const Data::PipelineConfig _config;
+        const uint32_t _maxEpisodeSteps;
+        uint32_t _allowedMask; // inputs the client can take
+        uint32_t _stepsWithoutReward;
+        uint32_t _livesLeft;
+        uint32_t _episodeSteps;
+    };
+}
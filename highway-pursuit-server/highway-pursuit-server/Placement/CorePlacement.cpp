@@ -0,0 +1,30 @@
+#include "../pch.h"
+#include "CorePlacement.hpp"
+
+namespace Placement
+{
+    CorePlacement AutoPlacement(uint32_t instance, uint32_t instanceCount, const std::vector<std::vector<uint32_t>>& physicalCores)
+    {
+        if (physicalCores.empty() || instanceCount == 0)
+        {
+            return CorePlacement{ 0, 0, 0 };
+        }
+        if (instance >= instanceCount)
+        {
+            throw std::invalid_argument("Instance " + std::to_string(instance) + " out of " + std::to_string(instanceCount));
+        }
+
+        // Every other core for 2 instances on 4 cores, which also spreads them over the sockets and core complexes
+        size_t coreCount = physicalCores.size();
+        size_t core = instanceCount <= coreCount ? static_cast<size_t>(instance) * coreCount / instanceCount : instance % coreCount;
+        const std::vector<uint32_t>& siblings = physicalCores[core];
+        uint64_t gameCores = 1ull << siblings.front();
+        uint64_t serverCores = 1ull << (siblings.size() > 1 ? siblings[1] : siblings.front());
+        return CorePlacement{ gameCores, serverCores, serverCores };
+    }
+
+    CorePlacement AutoPlacement(uint32_t instance, uint32_t instanceCount)
+    {
+        return AutoPlacement(instance, instanceCount, Platform::GetPhysicalCores());
+    }
+}
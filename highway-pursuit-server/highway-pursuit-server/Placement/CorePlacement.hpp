@@ -0,0 +1,20 @@
+#pragma once
+#include "../Platform/Platform.hpp"
+
+namespace Placement
+{
+    // Logical processors the threads of one instance run on, bit i for processor i, 0 leaves the thread to the scheduler
+    struct CorePlacement
+    {
+        uint64_t gameCores;
+        uint64_t serverCores;
+        uint64_t clientCores;
+    };
+
+    // Gives each instance a physical core, spread evenly when there are fewer instances than cores and shared round-robin otherwise.
+    // The client, server and game threads of an instance take turns, on one core their handoffs stay in its caches:
+    // the game runs on the first SMT sibling, the server and its client on the second one when there is one.
+    CorePlacement AutoPlacement(uint32_t instance, uint32_t instanceCount, const std::vector<std::vector<uint32_t>>& physicalCores);
+    // With the cores of the current machine, nothing is pinned if they are unknown
+    CorePlacement AutoPlacement(uint32_t instance, uint32_t instanceCount);
+}
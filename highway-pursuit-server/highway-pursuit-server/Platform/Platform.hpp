@@ -0,0 +1,162 @@
+#pragma once
+#include "../pch.h"
+
+// OS primitives used by the server, implemented in Win32Platform.cpp and PosixPlatform.cpp
+namespace Platform
+{
+    // Semaphore shared between processes, identified by its name
+    class NamedSemaphore
+    {
+    public:
+        // The creator owns the name (unlinked on destruction where the OS requires it)
+        static std::unique_ptr<NamedSemaphore> Create(const std::string& name, uint32_t initialCount, uint32_t maxCount);
+        static std::unique_ptr<NamedSemaphore> Open(const std::string& name);
+        ~NamedSemaphore();
+
+        // Returns true if the semaphore was acquired before the timeout
+        bool Wait(uint32_t timeoutMs);
+        bool Release();
+
+    private:
+        NamedSemaphore(void* handle, const std::string& name, bool isOwner);
+        NamedSemaphore(const NamedSemaphore&) = delete;
+        NamedSemaphore& operator=(const NamedSemaphore&) = delete;
+
+        void* _handle;
+        const std::string _name;
+        const bool _isOwner;
+    };
+
+    // Named shared memory section mapped in the current process.
+    // With largePages, sections of at least a large page are backed by large pages where the OS allows it (normal pages otherwise).
+    class SharedMemory
+    {
+    public:
+        static std::unique_ptr<SharedMemory> Create(const std::string& name, size_t size, bool largePages = false);
+        static std::unique_ptr<SharedMemory> Open(const std::string& name, size_t size, bool largePages = false);
+        // Returns nullptr if no section has this name, for optional sections
+        static std::unique_ptr<SharedMemory> TryOpen(const std::string& name, size_t size, bool largePages = false);
+        ~SharedMemory();
+
+        void* Data() const;
+        size_t Size() const;
+        // Size of the pages backing the view
+        size_t PageSize() const;
+
+    private:
+        SharedMemory(void* handle, void* view, size_t size, size_t pageSize, const std::string& name, bool isOwner);
+        SharedMemory(const SharedMemory&) = delete;
+        SharedMemory& operator=(const SharedMemory&) = delete;
+
+        void* _handle;
+        void* _view;
+        const size_t _size;
+        const size_t _pageSize;
+        const std::string _name;
+        const bool _isOwner;
+    };
+
+    // Read-only view of a whole file
+    class MappedFile
+    {
+    public:
+        static std::unique_ptr<MappedFile> Open(const std::string& path);
+        ~MappedFile();
+
+        const uint8_t* Data() const;
+        size_t Size() const;
+
+    private:
+        MappedFile(void* handle, const void* view, size_t size);
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        void* _handle;
+        const void* _view;
+        const size_t _size;
+    };
+
+    // Shared library loaded in the current process, unloaded on destruction
+    class SharedLibrary
+    {
+    public:
+        static std::unique_ptr<SharedLibrary> Load(const std::string& path);
+        ~SharedLibrary();
+
+        // nullptr if the library doesn't export the symbol
+        void* Symbol(const std::string& name) const;
+
+    private:
+        SharedLibrary(void* handle);
+        SharedLibrary(const SharedLibrary&) = delete;
+        SharedLibrary& operator=(const SharedLibrary&) = delete;
+
+        void* _handle;
+    };
+
+    // Process started by the current one, left running when the object is destroyed
+    class ChildProcess
+    {
+    public:
+        // command[0] is the path of the executable, the others its arguments
+        static std::unique_ptr<ChildProcess> Spawn(const std::vector<std::string>& command);
+        ~ChildProcess();
+
+        // Doesn't block, returns true with the exit code once the process has exited
+        bool TryGetExitCode(int& exitCode);
+        // Kills the process and waits for it to exit
+        void Kill();
+
+    private:
+        ChildProcess(void* handle, int64_t id);
+        ChildProcess(const ChildProcess&) = delete;
+        ChildProcess& operator=(const ChildProcess&) = delete;
+
+        void* _handle;
+        const int64_t _id;
+        bool _exited;
+        int _exitCode;
+    };
+
+    uint32_t CurrentProcessId();
+    // Kills the process and waits at most KILL_TIMEOUT for it to exit.
+    // Returns false if the process couldn't be killed (exited, or not ours) or didn't exit in time
+    constexpr uint32_t KILL_TIMEOUT = 5000; // in ms
+    bool KillProcess(uint32_t processId);
+    bool IsProcessRunning(uint32_t processId);
+
+    // Logical processors grouped by physical core (SMT siblings together), limited to the first 64 processors the process may run on
+    std::vector<std::vector<uint32_t>> GetPhysicalCores();
+    // Bit i of the mask allows logical processor i, threads are identified by their OS id
+    bool SetThreadAffinity(uint32_t threadId, uint64_t mask);
+    bool SetCurrentThreadAffinity(uint64_t mask);
+    // 0 if unknown
+    uint64_t GetCurrentThreadAffinity();
+
+    // Resident memory of the current process, in bytes
+    size_t GetWorkingSetSize();
+
+    // Virtual memory pages, used by the snapshot engine
+    size_t GetPageSize();
+    // Large pages of the shared memory sections, 0 if the OS has none
+    size_t GetLargePageSize();
+    // Page aligned and zeroed, size is rounded up to whole pages
+    void* AllocatePages(size_t size);
+    void FreePages(void* address, size_t size);
+    // Changes the protection of the pages containing [address, address + size), read is always allowed
+    bool ProtectPages(void* address, size_t size, bool writable);
+    // Write watch of memory allocated with MEM_WRITE_WATCH (Windows only, it records the writes of system calls too): puts in pages
+    // at most count pages of [address, address + size) written since the last collect or reset, sets count to the number of pages
+    // and resets the watch. Both return false if the memory isn't watched, always on POSIX.
+    bool CollectWrittenPages(void* address, size_t size, void** pages, size_t& count);
+    bool ResetWrittenPages(void* address, size_t size);
+    // Puts the content of a file at offset (page aligned) in the committed pages [address, address + size) as a private copy-on-write view:
+    // POSIX maps the file in place so that the pages are only read on first access, Windows can't replace committed memory
+    // and copies them from a copy-on-write view. Returns false if the file can't be read.
+    bool MapFileCopyOnWrite(const std::string& path, uint64_t offset, void* address, size_t size);
+
+    // Called on write access violations with the faulting address, returns true if the fault was handled and the write can be retried.
+    // Only one handler per process, it has to be async-signal-safe on POSIX.
+    typedef bool (*WriteFaultHandler)(void* address);
+    void InstallWriteFaultHandler(WriteFaultHandler handler);
+}
@@ -0,0 +1,667 @@
+#include "../pch.h"
+#include "Platform.hpp"
+#include <cerrno>
+#include <cstdio>
+#include <dlfcn.h>
+#include <limits>
+#include <ctime>
+#include <fcntl.h>
+#include <sched.h>
+#include <semaphore.h>
+#include <signal.h>
+#include <spawn.h>
+#include <sys/syscall.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+extern char** environ;
+
+namespace Platform
+{
+    namespace
+    {
+        // POSIX names of shared objects have to start with a slash
+        std::string PosixName(const std::string& name)
+        {
+            return "/" + name;
+        }
+
+        // Transparent huge pages of the shared memory follow the madvise hint when the tmpfs holding the sections (/dev/shm) is mounted with huge=
+        // (advise, always or within_size), unless the system forces or denies them for every tmpfs (shmem_enabled, the current mode is bracketed)
+        bool SharedLargePagesEnabled()
+        {
+            static const bool enabled = []()
+                {
+                    std::ifstream shmemEnabled("/sys/kernel/mm/transparent_hugepage/shmem_enabled");
+                    std::string modes;
+                    std::getline(shmemEnabled, modes);
+                    if (modes.find("[deny]") != std::string::npos || modes.find("[force]") != std::string::npos)
+                    {
+                        return modes.find("[force]") != std::string::npos;
+                    }
+
+                    std::ifstream mounts("/proc/mounts");
+                    std::string device, mountPoint, type, options;
+                    bool mounted = false;
+                    while (mounts >> device >> mountPoint >> type >> options)
+                    {
+                        // The last mount of /dev/shm hides the others
+                        if (mountPoint == "/dev/shm")
+                        {
+                            mounted = options.find("huge=advise") != std::string::npos || options.find("huge=always") != std::string::npos
+                                || options.find("huge=within_size") != std::string::npos;
+                        }
+                        mounts.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+                    }
+                    return mounted;
+                }();
+            return enabled;
+        }
+
+        // Maps the section, on an address aligned on the large pages when they can back it (the kernel only maps aligned large pages whole).
+        // pageSize is set to the size of the pages the kernel backs the view with.
+        void* MapSection(int fd, size_t size, bool largePages, size_t& pageSize)
+        {
+            pageSize = GetPageSize();
+            size_t largePageSize = GetLargePageSize();
+            if (!largePages || largePageSize == 0 || size < largePageSize || !SharedLargePagesEnabled())
+            {
+                return mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+            }
+
+            // Reserves enough address space to align the view, then gives back what it doesn't use
+            size_t reservedSize = size + largePageSize;
+            void* reserved = mmap(nullptr, reservedSize, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+            if (reserved == MAP_FAILED)
+            {
+                return mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+            }
+            uintptr_t begin = reinterpret_cast<uintptr_t>(reserved);
+            uintptr_t aligned = (begin + largePageSize - 1) & ~(static_cast<uintptr_t>(largePageSize) - 1);
+            void* view = mmap(reinterpret_cast<void*>(aligned), size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0);
+            if (view == MAP_FAILED)
+            {
+                munmap(reserved, reservedSize);
+                return mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+            }
+            uintptr_t end = aligned + ((size + GetPageSize() - 1) & ~(GetPageSize() - 1));
+            if (aligned > begin)
+            {
+                munmap(reserved, aligned - begin);
+            }
+            if (begin + reservedSize > end)
+            {
+                munmap(reinterpret_cast<void*>(end), begin + reservedSize - end);
+            }
+
+#ifdef MADV_HUGEPAGE
+            if (madvise(view, size, MADV_HUGEPAGE) == 0)
+            {
+                pageSize = largePageSize;
+            }
+#endif
+            return view;
+        }
+
+        std::atomic<WriteFaultHandler> writeFaultHandler(nullptr);
+        struct sigaction previousSegvAction;
+
+        void OnSegmentationFault(int signal, siginfo_t* info, void* /*context*/)
+        {
+            WriteFaultHandler handler = writeFaultHandler.load();
+            if (handler != nullptr && handler(info->si_addr))
+            {
+                return;
+            }
+
+            // Not ours, let the previous handler (or the default action) deal with it
+            sigaction(SIGSEGV, &previousSegvAction, nullptr);
+            raise(signal);
+        }
+    }
+
+    NamedSemaphore::NamedSemaphore(void* handle, const std::string& name, bool isOwner)
+        : _handle(handle), _name(name), _isOwner(isOwner)
+    {
+    }
+
+    // The maximum count isn't enforced by POSIX semaphores, the protocol never releases twice
+    std::unique_ptr<NamedSemaphore> NamedSemaphore::Create(const std::string& name, uint32_t initialCount, uint32_t /*maxCount*/)
+    {
+        sem_t* semaphore = sem_open(PosixName(name).c_str(), O_CREAT | O_EXCL, 0600, initialCount);
+        if (semaphore == SEM_FAILED)
+        {
+            throw std::runtime_error("Couldn't create semaphore, error " + std::to_string(errno));
+        }
+        return std::unique_ptr<NamedSemaphore>(new NamedSemaphore(semaphore, name, true));
+    }
+
+    std::unique_ptr<NamedSemaphore> NamedSemaphore::Open(const std::string& name)
+    {
+        sem_t* semaphore = sem_open(PosixName(name).c_str(), 0);
+        if (semaphore == SEM_FAILED)
+        {
+            throw std::runtime_error("Couldn't get semaphore, error " + std::to_string(errno));
+        }
+        return std::unique_ptr<NamedSemaphore>(new NamedSemaphore(semaphore, name, false));
+    }
+
+    NamedSemaphore::~NamedSemaphore()
+    {
+        sem_close(static_cast<sem_t*>(_handle));
+        if (_isOwner)
+        {
+            sem_unlink(PosixName(_name).c_str());
+        }
+    }
+
+    bool NamedSemaphore::Wait(uint32_t timeoutMs)
+    {
+        timespec deadline;
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_sec += timeoutMs / 1000;
+        deadline.tv_nsec += static_cast<long>(timeoutMs % 1000) * 1000000L;
+        if (deadline.tv_nsec >= 1000000000L)
+        {
+            deadline.tv_sec += 1;
+            deadline.tv_nsec -= 1000000000L;
+        }
+
+        int res;
+        do
+        {
+            res = sem_timedwait(static_cast<sem_t*>(_handle), &deadline);
+        } while (res != 0 && errno == EINTR);
+        return res == 0;
+    }
+
+    bool NamedSemaphore::Release()
+    {
+        return sem_post(static_cast<sem_t*>(_handle)) == 0;
+    }
+
+    SharedMemory::SharedMemory(void* handle, void* view, size_t size, size_t pageSize, const std::string& name, bool isOwner)
+        : _handle(handle), _view(view), _size(size), _pageSize(pageSize), _name(name), _isOwner(isOwner)
+    {
+    }
+
+    std::unique_ptr<SharedMemory> SharedMemory::Create(const std::string& name, size_t size, bool largePages)
+    {
+        int fd = shm_open(PosixName(name).c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+        if (fd < 0)
+        {
+            throw std::runtime_error("Couldn't create shared memory, error " + std::to_string(errno));
+        }
+
+        if (ftruncate(fd, static_cast<off_t>(size)) != 0)
+        {
+            int error = errno;
+            close(fd);
+            shm_unlink(PosixName(name).c_str());
+            throw std::runtime_error("Couldn't size shared memory, error " + std::to_string(error));
+        }
+
+        size_t pageSize = 0;
+        void* view = MapSection(fd, size, largePages, pageSize);
+        close(fd);
+        if (view == MAP_FAILED)
+        {
+            shm_unlink(PosixName(name).c_str());
+            throw std::runtime_error("Couldn't map shared memory, error " + std::to_string(errno));
+        }
+
+        return std::unique_ptr<SharedMemory>(new SharedMemory(nullptr, view, size, pageSize, name, true));
+    }
+
+    std::unique_ptr<SharedMemory> SharedMemory::Open(const std::string& name, size_t size, bool largePages)
+    {
+        int fd = shm_open(PosixName(name).c_str(), O_RDWR, 0600);
+        if (fd < 0)
+        {
+            throw std::runtime_error("Couldn't open shared memory, error " + std::to_string(errno));
+        }
+
+        size_t pageSize = 0;
+        void* view = MapSection(fd, size, largePages, pageSize);
+        close(fd);
+        if (view == MAP_FAILED)
+        {
+            throw std::runtime_error("Couldn't map shared memory, error " + std::to_string(errno));
+        }
+
+        return std::unique_ptr<SharedMemory>(new SharedMemory(nullptr, view, size, pageSize, name, false));
+    }
+
+    std::unique_ptr<SharedMemory> SharedMemory::TryOpen(const std::string& name, size_t size, bool largePages)
+    {
+        int fd = shm_open(PosixName(name).c_str(), O_RDWR, 0600);
+        if (fd < 0 && errno == ENOENT)
+        {
+            return nullptr;
+        }
+        if (fd >= 0)
+        {
+            close(fd);
+        }
+        return Open(name, size, largePages);
+    }
+
+    SharedMemory::~SharedMemory()
+    {
+        munmap(_view, _size);
+        if (_isOwner)
+        {
+            shm_unlink(PosixName(_name).c_str());
+        }
+    }
+
+    void* SharedMemory::Data() const
+    {
+        return _view;
+    }
+
+    size_t SharedMemory::Size() const
+    {
+        return _size;
+    }
+
+    size_t SharedMemory::PageSize() const
+    {
+        return _pageSize;
+    }
+
+    MappedFile::MappedFile(void* handle, const void* view, size_t size)
+        : _handle(handle), _view(view), _size(size)
+    {
+    }
+
+    std::unique_ptr<MappedFile> MappedFile::Open(const std::string& path)
+    {
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+        {
+            throw std::runtime_error("Couldn't open " + path + ", error " + std::to_string(errno));
+        }
+
+        struct stat status;
+        if (fstat(fd, &status) != 0)
+        {
+            int error = errno;
+            close(fd);
+            throw std::runtime_error("Couldn't get the size of " + path + ", error " + std::to_string(error));
+        }
+
+        // Empty files can't be mapped
+        size_t size = static_cast<size_t>(status.st_size);
+        const void* view = nullptr;
+        if (size > 0)
+        {
+            view = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+        }
+        close(fd);
+        if (view == MAP_FAILED)
+        {
+            throw std::runtime_error("Couldn't map " + path + ", error " + std::to_string(errno));
+        }
+
+        return std::unique_ptr<MappedFile>(new MappedFile(nullptr, view, size));
+    }
+
+    MappedFile::~MappedFile()
+    {
+        if (_view != nullptr)
+        {
+            munmap(const_cast<void*>(_view), _size);
+        }
+    }
+
+    const uint8_t* MappedFile::Data() const
+    {
+        return static_cast<const uint8_t*>(_view);
+    }
+
+    size_t MappedFile::Size() const
+    {
+        return _size;
+    }
+
+    SharedLibrary::SharedLibrary(void* handle)
+        : _handle(handle)
+    {
+    }
+
+    std::unique_ptr<SharedLibrary> SharedLibrary::Load(const std::string& path)
+    {
+        void* handle = dlopen(path.c_str(), RTLD_NOW | RTLD_LOCAL);
+        if (handle == nullptr)
+        {
+            const char* error = dlerror();
+            throw std::runtime_error("Couldn't load " + path + ": " + (error != nullptr ? error : "unknown error"));
+        }
+        return std::unique_ptr<SharedLibrary>(new SharedLibrary(handle));
+    }
+
+    SharedLibrary::~SharedLibrary()
+    {
+        dlclose(_handle);
+    }
+
+    void* SharedLibrary::Symbol(const std::string& name) const
+    {
+        return dlsym(_handle, name.c_str());
+    }
+
+    ChildProcess::ChildProcess(void* handle, int64_t id)
+        : _handle(handle), _id(id), _exited(false), _exitCode(0)
+    {
+    }
+
+    std::unique_ptr<ChildProcess> ChildProcess::Spawn(const std::vector<std::string>& command)
+    {
+        if (command.empty())
+        {
+            throw std::runtime_error("Can't spawn an empty command");
+        }
+
+        std::vector<char*> argv;
+        for (const std::string& arg : command)
+        {
+            argv.push_back(const_cast<char*>(arg.c_str()));
+        }
+        argv.push_back(nullptr);
+
+        pid_t pid;
+        int error = posix_spawn(&pid, argv[0], nullptr, nullptr, argv.data(), environ);
+        if (error != 0)
+        {
+            throw std::runtime_error("Couldn't spawn " + command[0] + ", error " + std::to_string(error));
+        }
+        return std::unique_ptr<ChildProcess>(new ChildProcess(nullptr, pid));
+    }
+
+    ChildProcess::~ChildProcess()
+    {
+        // Exited children that were never waited for are reaped by the init process once we exit
+    }
+
+    bool ChildProcess::TryGetExitCode(int& exitCode)
+    {
+        if (!_exited)
+        {
+            int status;
+            pid_t res = waitpid(static_cast<pid_t>(_id), &status, WNOHANG);
+            if (res == static_cast<pid_t>(_id))
+            {
+                _exited = true;
+                _exitCode = WIFEXITED(status) ? WEXITSTATUS(status) : 128 + WTERMSIG(status);
+            }
+            else if (res < 0)
+            {
+                // Already reaped
+                _exited = true;
+                _exitCode = -1;
+            }
+        }
+        exitCode = _exitCode;
+        return _exited;
+    }
+
+    void ChildProcess::Kill()
+    {
+        if (_exited)
+        {
+            return;
+        }
+
+        kill(static_cast<pid_t>(_id), SIGKILL);
+        int status;
+        pid_t res;
+        do
+        {
+            res = waitpid(static_cast<pid_t>(_id), &status, 0);
+        } while (res < 0 && errno == EINTR);
+        _exited = true;
+        _exitCode = 128 + SIGKILL;
+    }
+
+    uint32_t CurrentProcessId()
+    {
+        return static_cast<uint32_t>(getpid());
+    }
+
+    bool KillProcess(uint32_t processId)
+    {
+        if (kill(static_cast<pid_t>(processId), SIGKILL) != 0)
+        {
+            return false;
+        }
+        // The signal is delivered asynchronously, the process is gone once it's a zombie
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(KILL_TIMEOUT);
+        while (IsProcessRunning(processId))
+        {
+            if (std::chrono::steady_clock::now() > deadline)
+            {
+                return false;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        return true;
+    }
+
+    bool IsProcessRunning(uint32_t processId)
+    {
+        // Zombies count as exited, children are reaped by ChildProcess
+        if (kill(static_cast<pid_t>(processId), 0) != 0 && errno != EPERM)
+        {
+            return false;
+        }
+        std::ifstream stat("/proc/" + std::to_string(processId) + "/stat");
+        std::string line;
+        if (!std::getline(stat, line))
+        {
+            return true;
+        }
+        size_t nameEnd = line.rfind(')');
+        return nameEnd == std::string::npos || nameEnd + 2 >= line.size() || line[nameEnd + 2] != 'Z';
+    }
+
+    std::vector<std::vector<uint32_t>> GetPhysicalCores()
+    {
+        cpu_set_t allowed;
+        CPU_ZERO(&allowed);
+        if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0)
+        {
+            return {};
+        }
+
+        // Siblings are listed by the kernel (e.g. "0,64" or "0-1"), processors without topology are cores of their own
+        std::vector<std::vector<uint32_t>> cores;
+        std::vector<bool> assigned(64, false);
+        for (uint32_t processor = 0; processor < 64; ++processor)
+        {
+            if (!CPU_ISSET(processor, &allowed) || assigned[processor])
+            {
+                continue;
+            }
+
+            std::vector<uint32_t> siblings;
+            std::ifstream file("/sys/devices/system/cpu/cpu" + std::to_string(processor) + "/topology/thread_siblings_list");
+            std::string range;
+            while (std::getline(file, range, ','))
+            {
+                size_t dash = range.find('-');
+                uint32_t first = static_cast<uint32_t>(std::stoul(range.substr(0, dash)));
+                uint32_t last = dash == std::string::npos ? first : static_cast<uint32_t>(std::stoul(range.substr(dash + 1)));
+                for (uint32_t sibling = first; sibling <= last && sibling < 64; ++sibling)
+                {
+                    if (CPU_ISSET(sibling, &allowed) && !assigned[sibling])
+                    {
+                        siblings.push_back(sibling);
+                        assigned[sibling] = true;
+                    }
+                }
+            }
+            if (!assigned[processor])
+            {
+                siblings.insert(siblings.begin(), processor);
+                assigned[processor] = true;
+            }
+            cores.push_back(siblings);
+        }
+        return cores;
+    }
+
+    bool SetThreadAffinity(uint32_t threadId, uint64_t mask)
+    {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        for (uint32_t processor = 0; processor < 64; ++processor)
+        {
+            if (mask & (1ull << processor))
+            {
+                CPU_SET(processor, &set);
+            }
+        }
+        return sched_setaffinity(static_cast<pid_t>(threadId), sizeof(set), &set) == 0;
+    }
+
+    bool SetCurrentThreadAffinity(uint64_t mask)
+    {
+        return SetThreadAffinity(static_cast<uint32_t>(syscall(SYS_gettid)), mask);
+    }
+
+    uint64_t GetCurrentThreadAffinity()
+    {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        if (sched_getaffinity(0, sizeof(set), &set) != 0)
+        {
+            return 0;
+        }
+
+        uint64_t mask = 0;
+        for (uint32_t processor = 0; processor < 64; ++processor)
+        {
+            if (CPU_ISSET(processor, &set))
+            {
+                mask |= 1ull << processor;
+            }
+        }
+        return mask;
+    }
+
+    size_t GetWorkingSetSize()
+    {
+        // Second field of statm is the resident set, in pages. Read without streams, this runs during steps
+        int fd = open("/proc/self/statm", O_RDONLY);
+        if (fd < 0)
+        {
+            return 0;
+        }
+
+        char content[128];
+        ssize_t length = read(fd, content, sizeof(content) - 1);
+        close(fd);
+        if (length <= 0)
+        {
+            return 0;
+        }
+        content[length] = '\0';
+
+        unsigned long totalPages = 0;
+        unsigned long residentPages = 0;
+        if (std::sscanf(content, "%lu %lu", &totalPages, &residentPages) != 2)
+        {
+            return 0;
+        }
+        return static_cast<size_t>(residentPages) * static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    }
+
+    size_t GetPageSize()
+    {
+        static const size_t pageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+        return pageSize;
+    }
+
+    size_t GetLargePageSize()
+    {
+        // Size of the transparent huge pages, the file only exists on linux kernels that have them
+        static const size_t largePageSize = []()
+            {
+                std::ifstream file("/sys/kernel/mm/transparent_hugepage/hpage_pmd_size");
+                size_t size = 0;
+                return (file >> size) ? size : size_t(0);
+            }();
+        return largePageSize;
+    }
+
+    void* AllocatePages(size_t size)
+    {
+        void* address = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (address == MAP_FAILED)
+        {
+            throw std::runtime_error("Couldn't allocate pages, error " + std::to_string(errno));
+        }
+        return address;
+    }
+
+    void FreePages(void* address, size_t size)
+    {
+        munmap(address, size);
+    }
+
+    bool ProtectPages(void* address, size_t size, bool writable)
+    {
+        size_t pageSize = GetPageSize();
+        uintptr_t begin = reinterpret_cast<uintptr_t>(address) & ~(pageSize - 1);
+        uintptr_t end = reinterpret_cast<uintptr_t>(address) + size;
+        int protection = writable ? (PROT_READ | PROT_WRITE) : PROT_READ;
+        return mprotect(reinterpret_cast<void*>(begin), end - begin, protection) == 0;
+    }
+
+    // No write watch on POSIX, the snapshot regions are write-protected or compared instead
+    bool CollectWrittenPages(void* /*address*/, size_t /*size*/, void** /*pages*/, size_t& count)
+    {
+        count = 0;
+        return false;
+    }
+
+    bool ResetWrittenPages(void* /*address*/, size_t /*size*/)
+    {
+        return false;
+    }
+
+    bool MapFileCopyOnWrite(const std::string& path, uint64_t offset, void* address, size_t size)
+    {
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd == -1)
+        {
+            return false;
+        }
+        // MAP_FIXED replaces the pages atomically, the mapping holds its own reference to the file
+        void* view = mmap(address, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_FIXED, fd, static_cast<off_t>(offset));
+        close(fd);
+        return view == address;
+    }
+
+    void InstallWriteFaultHandler(WriteFaultHandler handler)
+    {
+        // Writes to protected pages raise SIGSEGV, reads are always allowed so any fault on a tracked page is a write
+        if (writeFaultHandler.exchange(handler) != nullptr)
+        {
+            return;
+        }
+
+        struct sigaction action;
+        std::memset(&action, 0, sizeof(action));
+        action.sa_sigaction = &OnSegmentationFault;
+        action.sa_flags = SA_SIGINFO | SA_NODEFER;
+        sigemptyset(&action.sa_mask);
+        if (sigaction(SIGSEGV, &action, &previousSegvAction) != 0)
+        {
+            throw std::runtime_error("Couldn't install the SIGSEGV handler, error " + std::to_string(errno));
+        }
+    }
+}
@@ -0,0 +1,546 @@
+#include "../pch.h"
+#include "Platform.hpp"
+#include "../framework.h"
+#include <processthreadsapi.h>
+#include <psapi.h>
+
+namespace Platform
+{
+    namespace
+    {
+        std::atomic<WriteFaultHandler> writeFaultHandler(nullptr);
+
+        LONG CALLBACK OnAccessViolation(PEXCEPTION_POINTERS exceptionInfo)
+        {
+            // ExceptionInformation[0] is 1 for writes, [1] is the address
+            const EXCEPTION_RECORD* record = exceptionInfo->ExceptionRecord;
+            WriteFaultHandler handler = writeFaultHandler.load();
+            if (handler != nullptr && record->ExceptionCode == EXCEPTION_ACCESS_VIOLATION && record->NumberParameters >= 2
+                && record->ExceptionInformation[0] == 1 && handler(reinterpret_cast<void*>(record->ExceptionInformation[1])))
+            {
+                return EXCEPTION_CONTINUE_EXECUTION;
+            }
+            return EXCEPTION_CONTINUE_SEARCH;
+        }
+    }
+
+    NamedSemaphore::NamedSemaphore(void* handle, const std::string& name, bool isOwner)
+        : _handle(handle), _name(name), _isOwner(isOwner)
+    {
+    }
+
+    std::unique_ptr<NamedSemaphore> NamedSemaphore::Create(const std::string& name, uint32_t initialCount, uint32_t maxCount)
+    {
+        HANDLE handle = CreateSemaphoreA(nullptr, initialCount, maxCount, name.c_str());
+        if (handle == nullptr)
+        {
+            throw std::runtime_error("Couldn't create semaphore, error " + std::to_string(GetLastError()));
+        }
+        return std::unique_ptr<NamedSemaphore>(new NamedSemaphore(handle, name, true));
+    }
+
+    std::unique_ptr<NamedSemaphore> NamedSemaphore::Open(const std::string& name)
+    {
+        HANDLE handle = OpenSemaphoreA(SYNCHRONIZE | SEMAPHORE_MODIFY_STATE, false, name.c_str());
+        if (handle == nullptr)
+        {
+            throw std::runtime_error("Couldn't get semaphore, error " + std::to_string(GetLastError()));
+        }
+        return std::unique_ptr<NamedSemaphore>(new NamedSemaphore(handle, name, false));
+    }
+
+    NamedSemaphore::~NamedSemaphore()
+    {
+        CloseHandle(_handle);
+    }
+
+    bool NamedSemaphore::Wait(uint32_t timeoutMs)
+    {
+        return WaitForSingleObject(_handle, timeoutMs) == WAIT_OBJECT_0;
+    }
+
+    bool NamedSemaphore::Release()
+    {
+        return ReleaseSemaphore(_handle, 1, nullptr);
+    }
+
+    SharedMemory::SharedMemory(void* handle, void* view, size_t size, size_t pageSize, const std::string& name, bool isOwner)
+        : _handle(handle), _view(view), _size(size), _pageSize(pageSize), _name(name), _isOwner(isOwner)
+    {
+    }
+
+    std::unique_ptr<SharedMemory> SharedMemory::Create(const std::string& name, size_t size, bool largePages)
+    {
+        // Large page sections need the lock pages privilege and a size in whole large pages, normal pages without it
+        size_t largePageSize = GetLargePageSize();
+        if (largePages && largePageSize != 0 && size >= largePageSize)
+        {
+            size_t largeSize = (size + largePageSize - 1) / largePageSize * largePageSize;
+            HANDLE hLargeMapFile = CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE | SEC_COMMIT | SEC_LARGE_PAGES,
+                static_cast<DWORD>(static_cast<uint64_t>(largeSize) >> 32), static_cast<DWORD>(largeSize), name.c_str());
+            if (hLargeMapFile != nullptr)
+            {
+                LPVOID pLargeBuf = MapViewOfFile(hLargeMapFile, FILE_MAP_ALL_ACCESS | FILE_MAP_LARGE_PAGES, 0, 0, largeSize);
+                if (pLargeBuf != nullptr)
+                {
+                    return std::unique_ptr<SharedMemory>(new SharedMemory(hLargeMapFile, pLargeBuf, size, largePageSize, name, true));
+                }
+                CloseHandle(hLargeMapFile);
+            }
+        }
+
+        HANDLE hMapFile = CreateFileMappingA(
+            INVALID_HANDLE_VALUE, // Backed by the paging file
+            nullptr,
+            PAGE_READWRITE,
+            static_cast<DWORD>(static_cast<uint64_t>(size) >> 32),
+            static_cast<DWORD>(size),
+            name.c_str()
+        );
+
+        if (hMapFile == nullptr)
+        {
+            throw std::runtime_error("Couldn't create FileMapping, error " + std::to_string(GetLastError()));
+        }
+
+        LPVOID pBuf = MapViewOfFile(hMapFile, FILE_MAP_ALL_ACCESS, 0, 0, size);
+        if (pBuf == nullptr)
+        {
+            DWORD error = GetLastError();
+            CloseHandle(hMapFile);
+            throw std::runtime_error("Couldn't get MapView, error " + std::to_string(error));
+        }
+
+        return std::unique_ptr<SharedMemory>(new SharedMemory(hMapFile, pBuf, size, GetPageSize(), name, true));
+    }
+
+    std::unique_ptr<SharedMemory> SharedMemory::Open(const std::string& name, size_t size, bool largePages)
+    {
+        // The creator of the section chose its pages, views can't ask for others (reported as normal pages)
+        (void)largePages;
+        HANDLE hMapFile = OpenFileMappingA(
+            FILE_MAP_ALL_ACCESS, // Request read/write access
+            FALSE,               // Do not inherit the handle
+            name.c_str() // Name of the shared memory
+        );
+
+        if (hMapFile == nullptr)
+        {
+            throw std::runtime_error("Couldn't open FileMapping, error " + std::to_string(GetLastError()));
+        }
+
+        LPVOID pBuf = MapViewOfFile(
+            hMapFile,            // Handle to the map object
+            FILE_MAP_ALL_ACCESS, // Read/write access
+            0,
+            0,
+            size                 // Size of the mapping
+        );
+
+        if (pBuf == nullptr)
+        {
+            DWORD error = GetLastError();
+            CloseHandle(hMapFile);
+            throw std::runtime_error("Couldn't get MapView, error " + std::to_string(error));
+        }
+
+        return std::unique_ptr<SharedMemory>(new SharedMemory(hMapFile, pBuf, size, GetPageSize(), name, false));
+    }
+
+    std::unique_ptr<SharedMemory> SharedMemory::TryOpen(const std::string& name, size_t size, bool largePages)
+    {
+        HANDLE hMapFile = OpenFileMappingA(FILE_MAP_ALL_ACCESS, FALSE, name.c_str());
+        if (hMapFile == nullptr && GetLastError() == ERROR_FILE_NOT_FOUND)
+        {
+            return nullptr;
+        }
+        if (hMapFile != nullptr)
+        {
+            CloseHandle(hMapFile);
+        }
+        return Open(name, size, largePages);
+    }
+
+    SharedMemory::~SharedMemory()
+    {
+        UnmapViewOfFile(_view);
+        CloseHandle(_handle);
+    }
+
+    void* SharedMemory::Data() const
+    {
+        return _view;
+    }
+
+    size_t SharedMemory::Size() const
+    {
+        return _size;
+    }
+
+    size_t SharedMemory::PageSize() const
+    {
+        return _pageSize;
+    }
+
+    MappedFile::MappedFile(void* handle, const void* view, size_t size)
+        : _handle(handle), _view(view), _size(size)
+    {
+    }
+
+    std::unique_ptr<MappedFile> MappedFile::Open(const std::string& path)
+    {
+        // Other processes can keep appending to the file
+        HANDLE hFile = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (hFile == INVALID_HANDLE_VALUE)
+        {
+            throw std::runtime_error("Couldn't open " + path + ", error " + std::to_string(GetLastError()));
+        }
+
+        LARGE_INTEGER fileSize;
+        if (!GetFileSizeEx(hFile, &fileSize))
+        {
+            DWORD error = GetLastError();
+            CloseHandle(hFile);
+            throw std::runtime_error("Couldn't get the size of " + path + ", error " + std::to_string(error));
+        }
+
+        // Empty files can't be mapped
+        size_t size = static_cast<size_t>(fileSize.QuadPart);
+        if (size == 0)
+        {
+            CloseHandle(hFile);
+            return std::unique_ptr<MappedFile>(new MappedFile(nullptr, nullptr, 0));
+        }
+
+        HANDLE hMapFile = CreateFileMappingA(hFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        CloseHandle(hFile);
+        if (hMapFile == nullptr)
+        {
+            throw std::runtime_error("Couldn't create FileMapping for " + path + ", error " + std::to_string(GetLastError()));
+        }
+
+        LPVOID pBuf = MapViewOfFile(hMapFile, FILE_MAP_READ, 0, 0, size);
+        if (pBuf == nullptr)
+        {
+            DWORD error = GetLastError();
+            CloseHandle(hMapFile);
+            throw std::runtime_error("Couldn't get MapView for " + path + ", error " + std::to_string(error));
+        }
+
+        return std::unique_ptr<MappedFile>(new MappedFile(hMapFile, pBuf, size));
+    }
+
+    MappedFile::~MappedFile()
+    {
+        if (_view != nullptr)
+        {
+            UnmapViewOfFile(_view);
+            CloseHandle(_handle);
+        }
+    }
+
+    const uint8_t* MappedFile::Data() const
+    {
+        return static_cast<const uint8_t*>(_view);
+    }
+
+    size_t MappedFile::Size() const
+    {
+        return _size;
+    }
+
+    SharedLibrary::SharedLibrary(void* handle)
+        : _handle(handle)
+    {
+    }
+
+    std::unique_ptr<SharedLibrary> SharedLibrary::Load(const std::string& path)
+    {
+        HMODULE module = LoadLibraryA(path.c_str());
+        if (module == nullptr)
+        {
+            throw std::runtime_error("Couldn't load " + path + ", error " + std::to_string(GetLastError()));
+        }
+        return std::unique_ptr<SharedLibrary>(new SharedLibrary(module));
+    }
+
+    SharedLibrary::~SharedLibrary()
+    {
+        FreeLibrary(static_cast<HMODULE>(_handle));
+    }
+
+    void* SharedLibrary::Symbol(const std::string& name) const
+    {
+        return reinterpret_cast<void*>(GetProcAddress(static_cast<HMODULE>(_handle), name.c_str()));
+    }
+
+    ChildProcess::ChildProcess(void* handle, int64_t id)
+        : _handle(handle), _id(id), _exited(false), _exitCode(0)
+    {
+    }
+
+    std::unique_ptr<ChildProcess> ChildProcess::Spawn(const std::vector<std::string>& command)
+    {
+        if (command.empty())
+        {
+            throw std::runtime_error("Can't spawn an empty command");
+        }
+
+        // Every argument is quoted, paths can contain spaces
+        std::string commandLine;
+        for (const std::string& arg : command)
+        {
+            commandLine += (commandLine.empty() ? "\"" : " \"") + arg + "\"";
+        }
+        std::vector<char> commandLineBuffer(commandLine.begin(), commandLine.end());
+        commandLineBuffer.push_back('\0');
+
+        STARTUPINFOA startupInfo;
+        ZeroMemory(&startupInfo, sizeof(startupInfo));
+        startupInfo.cb = sizeof(startupInfo);
+        PROCESS_INFORMATION processInfo;
+        if (!CreateProcessA(command[0].c_str(), commandLineBuffer.data(), nullptr, nullptr, FALSE, 0, nullptr, nullptr, &startupInfo, &processInfo))
+        {
+            throw std::runtime_error("Couldn't spawn " + command[0] + ", error " + std::to_string(GetLastError()));
+        }
+        CloseHandle(processInfo.hThread);
+        return std::unique_ptr<ChildProcess>(new ChildProcess(processInfo.hProcess, processInfo.dwProcessId));
+    }
+
+    ChildProcess::~ChildProcess()
+    {
+        CloseHandle(_handle);
+    }
+
+    bool ChildProcess::TryGetExitCode(int& exitCode)
+    {
+        if (!_exited && WaitForSingleObject(_handle, 0) == WAIT_OBJECT_0)
+        {
+            DWORD code;
+            _exited = true;
+            _exitCode = GetExitCodeProcess(_handle, &code) ? static_cast<int>(code) : -1;
+        }
+        exitCode = _exitCode;
+        return _exited;
+    }
+
+    void ChildProcess::Kill()
+    {
+        if (_exited)
+        {
+            return;
+        }
+
+        TerminateProcess(_handle, 1);
+        WaitForSingleObject(_handle, INFINITE);
+        _exited = true;
+        _exitCode = 1;
+    }
+
+    uint32_t CurrentProcessId()
+    {
+        return static_cast<uint32_t>(::GetCurrentProcessId());
+    }
+
+    bool KillProcess(uint32_t processId)
+    {
+        HANDLE hProcess = OpenProcess(PROCESS_TERMINATE | SYNCHRONIZE, FALSE, processId);
+        if (hProcess == nullptr)
+        {
+            return false;
+        }
+        // Termination is asynchronous, the process can still run until it's signaled
+        bool killed = TerminateProcess(hProcess, 1) != 0 && WaitForSingleObject(hProcess, KILL_TIMEOUT) == WAIT_OBJECT_0;
+        CloseHandle(hProcess);
+        return killed;
+    }
+
+    bool IsProcessRunning(uint32_t processId)
+    {
+        HANDLE hProcess = OpenProcess(SYNCHRONIZE, FALSE, processId);
+        if (hProcess == nullptr)
+        {
+            return false;
+        }
+        bool running = WaitForSingleObject(hProcess, 0) == WAIT_TIMEOUT;
+        CloseHandle(hProcess);
+        return running;
+    }
+
+    std::vector<std::vector<uint32_t>> GetPhysicalCores()
+    {
+        DWORD_PTR processMask = 0;
+        DWORD_PTR systemMask = 0;
+        DWORD length = 0;
+        GetLogicalProcessorInformation(nullptr, &length);
+        std::vector<SYSTEM_LOGICAL_PROCESSOR_INFORMATION> information(length / sizeof(SYSTEM_LOGICAL_PROCESSOR_INFORMATION));
+        if (!GetProcessAffinityMask(GetCurrentProcess(), &processMask, &systemMask) || information.empty()
+            || !GetLogicalProcessorInformation(information.data(), &length))
+        {
+            return {};
+        }
+
+        // Processors of the current group only, which is all of them for the 32 bits game
+        std::vector<std::vector<uint32_t>> cores;
+        for (const SYSTEM_LOGICAL_PROCESSOR_INFORMATION& entry : information)
+        {
+            if (entry.Relationship != RelationProcessorCore)
+            {
+                continue;
+            }
+
+            std::vector<uint32_t> siblings;
+            for (uint32_t processor = 0; processor < sizeof(ULONG_PTR) * 8; ++processor)
+            {
+                ULONG_PTR bit = static_cast<ULONG_PTR>(1) << processor;
+                if ((entry.ProcessorMask & bit) && (processMask & bit))
+                {
+                    siblings.push_back(processor);
+                }
+            }
+            if (!siblings.empty())
+            {
+                cores.push_back(siblings);
+            }
+        }
+        return cores;
+    }
+
+    bool SetThreadAffinity(uint32_t threadId, uint64_t mask)
+    {
+        HANDLE hThread = OpenThread(THREAD_SET_INFORMATION | THREAD_QUERY_INFORMATION, FALSE, threadId);
+        if (hThread == nullptr)
+        {
+            return false;
+        }
+        bool pinned = SetThreadAffinityMask(hThread, static_cast<DWORD_PTR>(mask)) != 0;
+        CloseHandle(hThread);
+        return pinned;
+    }
+
+    bool SetCurrentThreadAffinity(uint64_t mask)
+    {
+        return SetThreadAffinityMask(GetCurrentThread(), static_cast<DWORD_PTR>(mask)) != 0;
+    }
+
+    uint64_t GetCurrentThreadAffinity()
+    {
+        // Only readable by setting it, put back right away
+        DWORD_PTR processMask = 0;
+        DWORD_PTR systemMask = 0;
+        if (!GetProcessAffinityMask(GetCurrentProcess(), &processMask, &systemMask))
+        {
+            return 0;
+        }
+        DWORD_PTR previous = SetThreadAffinityMask(GetCurrentThread(), processMask);
+        if (previous != 0)
+        {
+            SetThreadAffinityMask(GetCurrentThread(), previous);
+        }
+        return previous;
+    }
+
+    size_t GetWorkingSetSize()
+    {
+        PROCESS_MEMORY_COUNTERS pmc;
+        if (GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc)))
+        {
+            return pmc.WorkingSetSize;
+        }
+        return 0;
+    }
+
+    size_t GetPageSize()
+    {
+        SYSTEM_INFO systemInfo;
+        GetSystemInfo(&systemInfo);
+        return systemInfo.dwPageSize;
+    }
+
+    size_t GetLargePageSize()
+    {
+        return GetLargePageMinimum();
+    }
+
+    void* AllocatePages(size_t size)
+    {
+        void* address = VirtualAlloc(nullptr, size, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+        if (address == nullptr)
+        {
+            throw std::runtime_error("Couldn't allocate pages, error " + std::to_string(GetLastError()));
+        }
+        return address;
+    }
+
+    void FreePages(void* address, size_t size)
+    {
+        VirtualFree(address, 0, MEM_RELEASE);
+    }
+
+    bool ProtectPages(void* address, size_t size, bool writable)
+    {
+        DWORD previousProtection;
+        return VirtualProtect(address, size, writable ? PAGE_READWRITE : PAGE_READONLY, &previousProtection);
+    }
+
+    bool CollectWrittenPages(void* address, size_t size, void** pages, size_t& count)
+    {
+        ULONG_PTR written = count;
+        DWORD granularity;
+        if (GetWriteWatch(WRITE_WATCH_FLAG_RESET, address, size, pages, &written, &granularity) != 0)
+        {
+            return false;
+        }
+        count = static_cast<size_t>(written);
+        return true;
+    }
+
+    bool ResetWrittenPages(void* address, size_t size)
+    {
+        return ResetWriteWatch(address, size) == 0;
+    }
+
+    bool MapFileCopyOnWrite(const std::string& path, uint64_t offset, void* address, size_t size)
+    {
+        HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE)
+        {
+            return false;
+        }
+        HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_WRITECOPY, 0, 0, nullptr);
+        CloseHandle(file);
+        if (mapping == nullptr)
+        {
+            return false;
+        }
+
+        // Views start on the allocation granularity, the committed pages can't be replaced by one so they are copied
+        SYSTEM_INFO info;
+        GetSystemInfo(&info);
+        uint64_t viewOffset = offset - offset % info.dwAllocationGranularity;
+        size_t viewSize = static_cast<size_t>(offset - viewOffset) + size;
+        void* view = MapViewOfFile(mapping, FILE_MAP_COPY, static_cast<DWORD>(viewOffset >> 32), static_cast<DWORD>(viewOffset), viewSize);
+        CloseHandle(mapping);
+        if (view == nullptr)
+        {
+            return false;
+        }
+        std::memcpy(address, static_cast<const uint8_t*>(view) + (offset - viewOffset), size);
+        UnmapViewOfFile(view);
+        return true;
+    }
+
+    void InstallWriteFaultHandler(WriteFaultHandler handler)
+    {
+        if (writeFaultHandler.exchange(handler) != nullptr)
+        {
+            return;
+        }
+
+        // First in the chain, the game's own handlers never see our faults
+        if (AddVectoredExceptionHandler(1, &OnAccessViolation) == nullptr)
+        {
+            throw std::runtime_error("Couldn't install the exception handler");
+        }
+    }
+}
@@ -0,0 +1,271 @@
+#include "../pch.h"
+#include "WarmPool.hpp"
+
+namespace Pool
+{
+    ParkedInstance::ParkedInstance(const std::string& prefix, const std::vector<std::string>& command)
+        : _prefix(prefix),
+        _names(false, 1, Data::ServerParams::RenderParams(0, 0, false), Data::ServerParams::TraceParams(false, 0, ""), prefix),
+        _serverProcessId(0),
+        _parked(false)
+    {
+        // Same initial state as a client starting its own server
+        _resources.lockServerPool = Platform::NamedSemaphore::Create(_names.serverMutexName, 0, 1);
+        _resources.lockClientPool = Platform::NamedSemaphore::Create(_names.clientMutexName, 0, 1);
+        _resources.returnCodeSM = Platform::SharedMemory::Create(_names.returnCodeMemoryName, sizeof(Data::ReturnCode));
+        *static_cast<Data::ErrorCode*>(_resources.returnCodeSM->Data()) = Data::ErrorCode::NOT_ACK;
+        _resources.serverInfoSM = Platform::SharedMemory::Create(_names.serverInfoMemoryName, sizeof(Data::ServerInfo));
+        _resources.serverInfoExSM = Platform::SharedMemory::Create(_names.serverInfoExMemoryName, Data::ServerInfoEx::SECTION_SIZE);
+        _resources.heartbeatSM = Platform::SharedMemory::Create(_names.heartbeatMemoryName, Data::Heartbeat::SECTION_SIZE);
+        _lockReady = Platform::NamedSemaphore::Create(_names.readyMutexName, 0, 1);
+
+        std::vector<std::string> instanceCommand;
+        std::string placeholder = WarmPoolParams::PREFIX_PLACEHOLDER;
+        for (std::string arg : command)
+        {
+            size_t position = arg.find(placeholder);
+            if (position != std::string::npos)
+            {
+                arg.replace(position, placeholder.size(), prefix);
+            }
+            instanceCommand.push_back(arg);
+        }
+        _process = Platform::ChildProcess::Spawn(instanceCommand);
+    }
+
+    ParkedInstance::~ParkedInstance()
+    {
+        int exitCode;
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(EXIT_TIMEOUT);
+        while ((!_process->TryGetExitCode(exitCode) || !HasServerExited()) && std::chrono::steady_clock::now() < deadline)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        Kill();
+    }
+
+    const std::string& ParkedInstance::Prefix() const
+    {
+        return _prefix;
+    }
+
+    bool ParkedInstance::IsParked()
+    {
+        if (!_parked && _lockReady->Wait(0))
+        {
+            _parked = true;
+        }
+        return _parked;
+    }
+
+    bool ParkedInstance::HasFailed()
+    {
+        int exitCode;
+        if (_process->TryGetExitCode(exitCode) && exitCode != 0)
+        {
+            return true;
+        }
+        // The launcher exits once it injected the server, the game is watched from then on
+        return ServerProcessId() != 0 && HasServerExited();
+    }
+
+    HandshakeResources ParkedInstance::TakeResources()
+    {
+        ServerProcessId();
+        return std::move(_resources);
+    }
+
+    void ParkedInstance::Discard()
+    {
+        if (_resources.lockServerPool != nullptr && IsParked() && !HasFailed())
+        {
+            // Woken up like by a client, the server checks the return code first
+            *static_cast<Data::ErrorCode*>(_resources.returnCodeSM->Data()) = Data::ErrorCode::DISCARDED;
+            _resources.lockServerPool->Release();
+            if (_resources.lockClientPool->Wait(EXIT_TIMEOUT))
+            {
+                return;
+            }
+        }
+        Kill();
+    }
+
+    uint32_t ParkedInstance::ServerProcessId()
+    {
+        if (_serverProcessId == 0 && _resources.heartbeatSM != nullptr)
+        {
+            _serverProcessId = static_cast<Data::Heartbeat*>(_resources.heartbeatSM->Data())->processId.load(std::memory_order_relaxed);
+        }
+        return _serverProcessId;
+    }
+
+    bool ParkedInstance::HasServerExited()
+    {
+        uint32_t serverProcessId = ServerProcessId();
+        return serverProcessId == 0 || !Platform::IsProcessRunning(serverProcessId);
+    }
+
+    void ParkedInstance::Kill()
+    {
+        // Without a launcher the child is the server itself, and it's killed below
+        int exitCode;
+        uint32_t serverProcessId = ServerProcessId();
+        if (_process->TryGetExitCode(exitCode) && serverProcessId != 0)
+        {
+            Platform::KillProcess(serverProcessId);
+        }
+        _process->Kill();
+    }
+
+    WarmPool::WarmPool(const WarmPoolParams& params)
+        : _params(params),
+        _stats{ 0, 0, 0, 0 },
+        _stopping(false),
+        _nextIndex(0),
+        _refillThread(&WarmPool::RefillLoop, this)
+    {
+    }
+
+    WarmPool::~WarmPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _stopping = true;
+        }
+        _refillCondition.notify_all();
+        _parkedCondition.notify_all();
+        _refillThread.join();
+
+        // All of them are told to exit before waiting for any
+        for (std::unique_ptr<ParkedInstance>& instance : _parked)
+        {
+            instance->Discard();
+        }
+        _parked.clear();
+    }
+
+    std::unique_ptr<ParkedInstance> WarmPool::Acquire(uint32_t timeoutMs)
+    {
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+        std::unique_lock<std::mutex> lock(_mutex);
+        while (_parkedCondition.wait_until(lock, deadline, [this]() { return !_parked.empty() || _stopping; }) && !_stopping)
+        {
+            std::unique_ptr<ParkedInstance> instance = std::move(_parked.front());
+            _parked.pop_front();
+            _refillCondition.notify_one();
+
+            // Parked servers can die while they wait (crashed or killed game)
+            if (instance->HasFailed())
+            {
+                _stats.failed++;
+                continue;
+            }
+            _stats.acquired++;
+            return instance;
+        }
+        return nullptr;
+    }
+
+    size_t WarmPool::ParkedCount() const
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _parked.size();
+    }
+
+    WarmPoolStats WarmPool::Stats() const
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _stats;
+    }
+
+    void WarmPool::RefillLoop()
+    {
+        // Only this thread touches the starting instances
+        std::vector<StartingInstance> starting;
+        auto retryTime = std::chrono::steady_clock::time_point::min();
+
+        std::unique_lock<std::mutex> lock(_mutex);
+        while (!_stopping)
+        {
+            size_t missing = _params.size - std::min<size_t>(_params.size, _parked.size() + starting.size());
+            lock.unlock();
+
+            // Processes are started and polled without the lock, acquiring never waits for them
+            auto now = std::chrono::steady_clock::now();
+            uint64_t started = 0;
+            uint64_t failed = 0;
+            for (size_t i = 0; i < missing && now >= retryTime; ++i)
+            {
+                try
+                {
+                    starting.push_back(StartingInstance{ StartInstance(), now + std::chrono::milliseconds(_params.startTimeoutMs) });
+                    started++;
+                }
+                catch (const std::exception&)
+                {
+                    failed++;
+                    retryTime = now + std::chrono::milliseconds(RETRY_DELAY);
+                }
+            }
+
+            std::vector<std::unique_ptr<ParkedInstance>> parked;
+            for (auto it = starting.begin(); it != starting.end();)
+            {
+                if (it->instance->IsParked())
+                {
+                    parked.push_back(std::move(it->instance));
+                    it = starting.erase(it);
+                }
+                else if (it->instance->HasFailed() || now > it->deadline)
+                {
+                    it->instance->Discard();
+                    failed++;
+                    retryTime = now + std::chrono::milliseconds(RETRY_DELAY);
+                    it = starting.erase(it);
+                }
+                else
+                {
+                    ++it;
+                }
+            }
+
+            lock.lock();
+            _stats.started += started;
+            _stats.failed += failed;
+            _stats.parked += parked.size();
+            if (!parked.empty())
+            {
+                for (std::unique_ptr<ParkedInstance>& instance : parked)
+                {
+                    _parked.push_back(std::move(instance));
+                }
+                _parkedCondition.notify_all();
+            }
+
+            if (!starting.empty())
+            {
+                _refillCondition.wait_for(lock, std::chrono::milliseconds(POLL_INTERVAL));
+            }
+            else if (std::chrono::steady_clock::now() < retryTime)
+            {
+                _refillCondition.wait_until(lock, retryTime, [this]() { return _stopping; });
+            }
+            else
+            {
+                _refillCondition.wait(lock, [this]() { return _stopping || _parked.size() < _params.size; });
+            }
+        }
+        lock.unlock();
+
+        for (StartingInstance& instance : starting)
+        {
+            instance.instance->Discard();
+        }
+    }
+
+    std::unique_ptr<ParkedInstance> WarmPool::StartInstance()
+    {
+        std::string prefix = _params.namePrefix + std::to_string(_nextIndex++) + "-";
+        return std::make_unique<ParkedInstance>(prefix, _params.command);
+    }
+}
@@ -0,0 +1,115 @@
+#pragma once
+#include "../Data/ServerTypes.hpp"
+#include "../Platform/Platform.hpp"
+#include <deque>
+
+namespace Pool
+{
+    struct WarmPoolParams
+    {
+        static constexpr const char* PREFIX_PLACEHOLDER = "{prefix}";
+        static constexpr uint32_t DEFAULT_START_TIMEOUT = 60000; // in ms
+
+        const uint32_t size; // parked instances kept ready
+        const std::vector<std::string> command; // starts one server with PoolParams::parked, PREFIX_PLACEHOLDER is replaced by its shared resources prefix
+        const std::string namePrefix; // shared resources prefix of the instances, followed by their index
+        const uint32_t startTimeoutMs; // instances that aren't parked by then are killed and replaced
+
+        WarmPoolParams(uint32_t size, const std::vector<std::string>& command, const std::string& namePrefix, uint32_t startTimeoutMs = DEFAULT_START_TIMEOUT)
+            : size(size), command(command), namePrefix(namePrefix), startTimeoutMs(startTimeoutMs)
+        {
+        }
+    };
+
+    // What a client creates before starting a server, in the same state
+    struct HandshakeResources
+    {
+        std::unique_ptr<Platform::NamedSemaphore> lockServerPool;
+        std::unique_ptr<Platform::NamedSemaphore> lockClientPool;
+        std::unique_ptr<Platform::SharedMemory> returnCodeSM;
+        std::unique_ptr<Platform::SharedMemory> serverInfoSM;
+        std::unique_ptr<Platform::SharedMemory> serverInfoExSM; // the protocol extensions are always offered
+        std::unique_ptr<Platform::SharedMemory> heartbeatSM; // pooled servers can always be supervised
+    };
+
+    // Server started ahead of its client, it waits on the first handshake once the game is past its intro.
+    // The client that acquires it takes the handshake resources over and connects as if it had started the server.
+    class ParkedInstance
+    {
+    public:
+        static constexpr uint32_t EXIT_TIMEOUT = 2000; // in ms, the process is killed after
+
+        ParkedInstance(const std::string& prefix, const std::vector<std::string>& command);
+        // Waits for the process to exit, the client closed the server or it was discarded
+        ~ParkedInstance();
+
+        const std::string& Prefix() const;
+        // Polls the readiness of the server
+        bool IsParked();
+        // The process exited with an error (exit code 0 is a launcher that's done injecting), or the server's process
+        // (the game, once injected) exited since
+        bool HasFailed();
+        HandshakeResources TakeResources();
+        // Parked servers exit without serving a client, the others are killed
+        void Discard();
+
+    private:
+        const std::string _prefix;
+        const Data::ServerParams _names;
+        HandshakeResources _resources;
+        std::unique_ptr<Platform::NamedSemaphore> _lockReady;
+        std::unique_ptr<Platform::ChildProcess> _process;
+        uint32_t _serverProcessId; // published in the heartbeat when the server starts, 0 before
+        bool _parked;
+
+        uint32_t ServerProcessId();
+        bool HasServerExited();
+        // Kills the launcher, or the game once the launcher is done injecting
+        void Kill();
+    };
+
+    struct WarmPoolStats
+    {
+        uint64_t started;
+        uint64_t parked;
+        uint64_t acquired;
+        uint64_t failed; // didn't park before the timeout, or died parked
+    };
+
+    // Keeps a number of servers parked, and starts new ones in the background as they are acquired
+    class WarmPool
+    {
+    public:
+        static constexpr uint32_t POLL_INTERVAL = 2; // in ms, between readiness checks of the starting instances
+        static constexpr uint32_t RETRY_DELAY = 1000; // in ms, after an instance failed to start
+
+        explicit WarmPool(const WarmPoolParams& params);
+        // Parked instances are discarded, starting ones killed
+        ~WarmPool();
+
+        // Returns nullptr if no instance was parked before the timeout
+        std::unique_ptr<ParkedInstance> Acquire(uint32_t timeoutMs);
+        size_t ParkedCount() const;
+        WarmPoolStats Stats() const;
+
+    private:
+        struct StartingInstance
+        {
+            std::unique_ptr<ParkedInstance> instance;
+            std::chrono::steady_clock::time_point deadline;
+        };
+
+        const WarmPoolParams _params;
+        mutable std::mutex _mutex;
+        std::condition_variable _parkedCondition; // an instance parked, or the pool stops
+        std::condition_variable _refillCondition; // an instance was acquired, or the pool stops
+        std::deque<std::unique_ptr<ParkedInstance>> _parked;
+        WarmPoolStats _stats;
+        bool _stopping;
+        uint64_t _nextIndex;
+        std::thread _refillThread;
+
+        void RefillLoop();
+        std::unique_ptr<ParkedInstance> StartInstance();
+    };
+}
@@ -0,0 +1,110 @@
+#include "../pch.h"
+#include "ActionLog.hpp"
+
+namespace Replay
+{
+    ActionLogWriter::ActionLogWriter(const std::string& path, const ActionLogHeader& header)
+        : _file(std::fopen(path.c_str(), "wb")),
+        _buffer(BUFFER_RECORDS),
+        _bufferedRecords(0)
+    {
+        if (_file == nullptr)
+        {
+            throw std::runtime_error("Couldn't open action log " + path);
+        }
+        if (std::fwrite(&header, sizeof(header), 1, _file) != 1)
+        {
+            std::fclose(_file);
+            throw std::runtime_error("Couldn't write the header of action log " + path);
+        }
+    }
+
+    ActionLogWriter::~ActionLogWriter()
+    {
+        try
+        {
+            Flush();
+        }
+        catch (const std::exception& e)
+        {
+            HPLogger::LogError(e.what());
+        }
+        std::fclose(_file);
+    }
+
+    void ActionLogWriter::Append(const ActionLogRecord& record)
+    {
+        _buffer[_bufferedRecords++] = record;
+        if (_bufferedRecords == _buffer.size())
+        {
+            Flush();
+        }
+    }
+
+    void ActionLogWriter::Flush()
+    {
+        if (_bufferedRecords > 0 && std::fwrite(_buffer.data(), sizeof(ActionLogRecord), _bufferedRecords, _file) != _bufferedRecords)
+        {
+            throw std::runtime_error("Failed to write the action log");
+        }
+        _bufferedRecords = 0;
+        std::fflush(_file);
+    }
+
+    ActionLogReader::ActionLogReader(const std::string& path)
+        : _header(0, Data::ServerInfo(0, 0, 0, 0), Data::ServerParams::ActionParams(0.0f, 0))
+    {
+        std::ifstream reader(path, std::ios::binary);
+        if (!reader.is_open())
+        {
+            throw std::runtime_error("Couldn't open action log " + path);
+        }
+
+        // Version 1 headers end before the action params, their steps have neither sticky actions nor repeat counts.
+        // Version 2 headers end before the pipeline config, their steps aren't transformed.
+        constexpr size_t version1Size = offsetof(ActionLogHeader, stickyProbability);
+        constexpr size_t version2Size = offsetof(ActionLogHeader, pipelineConfig);
+        reader.read(reinterpret_cast<char*>(&_header), version1Size);
+        if (!reader || _header.magic != ActionLogHeader::MAGIC || _header.version == 0 || _header.version > ActionLogHeader::VERSION)
+        {
+            throw std::runtime_error(path + " isn't an action log of this version");
+        }
+        size_t headerSize = _header.version == 1 ? version1Size : _header.version == 2 ? version2Size : sizeof(_header);
+        if (!reader.read(reinterpret_cast<char*>(&_header) + version1Size, headerSize - version1Size))
+        {
+            throw std::runtime_error(path + " isn't an action log of this version");
+        }
+
+        // A log cut short by a crash ends on the last complete record
+        ActionLogRecord record{};
+        while (reader.read(reinterpret_cast<char*>(&record), sizeof(record)))
+        {
+            _records.push_back(record);
+        }
+    }
+
+    const ActionLogHeader& ActionLogReader::Header() const
+    {
+        return _header;
+    }
+
+    const std::vector<ActionLogRecord>& ActionLogReader::Records() const
+    {
+        return _records;
+    }
+
+    std::string ReplayReport::ToString() const
+    {
+        std::ostringstream oss;
+        if (!diverged)
+        {
+            oss << "Replayed " << replayedRecords << " instructions without divergence";
+            return oss.str();
+        }
+
+        oss << "Replay diverged at instruction " << divergentRecord << " (code " << static_cast<uint32_t>(divergentCode)
+            << "), expected frame " << expectedFrame << " got " << actualFrame
+            << ", expected observation checksum 0x" << std::hex << expectedChecksum << " got 0x" << actualChecksum;
+        return oss.str();
+    }
+}
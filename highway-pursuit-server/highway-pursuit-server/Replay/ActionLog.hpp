@@ -0,0 +1,87 @@
+#pragma once
+#include "../Data/ServerTypes.hpp"
+
+namespace Replay
+{
+    #pragma pack(push, 1)
+    struct ActionLogHeader
+    {
+        static constexpr uint32_t MAGIC = 0x4C415048; // "HPAL"
+        static constexpr uint32_t VERSION = 3; // 2: sticky actions and repeat counts, 3: pipeline config
+
+        uint32_t magic;
+        uint32_t version;
+        int32_t frameskip;
+        uint32_t obsWidth;
+        uint32_t obsHeight;
+        uint32_t obsChannels;
+        float stickyProbability; // replays draw the same sticky actions from the same seed
+        uint64_t seed;
+        Data::PipelineConfig pipelineConfig; // replays apply the same transforms, the records hold the client's actions
+
+        // serverInfo describes the game, before the transforms
+        ActionLogHeader(int32_t frameskip, const Data::ServerInfo& serverInfo, const Data::ServerParams::ActionParams& actionParams,
+            const Data::PipelineConfig& pipelineConfig = Data::PipelineConfig())
+            : magic(MAGIC), version(VERSION), frameskip(frameskip),
+            obsWidth(serverInfo.obsWidth), obsHeight(serverInfo.obsHeight), obsChannels(serverInfo.obsChannels),
+            stickyProbability(actionParams.stickyProbability), seed(actionParams.seed), pipelineConfig(pipelineConfig) {}
+    };
+
+    // One per instruction handled, in the order they were received
+    struct ActionLogRecord
+    {
+        uint64_t frame; // _totalEllapsedFrames once the instruction was handled
+        uint64_t observationChecksum; // 0 if the instruction doesn't return an observation
+        uint32_t actionMask; // STEP only
+        uint32_t argument; // slot of SNAPSHOT/RESTORE, repeat count of STEP (0 for the frameskip)
+        Data::InstructionCode code;
+    };
+    #pragma pack(pop)
+
+    // Appends records to a file through a fixed buffer, appending doesn't allocate
+    class ActionLogWriter
+    {
+    public:
+        static constexpr size_t BUFFER_RECORDS = 4096;
+
+        ActionLogWriter(const std::string& path, const ActionLogHeader& header);
+        ~ActionLogWriter();
+
+        void Append(const ActionLogRecord& record);
+        void Flush();
+
+    private:
+        std::FILE* _file;
+        std::vector<ActionLogRecord> _buffer;
+        size_t _bufferedRecords;
+    };
+
+    // Loads a whole log
+    class ActionLogReader
+    {
+    public:
+        ActionLogReader(const std::string& path);
+
+        const ActionLogHeader& Header() const;
+        const std::vector<ActionLogRecord>& Records() const;
+
+    private:
+        ActionLogHeader _header;
+        std::vector<ActionLogRecord> _records;
+    };
+
+    struct ReplayReport
+    {
+        uint64_t replayedRecords = 0;
+        bool diverged = false;
+        // First record whose frame counter or observation doesn't match, when diverged
+        uint64_t divergentRecord = 0;
+        Data::InstructionCode divergentCode = Data::InstructionCode::PING;
+        uint64_t expectedFrame = 0;
+        uint64_t actualFrame = 0;
+        uint64_t expectedChecksum = 0;
+        uint64_t actualChecksum = 0;
+
+        std::string ToString() const;
+    };
+}
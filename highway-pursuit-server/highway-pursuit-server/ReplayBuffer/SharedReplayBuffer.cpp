@@ -0,0 +1,157 @@
+#include "../pch.h"
+#include "SharedReplayBuffer.hpp"
+
+namespace ReplayBuffer
+{
+    namespace
+    {
+        uint64_t WritingSequence(uint64_t ticket)
+        {
+            return 2 * ticket + 1;
+        }
+
+        uint64_t CompleteSequence(uint64_t ticket)
+        {
+            return 2 * ticket + 2;
+        }
+    }
+
+    size_t SharedReplayBuffer::SectionSize(uint32_t capacity, uint32_t observationSize)
+    {
+        return sizeof(ReplayBufferHeader) + sizeof(ReplayBufferCursor) + static_cast<size_t>(capacity) * SlotStride(observationSize);
+    }
+
+    std::unique_ptr<SharedReplayBuffer> SharedReplayBuffer::Create(const std::string& name, uint32_t capacity, uint32_t observationSize)
+    {
+        if (capacity == 0)
+        {
+            throw std::invalid_argument("A replay buffer needs at least one slot");
+        }
+
+        // New sections are zeroed: every sequence is 0 and the cursor at the first ticket
+        std::unique_ptr<Platform::SharedMemory> memory = Platform::SharedMemory::Create(name, SectionSize(capacity, observationSize), true);
+        new (memory->Data()) ReplayBufferHeader{ ReplayBufferHeader::MAGIC, ReplayBufferHeader::VERSION, capacity, observationSize, SlotStride(observationSize) };
+        return std::unique_ptr<SharedReplayBuffer>(new SharedReplayBuffer(std::move(memory)));
+    }
+
+    std::unique_ptr<SharedReplayBuffer> SharedReplayBuffer::Open(const std::string& name, uint32_t observationSize)
+    {
+        // The header gives the size of the whole section
+        ReplayBufferHeader header;
+        {
+            std::unique_ptr<Platform::SharedMemory> headerMemory = Platform::SharedMemory::Open(name, sizeof(ReplayBufferHeader));
+            std::memcpy(&header, headerMemory->Data(), sizeof(header));
+        }
+        if (header.magic != ReplayBufferHeader::MAGIC || header.version != ReplayBufferHeader::VERSION)
+        {
+            throw std::runtime_error(name + " isn't a replay buffer of this version");
+        }
+        if (header.observationSize != observationSize || header.slotStride != SlotStride(observationSize) || header.capacity == 0)
+        {
+            throw std::runtime_error("Replay buffer " + name + " holds observations of " + std::to_string(header.observationSize)
+                + " bytes, the server's are " + std::to_string(observationSize));
+        }
+
+        std::unique_ptr<Platform::SharedMemory> memory = Platform::SharedMemory::Open(name, SectionSize(header.capacity, observationSize), true);
+        return std::unique_ptr<SharedReplayBuffer>(new SharedReplayBuffer(std::move(memory)));
+    }
+
+    SharedReplayBuffer::SharedReplayBuffer(std::unique_ptr<Platform::SharedMemory> memory)
+        : _memory(std::move(memory))
+    {
+        uint8_t* base = static_cast<uint8_t*>(_memory->Data());
+        _header = reinterpret_cast<ReplayBufferHeader*>(base);
+        _cursor = reinterpret_cast<ReplayBufferCursor*>(base + sizeof(ReplayBufferHeader));
+        _slots = base + sizeof(ReplayBufferHeader) + sizeof(ReplayBufferCursor);
+    }
+
+    uint64_t SharedReplayBuffer::Append(Trajectory::TransitionKind kind, const void* observation, uint32_t actionMask, float reward,
+        const Data::Termination& termination, uint64_t previousTicket)
+    {
+        uint64_t ticket = _cursor->nextTicket.fetch_add(1, std::memory_order_relaxed);
+        ReplaySlotHeader& slot = Slot(ticket);
+
+        // Claim the slot unless a writer is still in it, or a later ticket already is
+        uint64_t sequence = slot.sequence.load(std::memory_order_relaxed);
+        do
+        {
+            if (sequence % 2 == 1 || sequence >= CompleteSequence(ticket))
+            {
+                return NO_TICKET;
+            }
+        } while (!slot.sequence.compare_exchange_weak(sequence, WritingSequence(ticket), std::memory_order_relaxed));
+
+        // Readers seeing any of the writes below also see the odd sequence
+        std::atomic_thread_fence(std::memory_order_release);
+        slot.previousTicket = previousTicket;
+        slot.actionMask = actionMask;
+        slot.reward = reward;
+        slot.kind = kind;
+        slot.terminated = termination.terminated;
+        slot.truncated = termination.truncated;
+        std::memcpy(reinterpret_cast<uint8_t*>(&slot) + sizeof(ReplaySlotHeader), observation, _header->observationSize);
+
+        slot.sequence.store(CompleteSequence(ticket), std::memory_order_release);
+        return ticket;
+    }
+
+    bool SharedReplayBuffer::TryRead(uint64_t ticket, ReplayTransition& transition, uint8_t* observation) const
+    {
+        if (ticket == NO_TICKET)
+        {
+            return false;
+        }
+
+        const ReplaySlotHeader& slot = Slot(ticket);
+        uint64_t sequence = slot.sequence.load(std::memory_order_acquire);
+        if (sequence != CompleteSequence(ticket))
+        {
+            return false;
+        }
+
+        transition = ReplayTransition{ slot.previousTicket, slot.actionMask, slot.reward, slot.kind, slot.terminated, slot.truncated };
+        std::memcpy(observation, reinterpret_cast<const uint8_t*>(&slot) + sizeof(ReplaySlotHeader), _header->observationSize);
+
+        // The copy is only valid if no writer claimed the slot meanwhile
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return slot.sequence.load(std::memory_order_relaxed) == sequence;
+    }
+
+    bool SharedReplayBuffer::TryReadStep(uint64_t ticket, ReplayTransition& transition, uint8_t* observation, uint8_t* nextObservation) const
+    {
+        if (!TryRead(ticket, transition, nextObservation) || transition.kind != Trajectory::TransitionKind::STEP)
+        {
+            return false;
+        }
+
+        ReplayTransition previous;
+        return TryRead(transition.previousTicket, previous, observation);
+    }
+
+    uint64_t SharedReplayBuffer::NextTicket() const
+    {
+        return _cursor->nextTicket.load(std::memory_order_acquire);
+    }
+
+    uint32_t SharedReplayBuffer::Capacity() const
+    {
+        return _header->capacity;
+    }
+
+    uint32_t SharedReplayBuffer::ObservationSize() const
+    {
+        return _header->observationSize;
+    }
+
+    ReplaySlotHeader& SharedReplayBuffer::Slot(uint64_t ticket) const
+    {
+        return *reinterpret_cast<ReplaySlotHeader*>(_slots + (ticket % _header->capacity) * _header->slotStride);
+    }
+
+    uint64_t SharedReplayBuffer::SlotStride(uint32_t observationSize)
+    {
+        // Slots start on their own cache line
+        uint64_t observationLines = (static_cast<uint64_t>(observationSize) + CACHE_LINE_SIZE - 1) / CACHE_LINE_SIZE;
+        return sizeof(ReplaySlotHeader) + observationLines * CACHE_LINE_SIZE;
+    }
+}
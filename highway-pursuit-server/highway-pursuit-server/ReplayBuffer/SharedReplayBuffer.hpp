@@ -0,0 +1,95 @@
+#pragma once
+#include "../Data/ServerTypes.hpp"
+#include "../Platform/Platform.hpp"
+#include "../Trajectory/TrajectoryFormat.hpp"
+
+// Circular transition store in a shared memory section, created by a learner and appended to by any number of servers.
+// Layout (python mirror in highway_pursuit_gym/datasets/shared_replay_buffer.py):
+// - [0, 64): ReplayBufferHeader
+// - [64, 128): ReplayBufferCursor, next ticket to hand out
+// - then capacity slots of slotStride bytes: a ReplaySlotHeader followed by the observation
+namespace ReplayBuffer
+{
+    constexpr size_t CACHE_LINE_SIZE = 64;
+
+    struct alignas(CACHE_LINE_SIZE) ReplayBufferHeader
+    {
+        static constexpr uint32_t MAGIC = 0x42525048; // "HPRB"
+        static constexpr uint32_t VERSION = 1;
+
+        uint32_t magic;
+        uint32_t version;
+        uint32_t capacity;
+        uint32_t observationSize;
+        uint64_t slotStride;
+    };
+
+    struct alignas(CACHE_LINE_SIZE) ReplayBufferCursor
+    {
+        std::atomic<uint64_t> nextTicket;
+    };
+
+    struct alignas(CACHE_LINE_SIZE) ReplaySlotHeader
+    {
+        // Seqlock: 2 * ticket + 1 while the transition of ticket is written, 2 * ticket + 2 once complete, 0 if never written
+        std::atomic<uint64_t> sequence;
+        uint64_t previousTicket; // transition whose observation precedes this one, NO_TICKET at an episode start
+        uint32_t actionMask;
+        float reward;
+        Trajectory::TransitionKind kind;
+        uint8_t terminated;
+        uint8_t truncated;
+    };
+
+    static_assert(std::atomic<uint64_t>::is_always_lock_free, "Sequence numbers are shared between processes");
+    static_assert(sizeof(ReplayBufferHeader) == CACHE_LINE_SIZE && sizeof(ReplayBufferCursor) == CACHE_LINE_SIZE
+        && sizeof(ReplaySlotHeader) == CACHE_LINE_SIZE, "The layout is shared with python");
+
+    struct ReplayTransition
+    {
+        uint64_t previousTicket;
+        uint32_t actionMask;
+        float reward;
+        Trajectory::TransitionKind kind;
+        uint8_t terminated;
+        uint8_t truncated;
+    };
+
+    class SharedReplayBuffer
+    {
+    public:
+        static constexpr uint64_t NO_TICKET = UINT64_MAX;
+
+        static size_t SectionSize(uint32_t capacity, uint32_t observationSize);
+        // Learner side, the buffer is zeroed (empty)
+        static std::unique_ptr<SharedReplayBuffer> Create(const std::string& name, uint32_t capacity, uint32_t observationSize);
+        // Server side, fails if the buffer doesn't hold observations of this size
+        static std::unique_ptr<SharedReplayBuffer> Open(const std::string& name, uint32_t observationSize);
+
+        // Lock-free. Returns the ticket of the transition, or NO_TICKET if it was dropped because a slower writer still
+        // holds the slot (the ring went around while it was writing, or it was killed mid-write)
+        uint64_t Append(Trajectory::TransitionKind kind, const void* observation, uint32_t actionMask, float reward,
+            const Data::Termination& termination, uint64_t previousTicket);
+
+        // Copies a transition, false if it isn't complete or was overwritten meanwhile. observation holds ObservationSize() bytes.
+        bool TryRead(uint64_t ticket, ReplayTransition& transition, uint8_t* observation) const;
+        // A step with the observation it started from, false if either isn't available
+        bool TryReadStep(uint64_t ticket, ReplayTransition& transition, uint8_t* observation, uint8_t* nextObservation) const;
+
+        // Transitions [max(0, NextTicket() - Capacity()), NextTicket()) may be available
+        uint64_t NextTicket() const;
+        uint32_t Capacity() const;
+        uint32_t ObservationSize() const;
+
+    private:
+        SharedReplayBuffer(std::unique_ptr<Platform::SharedMemory> memory);
+
+        std::unique_ptr<Platform::SharedMemory> _memory;
+        ReplayBufferHeader* _header;
+        ReplayBufferCursor* _cursor;
+        uint8_t* _slots;
+
+        ReplaySlotHeader& Slot(uint64_t ticket) const;
+        static uint64_t SlotStride(uint32_t observationSize);
+    };
+}
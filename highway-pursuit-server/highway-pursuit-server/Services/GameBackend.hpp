@@ -0,0 +1,24 @@
+#pragma once
+#include "IEpisodeService.hpp"
+#include "IInputService.hpp"
+#include "IRenderingService.hpp"
+#include "IScoreService.hpp"
+#include "IStateService.hpp"
+#include "IUpdateService.hpp"
+
+namespace Services
+{
+    // Owns the services the server drives, either hooked into the game or simulated
+    class GameBackend
+    {
+    public:
+        virtual ~GameBackend() = default;
+
+        virtual IEpisodeService& Episode() = 0;
+        virtual IScoreService& Score() = 0;
+        virtual IInputService& Input() = 0;
+        virtual IRenderingService& Rendering() = 0;
+        virtual IUpdateService& Update() = 0;
+        virtual IStateService& State() = 0;
+    };
+}
@@ -0,0 +1,16 @@
+#pragma once
+#include "../Data/ServerTypes.hpp"
+
+namespace Services
+{
+    class IEpisodeService
+    {
+    public:
+        virtual ~IEpisodeService() = default;
+
+        virtual void NewGame() = 0;
+        virtual void NewLife() = 0;
+        // Returns true once if a life was lost since the last call
+        virtual bool PullTerminated() = 0;
+    };
+}
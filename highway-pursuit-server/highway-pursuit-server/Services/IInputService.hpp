@@ -0,0 +1,17 @@
+#pragma once
+#include "../Data/ServerTypes.hpp"
+
+namespace Services
+{
+    class IInputService
+    {
+    public:
+        virtual ~IInputService() = default;
+
+        virtual int GetInputCount() = 0;
+        // Called once the game is initialized (bindings loaded), before any input is set
+        virtual void LoadBindings() = 0;
+        // Inputs are held until the next call
+        virtual void SetInput(const Data::InputSet& inputs) = 0;
+    };
+}
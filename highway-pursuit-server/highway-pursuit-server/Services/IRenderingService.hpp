@@ -0,0 +1,17 @@
+#pragma once
+#include "../Data/ServerTypes.hpp"
+#include "../Utils/FunctionRef.hpp"
+
+namespace Services
+{
+    class IRenderingService
+    {
+    public:
+        virtual ~IRenderingService() = default;
+
+        virtual Data::BufferFormat GetBufferFormat() = 0;
+        virtual void ResetZoomLevel() = 0;
+        // The pixel data is only valid during the handler call
+        virtual void Screenshot(Utils::FunctionRef<void(void*, const Data::BufferFormat&)> pixelDataHandler) = 0;
+    };
+}
@@ -0,0 +1,14 @@
+#pragma once
+#include "../Data/ServerTypes.hpp"
+
+namespace Services
+{
+    class IScoreService
+    {
+    public:
+        virtual ~IScoreService() = default;
+
+        // Returns the score gained since the last call
+        virtual uint32_t PullReward() = 0;
+    };
+}
@@ -0,0 +1,24 @@
+#pragma once
+#include "../Data/ServerTypes.hpp"
+
+namespace Services
+{
+    class IStateService
+    {
+    public:
+        virtual ~IStateService() = default;
+
+        // Number of snapshot slots, 0 if the backend can't snapshot
+        virtual uint32_t GetSnapshotSlotCount() = 0;
+        // Only called between two game updates, the game is paused
+        virtual void Capture(uint32_t slot) = 0;
+        // false if the slot can't be restored any more, the game is left untouched
+        virtual bool Restore(uint32_t slot) = 0;
+        // Startup image: the state once the intro is skipped, persisted by the first instance and loaded by the next ones.
+        // Only called before the first capture. Save returns false if the backend can't persist its state (the injected game when the intro
+        // allocated memory outside the tracked regions). Load returns false if there is no image or if it doesn't match
+        // this game and configuration.
+        virtual bool SaveImage(const std::string& /*path*/) { return false; }
+        virtual bool LoadImage(const std::string& /*path*/) { return false; }
+    };
+}
@@ -0,0 +1,16 @@
+#pragma once
+#include "../Data/ServerTypes.hpp"
+
+namespace Services
+{
+    class IUpdateService
+    {
+    public:
+        virtual ~IUpdateService() = default;
+
+        virtual void EnableCustomTime() = 0;
+        virtual void UpdateTime() = 0;
+        // Lets the game run one update, returns false if it didn't complete before the timeout
+        virtual bool WaitUpdate(uint32_t timeoutMs) = 0;
+    };
+}
@@ -0,0 +1,312 @@
+#include "../pch.h"
+#include "PageTracker.hpp"
+#include "../Platform/Platform.hpp"
+#include <algorithm>
+
+namespace Snapshot
+{
+    std::atomic<PageTracker*> PageTracker::Tracking[PageTracker::MAX_TRACKING] = {};
+
+    PageTracker::PageTracker(bool useWriteProtection)
+        : _useWriteProtection(useWriteProtection),
+        _pageSize(Platform::GetPageSize()),
+        _pageCount(0),
+        _isTracking(false),
+        _trackingSlot(MAX_TRACKING)
+    {
+    }
+
+    PageTracker::~PageTracker()
+    {
+        Stop();
+    }
+
+    void PageTracker::AddRegion(void* base, size_t size, WriteDetection detection)
+    {
+        if (_isTracking)
+        {
+            throw std::runtime_error("Regions can't be added while tracking");
+        }
+        if (size == 0)
+        {
+            return;
+        }
+
+        uintptr_t begin = reinterpret_cast<uintptr_t>(base) & ~(_pageSize - 1);
+        uintptr_t end = (reinterpret_cast<uintptr_t>(base) + size + _pageSize - 1) & ~(_pageSize - 1);
+        for (const Region& region : _regions)
+        {
+            if (begin < region.end && region.begin < end)
+            {
+                throw std::runtime_error("Overlapping snapshot regions");
+            }
+        }
+        if (detection == WriteDetection::WRITE_PROTECT && !_useWriteProtection)
+        {
+            detection = WriteDetection::NONE;
+        }
+        std::vector<void*> writtenPages(detection == WriteDetection::WRITE_WATCH ? (end - begin) / _pageSize : 0);
+        _regions.push_back(Region{ begin, end, 0, detection, std::move(writtenPages) });
+
+        // Keep the regions sorted for the lookups of the fault handler
+        std::sort(_regions.begin(), _regions.end(), [](const Region& a, const Region& b) { return a.begin < b.begin; });
+        _pageCount = 0;
+        for (Region& region : _regions)
+        {
+            region.firstPage = _pageCount;
+            _pageCount += (region.end - region.begin) / _pageSize;
+        }
+
+        _dirty.reset(new std::atomic<uint8_t>[_pageCount]);
+        for (size_t page = 0; page < _pageCount; ++page)
+        {
+            _dirty[page] = 1;
+        }
+    }
+
+    size_t PageTracker::PageCount() const
+    {
+        return _pageCount;
+    }
+
+    size_t PageTracker::PageSize() const
+    {
+        return _pageSize;
+    }
+
+    uint8_t* PageTracker::PageAddress(size_t page) const
+    {
+        const Region& region = RegionOfPage(page);
+        return reinterpret_cast<uint8_t*>(region.begin + (page - region.firstPage) * _pageSize);
+    }
+
+    void PageTracker::Start()
+    {
+        if (_isTracking)
+        {
+            return;
+        }
+
+        bool writeProtects = std::any_of(_regions.begin(), _regions.end(),
+            [](const Region& region) { return region.detection == WriteDetection::WRITE_PROTECT; });
+        if (writeProtects)
+        {
+            for (size_t slot = 0; slot < MAX_TRACKING && _trackingSlot == MAX_TRACKING; ++slot)
+            {
+                PageTracker* expected = nullptr;
+                if (Tracking[slot].compare_exchange_strong(expected, this))
+                {
+                    _trackingSlot = slot;
+                }
+            }
+            if (_trackingSlot == MAX_TRACKING)
+            {
+                throw std::runtime_error("Too many page trackers are write-protecting at once");
+            }
+            Platform::InstallWriteFaultHandler(&PageTracker::OnWriteFault);
+        }
+
+        for (const Region& region : _regions)
+        {
+            size_t regionPages = (region.end - region.begin) / _pageSize;
+            for (size_t page = region.firstPage; page < region.firstPage + regionPages; ++page)
+            {
+                _dirty[page] = region.detection == WriteDetection::NONE ? 1 : 0;
+            }
+        }
+
+        // Faults can happen as soon as the first region is protected
+        _isTracking = true;
+        for (const Region& region : _regions)
+        {
+            void* begin = reinterpret_cast<void*>(region.begin);
+            bool started = true;
+            if (region.detection == WriteDetection::WRITE_PROTECT)
+            {
+                started = Platform::ProtectPages(begin, region.end - region.begin, false);
+            }
+            else if (region.detection == WriteDetection::WRITE_WATCH)
+            {
+                started = Platform::ResetWrittenPages(begin, region.end - region.begin);
+            }
+            if (!started)
+            {
+                Stop();
+                throw std::runtime_error("Couldn't start tracking the writes to the snapshot regions");
+            }
+        }
+    }
+
+    void PageTracker::Stop()
+    {
+        if (_isTracking)
+        {
+            for (const Region& region : _regions)
+            {
+                if (region.detection == WriteDetection::WRITE_PROTECT)
+                {
+                    Platform::ProtectPages(reinterpret_cast<void*>(region.begin), region.end - region.begin, true);
+                }
+            }
+        }
+        for (size_t page = 0; page < _pageCount; ++page)
+        {
+            _dirty[page] = 1;
+        }
+
+        if (_trackingSlot != MAX_TRACKING)
+        {
+            Tracking[_trackingSlot].store(nullptr);
+            _trackingSlot = MAX_TRACKING;
+        }
+        _isTracking = false;
+    }
+
+    bool PageTracker::IsTracking() const
+    {
+        return _isTracking;
+    }
+
+    void PageTracker::CollectWrites()
+    {
+        if (!_isTracking)
+        {
+            return;
+        }
+        for (Region& region : _regions)
+        {
+            if (region.detection != WriteDetection::WRITE_WATCH)
+            {
+                continue;
+            }
+
+            size_t count = region.writtenPages.size();
+            if (!Platform::CollectWrittenPages(reinterpret_cast<void*>(region.begin), region.end - region.begin, region.writtenPages.data(), count))
+            {
+                throw std::runtime_error("Couldn't read the writes to a snapshot region");
+            }
+            for (size_t i = 0; i < count; ++i)
+            {
+                uintptr_t page = reinterpret_cast<uintptr_t>(region.writtenPages[i]);
+                _dirty[region.firstPage + (page - region.begin) / _pageSize].store(1, std::memory_order_release);
+            }
+        }
+    }
+
+    bool PageTracker::IsDirty(size_t page) const
+    {
+        return _dirty[page].load(std::memory_order_acquire) != 0;
+    }
+
+    bool PageTracker::IsWatched(size_t page) const
+    {
+        return RegionOfPage(page).detection != WriteDetection::NONE;
+    }
+
+    void PageTracker::ForEachDirtyPage(Utils::FunctionRef<void(size_t)> handler) const
+    {
+        for (size_t page = 0; page < _pageCount; ++page)
+        {
+            if (IsDirty(page))
+            {
+                handler(page);
+            }
+        }
+    }
+
+    void PageTracker::Clean(size_t page)
+    {
+        const Region& region = RegionOfPage(page);
+        if (!_isTracking || region.detection == WriteDetection::NONE)
+        {
+            return;
+        }
+        if (region.detection == WriteDetection::WRITE_PROTECT)
+        {
+            Platform::ProtectPages(PageAddress(page), _pageSize, false);
+        }
+        else
+        {
+            Platform::ResetWrittenPages(PageAddress(page), _pageSize);
+        }
+        _dirty[page].store(0, std::memory_order_release);
+    }
+
+    void PageTracker::MakeWritable(size_t page)
+    {
+        if (!_isTracking || IsDirty(page))
+        {
+            return;
+        }
+        _dirty[page].store(1, std::memory_order_release);
+        if (RegionOfPage(page).detection == WriteDetection::WRITE_PROTECT)
+        {
+            Platform::ProtectPages(PageAddress(page), _pageSize, true);
+        }
+    }
+
+    bool PageTracker::HandleWriteFault(uintptr_t address)
+    {
+        const Region* region = FindRegion(address);
+        if (region == nullptr || region->detection != WriteDetection::WRITE_PROTECT)
+        {
+            return false;
+        }
+
+        // Mark first, the write happens as soon as the page is writable
+        uintptr_t pageBegin = address & ~(_pageSize - 1);
+        size_t page = region->firstPage + (pageBegin - region->begin) / _pageSize;
+        _dirty[page].store(1, std::memory_order_release);
+        return Platform::ProtectPages(reinterpret_cast<void*>(pageBegin), _pageSize, true);
+    }
+
+    const PageTracker::Region* PageTracker::FindRegion(uintptr_t address) const
+    {
+        // Binary search without allocating, this runs in the fault handler
+        size_t low = 0;
+        size_t high = _regions.size();
+        while (low < high)
+        {
+            size_t middle = (low + high) / 2;
+            const Region& region = _regions[middle];
+            if (address < region.begin)
+            {
+                high = middle;
+            }
+            else if (address >= region.end)
+            {
+                low = middle + 1;
+            }
+            else
+            {
+                return &region;
+            }
+        }
+        return nullptr;
+    }
+
+    const PageTracker::Region& PageTracker::RegionOfPage(size_t page) const
+    {
+        if (page >= _pageCount)
+        {
+            throw std::out_of_range("Invalid page index");
+        }
+        // Last region starting at or before the page, the regions are sorted by first page too
+        auto next = std::upper_bound(_regions.begin(), _regions.end(), page, [](size_t page, const Region& region) { return page < region.firstPage; });
+        return *(next - 1);
+    }
+
+    bool PageTracker::OnWriteFault(void* address)
+    {
+        // Trackers track disjoint memory, at most one of them handles the fault
+        for (std::atomic<PageTracker*>& slot : Tracking)
+        {
+            PageTracker* tracker = slot.load(std::memory_order_acquire);
+            if (tracker != nullptr && tracker->_isTracking && tracker->HandleWriteFault(reinterpret_cast<uintptr_t>(address)))
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+}
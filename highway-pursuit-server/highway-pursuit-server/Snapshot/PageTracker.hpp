@@ -0,0 +1,77 @@
+#pragma once
+#include "../pch.h"
+#include "../Utils/FunctionRef.hpp"
+
+namespace Snapshot
+{
+    // How the writes to a tracked region are detected
+    enum class WriteDetection
+    {
+        // The pages are write-protected and the first write to each page faults. Only for memory written from user mode:
+        // a system call writing to a protected page (ReadFile, Win32 out parameters) fails with ERROR_NOACCESS instead of faulting
+        WRITE_PROTECT,
+        // The system records the written pages, system calls included. Windows only, for memory allocated with MEM_WRITE_WATCH
+        WRITE_WATCH,
+        // Nothing detects the writes, the pages are always dirty and are compared on restore
+        NONE
+    };
+
+    // Records which pages of a set of memory regions are written. Several trackers can track at once in a process,
+    // up to MAX_TRACKING of them with write-protected regions (the fault handler is process-wide and looks the address up in each).
+    class PageTracker
+    {
+    public:
+        static constexpr size_t MAX_TRACKING = 64;
+
+        // Without write protection the WRITE_PROTECT regions are tracked as NONE
+        PageTracker(bool useWriteProtection);
+        ~PageTracker();
+
+        // Regions are rounded out to whole pages, they can only be added before tracking starts
+        void AddRegion(void* base, size_t size, WriteDetection detection = WriteDetection::WRITE_PROTECT);
+        size_t PageCount() const;
+        size_t PageSize() const;
+        uint8_t* PageAddress(size_t page) const;
+
+        // Write-protects or resets the watch of the pages and marks them clean, except the NONE ones
+        void Start();
+        void Stop();
+        bool IsTracking() const;
+
+        // Marks the pages written since the last collect in the WRITE_WATCH regions as dirty, call before reading the dirty pages
+        void CollectWrites();
+        bool IsDirty(size_t page) const;
+        // False for the pages of the NONE regions, which are always dirty
+        bool IsWatched(size_t page) const;
+        void ForEachDirtyPage(Utils::FunctionRef<void(size_t)> handler) const;
+        // Write-protects the page again or resets its watch, the memory must not be written concurrently. NONE pages stay dirty
+        void Clean(size_t page);
+        // Lets the caller write the page without faulting, the page is then dirty
+        void MakeWritable(size_t page);
+
+    private:
+        struct Region
+        {
+            uintptr_t begin; // page aligned
+            uintptr_t end; // page aligned, exclusive
+            size_t firstPage; // index of the first page of the region among all the tracked pages
+            WriteDetection detection;
+            std::vector<void*> writtenPages; // collected pages of a WRITE_WATCH region, allocated with the region
+        };
+
+        const bool _useWriteProtection;
+        const size_t _pageSize;
+        std::vector<Region> _regions; // sorted by address
+        size_t _pageCount;
+        std::unique_ptr<std::atomic<uint8_t>[]> _dirty;
+        std::atomic<bool> _isTracking; // read by the fault handler
+        size_t _trackingSlot; // in Tracking, MAX_TRACKING if not registered
+
+        bool HandleWriteFault(uintptr_t address);
+        const Region* FindRegion(uintptr_t address) const;
+        const Region& RegionOfPage(size_t page) const;
+
+        static std::atomic<PageTracker*> Tracking[MAX_TRACKING]; // trackers with write-protected regions
+        static bool OnWriteFault(void* address);
+    };
+}
@@ -0,0 +1,382 @@
+#include "../pch.h"
+#include "SnapshotEngine.hpp"
+#include "../Platform/Platform.hpp"
+#include <filesystem>
+#include <random>
+
+namespace Snapshot
+{
+    namespace
+    {
+        constexpr char IMAGE_MAGIC[8] = { 'H', 'P', 'S', 'T', 'A', 'R', 'T', '3' };
+        constexpr uint64_t IMAGE_HAS_BASELINE = 1; // the baseline of the writer follows the pages
+        constexpr uint64_t IMAGE_VALIDATED = 2; // matched the memory another process reached on its own
+
+        struct ImageHeader
+        {
+            char magic[8];
+            uint32_t pageSize;
+            uint32_t regionCount;
+            uint64_t key;
+            uint64_t userData;
+            uint64_t pageCount;
+            uint64_t dataOffset; // of the pages, page aligned so that they can be mapped
+            uint64_t flags;
+        };
+
+        // A tracked region, in the order of the calls to TrackRegion. Followed in the file by its pages
+        struct ImageRegion
+        {
+            uint64_t pageOffset; // of the region in its first page
+            uint64_t size;
+
+            bool operator==(const ImageRegion& other) const
+            {
+                return pageOffset == other.pageOffset && size == other.size;
+            }
+        };
+
+        template <typename Regions>
+        std::vector<ImageRegion> Layout(const Regions& regions, size_t pageSize)
+        {
+            std::vector<ImageRegion> layout;
+            for (const auto& region : regions)
+            {
+                layout.push_back(ImageRegion{ region.base & (pageSize - 1), region.size });
+            }
+            return layout;
+        }
+
+        // Checks the header and the regions against the tracked ones
+        bool ReadHeader(std::ifstream& file, uint64_t key, const std::vector<ImageRegion>& layout, size_t pageSize, size_t pageCount, ImageHeader& header)
+        {
+            if (!file.read(reinterpret_cast<char*>(&header), sizeof(header)) || std::memcmp(header.magic, IMAGE_MAGIC, sizeof(IMAGE_MAGIC)) != 0
+                || header.pageSize != pageSize || header.key != key || header.pageCount != pageCount)
+            {
+                return false;
+            }
+            std::vector<ImageRegion> regions(header.regionCount);
+            if (!file.read(reinterpret_cast<char*>(regions.data()), regions.size() * sizeof(ImageRegion)) || regions != layout)
+            {
+                return false;
+            }
+            // A truncated file would fault on access instead of failing here
+            uint64_t dataSize = header.pageCount * header.pageSize * ((header.flags & IMAGE_HAS_BASELINE) != 0 ? 2 : 1);
+            file.seekg(0, std::ios::end);
+            return static_cast<uint64_t>(file.tellg()) >= header.dataOffset + dataSize;
+        }
+
+        // The pages of the image with the values of the writer's process replaced by the ones of this process: the words that differ
+        // between the two baselines take the value of this baseline. False if the writer changed such a word after its baseline,
+        // its new value (an object it created since) has no counterpart here
+        bool ReadRelocated(std::ifstream& file, const ImageHeader& header, const std::vector<uint8_t>& baseline, std::vector<uint8_t>& pages)
+        {
+            std::vector<uint8_t> writerBaseline(baseline.size());
+            pages.resize(baseline.size());
+            file.seekg(header.dataOffset);
+            if (!file.read(reinterpret_cast<char*>(pages.data()), pages.size()) || !file.read(reinterpret_cast<char*>(writerBaseline.data()), writerBaseline.size()))
+            {
+                return false;
+            }
+            // Pointers and handles are aligned
+            for (size_t offset = 0; offset < pages.size(); offset += sizeof(uint32_t))
+            {
+                uint32_t writerValue;
+                uint32_t value;
+                std::memcpy(&writerValue, writerBaseline.data() + offset, sizeof(uint32_t));
+                std::memcpy(&value, baseline.data() + offset, sizeof(uint32_t));
+                if (writerValue == value)
+                {
+                    continue;
+                }
+                if (std::memcmp(pages.data() + offset, &writerValue, sizeof(uint32_t)) != 0)
+                {
+                    return false;
+                }
+                std::memcpy(pages.data() + offset, &value, sizeof(uint32_t));
+            }
+            return true;
+        }
+    }
+
+    SnapshotEngine::SnapshotEngine(uint32_t slotCount, bool useWriteProtection)
+        : _tracker(useWriteProtection),
+        _images(slotCount),
+        _syncedSlot(NO_SLOT)
+    {
+    }
+
+    void SnapshotEngine::TrackRegion(void* base, size_t size, WriteDetection detection)
+    {
+        _tracker.AddRegion(base, size, detection);
+        if (size > 0)
+        {
+            _regions.push_back(TrackedRegion{ reinterpret_cast<uintptr_t>(base), size });
+        }
+    }
+
+    bool SnapshotEngine::HasRegions() const
+    {
+        return _tracker.PageCount() > 0;
+    }
+
+    void SnapshotEngine::Capture(uint32_t slot)
+    {
+        CheckSlot(slot);
+        size_t pageSize = _tracker.PageSize();
+        std::vector<uint8_t>& image = _images[slot];
+        _tracker.CollectWrites();
+
+        if (image.empty() || slot != _syncedSlot || !_tracker.IsTracking())
+        {
+            // Full copy, reads are allowed on protected pages
+            image.resize(ImageSize());
+            for (size_t page = 0; page < _tracker.PageCount(); ++page)
+            {
+                std::memcpy(image.data() + page * pageSize, _tracker.PageAddress(page), pageSize);
+            }
+        }
+        else
+        {
+            // The image already holds the clean pages
+            _tracker.ForEachDirtyPage([&](size_t page)
+                {
+                    std::memcpy(image.data() + page * pageSize, _tracker.PageAddress(page), pageSize);
+                }
+            );
+        }
+
+        if (_tracker.IsTracking())
+        {
+            _tracker.ForEachDirtyPage([this](size_t page) { _tracker.Clean(page); });
+        }
+        else
+        {
+            _tracker.Start();
+        }
+        _syncedSlot = slot;
+    }
+
+    RestoreStats SnapshotEngine::Restore(uint32_t slot)
+    {
+        CheckSlot(slot);
+        if (!HasSnapshot(slot))
+        {
+            throw Data::HighwayPursuitException(Data::ErrorCode::INVALID_SNAPSHOT);
+        }
+
+        size_t pageSize = _tracker.PageSize();
+        const uint8_t* image = _images[slot].data();
+        RestoreStats stats{ 0, 0 };
+        _tracker.CollectWrites();
+
+        if (slot == _syncedSlot && _tracker.IsTracking())
+        {
+            // Dirty pages are already writable (unprotected by the fault handler), the ones whose writes aren't detected are compared
+            _tracker.ForEachDirtyPage([&](size_t page)
+                {
+                    uint8_t* address = _tracker.PageAddress(page);
+                    const uint8_t* saved = image + page * pageSize;
+                    bool watched = _tracker.IsWatched(page);
+                    stats.comparedPages += watched ? 0 : 1;
+                    if (watched || std::memcmp(address, saved, pageSize) != 0)
+                    {
+                        std::memcpy(address, saved, pageSize);
+                        stats.copiedPages++;
+                    }
+                    _tracker.Clean(page);
+                }
+            );
+        }
+        else
+        {
+            // Diff against the image, only the pages that differ are written
+            for (size_t page = 0; page < _tracker.PageCount(); ++page)
+            {
+                uint8_t* address = _tracker.PageAddress(page);
+                const uint8_t* saved = image + page * pageSize;
+                stats.comparedPages++;
+                if (std::memcmp(address, saved, pageSize) != 0)
+                {
+                    _tracker.MakeWritable(page);
+                    std::memcpy(address, saved, pageSize);
+                    stats.copiedPages++;
+                }
+                if (_tracker.IsDirty(page))
+                {
+                    _tracker.Clean(page);
+                }
+            }
+        }
+
+        _syncedSlot = slot;
+        return stats;
+    }
+
+    bool SnapshotEngine::HasSnapshot(uint32_t slot) const
+    {
+        return slot < _images.size() && !_images[slot].empty();
+    }
+
+    uint32_t SnapshotEngine::SlotCount() const
+    {
+        return static_cast<uint32_t>(_images.size());
+    }
+
+    size_t SnapshotEngine::ImageSize() const
+    {
+        return _tracker.PageCount() * _tracker.PageSize();
+    }
+
+    std::vector<uint8_t> SnapshotEngine::ReadMemory() const
+    {
+        std::vector<uint8_t> memory;
+        memory.reserve(ImageSize());
+        for (const TrackedRegion& region : _regions)
+        {
+            const uint8_t* firstPage = FirstPage(region);
+            memory.insert(memory.end(), firstPage, firstPage + PageCount(region) * _tracker.PageSize());
+        }
+        return memory;
+    }
+
+    void SnapshotEngine::SaveImage(const std::string& path, uint64_t key, uint64_t userData, const std::vector<uint8_t>& baseline, bool validated) const
+    {
+        if (!baseline.empty() && baseline.size() != ImageSize())
+        {
+            throw std::runtime_error("The baseline of the startup image doesn't match the tracked memory");
+        }
+        size_t pageSize = _tracker.PageSize();
+        std::vector<ImageRegion> regions = Layout(_regions, pageSize);
+        ImageHeader header{};
+        std::memcpy(header.magic, IMAGE_MAGIC, sizeof(IMAGE_MAGIC));
+        header.pageSize = static_cast<uint32_t>(pageSize);
+        header.regionCount = static_cast<uint32_t>(regions.size());
+        header.key = key;
+        header.userData = userData;
+        header.pageCount = _tracker.PageCount();
+        size_t tableEnd = sizeof(ImageHeader) + regions.size() * sizeof(ImageRegion);
+        header.dataOffset = (tableEnd + pageSize - 1) / pageSize * pageSize;
+        header.flags = (baseline.empty() ? 0 : IMAGE_HAS_BASELINE) | (validated ? IMAGE_VALIDATED : 0);
+
+        // Instances started together can write the same image, the rename makes the last one win without torn files
+        std::string temporaryPath = path + "." + std::to_string(std::random_device()()) + ".tmp";
+        {
+            std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+            if (!file)
+            {
+                throw std::runtime_error("Couldn't open " + temporaryPath);
+            }
+            file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            file.write(reinterpret_cast<const char*>(regions.data()), regions.size() * sizeof(ImageRegion));
+            std::vector<char> padding(header.dataOffset - tableEnd, 0);
+            file.write(padding.data(), padding.size());
+            // Reads are allowed on protected pages
+            for (const TrackedRegion& region : _regions)
+            {
+                file.write(reinterpret_cast<const char*>(FirstPage(region)), PageCount(region) * pageSize);
+            }
+            file.write(reinterpret_cast<const char*>(baseline.data()), baseline.size());
+            if (!file)
+            {
+                throw std::runtime_error("Couldn't write " + temporaryPath);
+            }
+        }
+        std::error_code error;
+        std::filesystem::rename(temporaryPath, path, error);
+        if (error)
+        {
+            std::filesystem::remove(temporaryPath, error);
+            throw std::runtime_error("Couldn't replace " + path);
+        }
+    }
+
+    bool SnapshotEngine::LoadImage(const std::string& path, uint64_t key, uint64_t& userData, const std::vector<uint8_t>& baseline)
+    {
+        if (_tracker.IsTracking())
+        {
+            throw std::runtime_error("Startup images are loaded before the first snapshot");
+        }
+
+        size_t pageSize = _tracker.PageSize();
+        std::ifstream file(path, std::ios::binary);
+        ImageHeader header{};
+        if (!ReadHeader(file, key, Layout(_regions, pageSize), pageSize, _tracker.PageCount(), header))
+        {
+            return false;
+        }
+        // A relocatable image is only loaded with a baseline, once another process validated it
+        bool hasBaseline = (header.flags & IMAGE_HAS_BASELINE) != 0;
+        if (hasBaseline == baseline.empty() || (hasBaseline && ((header.flags & IMAGE_VALIDATED) == 0 || baseline.size() != ImageSize())))
+        {
+            return false;
+        }
+
+        if (hasBaseline)
+        {
+            std::vector<uint8_t> pages;
+            if (!ReadRelocated(file, header, baseline, pages))
+            {
+                return false;
+            }
+            // Nothing is write-protected before the first capture
+            size_t offset = 0;
+            for (const TrackedRegion& region : _regions)
+            {
+                size_t size = PageCount(region) * pageSize;
+                std::memcpy(FirstPage(region), pages.data() + offset, size);
+                offset += size;
+            }
+        }
+        else
+        {
+            file.close();
+            uint64_t offset = header.dataOffset;
+            for (const TrackedRegion& region : _regions)
+            {
+                size_t size = PageCount(region) * pageSize;
+                if (!Platform::MapFileCopyOnWrite(path, offset, FirstPage(region), size))
+                {
+                    // The regions before are already replaced
+                    throw std::runtime_error("Couldn't map the startup image " + path);
+                }
+                offset += size;
+            }
+        }
+        userData = header.userData;
+        return true;
+    }
+
+    bool SnapshotEngine::MatchesImage(const std::string& path, uint64_t key, const std::vector<uint8_t>& baseline) const
+    {
+        size_t pageSize = _tracker.PageSize();
+        std::ifstream file(path, std::ios::binary);
+        ImageHeader header{};
+        if (!ReadHeader(file, key, Layout(_regions, pageSize), pageSize, _tracker.PageCount(), header)
+            || (header.flags & IMAGE_HAS_BASELINE) == 0 || baseline.size() != ImageSize())
+        {
+            return false;
+        }
+        std::vector<uint8_t> pages;
+        return ReadRelocated(file, header, baseline, pages) && pages == ReadMemory();
+    }
+
+    void SnapshotEngine::CheckSlot(uint32_t slot) const
+    {
+        if (slot >= _images.size())
+        {
+            throw Data::HighwayPursuitException(Data::ErrorCode::INVALID_SNAPSHOT);
+        }
+    }
+
+    uint8_t* SnapshotEngine::FirstPage(const TrackedRegion& region) const
+    {
+        return reinterpret_cast<uint8_t*>(region.base & ~(_tracker.PageSize() - 1));
+    }
+
+    size_t SnapshotEngine::PageCount(const TrackedRegion& region) const
+    {
+        size_t pageSize = _tracker.PageSize();
+        return ((region.base & (pageSize - 1)) + region.size + pageSize - 1) / pageSize;
+    }
+}
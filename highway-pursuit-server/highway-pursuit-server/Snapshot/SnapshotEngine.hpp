@@ -0,0 +1,70 @@
+#pragma once
+#include "../Data/ServerTypes.hpp"
+#include "PageTracker.hpp"
+
+namespace Snapshot
+{
+    struct RestoreStats
+    {
+        size_t comparedPages;
+        size_t copiedPages;
+    };
+
+    // Captures a set of memory regions into page images (one per slot) and restores them in place.
+    // The tracked memory must not be written by other threads during Capture/Restore.
+    class SnapshotEngine
+    {
+    public:
+        SnapshotEngine(uint32_t slotCount, bool useWriteProtection);
+
+        // Regions are fixed once the first snapshot is captured
+        void TrackRegion(void* base, size_t size, WriteDetection detection = WriteDetection::WRITE_PROTECT);
+        bool HasRegions() const;
+
+        void Capture(uint32_t slot);
+        // Copies back only the pages written since the slot was captured/restored, or the pages that differ when
+        // another slot was used since (or whose writes aren't detected)
+        RestoreStats Restore(uint32_t slot);
+        bool HasSnapshot(uint32_t slot) const;
+        uint32_t SlotCount() const;
+        // Size of one image in bytes
+        size_t ImageSize() const;
+
+        // The tracked memory in the order of the image
+        std::vector<uint8_t> ReadMemory() const;
+
+        // Startup image: the tracked memory persisted to a file with the layout of the regions, key identifies the game and its configuration.
+        // The regions are identified by the order they were tracked in, their size and their offset in their first page, not by their
+        // address: the image loads in another process whose allocations landed elsewhere.
+        // userData is kept along (state of the backend outside the tracked memory). Written to a temporary file first, then renamed.
+        // Memory holding values of its process (pointers to objects outside the tracked memory, handles) is saved with a baseline: the memory
+        // (ReadMemory) at the same point of the boot of every process, before the state the image skips to. Such an image only loads once
+        // validated, when another process reached the same memory on its own (MatchesImage).
+        void SaveImage(const std::string& path, uint64_t key, uint64_t userData, const std::vector<uint8_t>& baseline = {}, bool validated = false) const;
+        // Maps the pages of the file copy-on-write onto the tracked memory, only before the first capture. With a baseline, copies the pages
+        // relocated to this process instead: the words that differ between the baseline of the writer and this one take this value.
+        // Returns false if there is no image, if it was saved from another key or layout, without a baseline or not validated when one is
+        // given, or if it can't be relocated. The memory is then untouched.
+        bool LoadImage(const std::string& path, uint64_t key, uint64_t& userData, const std::vector<uint8_t>& baseline = {});
+        // The image saved with a baseline, relocated to this one, equals the tracked memory
+        bool MatchesImage(const std::string& path, uint64_t key, const std::vector<uint8_t>& baseline) const;
+
+    private:
+        static constexpr int64_t NO_SLOT = -1;
+
+        struct TrackedRegion
+        {
+            uintptr_t base;
+            size_t size;
+        };
+
+        PageTracker _tracker;
+        std::vector<TrackedRegion> _regions; // in the order they were tracked
+        std::vector<std::vector<uint8_t>> _images;
+        int64_t _syncedSlot; // memory equals this image except for the dirty pages
+
+        void CheckSlot(uint32_t slot) const;
+        uint8_t* FirstPage(const TrackedRegion& region) const;
+        size_t PageCount(const TrackedRegion& region) const;
+    };
+}
@@ -0,0 +1,104 @@
+#include "../pch.h"
+#include "SpectatorTap.hpp"
+#include "../Observation/ObservationKernels.hpp"
+
+namespace Spectator
+{
+    size_t SpectatorTap::SectionSize(uint32_t observationSize)
+    {
+        return sizeof(SpectatorHeader) + sizeof(SpectatorFrame) + observationSize;
+    }
+
+    std::unique_ptr<SpectatorTap> SpectatorTap::Create(const std::string& name, const Data::BufferFormat& format)
+    {
+        // New sections are zeroed: the sequence says that nothing was published
+        uint32_t observationSize = format.width * format.height * format.channels;
+        std::unique_ptr<Platform::SharedMemory> memory = Platform::SharedMemory::Create(name, SectionSize(observationSize));
+        new (memory->Data()) SpectatorHeader{ SpectatorHeader::MAGIC, SpectatorHeader::VERSION, format.width, format.height, format.channels, observationSize };
+        return std::unique_ptr<SpectatorTap>(new SpectatorTap(std::move(memory)));
+    }
+
+    std::unique_ptr<SpectatorTap> SpectatorTap::Open(const std::string& name)
+    {
+        // The header gives the size of the whole section
+        SpectatorHeader header;
+        {
+            std::unique_ptr<Platform::SharedMemory> headerMemory = Platform::SharedMemory::Open(name, sizeof(SpectatorHeader));
+            std::memcpy(&header, headerMemory->Data(), sizeof(header));
+        }
+        if (header.magic != SpectatorHeader::MAGIC || header.version != SpectatorHeader::VERSION
+            || header.observationSize != header.width * header.height * header.channels)
+        {
+            throw std::runtime_error(name + " isn't a spectator tap of this version");
+        }
+
+        std::unique_ptr<Platform::SharedMemory> memory = Platform::SharedMemory::Open(name, SectionSize(header.observationSize));
+        return std::unique_ptr<SpectatorTap>(new SpectatorTap(std::move(memory)));
+    }
+
+    SpectatorTap::SpectatorTap(std::unique_ptr<Platform::SharedMemory> memory)
+        : _memory(std::move(memory))
+    {
+        uint8_t* base = static_cast<uint8_t*>(_memory->Data());
+        _header = reinterpret_cast<SpectatorHeader*>(base);
+        _frame = reinterpret_cast<SpectatorFrame*>(base + sizeof(SpectatorHeader));
+        _observation = base + sizeof(SpectatorHeader) + sizeof(SpectatorFrame);
+    }
+
+    void SpectatorTap::Publish(const void* observation, SpectatorStats stats)
+    {
+        stats.checksum = Observation::Checksum(observation, _header->observationSize);
+        uint64_t sequence = _frame->sequence.load(std::memory_order_relaxed);
+        _frame->sequence.store(sequence + 1, std::memory_order_relaxed);
+
+        // Readers seeing any of the writes below also see the odd sequence
+        std::atomic_thread_fence(std::memory_order_release);
+        _frame->stats = stats;
+        std::memcpy(_observation, observation, _header->observationSize);
+
+        _frame->sequence.store(sequence + 2, std::memory_order_release);
+    }
+
+    bool SpectatorTap::TryRead(SpectatorStats& stats, uint8_t* observation, uint32_t attempts) const
+    {
+        for (uint32_t attempt = 0; attempt < attempts; ++attempt)
+        {
+            uint64_t sequence = _frame->sequence.load(std::memory_order_acquire);
+            if (sequence == 0)
+            {
+                return false;
+            }
+            if (sequence % 2 == 1)
+            {
+                std::this_thread::yield();
+                continue;
+            }
+
+            stats = _frame->stats;
+            std::memcpy(observation, _observation, _header->observationSize);
+
+            // The copy is only valid if the server didn't start another publish meanwhile
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (_frame->sequence.load(std::memory_order_relaxed) == sequence)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    uint64_t SpectatorTap::PublishedCount() const
+    {
+        return _frame->sequence.load(std::memory_order_acquire) / 2;
+    }
+
+    Data::BufferFormat SpectatorTap::Format() const
+    {
+        return Data::BufferFormat(_header->width, _header->height, _header->channels);
+    }
+
+    uint32_t SpectatorTap::ObservationSize() const
+    {
+        return _header->observationSize;
+    }
+}
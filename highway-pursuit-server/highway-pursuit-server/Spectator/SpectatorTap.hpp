@@ -0,0 +1,78 @@
+#pragma once
+#include "../Data/ServerTypes.hpp"
+#include "../Platform/Platform.hpp"
+
+// Latest observation of a server with its stats, in a shared memory section created by the server and read by any number of viewers.
+// Single writer seqlock: viewers never block the server, they copy the frame again if it was published during the copy.
+// Layout (python mirror in highway_pursuit_gym/datasets/spectator_tap.py):
+// - [0, 64): SpectatorHeader, written once
+// - [64, 128): SpectatorFrame, sequence and stats of the published frame
+// - then the observation
+namespace Spectator
+{
+    constexpr size_t CACHE_LINE_SIZE = 64;
+
+    struct alignas(CACHE_LINE_SIZE) SpectatorHeader
+    {
+        static constexpr uint32_t MAGIC = 0x50535048; // "HPSP"
+        static constexpr uint32_t VERSION = 1;
+
+        uint32_t magic;
+        uint32_t version;
+        uint32_t width;
+        uint32_t height;
+        uint32_t channels;
+        uint32_t observationSize;
+    };
+
+    struct SpectatorStats
+    {
+        uint64_t frames; // game frames since the server started
+        uint64_t steps;
+        uint64_t episodes; // finished
+        uint64_t checksum; // Observation::Checksum of the observation, lets viewers check their copy
+        float reward; // of the last step
+        float tps;
+        float serverTime;
+        float gameTime;
+        uint8_t terminated;
+        uint8_t truncated;
+    };
+
+    struct alignas(CACHE_LINE_SIZE) SpectatorFrame
+    {
+        // Seqlock: odd while the frame is written, 2 * publishes once complete, 0 before the first publish
+        std::atomic<uint64_t> sequence;
+        SpectatorStats stats;
+    };
+
+    static_assert(std::atomic<uint64_t>::is_always_lock_free, "Sequence numbers are shared between processes");
+    static_assert(sizeof(SpectatorHeader) == CACHE_LINE_SIZE && sizeof(SpectatorFrame) == CACHE_LINE_SIZE, "The layout is shared with python");
+
+    class SpectatorTap
+    {
+    public:
+        static size_t SectionSize(uint32_t observationSize);
+        // Server side, nothing is published yet
+        static std::unique_ptr<SpectatorTap> Create(const std::string& name, const Data::BufferFormat& format);
+        // Viewer side, throws if the section isn't a spectator tap of this version
+        static std::unique_ptr<SpectatorTap> Open(const std::string& name);
+
+        // Only one writer. observation holds ObservationSize() bytes, the checksum of the stats is computed here.
+        void Publish(const void* observation, SpectatorStats stats);
+        // Copies the latest frame, false if none was published yet or if every attempt overlapped a publish
+        bool TryRead(SpectatorStats& stats, uint8_t* observation, uint32_t attempts = 64) const;
+        // Frames published so far
+        uint64_t PublishedCount() const;
+        Data::BufferFormat Format() const;
+        uint32_t ObservationSize() const;
+
+    private:
+        SpectatorTap(std::unique_ptr<Platform::SharedMemory> memory);
+
+        std::unique_ptr<Platform::SharedMemory> _memory;
+        SpectatorHeader* _header;
+        SpectatorFrame* _frame;
+        uint8_t* _observation;
+    };
+}
@@ -0,0 +1,85 @@
+#include "../pch.h"
+#include "EpisodeTracker.hpp"
+
+namespace Stats
+{
+    using namespace Data;
+
+    EpisodeTracker::EpisodeTracker()
+        : _stats(nullptr),
+        _finishedCount(0),
+        _life(0),
+        _state{ EpisodeRecord{}, std::chrono::steady_clock::time_point(), 0.0f, false },
+        _lastRecord{}
+    {
+    }
+
+    void EpisodeTracker::Attach(EpisodeStats* stats)
+    {
+        _stats = stats;
+    }
+
+    void EpisodeTracker::OnReset(bool startNewGame, float gameTime)
+    {
+        _life = startNewGame ? 1 : _life + 1;
+        _state.current = EpisodeRecord{};
+        _state.current.life = _life;
+        _state.start = std::chrono::steady_clock::now();
+        _state.startGameTime = gameTime;
+        _state.running = true;
+    }
+
+    void EpisodeTracker::OnStep(float reward, uint32_t frames, const Termination& termination, float gameTime)
+    {
+        // Steps without a reset aren't part of an episode
+        if (!_state.running)
+        {
+            return;
+        }
+        _state.current.steps++;
+        _state.current.frames += frames;
+        _state.current.episodeReturn += reward;
+        if (termination.IsDone())
+        {
+            Finish(termination, gameTime);
+        }
+    }
+
+    uint64_t EpisodeTracker::FinishedCount() const
+    {
+        return _finishedCount;
+    }
+
+    const EpisodeRecord& EpisodeTracker::LastRecord() const
+    {
+        return _lastRecord;
+    }
+
+    EpisodeTracker::State EpisodeTracker::Capture() const
+    {
+        return _state;
+    }
+
+    void EpisodeTracker::Restore(const State& state)
+    {
+        _state = state;
+        _life = state.current.life;
+    }
+
+    void EpisodeTracker::Finish(const Termination& termination, float gameTime)
+    {
+        _state.running = false;
+        _state.current.index = ++_finishedCount;
+        _state.current.wallTime = std::chrono::duration<float>(std::chrono::steady_clock::now() - _state.start).count();
+        _state.current.gameTime = gameTime - _state.startGameTime;
+        _state.current.terminated = termination.terminated;
+        _state.current.truncated = termination.truncated;
+        _lastRecord = _state.current;
+        if (_stats != nullptr)
+        {
+            // The count is written last, the client only reads between instructions anyway
+            _stats->records[(_finishedCount - 1) % EpisodeStats::RING_SIZE] = _state.current;
+            _stats->finishedCount = _finishedCount;
+        }
+    }
+}
@@ -0,0 +1,43 @@
+#pragma once
+#include "../Data/ServerTypes.hpp"
+
+namespace Stats
+{
+    // Accumulates the statistics of the running episode of an environment and appends a record to its
+    // episode stats section when the episode ends. Episodes a reset interrupts aren't recorded.
+    class EpisodeTracker
+    {
+    public:
+        // Saved with the snapshots, the rollouts from a snapshot continue its episode
+        struct State
+        {
+            Data::EpisodeRecord current;
+            std::chrono::steady_clock::time_point start;
+            float startGameTime;
+            bool running;
+        };
+
+        EpisodeTracker();
+
+        // nullptr if the client didn't create the section, episodes are still counted
+        void Attach(Data::EpisodeStats* stats);
+        // gameTime is the time spent in game updates since the server started, in seconds
+        void OnReset(bool startNewGame, float gameTime);
+        void OnStep(float reward, uint32_t frames, const Data::Termination& termination, float gameTime);
+        uint64_t FinishedCount() const;
+        // Record of the episode that ended last, attached or not
+        const Data::EpisodeRecord& LastRecord() const;
+
+        State Capture() const;
+        void Restore(const State& state);
+
+    private:
+        Data::EpisodeStats* _stats;
+        uint64_t _finishedCount;
+        uint32_t _life;
+        State _state;
+        Data::EpisodeRecord _lastRecord;
+
+        void Finish(const Data::Termination& termination, float gameTime);
+    };
+}
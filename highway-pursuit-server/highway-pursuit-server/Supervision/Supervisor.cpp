@@ -0,0 +1,83 @@
+#include "../pch.h"
+#include "Supervisor.hpp"
+
+namespace Supervision
+{
+    Supervisor::Supervisor(const SupervisorParams& params)
+        : _params(params),
+        _nextId(0),
+        _stallCount(0),
+        _stopping(false),
+        _pollThread(&Supervisor::PollLoop, this)
+    {
+    }
+
+    Supervisor::~Supervisor()
+    {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _stopping = true;
+        }
+        _stopCondition.notify_all();
+        _pollThread.join();
+    }
+
+    uint64_t Supervisor::Watch(const Data::Heartbeat* heartbeat, void* returnCode, Platform::NamedSemaphore* lockClientPool)
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        uint64_t id = _nextId++;
+        _servers.push_back(WatchedServer{ id, heartbeat, returnCode, lockClientPool, heartbeat->beat.load(std::memory_order_acquire), std::chrono::steady_clock::now() });
+        return id;
+    }
+
+    void Supervisor::Unwatch(uint64_t id)
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _servers.erase(std::remove_if(_servers.begin(), _servers.end(), [id](const WatchedServer& server) { return server.id == id; }), _servers.end());
+    }
+
+    uint64_t Supervisor::StallCount() const
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _stallCount;
+    }
+
+    void Supervisor::PollLoop()
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        while (!_stopping)
+        {
+            auto now = std::chrono::steady_clock::now();
+            _servers.erase(std::remove_if(_servers.begin(), _servers.end(), [this, now](WatchedServer& server) { return Check(server, now); }), _servers.end());
+            _stopCondition.wait_for(lock, std::chrono::milliseconds(_params.pollIntervalMs), [this]() { return _stopping; });
+        }
+    }
+
+    bool Supervisor::Check(WatchedServer& server, std::chrono::steady_clock::time_point now)
+    {
+        // Waiting for the client isn't a stall, and the game's startup is covered by the launch timeouts
+        uint64_t beat = server.heartbeat->beat.load(std::memory_order_acquire);
+        auto state = static_cast<Data::HeartbeatState>(server.heartbeat->state.load(std::memory_order_acquire));
+        if (state != Data::HeartbeatState::BUSY || beat != server.lastBeat)
+        {
+            server.lastBeat = beat;
+            server.lastProgress = now;
+            return false;
+        }
+        if (now - server.lastProgress < std::chrono::milliseconds(_params.stallTimeoutMs))
+        {
+            return false;
+        }
+
+        // Killed (and exited) before the client is answered, it can't write to the sections anymore
+        uint32_t processId = server.heartbeat->processId.load(std::memory_order_relaxed);
+        if (processId != Platform::CurrentProcessId())
+        {
+            Platform::KillProcess(processId);
+        }
+        *static_cast<Data::ErrorCode*>(server.returnCode) = Data::ErrorCode::STALLED;
+        server.lockClientPool->Release();
+        _stallCount++;
+        return true;
+    }
+}
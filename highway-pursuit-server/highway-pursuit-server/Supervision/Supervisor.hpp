@@ -0,0 +1,59 @@
+#pragma once
+#include "../Data/ServerTypes.hpp"
+#include "../Platform/Platform.hpp"
+#include <algorithm>
+
+namespace Supervision
+{
+    struct SupervisorParams
+    {
+        static constexpr uint32_t DEFAULT_STALL_TIMEOUT = 500; // in ms
+
+        const uint32_t stallTimeoutMs; // a server busy without a heartbeat for that long is stalled, longer than the slowest instruction
+        const uint32_t pollIntervalMs;
+
+        SupervisorParams(uint32_t stallTimeoutMs = DEFAULT_STALL_TIMEOUT)
+            : stallTimeoutMs(stallTimeoutMs), pollIntervalMs(std::max<uint32_t>(1, stallTimeoutMs / 10))
+        {
+        }
+    };
+
+    // Watches the heartbeats of servers from a background thread. A server that stalls (or crashes) while handling an instruction
+    // is killed, and the wait of its client returns STALLED right away instead of after the game and client timeouts.
+    // Servers running in the supervisor's process aren't killed.
+    class Supervisor
+    {
+    public:
+        explicit Supervisor(const SupervisorParams& params);
+        ~Supervisor();
+
+        // The sections and the semaphore belong to the client, they must outlive the watch
+        uint64_t Watch(const Data::Heartbeat* heartbeat, void* returnCode, Platform::NamedSemaphore* lockClientPool);
+        void Unwatch(uint64_t id);
+        uint64_t StallCount() const;
+
+    private:
+        struct WatchedServer
+        {
+            uint64_t id;
+            const Data::Heartbeat* heartbeat;
+            void* returnCode;
+            Platform::NamedSemaphore* lockClientPool;
+            uint64_t lastBeat;
+            std::chrono::steady_clock::time_point lastProgress;
+        };
+
+        const SupervisorParams _params;
+        mutable std::mutex _mutex;
+        std::condition_variable _stopCondition;
+        std::vector<WatchedServer> _servers;
+        uint64_t _nextId;
+        uint64_t _stallCount;
+        bool _stopping;
+        std::thread _pollThread;
+
+        void PollLoop();
+        // Returns true if the server stalled and was killed
+        bool Check(WatchedServer& server, std::chrono::steady_clock::time_point now);
+    };
+}
@@ -0,0 +1,327 @@
+#include "../pch.h"
+#include "SyntheticGame.hpp"
+#include "../Platform/Platform.hpp"
+#include <new>
+
+namespace Synthetic
+{
+    namespace
+    {
+        // BGRX colors
+        constexpr uint32_t GRASS_COLOR = 0x00306020;
+        constexpr uint32_t ROAD_COLOR = 0x00505050;
+        constexpr uint32_t STRIPE_COLOR = 0x00E0E0E0;
+        constexpr uint32_t PLAYER_COLOR = 0x002020D0;
+        constexpr uint32_t OBSTACLE_COLOR = 0x00D02020;
+
+        constexpr uint32_t DISTANCE_SCORE = 1; // per unit of speed per frame
+        constexpr uint32_t OVERTAKE_SCORE = 100;
+        constexpr uint32_t SHOT_SCORE = 250;
+        constexpr int32_t STEER_SPEED = 4;
+    }
+
+    SyntheticGame::SyntheticGame(const SyntheticGameParams& params)
+        : _params(params),
+        _format(params.width, params.height, CHANNELS),
+        _roadLeft(static_cast<int32_t>(params.width / 4)),
+        _roadRight(static_cast<int32_t>(3 * params.width / 4)),
+        _carWidth(std::max<int32_t>(1, static_cast<int32_t>(params.width / 16))),
+        _carHeight(std::max<int32_t>(1, static_cast<int32_t>(params.height / 8))),
+        // On pages of its own, the snapshot engine tracks them
+        _state(*new (Platform::AllocatePages(sizeof(SimulationState))) SimulationState()),
+        _frame(params.width * params.height * CHANNELS),
+        _snapshots(std::make_unique<Snapshot::SnapshotEngine>(HighwayPursuitConstants::SNAPSHOT_SLOTS, true))
+    {
+        _snapshots->TrackRegion(&_state, sizeof(SimulationState));
+        _state.rng = params.seed != 0 ? params.seed : 1; // xorshift can't start from 0
+        NewGame();
+    }
+
+    SyntheticGame::~SyntheticGame()
+    {
+        // The engine unprotects the pages before they are freed
+        _snapshots.reset();
+        _state.~SimulationState();
+        Platform::FreePages(&_state, sizeof(SimulationState));
+    }
+
+    Services::IEpisodeService& SyntheticGame::Episode()
+    {
+        return *this;
+    }
+
+    Services::IScoreService& SyntheticGame::Score()
+    {
+        return *this;
+    }
+
+    Services::IInputService& SyntheticGame::Input()
+    {
+        return *this;
+    }
+
+    Services::IRenderingService& SyntheticGame::Rendering()
+    {
+        return *this;
+    }
+
+    Services::IUpdateService& SyntheticGame::Update()
+    {
+        return *this;
+    }
+
+    Services::IStateService& SyntheticGame::State()
+    {
+        return *this;
+    }
+
+    void SyntheticGame::NewGame()
+    {
+        _state.score = 0;
+        _state.lastScore = 0;
+        _state.terminated = 0;
+        Respawn();
+    }
+
+    void SyntheticGame::NewLife()
+    {
+        _state.terminated = 0;
+        Respawn();
+    }
+
+    bool SyntheticGame::PullTerminated()
+    {
+        bool res = _state.terminated != 0;
+        _state.terminated = 0;
+        return res;
+    }
+
+    uint32_t SyntheticGame::PullReward()
+    {
+        uint32_t scoreDelta = _state.score - _state.lastScore;
+        _state.lastScore = _state.score;
+        return scoreDelta;
+    }
+
+    int SyntheticGame::GetInputCount()
+    {
+        return HighwayPursuitConstants::ACTION_COUNT;
+    }
+
+    void SyntheticGame::LoadBindings()
+    {
+        // Inputs are read directly from the mask
+    }
+
+    void SyntheticGame::SetInput(const InputSet& inputs)
+    {
+        _state.inputMask = inputs.Mask();
+    }
+
+    BufferFormat SyntheticGame::GetBufferFormat()
+    {
+        return _format;
+    }
+
+    void SyntheticGame::ResetZoomLevel()
+    {
+        // No intro animation
+    }
+
+    void SyntheticGame::Screenshot(Utils::FunctionRef<void(void*, const BufferFormat&)> pixelDataHandler)
+    {
+        // Frames are only drawn when observed
+        Render();
+        pixelDataHandler(_frame.data(), _format);
+    }
+
+    void SyntheticGame::EnableCustomTime()
+    {
+        // Time is always simulated
+    }
+
+    void SyntheticGame::UpdateTime()
+    {
+        // Time is always simulated
+    }
+
+    bool SyntheticGame::WaitUpdate(uint32_t timeoutMs)
+    {
+        // A frame costing more than the timeout is a hung game: the frame doesn't run
+        auto frameCost = std::chrono::microseconds(_params.frameCostUs);
+        auto timeout = std::chrono::milliseconds(timeoutMs);
+        if (frameCost > timeout)
+        {
+            std::this_thread::sleep_for(timeout);
+            return false;
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        RunFrame();
+
+        // Stand in for the cost of a real game update
+        while (std::chrono::steady_clock::now() - start < frameCost)
+        {
+        }
+        return true;
+    }
+
+    void SyntheticGame::RunFrame()
+    {
+        _state.frame++;
+
+        // Apply inputs
+        if (IsPressed(Data::Input::Accelerate))
+        {
+            _state.speed = std::min(_state.speed + 1, MAX_SPEED);
+        }
+        if (IsPressed(Data::Input::Brake))
+        {
+            _state.speed = std::max(_state.speed - 2, 0);
+        }
+        if (IsPressed(Data::Input::SteerL))
+        {
+            _state.playerX = std::max(_state.playerX - STEER_SPEED, _roadLeft);
+        }
+        if (IsPressed(Data::Input::SteerR))
+        {
+            _state.playerX = std::min(_state.playerX + STEER_SPEED, _roadRight - _carWidth);
+        }
+
+        // Shooting destroys the obstacle if it's in front of the player, missiles always do
+        bool aligned = std::abs(_state.obstacleX - _state.playerX) < _carWidth;
+        if (IsPressed(Data::Input::Missiles) || (IsPressed(Data::Input::Fire) && aligned))
+        {
+            _state.score += SHOT_SCORE;
+            SpawnObstacle();
+        }
+
+        // Scroll, the obstacle is slower than the player at full speed
+        _state.score += DISTANCE_SCORE * static_cast<uint32_t>(_state.speed);
+        _state.obstacleY += _state.speed - MAX_SPEED / 2;
+
+        int32_t playerTop = static_cast<int32_t>(_params.height) - 2 * _carHeight;
+        bool overlapsVertically = _state.obstacleY + _carHeight > playerTop && _state.obstacleY < playerTop + _carHeight;
+        if (overlapsVertically && aligned)
+        {
+            // Crash, like the game the player respawns on its own
+            _state.terminated = 1;
+            Respawn();
+        }
+        else if (_state.obstacleY > static_cast<int32_t>(_params.height))
+        {
+            _state.score += OVERTAKE_SCORE;
+            SpawnObstacle();
+        }
+        else if (_state.obstacleY < -2 * _carHeight)
+        {
+            // Left behind by a slow player
+            SpawnObstacle();
+        }
+    }
+
+    void SyntheticGame::Respawn()
+    {
+        _state.inputMask = 0;
+        _state.speed = 0;
+        _state.playerX = (_roadLeft + _roadRight - _carWidth) / 2;
+        SpawnObstacle();
+    }
+
+    void SyntheticGame::SpawnObstacle()
+    {
+        int32_t lanes = std::max<int32_t>(1, (_roadRight - _roadLeft) / _carWidth);
+        _state.obstacleX = _roadLeft + static_cast<int32_t>(NextRandom() % lanes) * _carWidth;
+        _state.obstacleY = 0;
+    }
+
+    uint64_t SyntheticGame::NextRandom()
+    {
+        // xorshift64
+        _state.rng ^= _state.rng << 13;
+        _state.rng ^= _state.rng >> 7;
+        _state.rng ^= _state.rng << 17;
+        return _state.rng;
+    }
+
+    bool SyntheticGame::IsPressed(Data::Input input) const
+    {
+        return (_state.inputMask & (1u << static_cast<uint32_t>(input))) != 0;
+    }
+
+    void SyntheticGame::Render()
+    {
+        int32_t width = static_cast<int32_t>(_params.width);
+        int32_t height = static_cast<int32_t>(_params.height);
+
+        FillRect(0, 0, width, height, GRASS_COLOR);
+        FillRect(_roadLeft, 0, _roadRight, height, ROAD_COLOR);
+
+        // Center stripes scroll with the distance travelled
+        int32_t stripeLength = std::max<int32_t>(1, height / 12);
+        int32_t stripeOffset = static_cast<int32_t>(_state.frame * static_cast<uint64_t>(_state.speed + 1) % (2 * stripeLength));
+        int32_t center = (_roadLeft + _roadRight) / 2;
+        for (int32_t y = stripeOffset - 2 * stripeLength; y < height; y += 2 * stripeLength)
+        {
+            FillRect(center - 1, y, center + 1, y + stripeLength, STRIPE_COLOR);
+        }
+
+        int32_t playerTop = height - 2 * _carHeight;
+        FillRect(_state.obstacleX, _state.obstacleY, _state.obstacleX + _carWidth, _state.obstacleY + _carHeight, OBSTACLE_COLOR);
+        FillRect(_state.playerX, playerTop, _state.playerX + _carWidth, playerTop + _carHeight, PLAYER_COLOR);
+    }
+
+    void SyntheticGame::FillRect(int32_t left, int32_t top, int32_t right, int32_t bottom, uint32_t color)
+    {
+        left = std::max(left, 0);
+        top = std::max(top, 0);
+        right = std::min(right, static_cast<int32_t>(_params.width));
+        bottom = std::min(bottom, static_cast<int32_t>(_params.height));
+
+        uint32_t* pixels = reinterpret_cast<uint32_t*>(_frame.data());
+        for (int32_t y = top; y < bottom; ++y)
+        {
+            uint32_t* row = pixels + static_cast<size_t>(y) * _params.width;
+            std::fill(row + left, row + std::max(left, right), color);
+        }
+    }
+
+    uint32_t SyntheticGame::GetSnapshotSlotCount()
+    {
+        return _snapshots->SlotCount();
+    }
+
+    void SyntheticGame::Capture(uint32_t slot)
+    {
+        _snapshots->Capture(slot);
+    }
+
+    bool SyntheticGame::Restore(uint32_t slot)
+    {
+        _snapshots->Restore(slot);
+        return true;
+    }
+
+    bool SyntheticGame::SaveImage(const std::string& path)
+    {
+        _snapshots->SaveImage(path, ImageKey(), 0);
+        return true;
+    }
+
+    bool SyntheticGame::LoadImage(const std::string& path)
+    {
+        uint64_t userData = 0;
+        return _snapshots->LoadImage(path, ImageKey(), userData);
+    }
+
+    uint64_t SyntheticGame::ImageKey() const
+    {
+        // The state depends on the resolution and the seed, the frame cost doesn't change it
+        uint64_t key = 1469598103934665603ull;
+        for (uint64_t value : { uint64_t(_params.width), uint64_t(_params.height), _params.seed, uint64_t(sizeof(SimulationState)) })
+        {
+            key = (key ^ value) * 1099511628211ull;
+        }
+        return key;
+    }
+}
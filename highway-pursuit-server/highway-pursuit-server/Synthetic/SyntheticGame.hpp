@@ -0,0 +1,113 @@
+#pragma once
+#include "../Services/GameBackend.hpp"
+#include "../Snapshot/SnapshotEngine.hpp"
+
+namespace Synthetic
+{
+    using namespace Data;
+
+    struct SyntheticGameParams
+    {
+        const uint32_t width;
+        const uint32_t height;
+        const uint64_t seed;
+        const uint32_t frameCostUs; // busy-waited on every update, stands in for the game's own work. Above the update timeout the update times out
+
+        SyntheticGameParams(uint32_t width, uint32_t height, uint64_t seed, uint32_t frameCostUs)
+            : width(width), height(height), seed(seed), frameCostUs(frameCostUs)
+        {
+        }
+    };
+
+    // Deterministic stand-in for the game: a car on a scrolling road dodging (or shooting) another car.
+    // Runs its updates synchronously on the server thread, the same actions always produce the same frames/rewards.
+    class SyntheticGame :
+        public Services::GameBackend,
+        public Services::IEpisodeService,
+        public Services::IScoreService,
+        public Services::IInputService,
+        public Services::IRenderingService,
+        public Services::IUpdateService,
+        public Services::IStateService
+    {
+    public:
+        static constexpr uint32_t CHANNELS = 4; // BGRX, like the game's back buffer
+        static constexpr int32_t MAX_SPEED = 8;
+
+        SyntheticGame(const SyntheticGameParams& params);
+        ~SyntheticGame() override;
+
+        // GameBackend
+        Services::IEpisodeService& Episode() override;
+        Services::IScoreService& Score() override;
+        Services::IInputService& Input() override;
+        Services::IRenderingService& Rendering() override;
+        Services::IUpdateService& Update() override;
+        Services::IStateService& State() override;
+
+        // Episode
+        void NewGame() override;
+        void NewLife() override;
+        bool PullTerminated() override;
+
+        // Score
+        uint32_t PullReward() override;
+
+        // Input
+        int GetInputCount() override;
+        void LoadBindings() override;
+        void SetInput(const InputSet& inputs) override;
+
+        // Rendering
+        BufferFormat GetBufferFormat() override;
+        void ResetZoomLevel() override;
+        void Screenshot(Utils::FunctionRef<void(void*, const BufferFormat&)> pixelDataHandler) override;
+
+        // Update
+        void EnableCustomTime() override;
+        void UpdateTime() override;
+        bool WaitUpdate(uint32_t timeoutMs) override;
+
+        // State, the simulation state lives on its own pages and is snapshotted by the page-tracking engine
+        uint32_t GetSnapshotSlotCount() override;
+        void Capture(uint32_t slot) override;
+        bool Restore(uint32_t slot) override;
+        bool SaveImage(const std::string& path) override;
+        bool LoadImage(const std::string& path) override;
+
+    private:
+        // Whole simulation state, plain data
+        struct SimulationState
+        {
+            uint64_t rng;
+            uint64_t frame;
+            uint32_t inputMask;
+            int32_t playerX;
+            int32_t speed;
+            int32_t obstacleX;
+            int32_t obstacleY;
+            uint32_t score;
+            uint32_t lastScore;
+            uint8_t terminated;
+        };
+
+        const SyntheticGameParams _params;
+        const BufferFormat _format;
+        const int32_t _roadLeft;
+        const int32_t _roadRight;
+        const int32_t _carWidth;
+        const int32_t _carHeight;
+        SimulationState& _state;
+        std::vector<uint8_t> _frame;
+        std::unique_ptr<Snapshot::SnapshotEngine> _snapshots;
+
+        void RunFrame();
+        void Respawn();
+        void SpawnObstacle();
+        uint64_t NextRandom();
+        bool IsPressed(Data::Input input) const;
+        void Render();
+        void FillRect(int32_t left, int32_t top, int32_t right, int32_t bottom, uint32_t color);
+        uint64_t ImageKey() const;
+    };
+}
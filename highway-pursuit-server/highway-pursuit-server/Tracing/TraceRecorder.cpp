@@ -0,0 +1,120 @@
+#include "../pch.h"
+#include "TraceRecorder.hpp"
+
+namespace Tracing
+{
+    std::atomic<bool> TraceRecorder::_enabled(false);
+    std::unique_ptr<TraceRecorder::ThreadBuffer[]> TraceRecorder::_buffers;
+    uint32_t TraceRecorder::_threadCount(0);
+    std::atomic<uint32_t> TraceRecorder::_generation(0);
+    std::atomic<uint32_t> TraceRecorder::_registeredThreads(0);
+    std::atomic<bool> TraceRecorder::_overflowLogged(false);
+    const std::chrono::steady_clock::time_point TraceRecorder::_origin = std::chrono::steady_clock::now();
+
+    void TraceRecorder::Configure(bool enabled, size_t memoryBudget, uint32_t threadCount)
+    {
+        // Buffers are never resized while recording, the previous ones are released here
+        _enabled = false;
+        _buffers.reset();
+        _threadCount = 0;
+        size_t eventsPerThread = threadCount > 0 ? memoryBudget / (threadCount * sizeof(TraceEvent)) : 0;
+        if (!enabled || eventsPerThread == 0)
+        {
+            return;
+        }
+
+        _buffers = std::make_unique<ThreadBuffer[]>(threadCount);
+        for (uint32_t i = 0; i < threadCount; ++i)
+        {
+            _buffers[i].events.assign(eventsPerThread, TraceEvent{ nullptr, 0, 0 });
+        }
+        _threadCount = threadCount;
+        _registeredThreads = 0;
+        _overflowLogged = false;
+        _generation.fetch_add(1, std::memory_order_release);
+        _enabled = true;
+    }
+
+    bool TraceRecorder::IsEnabled()
+    {
+        return _enabled.load(std::memory_order_relaxed);
+    }
+
+    int64_t TraceRecorder::NowUs()
+    {
+        auto elapsed = std::chrono::steady_clock::now() - _origin;
+        return std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count();
+    }
+
+    void TraceRecorder::Record(const char* name, int64_t startUs, int64_t endUs)
+    {
+        ThreadBuffer* buffer = LocalBuffer();
+        if (buffer == nullptr)
+        {
+            return;
+        }
+
+        // Ring buffer, the oldest events are overwritten once the budget is used
+        uint64_t head = buffer->head.load(std::memory_order_relaxed);
+        buffer->events[head % buffer->events.size()] = TraceEvent{ name, startUs, endUs - startUs };
+        buffer->head.store(head + 1, std::memory_order_release);
+    }
+
+    TraceRecorder::ThreadBuffer* TraceRecorder::LocalBuffer()
+    {
+        // Each thread claims a buffer on its first event of each generation
+        thread_local uint32_t generation = 0;
+        thread_local uint32_t index = 0;
+        uint32_t current = _generation.load(std::memory_order_acquire);
+        if (generation != current)
+        {
+            generation = current;
+            index = _registeredThreads.fetch_add(1);
+            if (index >= _threadCount && !_overflowLogged.exchange(true))
+            {
+                HPLogger::LogWarning("More than " + std::to_string(_threadCount) + " threads record trace events, the others aren't traced");
+            }
+        }
+        return index < _threadCount ? &_buffers[index] : nullptr;
+    }
+
+    bool TraceRecorder::Dump(const std::string& path)
+    {
+        if (!IsEnabled())
+        {
+            return false;
+        }
+
+        std::ofstream writer(path, std::ios::trunc);
+        if (!writer.is_open())
+        {
+            HPLogger::LogWarning("Couldn't open trace file " + path);
+            return false;
+        }
+
+        // Events still being written by other threads may be torn, the server thread is the only one tracing when it dumps
+        uint64_t overwrittenEvents = 0;
+        bool first = true;
+        writer << "{\"traceEvents\":[";
+        for (uint32_t tid = 0; tid < _threadCount; ++tid)
+        {
+            const ThreadBuffer& buffer = _buffers[tid];
+            uint64_t head = buffer.head.load(std::memory_order_acquire);
+            uint64_t capacity = buffer.events.size();
+            uint64_t begin = head > capacity ? head - capacity : 0;
+            overwrittenEvents += begin;
+
+            for (uint64_t i = begin; i < head; ++i)
+            {
+                const TraceEvent& event = buffer.events[i % capacity];
+                writer << (first ? "\n" : ",\n")
+                    << "{\"name\":\"" << event.name << "\",\"ph\":\"X\",\"ts\":" << event.startUs
+                    << ",\"dur\":" << event.durationUs << ",\"pid\":0,\"tid\":" << tid << "}";
+                first = false;
+            }
+        }
+        writer << "\n],\"displayTimeUnit\":\"ms\",\"otherData\":{\"overwrittenEvents\":" << overwrittenEvents << "}}\n";
+
+        return writer.good();
+    }
+}
@@ -0,0 +1,78 @@
+#pragma once
+#include "../pch.h"
+
+// Trace points are compiled out unless the HP_ENABLE_TRACING CMake option is set
+#ifdef HP_ENABLE_TRACING
+#define HP_TRACE_CONCAT_INNER(a, b) a##b
+#define HP_TRACE_CONCAT(a, b) HP_TRACE_CONCAT_INNER(a, b)
+#define HP_TRACE_SCOPE(name) Tracing::TraceScope HP_TRACE_CONCAT(_traceScope, __LINE__)(name)
+#else
+#define HP_TRACE_SCOPE(name)
+#endif
+
+namespace Tracing
+{
+    // A complete (begin + duration) event, the name has to be a string literal
+    struct TraceEvent
+    {
+        const char* name;
+        int64_t startUs;
+        int64_t durationUs;
+    };
+
+    // Records scoped events into per-thread ring buffers and dumps them in the Chrome/Perfetto JSON format
+    class TraceRecorder
+    {
+    public:
+        // Allocates a buffer for each of the threadCount first threads recording events, memoryBudget is split between them.
+        // Every call hands the buffers out again (a new server in the process), the threads beyond threadCount are not traced.
+        // Must not be called while another thread records events.
+        static void Configure(bool enabled, size_t memoryBudget, uint32_t threadCount);
+        static bool IsEnabled();
+        static int64_t NowUs();
+        static void Record(const char* name, int64_t startUs, int64_t endUs);
+        static bool Dump(const std::string& path);
+
+    private:
+        struct ThreadBuffer
+        {
+            std::vector<TraceEvent> events;
+            std::atomic<uint64_t> head{ 0 }; // total number of events written, only incremented by the owner thread
+        };
+
+        static std::atomic<bool> _enabled;
+        static std::unique_ptr<ThreadBuffer[]> _buffers;
+        static uint32_t _threadCount;
+        static std::atomic<uint32_t> _generation; // of the buffers, incremented by Configure
+        static std::atomic<uint32_t> _registeredThreads; // in this generation
+        static std::atomic<bool> _overflowLogged;
+        static const std::chrono::steady_clock::time_point _origin;
+
+        static ThreadBuffer* LocalBuffer();
+    };
+
+    class TraceScope
+    {
+    public:
+        TraceScope(const char* name)
+            : _name(name),
+            _startUs(TraceRecorder::IsEnabled() ? TraceRecorder::NowUs() : -1)
+        {
+        }
+
+        ~TraceScope()
+        {
+            if (_startUs >= 0)
+            {
+                TraceRecorder::Record(_name, _startUs, TraceRecorder::NowUs());
+            }
+        }
+
+        TraceScope(const TraceScope&) = delete;
+        TraceScope& operator=(const TraceScope&) = delete;
+
+    private:
+        const char* _name;
+        const int64_t _startUs;
+    };
+}
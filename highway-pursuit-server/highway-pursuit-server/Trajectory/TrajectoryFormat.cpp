@@ -0,0 +1,138 @@
+#include "../pch.h"
+#include "TrajectoryFormat.hpp"
+
+namespace Trajectory
+{
+    namespace
+    {
+        // Each packet starts with a 16 bits header: the high bit tells a run (one pixel repeated) from literals,
+        // the low bits are the pixel count minus one
+        constexpr size_t PIXEL_SIZE = 4;
+        constexpr uint16_t RUN_FLAG = 0x8000;
+        constexpr size_t MAX_PACKET_PIXELS = 0x8000;
+        constexpr size_t MIN_RUN_PIXELS = 2;
+
+        uint32_t LoadPixel(const uint8_t* source)
+        {
+            uint32_t pixel;
+            std::memcpy(&pixel, source, PIXEL_SIZE);
+            return pixel;
+        }
+
+        uint8_t* WritePacketHeader(uint8_t* destination, bool isRun, size_t pixelCount)
+        {
+            uint16_t header = static_cast<uint16_t>((isRun ? RUN_FLAG : 0) | (pixelCount - 1));
+            std::memcpy(destination, &header, sizeof(header));
+            return destination + sizeof(header);
+        }
+    }
+
+    std::string IndexPath(const std::string& directory)
+    {
+        return directory + "/index.hpti";
+    }
+
+    std::string ChunkPath(const std::string& directory, uint32_t chunk)
+    {
+        char name[32];
+        std::snprintf(name, sizeof(name), "/chunk_%06u.hptc", chunk);
+        return directory + name;
+    }
+
+    size_t MaxCompressedSize(size_t size)
+    {
+        size_t pixelCount = size / PIXEL_SIZE;
+        return size + sizeof(uint16_t) * (pixelCount / MAX_PACKET_PIXELS + 1);
+    }
+
+    size_t CompressFrame(uint8_t* destination, const uint8_t* source, size_t size)
+    {
+        if (size % PIXEL_SIZE != 0)
+        {
+            return 0;
+        }
+
+        size_t pixelCount = size / PIXEL_SIZE;
+        uint8_t* out = destination;
+        size_t literalStart = 0;
+        size_t i = 0;
+        while (i < pixelCount)
+        {
+            // Length of the run starting at i
+            uint32_t pixel = LoadPixel(source + i * PIXEL_SIZE);
+            size_t runEnd = i + 1;
+            while (runEnd < pixelCount && runEnd - i < MAX_PACKET_PIXELS && LoadPixel(source + runEnd * PIXEL_SIZE) == pixel)
+            {
+                runEnd++;
+            }
+
+            // Pending literals are written before a run and at the end of the frame, or when they fill a packet
+            bool isRun = runEnd - i >= MIN_RUN_PIXELS;
+            size_t literalEnd = isRun ? i : runEnd;
+            bool flushLiterals = isRun || runEnd == pixelCount;
+            while (literalEnd - literalStart >= MAX_PACKET_PIXELS || (flushLiterals && literalEnd > literalStart))
+            {
+                size_t count = std::min(literalEnd - literalStart, MAX_PACKET_PIXELS);
+                out = WritePacketHeader(out, false, count);
+                std::memcpy(out, source + literalStart * PIXEL_SIZE, count * PIXEL_SIZE);
+                out += count * PIXEL_SIZE;
+                literalStart += count;
+            }
+
+            if (isRun)
+            {
+                out = WritePacketHeader(out, true, runEnd - i);
+                std::memcpy(out, &pixel, PIXEL_SIZE);
+                out += PIXEL_SIZE;
+                literalStart = runEnd;
+            }
+            i = runEnd;
+        }
+        return static_cast<size_t>(out - destination);
+    }
+
+    bool DecompressFrame(uint8_t* destination, size_t size, const uint8_t* source, size_t compressedSize)
+    {
+        const uint8_t* in = source;
+        const uint8_t* inEnd = source + compressedSize;
+        uint8_t* out = destination;
+        uint8_t* outEnd = destination + size;
+        while (in + sizeof(uint16_t) <= inEnd)
+        {
+            uint16_t header;
+            std::memcpy(&header, in, sizeof(header));
+            in += sizeof(header);
+
+            size_t pixelCount = static_cast<size_t>(header & ~RUN_FLAG) + 1;
+            size_t outputSize = pixelCount * PIXEL_SIZE;
+            if (out + outputSize > outEnd)
+            {
+                return false;
+            }
+
+            if ((header & RUN_FLAG) != 0)
+            {
+                if (in + PIXEL_SIZE > inEnd)
+                {
+                    return false;
+                }
+                for (size_t i = 0; i < pixelCount; ++i)
+                {
+                    std::memcpy(out + i * PIXEL_SIZE, in, PIXEL_SIZE);
+                }
+                in += PIXEL_SIZE;
+            }
+            else
+            {
+                if (in + outputSize > inEnd)
+                {
+                    return false;
+                }
+                std::memcpy(out, in, outputSize);
+                in += outputSize;
+            }
+            out += outputSize;
+        }
+        return in == inEnd && out == outEnd;
+    }
+}
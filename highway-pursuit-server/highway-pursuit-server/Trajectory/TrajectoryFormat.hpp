@@ -0,0 +1,60 @@
+#pragma once
+#include "../Data/ServerTypes.hpp"
+
+// On-disk layout of a recorded trajectory directory:
+// - index.hpti: a TrajectoryHeader followed by one fixed-size TrajectoryIndexEntry per transition
+// - chunk_<n>.hptc: the observations of chunkTransitions consecutive transitions, back to back
+namespace Trajectory
+{
+    enum class TransitionKind : uint8_t
+    {
+        RESET = 0, // first observation of an episode
+        STEP = 1,
+        RESTORE = 2 // observation of a restored snapshot
+    };
+
+    enum class FrameCompression : uint8_t
+    {
+        NONE = 0,
+        PIXEL_RLE = 1 // runs of identical 4 bytes pixels, see CompressFrame
+    };
+
+    #pragma pack(push, 1)
+    struct TrajectoryHeader
+    {
+        static constexpr uint32_t MAGIC = 0x52545048; // "HPTR"
+        static constexpr uint32_t VERSION = 1;
+
+        uint32_t magic;
+        uint32_t version;
+        uint32_t obsWidth;
+        uint32_t obsHeight;
+        uint32_t obsChannels;
+        uint32_t chunkTransitions;
+    };
+
+    struct TrajectoryIndexEntry
+    {
+        uint64_t sequence; // transitions dropped when the queue was full leave gaps
+        uint64_t offset; // of the observation in its chunk
+        uint32_t chunk;
+        uint32_t storedSize; // of the observation in the chunk
+        uint32_t actionMask;
+        float reward;
+        TransitionKind kind;
+        FrameCompression compression;
+        uint8_t terminated;
+        uint8_t truncated;
+    };
+    #pragma pack(pop)
+
+    std::string IndexPath(const std::string& directory);
+    std::string ChunkPath(const std::string& directory, uint32_t chunk);
+
+    // Upper bound of the compressed size of a frame
+    size_t MaxCompressedSize(size_t size);
+    // Returns the compressed size, or 0 if the frame isn't a whole number of 4 bytes pixels
+    size_t CompressFrame(uint8_t* destination, const uint8_t* source, size_t size);
+    // Returns false if the data is corrupted
+    bool DecompressFrame(uint8_t* destination, size_t size, const uint8_t* source, size_t compressedSize);
+}
@@ -0,0 +1,95 @@
+#include "../pch.h"
+#include "TrajectoryReader.hpp"
+
+namespace Trajectory
+{
+    TrajectoryReader::TrajectoryReader(const std::string& directory)
+        : _directory(directory),
+        _header{},
+        _size(0)
+    {
+        Refresh();
+    }
+
+    void TrajectoryReader::Refresh()
+    {
+        _index = Platform::MappedFile::Open(IndexPath(_directory));
+        if (_index->Size() < sizeof(TrajectoryHeader))
+        {
+            throw std::runtime_error(_directory + " doesn't contain a trajectory");
+        }
+
+        std::memcpy(&_header, _index->Data(), sizeof(_header));
+        if (_header.magic != TrajectoryHeader::MAGIC || _header.version != TrajectoryHeader::VERSION)
+        {
+            throw std::runtime_error(_directory + " doesn't contain a trajectory of this version");
+        }
+        _size = (_index->Size() - sizeof(TrajectoryHeader)) / sizeof(TrajectoryIndexEntry);
+    }
+
+    Data::BufferFormat TrajectoryReader::Format() const
+    {
+        return Data::BufferFormat(_header.obsWidth, _header.obsHeight, _header.obsChannels);
+    }
+
+    size_t TrajectoryReader::Size() const
+    {
+        return _size;
+    }
+
+    const TrajectoryIndexEntry& TrajectoryReader::Entry(size_t index) const
+    {
+        if (index >= _size)
+        {
+            throw std::out_of_range("Transition " + std::to_string(index) + " isn't in the trajectory");
+        }
+        // Entries are packed, they are read in place
+        return *reinterpret_cast<const TrajectoryIndexEntry*>(_index->Data() + sizeof(TrajectoryHeader) + index * sizeof(TrajectoryIndexEntry));
+    }
+
+    void TrajectoryReader::ReadObservation(size_t index, uint8_t* destination)
+    {
+        const TrajectoryIndexEntry& entry = Entry(index);
+        const uint8_t* stored = Chunk(entry).Data() + entry.offset;
+        size_t size = Format().Size();
+
+        switch (entry.compression)
+        {
+        case FrameCompression::NONE:
+            if (entry.storedSize != size)
+            {
+                throw std::runtime_error("Transition " + std::to_string(index) + " has an unexpected size");
+            }
+            std::memcpy(destination, stored, size);
+            break;
+        case FrameCompression::PIXEL_RLE:
+            if (!DecompressFrame(destination, size, stored, entry.storedSize))
+            {
+                throw std::runtime_error("Transition " + std::to_string(index) + " is corrupted");
+            }
+            break;
+        default:
+            throw std::runtime_error("Transition " + std::to_string(index) + " uses an unknown compression");
+        }
+    }
+
+    const Platform::MappedFile& TrajectoryReader::Chunk(const TrajectoryIndexEntry& entry)
+    {
+        if (entry.chunk >= _chunks.size())
+        {
+            _chunks.resize(static_cast<size_t>(entry.chunk) + 1);
+        }
+
+        // The last chunk grows while recording, it's mapped again when it no longer covers the entry
+        std::unique_ptr<Platform::MappedFile>& chunk = _chunks[entry.chunk];
+        if (chunk == nullptr || chunk->Size() < entry.offset + entry.storedSize)
+        {
+            chunk = Platform::MappedFile::Open(ChunkPath(_directory, entry.chunk));
+            if (chunk->Size() < entry.offset + entry.storedSize)
+            {
+                throw std::runtime_error(ChunkPath(_directory, entry.chunk) + " is truncated");
+            }
+        }
+        return *chunk;
+    }
+}
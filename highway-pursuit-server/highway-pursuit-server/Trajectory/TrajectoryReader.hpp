@@ -0,0 +1,31 @@
+#pragma once
+#include "../Data/ServerTypes.hpp"
+#include "../Platform/Platform.hpp"
+#include "TrajectoryFormat.hpp"
+
+namespace Trajectory
+{
+    // Random access to a recorded trajectory directory through file mappings (for training jobs).
+    // The transitions are the ones indexed when the reader was opened, Refresh picks up the ones recorded since.
+    class TrajectoryReader
+    {
+    public:
+        TrajectoryReader(const std::string& directory);
+
+        void Refresh();
+        Data::BufferFormat Format() const;
+        size_t Size() const;
+        const TrajectoryIndexEntry& Entry(size_t index) const;
+        // destination holds Format().Size() bytes
+        void ReadObservation(size_t index, uint8_t* destination);
+
+    private:
+        const std::string _directory;
+        std::unique_ptr<Platform::MappedFile> _index;
+        TrajectoryHeader _header;
+        size_t _size;
+        std::vector<std::unique_ptr<Platform::MappedFile>> _chunks;
+
+        const Platform::MappedFile& Chunk(const TrajectoryIndexEntry& entry);
+    };
+}
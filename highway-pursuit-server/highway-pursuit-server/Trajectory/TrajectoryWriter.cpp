@@ -0,0 +1,163 @@
+#include "../pch.h"
+#include "TrajectoryWriter.hpp"
+#include <filesystem>
+
+namespace Trajectory
+{
+    TrajectoryWriter::TrajectoryWriter(const Data::ServerParams::TrajectoryParams& params, const Data::BufferFormat& format)
+        : _directory(params.outputDirectory),
+        _compressed(params.compressed),
+        _chunkTransitions(std::max<uint32_t>(params.chunkTransitions, 1)),
+        _observationSize(format.Size()),
+        _nextSequence(0),
+        _writtenTransitions(0),
+        _indexFile(nullptr),
+        _chunkFile(nullptr),
+        _chunk(0),
+        _chunkTransitionCount(0),
+        _chunkOffset(0),
+        _compressionBuffer(MaxCompressedSize(format.Size())),
+        _writer("Trajectory recording", params.queueCapacity)
+    {
+        // All the memory used while recording is allocated here
+        for (QueuedTransition& transition : _writer.Items())
+        {
+            transition.observation.resize(_observationSize);
+        }
+        _unflushedEntries.reserve(_writer.Capacity());
+
+        std::filesystem::create_directories(_directory);
+        _indexFile = std::fopen(IndexPath(_directory).c_str(), "wb");
+        if (_indexFile == nullptr)
+        {
+            throw std::runtime_error("Couldn't create the trajectory index in " + _directory);
+        }
+
+        TrajectoryHeader header{ TrajectoryHeader::MAGIC, TrajectoryHeader::VERSION, format.width, format.height, format.channels, _chunkTransitions };
+        if (std::fwrite(&header, sizeof(header), 1, _indexFile) != 1 || std::fflush(_indexFile) != 0)
+        {
+            std::fclose(_indexFile);
+            throw std::runtime_error("Couldn't write the trajectory index in " + _directory);
+        }
+
+        try
+        {
+            OpenChunk(0);
+        }
+        catch (...)
+        {
+            std::fclose(_indexFile);
+            throw;
+        }
+        _writer.Start([this](QueuedTransition& transition) { Write(transition); }, [this]() { Flush(); });
+    }
+
+    TrajectoryWriter::~TrajectoryWriter()
+    {
+        _writer.Stop();
+
+        if (_chunkFile != nullptr)
+        {
+            std::fclose(_chunkFile);
+        }
+        std::fclose(_indexFile);
+        HPLogger::LogInfo("Trajectory in " + _directory + ": " + std::to_string(WrittenTransitions()) + " transitions written, "
+            + std::to_string(DroppedTransitions()) + " dropped");
+    }
+
+    bool TrajectoryWriter::Push(TransitionKind kind, const void* observation, uint32_t actionMask, float reward, const Data::Termination& termination)
+    {
+        uint64_t sequence = _nextSequence++;
+        QueuedTransition* transition = _writer.Acquire();
+        if (transition == nullptr)
+        {
+            return false;
+        }
+
+        transition->entry = TrajectoryIndexEntry{ sequence, 0, 0, 0, actionMask, reward, kind, FrameCompression::NONE, termination.terminated, termination.truncated };
+        std::memcpy(transition->observation.data(), observation, _observationSize);
+        _writer.Commit();
+        return true;
+    }
+
+    uint64_t TrajectoryWriter::WrittenTransitions() const
+    {
+        return _writtenTransitions.load(std::memory_order_relaxed);
+    }
+
+    uint64_t TrajectoryWriter::DroppedTransitions() const
+    {
+        return _writer.Dropped();
+    }
+
+    void TrajectoryWriter::Write(QueuedTransition& transition)
+    {
+        if (_chunkTransitionCount == _chunkTransitions)
+        {
+            Flush();
+            std::fclose(_chunkFile);
+            _chunkFile = nullptr;
+            OpenChunk(_chunk + 1);
+        }
+
+        const uint8_t* data = transition.observation.data();
+        size_t size = _observationSize;
+        transition.entry.compression = FrameCompression::NONE;
+        if (_compressed)
+        {
+            // Frames that don't shrink are stored as is
+            size_t compressedSize = CompressFrame(_compressionBuffer.data(), data, size);
+            if (compressedSize > 0 && compressedSize < size)
+            {
+                data = _compressionBuffer.data();
+                size = compressedSize;
+                transition.entry.compression = FrameCompression::PIXEL_RLE;
+            }
+        }
+
+        if (std::fwrite(data, 1, size, _chunkFile) != size)
+        {
+            throw std::runtime_error("Couldn't write to " + ChunkPath(_directory, _chunk));
+        }
+        transition.entry.chunk = _chunk;
+        transition.entry.offset = _chunkOffset;
+        transition.entry.storedSize = static_cast<uint32_t>(size);
+        _chunkOffset += size;
+        _chunkTransitionCount++;
+
+        if (_unflushedEntries.size() == _unflushedEntries.capacity())
+        {
+            Flush();
+        }
+        _unflushedEntries.push_back(transition.entry);
+    }
+
+    void TrajectoryWriter::Flush()
+    {
+        if (_unflushedEntries.empty())
+        {
+            return;
+        }
+
+        if (std::fflush(_chunkFile) != 0
+            || std::fwrite(_unflushedEntries.data(), sizeof(TrajectoryIndexEntry), _unflushedEntries.size(), _indexFile) != _unflushedEntries.size()
+            || std::fflush(_indexFile) != 0)
+        {
+            throw std::runtime_error("Couldn't write the trajectory index in " + _directory);
+        }
+        _writtenTransitions.fetch_add(_unflushedEntries.size(), std::memory_order_relaxed);
+        _unflushedEntries.clear();
+    }
+
+    void TrajectoryWriter::OpenChunk(uint32_t chunk)
+    {
+        _chunkFile = std::fopen(ChunkPath(_directory, chunk).c_str(), "wb");
+        if (_chunkFile == nullptr)
+        {
+            throw std::runtime_error("Couldn't create " + ChunkPath(_directory, chunk));
+        }
+        _chunk = chunk;
+        _chunkTransitionCount = 0;
+        _chunkOffset = 0;
+    }
+}
@@ -0,0 +1,53 @@
+#pragma once
+#include "../Data/ServerTypes.hpp"
+#include "../Utils/BackgroundWriter.hpp"
+#include "TrajectoryFormat.hpp"
+
+namespace Trajectory
+{
+    // Records transitions to a trajectory directory. Observations are copied to a bounded queue and written
+    // (and compressed) by a background thread, so that pushing never waits on the disk.
+    class TrajectoryWriter
+    {
+    public:
+        TrajectoryWriter(const Data::ServerParams::TrajectoryParams& params, const Data::BufferFormat& format);
+        // Writes the transitions still queued
+        ~TrajectoryWriter();
+
+        // Doesn't allocate or block, returns false if the queue was full and the transition dropped
+        bool Push(TransitionKind kind, const void* observation, uint32_t actionMask, float reward, const Data::Termination& termination);
+        uint64_t WrittenTransitions() const;
+        uint64_t DroppedTransitions() const;
+
+    private:
+        struct QueuedTransition
+        {
+            TrajectoryIndexEntry entry;
+            std::vector<uint8_t> observation;
+        };
+
+        const std::string _directory;
+        const bool _compressed;
+        const uint32_t _chunkTransitions;
+        const size_t _observationSize;
+
+        // Producer side
+        uint64_t _nextSequence; // including the dropped transitions
+        std::atomic<uint64_t> _writtenTransitions;
+
+        // Writer thread side
+        std::FILE* _indexFile;
+        std::FILE* _chunkFile;
+        uint32_t _chunk;
+        uint32_t _chunkTransitionCount;
+        uint64_t _chunkOffset;
+        std::vector<uint8_t> _compressionBuffer;
+        std::vector<TrajectoryIndexEntry> _unflushedEntries;
+        Utils::BackgroundWriter<QueuedTransition> _writer; // last, stopped before the files it writes are closed
+
+        void Write(QueuedTransition& transition);
+        // Index entries are only written once the observations they point to are flushed
+        void Flush();
+        void OpenChunk(uint32_t chunk);
+    };
+}
@@ -0,0 +1,150 @@
+#pragma once
+
+namespace Utils
+{
+    // Bounded queue of preallocated items, consumed by a background thread so that the producer never waits on the disk:
+    // items that find the queue full are dropped. A single producer fills the item Acquire returns and queues it with Commit.
+    // The writer thread hands each item to write, and calls flush whenever it goes idle and before it stops, so that readers
+    // see everything queued before a pause. An exception of write or flush stops the writer, the next items are dropped.
+    template <typename Item>
+    class BackgroundWriter
+    {
+    public:
+        // name prefixes the error logged when the writer stops on an exception
+        BackgroundWriter(const std::string& name, size_t capacity)
+            : _name(name),
+            _items(std::max<size_t>(capacity, 1)),
+            _head(0),
+            _size(0),
+            _stopping(false),
+            _dropped(0)
+        {
+        }
+
+        // Writes the items still queued
+        ~BackgroundWriter()
+        {
+            Stop();
+        }
+
+        BackgroundWriter(const BackgroundWriter&) = delete;
+        BackgroundWriter& operator=(const BackgroundWriter&) = delete;
+
+        // The items of the queue, for the owner to allocate their memory before Start
+        std::vector<Item>& Items()
+        {
+            return _items;
+        }
+
+        size_t Capacity() const
+        {
+            return _items.size();
+        }
+
+        // write and flush run on the writer thread
+        void Start(std::function<void(Item&)> write, std::function<void()> flush)
+        {
+            _write = std::move(write);
+            _flush = std::move(flush);
+            _thread = std::thread([this]() { WriterLoop(); });
+        }
+
+        // Waits for the queued items to be written, the owner can release what write and flush use once it returns
+        void Stop()
+        {
+            if (!_thread.joinable())
+            {
+                return;
+            }
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+                _stopping = true;
+            }
+            _notEmpty.notify_one();
+            _thread.join();
+        }
+
+        // Item after the queued ones, only touched by the producer until Commit. nullptr if the queue is full, the item is counted as dropped
+        Item* Acquire()
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            if (_size == _items.size())
+            {
+                _dropped.fetch_add(1, std::memory_order_relaxed);
+                return nullptr;
+            }
+            return &_items[(_head + _size) % _items.size()];
+        }
+
+        void Commit()
+        {
+            // The writer thread only waits on an empty queue, it's woken up when the first item is queued
+            bool wasEmpty;
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+                wasEmpty = _size == 0;
+                _size++;
+            }
+            if (wasEmpty)
+            {
+                _notEmpty.notify_one();
+            }
+        }
+
+        uint64_t Dropped() const
+        {
+            return _dropped.load(std::memory_order_relaxed);
+        }
+
+    private:
+        const std::string _name;
+        std::vector<Item> _items;
+        size_t _head; // oldest item, being written
+        size_t _size;
+        bool _stopping;
+        std::mutex _mutex;
+        std::condition_variable _notEmpty;
+        std::atomic<uint64_t> _dropped;
+        std::function<void(Item&)> _write;
+        std::function<void()> _flush;
+        std::thread _thread;
+
+        void WriterLoop()
+        {
+            try
+            {
+                while (true)
+                {
+                    Item* item = nullptr;
+                    {
+                        std::unique_lock<std::mutex> lock(_mutex);
+                        if (_size == 0)
+                        {
+                            lock.unlock();
+                            _flush();
+                            lock.lock();
+                        }
+                        _notEmpty.wait(lock, [this]() { return _size > 0 || _stopping; });
+                        if (_size == 0)
+                        {
+                            break;
+                        }
+                        item = &_items[_head];
+                    }
+
+                    _write(*item);
+
+                    std::lock_guard<std::mutex> lock(_mutex);
+                    _head = (_head + 1) % _items.size();
+                    _size--;
+                }
+                _flush();
+            }
+            catch (const std::exception& e)
+            {
+                // The server keeps running, the queue fills up and further items are dropped
+                HPLogger::LogError(_name + " stopped: " + e.what());
+            }
+        }
+    };
+}
@@ -0,0 +1,38 @@
+#pragma once
+#include <type_traits>
+#include <utility>
+
+namespace Utils
+{
+    template <typename Signature>
+    class FunctionRef;
+
+    // Non-owning reference to a callable, never allocates (unlike std::function).
+    // The callable has to outlive the reference, which is only meant to be used as a parameter.
+    template <typename R, typename... Args>
+    class FunctionRef<R(Args...)>
+    {
+    public:
+        template <typename F, typename = std::enable_if_t<!std::is_same<std::decay_t<F>, FunctionRef>::value>>
+        FunctionRef(F&& callable)
+            : _callable(const_cast<void*>(static_cast<const void*>(std::addressof(callable)))),
+            _invoke(&Invoke<std::remove_reference_t<F>>)
+        {
+        }
+
+        R operator()(Args... args) const
+        {
+            return _invoke(_callable, std::forward<Args>(args)...);
+        }
+
+    private:
+        void* _callable;
+        R(*_invoke)(void*, Args...);
+
+        template <typename F>
+        static R Invoke(void* callable, Args... args)
+        {
+            return (*static_cast<F*>(callable))(std::forward<Args>(args)...);
+        }
+    };
+}
@@ -0,0 +1,273 @@
+#include "../pch.h"
+#include "VectorizedServer.hpp"
+
+namespace Vectorized
+{
+    using namespace Data;
+
+    VectorizedServer::VectorizedServer(const ServerParams& options, std::vector<std::unique_ptr<Services::GameBackend>> backends, uint32_t threadCount)
+        : _options(options),
+        _communicationManager(std::make_unique<CommunicationManager>(options)),
+        _pool(std::min<uint32_t>(threadCount, static_cast<uint32_t>(backends.size()))),
+        _serverTerminated(false),
+        _tps(0.0f),
+        _memory(0.0f),
+        _metricsFrames(0),
+        _traceDumpCount(0)
+    {
+        if (backends.empty())
+        {
+            throw std::invalid_argument("A vectorized server needs at least one environment");
+        }
+        for (std::unique_ptr<Services::GameBackend>& backend : backends)
+        {
+            ServerParams::ActionParams actionParams(options.actionParams.stickyProbability, options.actionParams.seed + _slots.size());
+            auto environment = std::make_unique<Environment::GameEnvironment>(*backend, *_communicationManager, actionParams, options.frameskip);
+            _slots.push_back(Slot{ std::move(backend), std::move(environment), Metrics::MetricsWriter() });
+        }
+        // The slots are stepped by the threads of the pool, the server thread included
+        Tracing::TraceRecorder::Configure(options.traceParams.traceEnabled, options.traceParams.memoryBudget, _pool.ThreadCount());
+
+        if (options.isRealTime || options.replayParams.IsReplaying() || !options.replayParams.recordPath.empty()
+            || options.trajectoryParams.IsEnabled() || options.replayBufferParams.IsEnabled())
+        {
+            HPLogger::LogWarning("Real time, replays and recordings are ignored by the vectorized server");
+        }
+    }
+
+    VectorizedServer::~VectorizedServer()
+    {
+        // Keep the trace of the last run
+        DumpTrace();
+    }
+
+    void VectorizedServer::Run()
+    {
+        try
+        {
+            // The workers aren't pinned, they run whichever slot is left
+            if (_options.affinityParams.serverCores != 0 && !Platform::SetCurrentThreadAffinity(_options.affinityParams.serverCores))
+            {
+                HPLogger::LogWarning("Failed to pin the server thread to the cores " + std::to_string(_options.affinityParams.serverCores));
+            }
+            _communicationManager->OpenHeartbeat();
+            ServerInfo serverInfo = StartGames();
+            ServerInfoEx serverInfoEx(ActionEncoding::BITMASK, 0, SlotCount(), _options.episodeParams.autoReset);
+
+            if (_options.poolParams.parked)
+            {
+                _communicationManager->Park();
+            }
+            if (!_communicationManager->Connect(serverInfo, serverInfoEx))
+            {
+                HPLogger::LogInfo("Discarded by the warm pool before serving a client");
+                _communicationManager->SetHeartbeatState(HeartbeatState::EXITED);
+                return;
+            }
+            _communicationManager->SetHeartbeatState(HeartbeatState::IDLE);
+            for (uint32_t index = 0; index < SlotCount(); ++index)
+            {
+                _slots[index].environment->SetPipeline(std::make_unique<Pipeline::TransformPipeline>(_communicationManager->GetPipelineConfig(), serverInfo.actionCount));
+                _slots[index].environment->Episodes().Attach(_communicationManager->EpisodeStatsSection(index));
+                _slots[index].metrics = _communicationManager->MetricsBlock(index);
+            }
+            _memory = Platform::GetWorkingSetSize() / (1024.0f * 1024.0f);
+            _metricsStart = std::chrono::steady_clock::now();
+
+            while (!_serverTerminated)
+            {
+                auto handler = [this](InstructionCode code) { HandleInstruction(code); };
+                _communicationManager->ExecuteOnInstruction(handler);
+            }
+        }
+        catch (const HighwayPursuitException& e)
+        {
+            HPLogger::LogException(e);
+            _communicationManager->WriteException(e);
+        }
+        catch (const std::exception& e)
+        {
+            HPLogger::LogException(e);
+            _communicationManager->WriteException(HighwayPursuitException(ErrorCode::NATIVE_ERROR));
+        }
+        _communicationManager->SetHeartbeatState(HeartbeatState::EXITED);
+    }
+
+    uint32_t VectorizedServer::SlotCount() const
+    {
+        return static_cast<uint32_t>(_slots.size());
+    }
+
+    uint64_t VectorizedServer::StolenCount() const
+    {
+        return _pool.StolenCount();
+    }
+
+    ServerInfo VectorizedServer::StartGames()
+    {
+        // Same startup as HighwayPursuitServer, the games start in parallel
+        _pool.Run(SlotCount(), [this](uint32_t index)
+            {
+                Slot& slot = _slots[index];
+                slot.environment->WaitGameUpdate();
+                slot.backend->Update().EnableCustomTime();
+                slot.environment->SkipIntro();
+                slot.backend->Input().LoadBindings();
+            }
+        );
+
+        BufferFormat format = _slots.front().backend->Rendering().GetBufferFormat();
+        for (const Slot& slot : _slots)
+        {
+            BufferFormat slotFormat = slot.backend->Rendering().GetBufferFormat();
+            if (slotFormat.width != format.width || slotFormat.height != format.height || slotFormat.channels != format.channels)
+            {
+                throw std::runtime_error("The environments of a vectorized server must have the same observation format");
+            }
+        }
+        return ServerInfo(format.height, format.width, format.channels, _slots.front().backend->Input().GetInputCount());
+    }
+
+    void VectorizedServer::HandleInstruction(InstructionCode code)
+    {
+        switch (code)
+        {
+        case InstructionCode::STEP_BATCH:
+            _pool.Run(SlotCount(), [this](uint32_t index) { RunSlot(index); });
+            UpdateMetrics();
+            break;
+        case InstructionCode::PING:
+            break;
+        case InstructionCode::DUMP_TRACE:
+            DumpTrace();
+            break;
+        case InstructionCode::CLOSE:
+            _serverTerminated = true;
+            break;
+        default:
+            // Environments are only driven through batches
+            _communicationManager->WriteNonFatalError(ErrorCode::UNSUPPORTED_INSTRUCTION);
+            break;
+        }
+    }
+
+    void VectorizedServer::RunSlot(uint32_t index)
+    {
+        // Runs on any thread of the pool, only touches its slot
+        ErrorCode result = ErrorCode::ACKNOWLEDGED;
+        try
+        {
+            switch (_communicationManager->ReadSlotInstruction(index))
+            {
+            case InstructionCode::SKIP:
+                break;
+            case InstructionCode::RESET_NEW_LIFE:
+                Reset(index, false);
+                break;
+            case InstructionCode::RESET_NEW_GAME:
+                Reset(index, true);
+                break;
+            case InstructionCode::STEP:
+                // Stepped anyway, like a single environment
+                if (!_slots[index].environment->IsInitialized() || _slots[index].environment->LastTermination().IsDone())
+                {
+                    result = ErrorCode::ENVIRONMENT_NOT_RESET;
+                }
+                Step(index);
+                break;
+            default:
+                result = ErrorCode::UNSUPPORTED_INSTRUCTION;
+                break;
+            }
+        }
+        catch (const HighwayPursuitException& e)
+        {
+            result = e.code;
+        }
+        catch (const std::exception&)
+        {
+            result = ErrorCode::NATIVE_ERROR;
+        }
+        _communicationManager->WriteSlotResult(index, result);
+    }
+
+    void VectorizedServer::Reset(uint32_t index, bool startNewGame)
+    {
+        Slot& slot = _slots[index];
+        slot.environment->Reset(startNewGame);
+        WriteOutputs(index, 0.0f, slot.environment->LastTermination());
+    }
+
+    void VectorizedServer::Step(uint32_t index)
+    {
+        Slot& slot = _slots[index];
+        Environment::GameEnvironment::StepResult result = slot.environment->Step(_communicationManager->ReadActionMask(index), _communicationManager->ReadActionRepeat(index));
+
+        // The slot doesn't wait for another batch to start its next episode, the client gets the terminal reward and termination
+        Termination termination = slot.environment->LastTermination();
+        if (termination.IsDone() && _options.episodeParams.autoReset)
+        {
+            slot.backend->Rendering().Screenshot(
+                [this, index](void* pixelData, const BufferFormat& format)
+                {
+                    _communicationManager->WriteObservationBuffer(pixelData, format, index);
+                });
+            _communicationManager->KeepFinalObservation(index);
+            slot.environment->Reset(false);
+        }
+        WriteOutputs(index, result.reward, termination);
+    }
+
+    void VectorizedServer::WriteOutputs(uint32_t index, float reward, const Termination& termination)
+    {
+        Slot& slot = _slots[index];
+        slot.backend->Rendering().Screenshot(
+            [this, index](void* pixelData, const BufferFormat& format)
+            {
+                _communicationManager->WriteObservationBuffer(pixelData, format, index);
+            });
+
+        _communicationManager->WriteRewardBuffer(Reward(reward), index);
+        _communicationManager->WriteInfoBuffer(Info(_tps, _memory, slot.environment->ServerTime(), slot.environment->GameTime()), index);
+
+        // tps and memory are the ones of the server, the other metrics the ones of the slot
+        slot.environment->PublishMetrics(slot.metrics, _tps, _memory);
+        _communicationManager->WriteTerminationBuffer(termination, index);
+    }
+
+    void VectorizedServer::UpdateMetrics()
+    {
+        // tps counts the frames of all the slots, the memory is the one of the whole process
+        uint64_t frames = 0;
+        for (const Slot& slot : _slots)
+        {
+            frames += slot.environment->Frames();
+        }
+        if (frames - _metricsFrames < PERIODIC_METRICS_FRAMES * SlotCount())
+        {
+            return;
+        }
+
+        auto now = std::chrono::steady_clock::now();
+        _tps = static_cast<float>((frames - _metricsFrames) / std::chrono::duration<double>(now - _metricsStart).count());
+        _memory = Platform::GetWorkingSetSize() / (1024.0f * 1024.0f);
+        _metricsFrames = frames;
+        _metricsStart = now;
+    }
+
+    void VectorizedServer::DumpTrace()
+    {
+        if (!Tracing::TraceRecorder::IsEnabled())
+        {
+            return;
+        }
+
+        // Same files as the single server
+        std::string path = _options.traceParams.outputDirectory + "/trace_" + _options.sharedResourcesPrefix + std::to_string(_traceDumpCount) + ".json";
+        if (Tracing::TraceRecorder::Dump(path))
+        {
+            _traceDumpCount++;
+            HPLogger::LogInfo("Trace written to " + path);
+        }
+    }
+}
@@ -0,0 +1,61 @@
+#pragma once
+#include "../Data/ServerTypes.hpp"
+#include "../CommunicationManager.hpp"
+#include "../Services/GameBackend.hpp"
+#include "../Environment/GameEnvironment.hpp"
+#include "../Tracing/TraceRecorder.hpp"
+#include "WorkStealingPool.hpp"
+
+namespace Vectorized
+{
+    // Variant of HighwayPursuitServer hosting several environments in one process, for in-process backends (the synthetic game).
+    // They share the semaphores and sections of one client, which runs all of them with a single STEP_BATCH round trip;
+    // the slots of a batch run on a work-stealing pool. Snapshots, recordings, replays and real time aren't supported.
+    // With auto-reset, each slot starts its next episode as soon as one ends. Each slot runs its own copy of the client's transforms,
+    // the episode rules are the ones of the single server (Environment::GameEnvironment).
+    class VectorizedServer
+    {
+    public:
+        static constexpr uint64_t PERIODIC_METRICS_FRAMES = 1800; // frames of each slot between the updates of tps and memory
+
+        // One environment per backend, threadCount includes the server thread
+        VectorizedServer(const Data::ServerParams& options, std::vector<std::unique_ptr<Services::GameBackend>> backends, uint32_t threadCount);
+        ~VectorizedServer();
+
+        // Serves a client until it closes the server
+        void Run();
+        uint32_t SlotCount() const;
+        // Slots stepped by another thread than the one they were given to, see WorkStealingPool
+        uint64_t StolenCount() const;
+
+    private:
+        struct Slot
+        {
+            std::unique_ptr<Services::GameBackend> backend;
+            // Sticky actions seeded with the seed of the options + the slot index, transforms set once connected
+            std::unique_ptr<Environment::GameEnvironment> environment;
+            Metrics::MetricsWriter metrics; // attached once connected
+        };
+
+        const Data::ServerParams _options;
+        std::unique_ptr<CommunicationManager> _communicationManager;
+        std::vector<Slot> _slots;
+        WorkStealingPool _pool;
+        bool _serverTerminated;
+        // Shared by the slots, only updated between batches
+        float _tps;
+        float _memory;
+        uint64_t _metricsFrames;
+        std::chrono::steady_clock::time_point _metricsStart;
+        uint32_t _traceDumpCount;
+
+        Data::ServerInfo StartGames();
+        void HandleInstruction(Data::InstructionCode code);
+        void RunSlot(uint32_t index);
+        void Reset(uint32_t index, bool startNewGame);
+        void Step(uint32_t index);
+        void WriteOutputs(uint32_t index, float reward, const Data::Termination& termination);
+        void UpdateMetrics();
+        void DumpTrace();
+    };
+}
@@ -0,0 +1,161 @@
+#include "../pch.h"
+#include "WorkStealingPool.hpp"
+
+namespace Vectorized
+{
+    WorkStealingPool::WorkStealingPool(uint32_t threadCount)
+        : _threadCount(std::max<uint32_t>(1, threadCount)),
+        _ranges(std::make_unique<TaskRange[]>(_threadCount)),
+        _task(nullptr),
+        _generation(0),
+        _busyWorkers(0),
+        _stopping(false),
+        _stolenCount(0)
+    {
+        for (uint32_t index = 0; index + 1 < _threadCount; ++index)
+        {
+            _workers.emplace_back(&WorkStealingPool::WorkerLoop, this, index);
+        }
+    }
+
+    WorkStealingPool::~WorkStealingPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _stopping = true;
+        }
+        _startCondition.notify_all();
+        for (std::thread& worker : _workers)
+        {
+            worker.join();
+        }
+    }
+
+    uint32_t WorkStealingPool::ThreadCount() const
+    {
+        return _threadCount;
+    }
+
+    void WorkStealingPool::Run(uint32_t taskCount, Utils::FunctionRef<void(uint32_t)> task)
+    {
+        // No worker is running, the ranges can be written without their locks
+        for (uint32_t index = 0; index < _threadCount; ++index)
+        {
+            _ranges[index].begin = static_cast<uint32_t>(static_cast<uint64_t>(taskCount) * index / _threadCount);
+            _ranges[index].end = static_cast<uint32_t>(static_cast<uint64_t>(taskCount) * (index + 1) / _threadCount);
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _task = &task;
+            _error = nullptr;
+            _busyWorkers = _threadCount - 1;
+            _generation++;
+        }
+        _startCondition.notify_all();
+        Work(_threadCount - 1);
+
+        // Workers can still be looking for tasks to steal, the next batch waits for them
+        std::exception_ptr error;
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _doneCondition.wait(lock, [this]() { return _busyWorkers == 0; });
+            _task = nullptr;
+            error = _error;
+        }
+        if (error != nullptr)
+        {
+            std::rethrow_exception(error);
+        }
+    }
+
+    uint64_t WorkStealingPool::StolenCount() const
+    {
+        return _stolenCount.load(std::memory_order_relaxed);
+    }
+
+    void WorkStealingPool::WorkerLoop(uint32_t index)
+    {
+        uint64_t generation = 0;
+        std::unique_lock<std::mutex> lock(_mutex);
+        while (true)
+        {
+            _startCondition.wait(lock, [this, generation]() { return _stopping || _generation != generation; });
+            if (_stopping)
+            {
+                return;
+            }
+            generation = _generation;
+
+            lock.unlock();
+            Work(index);
+            lock.lock();
+            if (--_busyWorkers == 0)
+            {
+                _doneCondition.notify_all();
+            }
+        }
+    }
+
+    void WorkStealingPool::Work(uint32_t index)
+    {
+        uint32_t task = 0;
+        while (Pop(index, task) || Steal(index, task))
+        {
+            try
+            {
+                (*_task)(task);
+            }
+            catch (...)
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+                if (_error == nullptr)
+                {
+                    _error = std::current_exception();
+                }
+            }
+        }
+    }
+
+    bool WorkStealingPool::Pop(uint32_t index, uint32_t& task)
+    {
+        TaskRange& range = _ranges[index];
+        std::lock_guard<std::mutex> lock(range.mutex);
+        if (range.begin >= range.end)
+        {
+            return false;
+        }
+        task = range.begin++;
+        return true;
+    }
+
+    bool WorkStealingPool::Steal(uint32_t index, uint32_t& task)
+    {
+        for (uint32_t offset = 1; offset < _threadCount; ++offset)
+        {
+            TaskRange& victim = _ranges[(index + offset) % _threadCount];
+            uint32_t first = 0;
+            uint32_t last = 0;
+            {
+                std::lock_guard<std::mutex> lock(victim.mutex);
+                if (victim.begin >= victim.end)
+                {
+                    continue;
+                }
+                first = victim.end - (victim.end - victim.begin + 1) / 2;
+                last = victim.end;
+                victim.end = first;
+            }
+            _stolenCount.fetch_add(last - first, std::memory_order_relaxed);
+
+            // Runs the first stolen task now, the others can be stolen in turn
+            TaskRange& range = _ranges[index];
+            std::lock_guard<std::mutex> lock(range.mutex);
+            range.begin = first + 1;
+            range.end = last;
+            task = first;
+            return true;
+        }
+        return false;
+    }
+}
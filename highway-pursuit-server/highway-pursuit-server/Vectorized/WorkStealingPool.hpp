@@ -0,0 +1,48 @@
+#pragma once
+#include "../Utils/FunctionRef.hpp"
+
+namespace Vectorized
+{
+    // Runs the tasks of a batch on a fixed set of threads, the caller included. Each thread starts on its own contiguous range of tasks
+    // and steals half of the remaining range of another one once done, which balances tasks of uneven cost without allocating.
+    class WorkStealingPool
+    {
+    public:
+        // threadCount - 1 background threads, the thread calling Run is the last one
+        explicit WorkStealingPool(uint32_t threadCount);
+        ~WorkStealingPool();
+
+        uint32_t ThreadCount() const;
+        // Runs task(i) for every i in [0, taskCount), returns once all are done. The first exception of a task is rethrown then.
+        void Run(uint32_t taskCount, Utils::FunctionRef<void(uint32_t)> task);
+        // Tasks run by another thread than the one they were given to
+        uint64_t StolenCount() const;
+
+    private:
+        // Remaining tasks of a thread, taken from the front by the thread and from the back by thieves
+        struct alignas(64) TaskRange
+        {
+            std::mutex mutex;
+            uint32_t begin = 0;
+            uint32_t end = 0;
+        };
+
+        const uint32_t _threadCount;
+        std::unique_ptr<TaskRange[]> _ranges;
+        std::mutex _mutex;
+        std::condition_variable _startCondition;
+        std::condition_variable _doneCondition;
+        const Utils::FunctionRef<void(uint32_t)>* _task;
+        std::exception_ptr _error;
+        uint64_t _generation;
+        uint32_t _busyWorkers;
+        bool _stopping;
+        std::atomic<uint64_t> _stolenCount;
+        std::vector<std::thread> _workers;
+
+        void WorkerLoop(uint32_t index);
+        void Work(uint32_t index);
+        bool Pop(uint32_t index, uint32_t& task);
+        bool Steal(uint32_t index, uint32_t& task);
+    };
+}
@@ -0,0 +1,175 @@
+#include "../pch.h"
+#include "VideoRecorder.hpp"
+
+namespace Video
+{
+    namespace
+    {
+        uint32_t ClampDownsample(uint32_t downsample, const Data::BufferFormat& format)
+        {
+            return std::max(1u, std::min({ downsample, format.width, format.height }));
+        }
+
+        bool IsMonochrome(const Data::BufferFormat& format)
+        {
+            return format.channels == 1;
+        }
+    }
+
+    VideoRecorder::VideoRecorder(const Data::ServerParams::VideoParams& params, const Data::BufferFormat& format, uint32_t frameRate, uint32_t frameRateDivisor)
+        : _path(params.outputPath),
+        _format(format),
+        _downsample(ClampDownsample(params.downsample, format)),
+        _frameInterval(std::max<uint32_t>(params.frameInterval, 1)),
+        _width(format.width / _downsample),
+        _height(format.height / _downsample),
+        _submittedObservations(0),
+        _writtenFrames(0),
+        _file(nullptr),
+        _unflushedFrames(0),
+        _writer("Video recording", params.queueCapacity)
+    {
+        if (format.channels != 1 && format.channels != 3 && format.channels != 4)
+        {
+            throw std::runtime_error("Videos can't be recorded from observations with " + std::to_string(format.channels) + " channels");
+        }
+
+        // All the memory used while recording is allocated here
+        for (std::vector<uint8_t>& frame : _writer.Items())
+        {
+            frame.resize(format.Size());
+        }
+        size_t planeSize = static_cast<size_t>(_width) * _height;
+        _planes.resize(IsMonochrome(format) ? planeSize : 3 * planeSize);
+
+        _file = std::fopen(_path.c_str(), "wb");
+        if (_file == nullptr)
+        {
+            throw std::runtime_error("Couldn't create the video " + _path);
+        }
+
+        std::string header = "YUV4MPEG2 W" + std::to_string(_width) + " H" + std::to_string(_height)
+            + " F" + std::to_string(frameRate) + ":" + std::to_string(std::max<uint32_t>(frameRateDivisor, 1) * _frameInterval)
+            + " Ip A1:1 " + (IsMonochrome(format) ? "Cmono" : "C444") + "\n";
+        if (std::fwrite(header.data(), 1, header.size(), _file) != header.size() || std::fflush(_file) != 0)
+        {
+            std::fclose(_file);
+            throw std::runtime_error("Couldn't write the video " + _path);
+        }
+        _writer.Start([this](std::vector<uint8_t>& observation) { Write(observation); }, [this]() { Flush(); });
+    }
+
+    VideoRecorder::~VideoRecorder()
+    {
+        _writer.Stop();
+
+        std::fclose(_file);
+        HPLogger::LogInfo("Video " + _path + ": " + std::to_string(WrittenFrames()) + " frames written, "
+            + std::to_string(DroppedFrames()) + " dropped");
+    }
+
+    bool VideoRecorder::Submit(const void* observation)
+    {
+        if (_submittedObservations++ % _frameInterval != 0)
+        {
+            return false;
+        }
+
+        std::vector<uint8_t>* frame = _writer.Acquire();
+        if (frame == nullptr)
+        {
+            return false;
+        }
+        std::memcpy(frame->data(), observation, _format.Size());
+        _writer.Commit();
+        return true;
+    }
+
+    uint64_t VideoRecorder::WrittenFrames() const
+    {
+        return _writtenFrames.load(std::memory_order_relaxed);
+    }
+
+    uint64_t VideoRecorder::DroppedFrames() const
+    {
+        return _writer.Dropped();
+    }
+
+    uint32_t VideoRecorder::Width() const
+    {
+        return _width;
+    }
+
+    uint32_t VideoRecorder::Height() const
+    {
+        return _height;
+    }
+
+    void VideoRecorder::Write(const std::vector<uint8_t>& observation)
+    {
+        // Each pixel averages a block of the observation, then BT.601 studio swing in 8 bits fixed point
+        size_t planeSize = static_cast<size_t>(_width) * _height;
+        uint32_t blockArea = _downsample * _downsample;
+        size_t rowSize = static_cast<size_t>(_format.width) * _format.channels;
+        for (uint32_t y = 0; y < _height; ++y)
+        {
+            const uint8_t* blockRow = observation.data() + static_cast<size_t>(y) * _downsample * rowSize;
+            for (uint32_t x = 0; x < _width; ++x)
+            {
+                uint32_t sums[3] = { 0, 0, 0 };
+                for (uint32_t dy = 0; dy < _downsample; ++dy)
+                {
+                    const uint8_t* pixel = blockRow + dy * rowSize + static_cast<size_t>(x) * _downsample * _format.channels;
+                    for (uint32_t dx = 0; dx < _downsample; ++dx, pixel += _format.channels)
+                    {
+                        for (uint32_t channel = 0; channel < std::min(_format.channels, 3u); ++channel)
+                        {
+                            sums[channel] += pixel[channel];
+                        }
+                    }
+                }
+
+                size_t i = static_cast<size_t>(y) * _width + x;
+                if (IsMonochrome(_format))
+                {
+                    _planes[i] = static_cast<uint8_t>((sums[0] + blockArea / 2) / blockArea);
+                    continue;
+                }
+                // Observations are BGR(X)
+                int b = static_cast<int>((sums[0] + blockArea / 2) / blockArea);
+                int g = static_cast<int>((sums[1] + blockArea / 2) / blockArea);
+                int r = static_cast<int>((sums[2] + blockArea / 2) / blockArea);
+                _planes[i] = static_cast<uint8_t>(((66 * r + 129 * g + 25 * b + 128) >> 8) + 16);
+                _planes[planeSize + i] = static_cast<uint8_t>(((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128);
+                _planes[2 * planeSize + i] = static_cast<uint8_t>(((112 * r - 94 * g - 18 * b + 128) >> 8) + 128);
+            }
+        }
+
+        static const char FRAME_HEADER[] = "FRAME\n";
+        if (std::fwrite(FRAME_HEADER, 1, sizeof(FRAME_HEADER) - 1, _file) != sizeof(FRAME_HEADER) - 1
+            || std::fwrite(_planes.data(), 1, _planes.size(), _file) != _planes.size())
+        {
+            throw std::runtime_error("Couldn't write to the video " + _path);
+        }
+        _unflushedFrames++;
+        if (_unflushedFrames == _writer.Capacity())
+        {
+            Flush();
+        }
+    }
+
+    void VideoRecorder::Flush()
+    {
+        if (_unflushedFrames == 0)
+        {
+            return;
+        }
+
+        if (std::fflush(_file) != 0)
+        {
+            throw std::runtime_error("Couldn't write to the video " + _path);
+        }
+        _writtenFrames.fetch_add(_unflushedFrames, std::memory_order_relaxed);
+        _unflushedFrames = 0;
+    }
+}
@@ -0,0 +1,49 @@
+#pragma once
+#include "../Data/ServerTypes.hpp"
+#include "../Utils/BackgroundWriter.hpp"
+
+namespace Video
+{
+    // Records observations to a YUV4MPEG2 (.y4m) video, readable by ffmpeg and most players. Observations are copied to a
+    // bounded queue and downsampled, converted and written by a background thread, so that submitting never waits on the disk:
+    // frames that find the queue full are dropped. BGR(X) observations give 4:4:4 frames, grayscale ones monochrome frames.
+    // The frame rate is fixed in the header and assumes every observation is frameskip frames apart: steps with another action
+    // repeat, the early end of the steps that terminate the episode and the dropped frames make the video play too fast or too slow.
+    class VideoRecorder
+    {
+    public:
+        // Recorded observations are played at frameRate / frameRateDivisor frames per second
+        VideoRecorder(const Data::ServerParams::VideoParams& params, const Data::BufferFormat& format, uint32_t frameRate, uint32_t frameRateDivisor);
+        // Writes the frames still queued
+        ~VideoRecorder();
+
+        // Doesn't allocate or block. Returns false if the observation was skipped by the frame interval or dropped
+        bool Submit(const void* observation);
+        uint64_t WrittenFrames() const;
+        uint64_t DroppedFrames() const;
+        // Size of the video frames
+        uint32_t Width() const;
+        uint32_t Height() const;
+
+    private:
+        const std::string _path;
+        const Data::BufferFormat _format;
+        const uint32_t _downsample;
+        const uint32_t _frameInterval;
+        const uint32_t _width;
+        const uint32_t _height;
+
+        // Producer side
+        uint64_t _submittedObservations; // including the ones skipped by the interval
+        std::atomic<uint64_t> _writtenFrames;
+
+        // Writer thread side
+        std::FILE* _file;
+        std::vector<uint8_t> _planes; // Y, U and V planes of a frame, only Y in monochrome
+        uint64_t _unflushedFrames;
+        Utils::BackgroundWriter<std::vector<uint8_t>> _writer; // last, stopped before the file it writes is closed
+
+        void Write(const std::vector<uint8_t>& observation);
+        void Flush();
+    };
+}
@@ -1,6 +1,9 @@
 #include "pch.h"
+#include "framework.h"
 #include "Shared/HighwayPursuitArgs.hpp"
 #include "HighwayPursuitServer.hpp"
+#include "Injected/InjectedBackend.hpp"
+#include "Placement/CorePlacement.hpp"
 using namespace Shared;
 
 static std::unique_ptr<HighwayPursuitServer> serverPtr = nullptr;
@@ -17,8 +20,31 @@ extern "C" __declspec(dllexport) void Initialize(LPVOID lpParam)
     {
         // Setup hooks
         Data::ServerParams::RenderParams renderParams(args.renderWidth, args.renderHeight, args.renderEnabled);
-        Data::ServerParams options(args.isRealTime, args.frameSkip, renderParams, args.sharedResourcesPrefix);
-        serverPtr = std::make_unique<HighwayPursuitServer>(options);
+        Data::ServerParams::TraceParams traceParams(args.traceEnabled, args.traceMemoryBudget, args.logDirPath);
+        Data::ServerParams::ReplayParams replayParams(args.actionLogPath, args.replayPath);
+        Data::ServerParams::AgentParams agentParams(args.agentPath, args.agentConfig, args.agentEpisodes, args.agentStatsPath, args.agentMaxSteps);
+        // Replays and agents run at max speed
+        bool isRealTime = args.isRealTime && !replayParams.IsReplaying() && !agentParams.IsEnabled();
+        Data::ServerParams::TrajectoryParams trajectoryParams(args.trajectoryDir, args.trajectoryCompression);
+        Data::ServerParams::ReplayBufferParams replayBufferParams(args.replayBufferName);
+        Data::ServerParams::PoolParams poolParams(args.parked);
+        Placement::CorePlacement placement = Placement::AutoPlacement(args.placementIndex, args.placementCount);
+        Data::ServerParams::AffinityParams affinityParams(args.gameCores != 0 ? args.gameCores : placement.gameCores, args.serverCores != 0 ? args.serverCores : placement.serverCores);
+        Data::ServerParams::EpisodeParams episodeParams(args.autoReset);
+        Data::ServerParams::ActionParams actionParams(args.stickyProbability, args.seed);
+        Data::ServerParams::StartupParams startupParams(args.startupImagePath);
+        Data::ServerParams::SpectatorParams spectatorParams(args.spectatorName, args.spectatorFps);
+        Data::ServerParams::VideoParams videoParams(args.videoPath, args.videoDownsample, args.videoInterval, args.videoQueue);
+        Data::ServerParams options(isRealTime, args.frameSkip, renderParams, traceParams, args.sharedResourcesPrefix, replayParams, trajectoryParams, replayBufferParams, poolParams,
+            affinityParams, episodeParams, actionParams, agentParams, startupParams, spectatorParams, videoParams);
+
+        // The game's main thread is still suspended, the server thread pins itself in Run
+        if (affinityParams.gameCores != 0 && !Platform::SetThreadAffinity(args.gameThreadId, affinityParams.gameCores))
+        {
+            HPLogger::LogWarning("Failed to pin the game thread to the cores " + std::to_string(affinityParams.gameCores));
+        }
+        auto backend = std::make_unique<Injected::InjectedBackend>(options, HighwayPursuitServer::FPS, HighwayPursuitServer::PERFORMANCE_COUNTER_FREQUENCY);
+        serverPtr = std::make_unique<HighwayPursuitServer>(options, std::move(backend));
     }
     catch (const std::exception& e)
     {
@@ -1,7 +1,6 @@
 #ifndef PCH_H
 #define PCH_H
 
-#include "framework.h"
 #include <iostream>
 #include <string>
 #include <cstdint>
@@ -17,8 +16,9 @@
 #include <mutex>
 #include <vector>
 #include <functional>
-#include <processthreadsapi.h>
-#include <psapi.h>
+#include <type_traits>
+#include <thread>
+#include <fstream>
 
 #include "HPLogger.hpp"
 
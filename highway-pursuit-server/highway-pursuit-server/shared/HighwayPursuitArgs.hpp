@@ -7,6 +7,10 @@ namespace Shared
     struct HighwayPursuitArgs
     {
         static const size_t prefixMaxSize = 256;
+        static const uint32_t defaultTraceMemoryBudget = 16 * 1024 * 1024;
+        static const size_t agentConfigMaxSize = 1024;
+        static const uint32_t defaultVideoQueue = 64; // VideoParams::DEFAULT_QUEUE_CAPACITY
+        static const uint32_t defaultAgentMaxSteps = 27000; // AgentParams::DEFAULT_MAX_EPISODE_STEPS
 
         bool isRealTime;
         int frameSkip;
@@ -15,16 +19,73 @@ namespace Shared
         bool renderEnabled;
         char sharedResourcesPrefix[prefixMaxSize];
         char logDirPath[MAX_PATH];
+        // Optional args
+        bool traceEnabled;
+        uint32_t traceMemoryBudget;
+        char actionLogPath[MAX_PATH]; // empty: no recording
+        char replayPath[MAX_PATH]; // empty: serve a client
+        char trajectoryDir[MAX_PATH]; // empty: no recording
+        bool trajectoryCompression;
+        char replayBufferName[prefixMaxSize]; // empty: no replay buffer
+        bool parked; // started by a warm pool
+        uint64_t gameCores; // bit i pins the thread to logical processor i, 0: not pinned
+        uint64_t serverCores;
+        uint32_t placementIndex; // automatic placement of instance placementIndex out of placementCount, for the threads without cores
+        uint32_t placementCount; // 0: no automatic placement
+        bool autoReset; // steps ending the episode reset it
+        float stickyProbability; // 0: no sticky actions
+        uint64_t seed; // of the sticky actions, given to agents
+        char agentPath[MAX_PATH]; // empty: serve a client
+        char agentConfig[agentConfigMaxSize];
+        uint32_t agentEpisodes;
+        uint32_t agentMaxSteps; // per episode, 0: no cap
+        char agentStatsPath[MAX_PATH]; // empty: no stats file
+        char startupImagePath[MAX_PATH]; // empty: always skip the intro
+        char spectatorName[prefixMaxSize]; // empty: no spectator tap
+        float spectatorFps; // 0: every observation is published
+        char videoPath[MAX_PATH]; // empty: no video
+        uint32_t videoDownsample;
+        uint32_t videoInterval; // one observation out of videoInterval is recorded
+        uint32_t videoQueue;
+        uint32_t gameThreadId; // set by the launcher, pinned at injection
 
         HighwayPursuitArgs()
             : isRealTime(false),
             frameSkip(0),
             renderWidth(0),
             renderHeight(0),
-            renderEnabled(false)
+            renderEnabled(false),
+            traceEnabled(false),
+            traceMemoryBudget(defaultTraceMemoryBudget),
+            trajectoryCompression(true),
+            parked(false),
+            gameCores(0),
+            serverCores(0),
+            placementIndex(0),
+            placementCount(0),
+            autoReset(false),
+            stickyProbability(0.0f),
+            seed(0),
+            agentEpisodes(1),
+            agentMaxSteps(defaultAgentMaxSteps),
+            spectatorFps(0.0f),
+            videoDownsample(1),
+            videoInterval(1),
+            videoQueue(defaultVideoQueue),
+            gameThreadId(0)
         {
             this->logDirPath[0] = '\0';
             this->sharedResourcesPrefix[0] = '\0';
+            this->actionLogPath[0] = '\0';
+            this->replayPath[0] = '\0';
+            this->trajectoryDir[0] = '\0';
+            this->replayBufferName[0] = '\0';
+            this->agentPath[0] = '\0';
+            this->agentConfig[0] = '\0';
+            this->agentStatsPath[0] = '\0';
+            this->startupImagePath[0] = '\0';
+            this->spectatorName[0] = '\0';
+            this->videoPath[0] = '\0';
         }
 
         HighwayPursuitArgs(bool realTime, int skip, int width, int height, bool enableRender, const char* logDirPath, const char* sharedResources)
@@ -32,13 +93,42 @@ namespace Shared
             frameSkip(skip),
             renderWidth(width),
             renderHeight(height),
-            renderEnabled(enableRender)
+            renderEnabled(enableRender),
+            traceEnabled(false),
+            traceMemoryBudget(defaultTraceMemoryBudget),
+            trajectoryCompression(true),
+            parked(false),
+            gameCores(0),
+            serverCores(0),
+            placementIndex(0),
+            placementCount(0),
+            autoReset(false),
+            stickyProbability(0.0f),
+            seed(0),
+            agentEpisodes(1),
+            agentMaxSteps(defaultAgentMaxSteps),
+            spectatorFps(0.0f),
+            videoDownsample(1),
+            videoInterval(1),
+            videoQueue(defaultVideoQueue),
+            gameThreadId(0)
         {
             strncpy_s(this->logDirPath, logDirPath, MAX_PATH - 1);
             this->logDirPath[MAX_PATH - 1] = '\0';
 
             strncpy_s(this->sharedResourcesPrefix, sharedResources, prefixMaxSize - 1);
             this->sharedResourcesPrefix[prefixMaxSize - 1] = '\0';
+
+            this->actionLogPath[0] = '\0';
+            this->replayPath[0] = '\0';
+            this->trajectoryDir[0] = '\0';
+            this->replayBufferName[0] = '\0';
+            this->agentPath[0] = '\0';
+            this->agentConfig[0] = '\0';
+            this->agentStatsPath[0] = '\0';
+            this->startupImagePath[0] = '\0';
+            this->spectatorName[0] = '\0';
+            this->videoPath[0] = '\0';
         }
     };
     #pragma pack(pop)